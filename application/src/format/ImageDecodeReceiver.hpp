@@ -0,0 +1,85 @@
+/*--------------------------------------------------------------------
+
+   Perceptuum3 rendering components
+   Copyright (c) 2005, Harrison Ainsworth / HXA7241.
+
+   http://www.hxa7241.org/
+
+--------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later
+   version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+   MA  02110-1301  USA
+
+--------------------------------------------------------------------*/
+
+
+
+#ifndef ImageDecodeReceiver_h
+#define ImageDecodeReceiver_h
+
+
+
+
+#include "p3tonemapper_format.hpp"
+namespace p3tonemapper_format
+{
+
+
+/**
+ * Receiver of an image as it is decoded, by a whole-image read.<br/><br/>
+ *
+ * First the header is given, then all the rows, in image order, lowest row
+ * first (eg to analyse the image while the rest is still being decoded).
+ * Rows are packed RGB pixels, each band only valid during the call.
+ *
+ * @exceptions can throw, which fails the read
+ */
+class ImageDecodeReceiver
+{
+/// standard object services ---------------------------------------------------
+public:
+	virtual ~ImageDecodeReceiver() {}
+
+
+/// commands -------------------------------------------------------------------
+	/**
+	 * @pPrimaries8        chromaticities of RGB and white, all 0 if not
+	 *                     present
+	 * @scalingToGetCdm2   scaling needed to make cd/m^2, 0 if not present
+	 * @isHalf             whether rows will be halfs, else floats
+	 */
+	virtual void  receiveHeader( dword        width,
+	                             dword        height,
+	                             const float* pPrimaries8,
+	                             float        scalingToGetCdm2,
+	                             bool         isHalf )                     = 0;
+	/**
+	 * @rowCount  number of rows in the band
+	 * @pRows     packed RGB pixels of the band, lowest row first
+	 */
+	virtual void  receiveRows( dword       rowCount,
+	                           const void* pRows )                           = 0;
+};
+
+
+}//namespace
+
+
+
+
+#endif//ImageDecodeReceiver_h
@@ -29,13 +29,19 @@
 
 
 #include <ctype.h>
+#include <string.h>
 #include <fstream>
+#include <streambuf>
 
+#include "MappedFile.hpp"
 #include "exr.hpp"
 #include "rgbe.hpp"
+#include "pfm.hpp"
 #include "png.hpp"
 #include "ppm.hpp"
+#include "qoi.hpp"
 #include "ImageRef.hpp"
+#include "ImageRowsWriter.hpp"
 
 #include "ImageFormatter.hpp"   // own header is included last
 
@@ -52,6 +58,14 @@ const char ImageFormatter::NO_WRITE_FORMATTER_EXCEPTION_MESSAGE[] =
 	"could not write unrecognized image format";
 const char ImageFormatter::FILE_OPEN_EXCEPTION_MESSAGE[] =
 	"could not open image file";
+const char ImageFormatter::EXR_IN_MEMORY_EXCEPTION_MESSAGE[] =
+	"could not read OpenEXR image from memory (only from a file)";
+const char ImageFormatter::SHARED_LAYOUT_EXCEPTION_MESSAGE[] =
+	"image layout does not fit in shared memory";
+
+/// libraries held (bits)
+static const dword LIBRARY_PNG = 1;
+static const dword LIBRARY_EXR = 2;
 
 
 static std::string getFileNameExtension
@@ -59,6 +73,116 @@ static std::string getFileNameExtension
 	const char filePathname[]
 );
 
+static std::string lowerCase
+(
+	const std::string& str
+);
+
+static void setImage
+(
+	dword        width,
+	dword        height,
+	const float* pPrimaries8,
+	float        scalingToGetCdm2,
+	float*       pRgbTriples,
+	uword*       pRgbHalfTriples,
+	ImageRef&    image
+);
+
+static bool writeImageStream
+(
+	const std::string& nameExt,
+	const ImageRef&    image,
+	const char         pngLibraryPathName[],
+	dword              pngProfile,
+	std::ostream&      outBytes
+);
+
+
+namespace
+{
+
+/**
+ * Rows writer that owns its file stream.
+ */
+class FileRowsWriter
+	: public ImageRowsWriter
+{
+public:
+	explicit FileRowsWriter( const char filePathname[] )
+	 :	outBytes_m( filePathname, std::ofstream::binary )
+	 ,	pWriter_m ( 0 )
+	{
+	}
+
+	virtual ~FileRowsWriter()
+	{
+		delete pWriter_m;
+	}
+
+private:
+	FileRowsWriter( const FileRowsWriter& );
+	FileRowsWriter& operator=( const FileRowsWriter& );
+
+public:
+	virtual void  writeRows( const dword rowCount, const void* pRows )
+	{
+		pWriter_m->writeRows( rowCount, pRows );
+	}
+
+	virtual void  finish()
+	{
+		pWriter_m->finish();
+	}
+
+	std::ofstream    outBytes_m;
+	ImageRowsWriter* pWriter_m;
+};
+
+
+/**
+ * Stream buffer that appends to a byte vector (so writers can write straight
+ * into memory).
+ */
+class BytesOutBuffer
+	: public std::streambuf
+{
+public:
+	explicit BytesOutBuffer( std::vector<ubyte>& bytes )
+	 :	bytes_m( bytes )
+	{
+	}
+
+private:
+	BytesOutBuffer( const BytesOutBuffer& );
+	BytesOutBuffer& operator=( const BytesOutBuffer& );
+
+protected:
+	virtual int_type overflow( const int_type c )
+	{
+		if( !traits_type::eq_int_type( c, traits_type::eof() ) )
+		{
+			bytes_m.push_back( ubyte(traits_type::to_char_type( c )) );
+		}
+
+		return traits_type::not_eof( c );
+	}
+
+	virtual std::streamsize xsputn( const char* pChars,
+		const std::streamsize length )
+	{
+		const ubyte* pBytes = reinterpret_cast<const ubyte*>( pChars );
+		bytes_m.insert( bytes_m.end(), pBytes, pBytes + length );
+
+		return length;
+	}
+
+private:
+	std::vector<ubyte>& bytes_m;
+};
+
+}
+
 
 
 
@@ -66,6 +190,7 @@ static std::string getFileNameExtension
 ImageFormatter::ImageFormatter()
  :	exrLibraryPathName_m()
  ,	pngLibraryPathName_m()
+ ,	pngProfile_m        ( png::PROFILE_SIZE )
 {
 }
 
@@ -77,6 +202,7 @@ ImageFormatter::ImageFormatter
 )
  :	exrLibraryPathName_m()
  ,	pngLibraryPathName_m()
+ ,	pngProfile_m        ( png::PROFILE_SIZE )
 {
 	ImageFormatter::setImageFormatter( exrLibraryPathName, pngLibraryPathName );
 }
@@ -105,6 +231,7 @@ ImageFormatter& ImageFormatter::operator=
 	{
 		exrLibraryPathName_m = other.exrLibraryPathName_m;
 		pngLibraryPathName_m = other.pngLibraryPathName_m;
+		pngProfile_m         = other.pngProfile_m;
 	}
 
 	return *this;
@@ -143,6 +270,15 @@ void ImageFormatter::setExrLibrary
 }
 
 
+void ImageFormatter::setPngProfile
+(
+	const dword profile
+)
+{
+	pngProfile_m = profile;
+}
+
+
 
 
 /// queries --------------------------------------------------------------------
@@ -151,6 +287,17 @@ void ImageFormatter::readImage
 	const char filePathname[],
 	ImageRef&  image
 ) const
+{
+	ImageFormatter::readImage( filePathname, image, 0 );
+}
+
+
+void ImageFormatter::readImage
+(
+	const char                 filePathname[],
+	ImageRef&                  image,
+	ImageDecodeReceiver* const pReceiver
+) const
 {
 	// declare image data
 	dword  width            = 0;
@@ -158,6 +305,8 @@ void ImageFormatter::readImage
 	float  primaries[8];
 	float  scalingToGetCdm2 = 0.0f;
 	float* pRgbTriples      = 0;
+	uword* pRgbHalfTriples  = 0;
+	hxa7241_general::MappedFile* pMapping = 0;
 
 	// choose formatter and read
 	{
@@ -171,16 +320,13 @@ void ImageFormatter::readImage
 		{
 			float exposure = 0.0f;
 
-			// make in file stream
-			std::ifstream inBytes( filePathname, std::ifstream::binary );
-			if( !inBytes )
-			{
-				throw FILE_OPEN_EXCEPTION_MESSAGE;
-			}
+			// map in file
+			const hxa7241_general::MappedFile inBytes( filePathname );
 
 			// read image file into data
-			p3tonemapper_format::rgbe::read( inBytes, false, width, height,
-				primaries, exposure, pRgbTriples );
+			p3tonemapper_format::rgbe::read( inBytes.getBytes(),
+				inBytes.getLength(), false, width, height, primaries, exposure,
+				pRgbTriples, pReceiver );
 
 			scalingToGetCdm2 = (exposure != 0.0f) ? 1.0f / exposure : 0.0f;
 		}
@@ -188,9 +334,40 @@ void ImageFormatter::readImage
 		else if( std::string("exr") == nameExt )
 		{
 			// read image file into data
+			// (left as halfs, for the mapper to convert as it goes)
 			p3tonemapper_format::exr::read( exrLibraryPathName_m.c_str(),
 				filePathname, 0, width, height, primaries, scalingToGetCdm2,
-				pRgbTriples );
+				pRgbHalfTriples, pReceiver );
+		}
+		// Portable Float Map (pfm)
+		else if( std::string("pfm") == nameExt )
+		{
+			for( dword i = 8;  i-- > 0; )
+			{
+				primaries[i] = 0.0f;
+			}
+
+			// map in file (kept if the pixels can be used in place)
+			pMapping = new hxa7241_general::MappedFile( filePathname );
+			try
+			{
+				const void* pPixels = 0;
+				bool        isCopy  = false;
+				p3tonemapper_format::pfm::read( pMapping->getBytes(),
+					pMapping->getLength(), width, height, pPixels, isCopy );
+
+				pRgbTriples = static_cast<float*>( const_cast<void*>( pPixels ) );
+				if( isCopy )
+				{
+					delete pMapping;
+					pMapping = 0;
+				}
+			}
+			catch( ... )
+			{
+				delete pMapping;
+				throw;
+			}
 		}
 		else
 		{
@@ -199,17 +376,166 @@ void ImageFormatter::readImage
 	}
 
 	// set image
+	setImage( width, height, primaries, scalingToGetCdm2, pRgbTriples,
+		pRgbHalfTriples, image );
+	image.setMapping( pMapping );
+}
+
+
+void ImageFormatter::readImage
+(
+	const ubyte* const         pBytes,
+	const udword               length,
+	const char                 formatName[],
+	ImageRef&                  image,
+	ImageDecodeReceiver* const pReceiver
+) const
+{
+	// declare image data
+	dword  width            = 0;
+	dword  height           = 0;
+	float  primaries[8];
+	float  scalingToGetCdm2 = 0.0f;
+	float* pRgbTriples      = 0;
+
+	// choose formatter and read
 	{
-		bool isPrimariesSet = false;
-		for( dword i = 8;  i-- > 0; )
+		// get format name, given or recognized
+		const std::string nameExt( ((0 != formatName) && (0 != formatName[0])) ?
+			lowerCase( formatName ) : getFormatName( pBytes, length ) );
+
+		// choose formatter
+		// Radiance (rgbe pic hdr rad)
+		if( (std::string("hdr") == nameExt) || (std::string("rad") == nameExt) ||
+			(std::string("rgbe") == nameExt) || (std::string("pic") == nameExt) )
 		{
-			isPrimariesSet |= (0.0f != primaries[i]);
+			float exposure = 0.0f;
+
+			// read image bytes into data
+			p3tonemapper_format::rgbe::read( pBytes, length, false, width,
+				height, primaries, exposure, pRgbTriples, pReceiver );
+
+			scalingToGetCdm2 = (exposure != 0.0f) ? 1.0f / exposure : 0.0f;
 		}
+		// OpenEXR (exr)
+		// (the library is reached through its C interface, which only opens
+		// files)
+		else if( std::string("exr") == nameExt )
+		{
+			throw EXR_IN_MEMORY_EXCEPTION_MESSAGE;
+		}
+		// Portable Float Map (pfm)
+		else if( std::string("pfm") == nameExt )
+		{
+			for( dword i = 8;  i-- > 0; )
+			{
+				primaries[i] = 0.0f;
+			}
 
-		// set data to image, adopting pixel storage
-		image.set( width, height,
-			isPrimariesSet ? primaries : 0, scalingToGetCdm2,
-			image.PIXELS_FLOAT, pRgbTriples );
+			const void* pPixels = 0;
+			bool        isCopy  = false;
+			p3tonemapper_format::pfm::read( pBytes, length, width, height,
+				pPixels, isCopy );
+
+			// copy pixels left in place (and maybe unaligned)
+			if( isCopy )
+			{
+				pRgbTriples = static_cast<float*>( const_cast<void*>( pPixels ) );
+			}
+			else
+			{
+				const udword count = udword(width) * udword(height) * 3;
+				pRgbTriples = new float[ count ];
+				::memcpy( pRgbTriples, pPixels, count * sizeof(float) );
+			}
+		}
+		else
+		{
+			throw NO_READ_FORMATTER_EXCEPTION_MESSAGE;
+		}
+	}
+
+	// set image
+	setImage( width, height, primaries, scalingToGetCdm2, pRgbTriples, 0,
+		image );
+}
+
+
+bool ImageFormatter::readImageHeader
+(
+	const char filePathname[],
+	ImageRef&  image
+) const
+{
+	bool isBandable = false;
+
+	// OpenEXR (exr), if tiled
+	if( std::string("exr") == getFileNameExtension( filePathname ) )
+	{
+		dword width            = 0;
+		dword height           = 0;
+		float primaries[8];
+		float scalingToGetCdm2 = 0.0f;
+
+		isBandable = p3tonemapper_format::exr::readTiledHeader(
+			exrLibraryPathName_m.c_str(), filePathname, width, height,
+			primaries, scalingToGetCdm2 );
+
+		if( isBandable )
+		{
+			bool isPrimariesSet = false;
+			for( dword i = 8;  i-- > 0; )
+			{
+				isPrimariesSet |= (0.0f != primaries[i]);
+			}
+
+			image.set( width, height,
+				isPrimariesSet ? primaries : 0, scalingToGetCdm2,
+				image.PIXELS_HALF, 0 );
+		}
+	}
+
+	return isBandable;
+}
+
+
+dword ImageFormatter::findImageLevel
+(
+	const char  filePathname[],
+	const dword minWidth,
+	const dword minHeight,
+	dword&      levelWidth,
+	dword&      levelHeight
+) const
+{
+	if( std::string("exr") == getFileNameExtension( filePathname ) )
+	{
+		return p3tonemapper_format::exr::findTiledLevel(
+			exrLibraryPathName_m.c_str(), filePathname, minWidth, minHeight,
+			levelWidth, levelHeight );
+	}
+	else
+	{
+		throw NO_READ_FORMATTER_EXCEPTION_MESSAGE;
+	}
+}
+
+
+void ImageFormatter::readImageRows
+(
+	const char         filePathname[],
+	const dword        level,
+	ImageRowsReceiver& rowsReceiver
+) const
+{
+	if( std::string("exr") == getFileNameExtension( filePathname ) )
+	{
+		p3tonemapper_format::exr::readTiled( exrLibraryPathName_m.c_str(),
+			filePathname, level, rowsReceiver );
+	}
+	else
+	{
+		throw NO_READ_FORMATTER_EXCEPTION_MESSAGE;
 	}
 }
 
@@ -219,6 +545,352 @@ void ImageFormatter::writeImage
 	const char      filePathname[],
 	const ImageRef& image
 ) const
+{
+	// make out file stream
+	std::ofstream outBytes( filePathname, std::ofstream::binary );
+
+	if( !writeImageStream( getFileNameExtension( filePathname ), image,
+		pngLibraryPathName_m.c_str(), pngProfile_m, outBytes ) )
+	{
+		throw NO_WRITE_FORMATTER_EXCEPTION_MESSAGE;
+	}
+}
+
+
+void ImageFormatter::writeImage
+(
+	const char          formatName[],
+	const ImageRef&     image,
+	std::vector<ubyte>& bytes
+) const
+{
+	// make out stream, appending to the bytes
+	BytesOutBuffer outBuffer( bytes );
+	std::ostream   outBytes( &outBuffer );
+
+	ImageFormatter::writeImage( formatName, image, outBytes );
+}
+
+
+void ImageFormatter::writeImage
+(
+	const char      formatName[],
+	const ImageRef& image,
+	std::ostream&   outBytes
+) const
+{
+	if( !writeImageStream( lowerCase( formatName ), image,
+		pngLibraryPathName_m.c_str(), pngProfile_m, outBytes ) )
+	{
+		throw NO_WRITE_FORMATTER_EXCEPTION_MESSAGE;
+	}
+}
+
+
+std::string ImageFormatter::getFormatName
+(
+	const ubyte* const pBytes,
+	const udword       length
+)
+{
+	// magic numbers, and their formats
+	static const struct
+	{
+		const char* pMagic;
+		dword       length;
+		const char* pFormatName;
+	} FORMATS[] = {
+		{ "\x76\x2F\x31\x01",    4, "exr" },
+		{ "#?",                  2, "hdr" },
+		{ "PF",                  2, "pfm" },
+		{ "Pf",                  2, "pfm" },
+		{ "\x89PNG\r\n\x1A\n",   8, "png" },
+		{ "P6",                  2, "ppm" },
+		{ "qoif",                4, "qoi" }
+	};
+
+	std::string nameExt;
+	for( dword i = 0;  i < dword(sizeof(FORMATS) / sizeof(FORMATS[0]));  ++i )
+	{
+		if( (length >= udword(FORMATS[i].length)) && (0 == ::memcmp( pBytes,
+			FORMATS[i].pMagic, FORMATS[i].length )) )
+		{
+			nameExt = FORMATS[i].pFormatName;
+			break;
+		}
+	}
+
+	return nameExt;
+}
+
+
+bool ImageFormatter::makeImageInFile
+(
+	const char  filePathname[],
+	const dword width,
+	const dword height,
+	const bool  is48Bit,
+	ImageRef&   image
+) const
+{
+	const std::string header( p3tonemapper_format::ppm::makeHeader(
+		width, height, is48Bit ) );
+	const dword channelBytes = is48Bit ? 2 : 1;
+
+	// ppm, and mappable size (else write the usual way)
+	const bool isMade =
+		(std::string("ppm") == getFileNameExtension( filePathname )) &
+		((double(width) * double(height) * double(3 * channelBytes)) < 2e9);
+	if( isMade )
+	{
+		using hxa7241_general::MappedFile;
+
+		MappedFile* pMapping = new MappedFile( filePathname, udword(
+			header.length() ) + (udword(width) * udword(height) *
+			udword(3 * channelBytes)) );
+
+		// write header, and point pixels after it
+		ubyte* pBytes = pMapping->getWritableBytes();
+		header.copy( reinterpret_cast<char*>( pBytes ), header.length() );
+
+		image.set( width, height, 0, 1.0f,
+			is48Bit ? ImageRef::PIXELS_WORD : ImageRef::PIXELS_BYTE,
+			pBytes + header.length() );
+		image.setMapping( pMapping );
+	}
+
+	return isMade;
+}
+
+
+void ImageFormatter::readSharedImage
+(
+	const char   sharedName[],
+	const dword  width,
+	const dword  height,
+	const bool   isHalf,
+	const dword  channelCount,
+	const dword  rowBytes,
+	const udword offset,
+	ImageRef&    image
+) const
+{
+	using hxa7241_general::MappedFile;
+
+	MappedFile* pMapping = new MappedFile( sharedName,
+		MappedFile::SHARED_MEMORY );
+
+	// check the layout is within the segment
+	const dword  pixelStep = channelCount * (isHalf ? 2 : 4);
+	const dword  rowStride = (0 != rowBytes) ? rowBytes : width * pixelStep;
+	const double end = double(offset) + (double(height - 1) *
+		double(rowStride)) + (double(width) * double(pixelStep));
+	if( (width <= 0) | (height <= 0) | (channelCount < 3) |
+		(rowStride < (width * pixelStep)) |
+		(end > double(pMapping->getLength())) )
+	{
+		delete pMapping;
+		throw SHARED_LAYOUT_EXCEPTION_MESSAGE;
+	}
+
+	image.set( width, height, 0, 0.0f,
+		isHalf ? ImageRef::PIXELS_HALF : ImageRef::PIXELS_FLOAT,
+		const_cast<ubyte*>( pMapping->getBytes() ) + offset );
+	image.setLayout( pixelStep, rowStride );
+	image.setMapping( pMapping );
+}
+
+
+void ImageFormatter::makeSharedImage
+(
+	const char  sharedName[],
+	const dword width,
+	const dword height,
+	const bool  is48Bit,
+	ImageRef&   image
+) const
+{
+	using hxa7241_general::MappedFile;
+
+	MappedFile* pMapping = new MappedFile( sharedName, udword(width) *
+		udword(height) * udword(is48Bit ? 6 : 3), MappedFile::SHARED_MEMORY );
+
+	image.set( width, height, 0, 1.0f,
+		is48Bit ? ImageRef::PIXELS_WORD : ImageRef::PIXELS_BYTE,
+		pMapping->getWritableBytes() );
+	image.setMapping( pMapping );
+}
+
+
+ImageRowsWriter* ImageFormatter::makeImageRowsWriter
+(
+	const char   filePathname[],
+	const dword  width,
+	const dword  height,
+	const bool   is48Bit,
+	const float* pPrimaries8
+) const
+{
+	ImageRowsWriter* pWriter = 0;
+
+	// png, with libpng (the other profiles deflate the whole image at once)
+	if( (std::string("png") == getFileNameExtension( filePathname )) &
+		(png::PROFILE_SIZE == pngProfile_m) )
+	{
+		FileRowsWriter* pFileWriter = new FileRowsWriter( filePathname );
+		try
+		{
+			pFileWriter->pWriter_m = ImageFormatter::makeImageRowsWriter(
+				getFileNameExtension( filePathname ).c_str(), width, height,
+				is48Bit, pPrimaries8, pFileWriter->outBytes_m );
+		}
+		catch( ... )
+		{
+			delete pFileWriter;
+			throw;
+		}
+
+		pWriter = pFileWriter;
+	}
+
+	return pWriter;
+}
+
+
+ImageRowsWriter* ImageFormatter::makeImageRowsWriter
+(
+	const char         formatName[],
+	const dword        width,
+	const dword        height,
+	const bool         is48Bit,
+	const float* const pPrimaries8,
+	std::ostream&      outBytes
+) const
+{
+	ImageRowsWriter* pWriter = 0;
+
+	// png, with libpng (the other profiles deflate the whole image at once)
+	if( (std::string("png") == lowerCase( formatName )) &
+		(png::PROFILE_SIZE == pngProfile_m) )
+	{
+		const float gamma         = 0.0f;
+		const dword orderingFlags = png::IS_TOP_FIRST;
+
+		pWriter = p3tonemapper_format::png::makeRowsWriter(
+			pngLibraryPathName_m.c_str(), width, height, pPrimaries8, gamma,
+			is48Bit, orderingFlags, outBytes );
+	}
+
+	return pWriter;
+}
+
+
+dword ImageFormatter::acquireLibraries() const
+{
+	return
+		(png::acquireLibraries( pngLibraryPathName_m.c_str() ) ?
+			LIBRARY_PNG : 0) |
+		(exr::acquireLibraries( exrLibraryPathName_m.c_str() ) ?
+			LIBRARY_EXR : 0);
+}
+
+
+void ImageFormatter::releaseLibraries
+(
+	const dword libraries
+) const
+{
+	if( 0 != (libraries & LIBRARY_PNG) )
+	{
+		png::releaseLibraries();
+	}
+	if( 0 != (libraries & LIBRARY_EXR) )
+	{
+		exr::releaseLibraries();
+	}
+}
+
+
+
+
+/// implementation -------------------------------------------------------------
+std::string getFileNameExtension
+(
+	const char filePathname[]
+)
+{
+	std::string nameExt;
+
+	std::string fpn( filePathname );
+	const size_t extPos = fpn.rfind( '.' );
+	if( std::string::npos != extPos )
+	{
+		nameExt = lowerCase( fpn.substr( extPos + 1 ) );
+	}
+
+	return nameExt;
+}
+
+
+std::string lowerCase
+(
+	const std::string& str
+)
+{
+	std::string lower( str );
+
+	// lower case-ify
+	// (you would think there is a function for this, but, unbelievably, no.)
+	for( dword i = lower.length();  i-- > 0; )
+	{
+		lower[i] = char(::tolower( lower[i] ));
+	}
+
+	return lower;
+}
+
+
+void setImage
+(
+	const dword        width,
+	const dword        height,
+	const float* const pPrimaries8,
+	const float        scalingToGetCdm2,
+	float* const       pRgbTriples,
+	uword* const       pRgbHalfTriples,
+	ImageRef&          image
+)
+{
+	bool isPrimariesSet = false;
+	for( dword i = 8;  i-- > 0; )
+	{
+		isPrimariesSet |= (0.0f != pPrimaries8[i]);
+	}
+
+	// set data to image, adopting pixel storage
+	if( pRgbHalfTriples )
+	{
+		image.set( width, height,
+			isPrimariesSet ? pPrimaries8 : 0, scalingToGetCdm2,
+			image.PIXELS_HALF, pRgbHalfTriples );
+	}
+	else
+	{
+		image.set( width, height,
+			isPrimariesSet ? pPrimaries8 : 0, scalingToGetCdm2,
+			image.PIXELS_FLOAT, pRgbTriples );
+	}
+}
+
+
+bool writeImageStream
+(
+	const std::string& nameExt,
+	const ImageRef&    image,
+	const char         pngLibraryPathName[],
+	const dword        pngProfile,
+	std::ostream&      outBytes
+)
 {
 	// extract image data
 	const dword      width         = image.getWidth();
@@ -227,12 +899,6 @@ void ImageFormatter::writeImage
 	const dword      orderingFlags = 0;
 	const void*const pRgbTriples   = image.getPixels();
 
-	// make out file stream
-	std::ofstream outBytes( filePathname, std::ofstream::binary );
-
-	// get name ext
-	const std::string nameExt( getFileNameExtension( filePathname ) );
-
 	// choose formatter
 	// ppm
 	if( std::string("ppm") == nameExt )
@@ -249,40 +915,393 @@ void ImageFormatter::writeImage
 		const float  gamma       = 0.0f;
 
 		// write image data to stream
-		p3tonemapper_format::png::write( pngLibraryPathName_m.c_str(),
+		p3tonemapper_format::png::write( pngLibraryPathName,
 			width, height, pPrimaries8, gamma,
-			is48Bit, orderingFlags, pRgbTriples, outBytes );
+			is48Bit, orderingFlags, pngProfile, pRgbTriples, outBytes );
+	}
+	// qoi
+	else if( std::string("qoi") == nameExt )
+	{
+		// write image data to stream
+		p3tonemapper_format::qoi::write( width, height, is48Bit, orderingFlags,
+			pRgbTriples, outBytes );
 	}
 	else
 	{
-		throw NO_WRITE_FORMATTER_EXCEPTION_MESSAGE;
+		return false;
 	}
+
+	return true;
 }
 
 
 
 
-/// implementation -------------------------------------------------------------
-std::string getFileNameExtension
+
+
+
+
+/// test -----------------------------------------------------------------------
+#ifdef TESTING
+
+
+#include <stdio.h>
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+
+namespace p3tonemapper_format
+{
+	using namespace hxa7241;
+
+
+bool test_ImageFormatter
 (
-	const char filePathname[]
+	std::ostream* pOut,
+	const bool    isVerbose,
+	const dword   seed
 )
 {
-	std::string nameExt;
+	bool isOk = true;
 
-	std::string fpn( filePathname );
-	const size_t extPos = fpn.rfind( '.' );
-	if( std::string::npos != extPos )
+	if( pOut ) *pOut << "[ test_ImageFormatter ]\n\n";
+
+
+	// image in file, same as written
 	{
-		nameExt = fpn.substr( extPos + 1 );
+		bool isFail = false;
+
+		static const dword WIDTH  = 7;
+		static const dword HEIGHT = 5;
+		static const dword LENGTH = WIDTH * HEIGHT * 3;
+		static const char  PATHNAME[] = "zzztestinfile.ppm";
 
-		// lower case-ify
-		// (you would think there is a function for this, but, unbelievably, no.)
-		for( dword i = nameExt.length();  i-- > 0; )
+		const ImageFormatter formatter;
+
+		for( dword i = 0;  i < 2;  ++i )
 		{
-			nameExt[i] = char(::tolower( nameExt[i] ));
+			const bool is48Bit = (0 != i);
+
+			// make pixels, as mapped into memory: bottom row first, words
+			// native
+			std::vector<uword> pixels( LENGTH );
+			for( dword p = LENGTH;  p-- > 0; )
+			{
+				pixels[p] = uword( (p * 2731) + 17 );
+				pixels[p] = is48Bit ? pixels[p] : uword(pixels[p] & 0xFF);
+			}
+
+			// write the usual way
+			std::ostringstream outWritten( std::ostringstream::binary );
+			if( is48Bit )
+			{
+				ppm::write( WIDTH, HEIGHT, true, 0, &(pixels[0]), outWritten );
+			}
+			else
+			{
+				std::vector<ubyte> bytes( pixels.begin(), pixels.end() );
+				ppm::write( WIDTH, HEIGHT, false, 0, &(bytes[0]), outWritten );
+			}
+
+			// make in file, and map pixels into it: top row first, words
+			// most significant byte first
+			{
+				ImageRef image;
+				const bool isMade = formatter.makeImageInFile( PATHNAME, WIDTH,
+					HEIGHT, is48Bit, image );
+				isFail |= !isMade;
+
+				ubyte* pBytes = static_cast<ubyte*>( image.getPixels() );
+				for( dword y = isMade ? HEIGHT : 0;  y-- > 0; )
+				{
+					for( dword x = WIDTH * 3;  x-- > 0; )
+					{
+						const uword value =
+							pixels[((HEIGHT - 1 - y) * WIDTH * 3) + x];
+						const dword b = (y * WIDTH * 3) + x;
+						if( is48Bit )
+						{
+							pBytes[(b * 2) + 0] = ubyte(value >> 8);
+							pBytes[(b * 2) + 1] = ubyte(value);
+						}
+						else
+						{
+							pBytes[b] = ubyte(value);
+						}
+					}
+				}
+			}
+
+			// compare file with written
+			std::string inFile;
+			{
+				std::ifstream in( PATHNAME, std::ifstream::binary );
+				inFile.assign( std::istreambuf_iterator<char>( in ),
+					std::istreambuf_iterator<char>() );
+			}
+			::remove( PATHNAME );
+
+			isFail |= (outWritten.str() != inFile);
+
+			if( pOut && isVerbose ) *pOut << (is48Bit ? "48" : "24") <<
+				" bit  written " << outWritten.str().length() << "  in file " <<
+				inFile.length() << "\n";
 		}
+
+		// not ppm: not made
+		{
+			ImageRef image;
+			isFail |= formatter.makeImageInFile( "zzztestinfile.png", WIDTH,
+				HEIGHT, false, image );
+		}
+
+		if( pOut && isVerbose ) *pOut << "\n";
+
+		if( pOut ) *pOut << "image in file : " <<
+			(!isFail ? "--- succeeded" : "*** failed") << "\n\n";
+		isOk &= !isFail;
 	}
 
-	return nameExt;
+
+	// format from bytes
+	{
+		bool isFail = false;
+
+		static const struct
+		{
+			const char* pBytes;
+			dword       length;
+			const char* pFormatName;
+		} BYTES[] = {
+			{ "\x76\x2F\x31\x01\x02",           5, "exr" },
+			{ "#?RADIANCE\n",                  11, "hdr" },
+			{ "#?RGBE\n",                       7, "hdr" },
+			{ "PF\n3 2\n",                      7, "pfm" },
+			{ "Pf\n3 2\n",                      7, "pfm" },
+			{ "\x89PNG\r\n\x1A\n\0\0",         10, "png" },
+			{ "P6\n3 2\n",                      7, "ppm" },
+			{ "qoif\0\0",                       6, "qoi" },
+			{ "P5\n3 2\n",                      7, ""    },
+			{ "qoi",                            3, ""    },
+			{ "\x89PNG\r\n\x1A",                7, ""    },
+			{ "",                               0, ""    }
+		};
+
+		for( dword i = dword(sizeof(BYTES) / sizeof(BYTES[0]));  i-- > 0; )
+		{
+			const std::string name( ImageFormatter::getFormatName(
+				reinterpret_cast<const ubyte*>( BYTES[i].pBytes ),
+				udword(BYTES[i].length) ) );
+			isFail |= (std::string(BYTES[i].pFormatName) != name);
+
+			if( pOut && isVerbose ) *pOut << i << " \"" << name << "\"  ";
+		}
+		if( pOut && isVerbose ) *pOut << "\n\n";
+
+		if( pOut ) *pOut << "format from bytes : " <<
+			(!isFail ? "--- succeeded" : "*** failed") << "\n\n";
+		isOk &= !isFail;
+	}
+
+
+	// read from memory, same as from file
+	{
+		bool isFail = false;
+
+		static const dword WIDTH  = 5;
+		static const dword HEIGHT = 3;
+
+		// make flat rgbe, and pfm, files, with random pixels
+		std::string files[2];
+		files[0] = "#?RADIANCE\nFORMAT=32-bit_rle_rgbe\nEXPOSURE=2.0\n\n"
+			"-Y 3 +X 5\n";
+		files[1] = "PF\n5 3\n-1.0\n";
+		{
+			udword random = udword(seed);
+			for( dword i = WIDTH * HEIGHT * 4;  i-- > 0; )
+			{
+				random = (random * 1664525u) + 1013904223u;
+				files[0] += char(ubyte(random >> 24) | ((3 == (i & 3)) ?
+					0x80 : 0));
+			}
+			for( dword i = WIDTH * HEIGHT * 3;  i-- > 0; )
+			{
+				random = (random * 1664525u) + 1013904223u;
+				const float value = float(random >> 8) / 65536.0f;
+				files[1].append( reinterpret_cast<const char*>( &value ),
+					sizeof(float) );
+			}
+		}
+
+		static const char* PATHNAMES[] = { "zzztestmemory.hdr",
+			"zzztestmemory.pfm" };
+
+		const ImageFormatter formatter;
+
+		for( dword f = 0;  f < 2;  ++f )
+		{
+			{
+				std::ofstream out( PATHNAMES[f], std::ofstream::binary );
+				out << files[f];
+			}
+
+			// read from file, and from memory, named and recognized
+			ImageRef fromFile;
+			ImageRef fromMemory[2];
+			try
+			{
+				formatter.readImage( PATHNAMES[f], fromFile );
+				for( dword m = 0;  m < 2;  ++m )
+				{
+					formatter.readImage( reinterpret_cast<const ubyte*>(
+						files[f].data() ), udword(files[f].size()),
+						(0 == m) ? (0 == f ? "hdr" : "pfm") : 0, fromMemory[m],
+						0 );
+				}
+			}
+			catch( ... )
+			{
+				isFail = true;
+			}
+			::remove( PATHNAMES[f] );
+
+			for( dword m = 0;  m < 2;  ++m )
+			{
+				const ImageRef& image = fromMemory[m];
+				dword diffs = 0;
+				if( (fromFile.getWidth()     == image.getWidth())   &
+					(fromFile.getHeight()    == image.getHeight())  &
+					(fromFile.getScaling()   == image.getScaling()) &
+					(fromFile.getPixelType() == image.getPixelType()) &
+					(WIDTH == image.getWidth()) & (HEIGHT == image.getHeight()) &
+					(ImageRef::PIXELS_FLOAT == image.getPixelType()) )
+				{
+					const float* pA = static_cast<const float*>(
+						fromFile.getPixels() );
+					const float* pB = static_cast<const float*>(
+						image.getPixels() );
+					for( dword i = WIDTH * HEIGHT * 3;  i-- > 0; )
+					{
+						diffs += dword(pA[i] != pB[i]);
+					}
+				}
+				else
+				{
+					diffs = 1;
+				}
+				isFail |= (0 != diffs);
+
+				if( pOut && isVerbose ) *pOut << PATHNAMES[f] <<
+					((0 == m) ? "  named" : "  recognized") << "  diffs " <<
+					diffs << "\n";
+			}
+		}
+		if( pOut && isVerbose ) *pOut << "\n";
+
+		if( pOut ) *pOut << "read from memory : " <<
+			(!isFail ? "--- succeeded" : "*** failed") << "\n\n";
+		isOk &= !isFail;
+	}
+
+
+	// write into memory, same as to file
+	{
+		bool isFail = false;
+
+		static const dword WIDTH  = 6;
+		static const dword HEIGHT = 4;
+		static const dword LENGTH = WIDTH * HEIGHT * 3;
+
+		const ImageFormatter formatter;
+
+		static const char* FORMATS[] = { "png", "ppm", "qoi" };
+
+		for( dword i = 0;  i < 2;  ++i )
+		{
+			const bool is48Bit = (0 != i);
+
+			// make image, of random pixels
+			void* pPixels = is48Bit ? static_cast<void*>( new uword[LENGTH] ) :
+				static_cast<void*>( new ubyte[LENGTH] );
+			{
+				udword random = udword(seed);
+				for( dword p = LENGTH;  p-- > 0; )
+				{
+					random = (random * 1664525u) + 1013904223u;
+					if( is48Bit )
+					{
+						static_cast<uword*>( pPixels )[p] = uword(random >> 16);
+					}
+					else
+					{
+						static_cast<ubyte*>( pPixels )[p] = ubyte(random >> 24);
+					}
+				}
+			}
+			const ImageRef image( WIDTH, HEIGHT, 0, 1.0f, is48Bit ?
+				ImageRef::PIXELS_WORD : ImageRef::PIXELS_BYTE, pPixels );
+
+			// (qoi is 8 bit only)
+			for( dword f = is48Bit ? 2 : 3;  f-- > 0; )
+			{
+				const std::string pathname( std::string("zzztestmemory.") +
+					FORMATS[f] );
+
+				// write to file, and into memory (appended to what is there)
+				std::string toFile;
+				std::vector<ubyte> toMemory( 2, ubyte(0xA5) );
+				try
+				{
+					formatter.writeImage( pathname.c_str(), image );
+					{
+						std::ifstream in( pathname.c_str(),
+							std::ifstream::binary );
+						toFile.assign( std::istreambuf_iterator<char>( in ),
+							std::istreambuf_iterator<char>() );
+					}
+
+					formatter.writeImage( FORMATS[f], image, toMemory );
+				}
+				catch( ... )
+				{
+					isFail = true;
+				}
+				::remove( pathname.c_str() );
+
+				const bool isSame = !toFile.empty() &&
+					(toMemory.size() == (toFile.size() + 2)) &&
+					(ubyte(0xA5) == toMemory[0]) && (ubyte(0xA5) == toMemory[1]) &&
+					std::equal( toFile.begin(), toFile.end(),
+						reinterpret_cast<const char*>( &(toMemory[2]) ) );
+				isFail |= !isSame;
+
+				if( pOut && isVerbose ) *pOut << FORMATS[f] <<
+					(is48Bit ? " 48" : " 24") << " bit  file " <<
+					toFile.size() << "  memory " << (toMemory.size() - 2) <<
+					"  " << (isSame ? "same" : "differs") << "\n";
+			}
+		}
+		if( pOut && isVerbose ) *pOut << "\n";
+
+		if( pOut ) *pOut << "write into memory : " <<
+			(!isFail ? "--- succeeded" : "*** failed") << "\n\n";
+		isOk &= !isFail;
+	}
+
+
+	if( pOut ) *pOut << (isOk ? "--- successfully" : "*** failurefully") <<
+		" completed " << "\n\n\n";
+
+	if( pOut ) pOut->flush();
+
+
+	return isOk;
 }
+
+
+}//namespace
+
+
+#endif//TESTING
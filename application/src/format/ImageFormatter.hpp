@@ -32,7 +32,9 @@
 #define ImageFormatter_h
 
 
+#include <iosfwd>
 #include <string>
+#include <vector>
 
 
 
@@ -45,7 +47,9 @@ namespace p3tonemapper_format
 /**
  * A general interface for image file IO.<br/><br/>
  *
- * Supports OpenEXR and Radiance-RGBE to read, and PNG and PPM to write.
+ * Supports OpenEXR, Radiance-RGBE and PFM to read, and PNG, PPM and QOI to
+ * write. Images can also be read from, and written into, memory (except
+ * OpenEXR, which is only read from a file).
  * <br/><br/>
  *
  * @exceptions queries throw char[] messages, all throw allocation exceptions
@@ -68,29 +72,209 @@ public:
 	                                 const char pngLibraryPathName[] );
 	virtual void  setPngLibrary( const char libraryPathName[] );
 	virtual void  setExrLibrary( const char libraryPathName[] );
+	/**
+	 * @profile  png::EProfile value: size (the default), balanced, or speed
+	 */
+	virtual void  setPngProfile( dword profile );
 
 
 /// queries --------------------------------------------------------------------
 	/**
-	 * @filePathname extension must be one of: .exr .rgbe. .pic .hdr .rad
+	 * PFM color pixels are left in place, in a mapping of the file (so are
+	 * read-only).
+	 *
+	 * @filePathname extension must be one of: .exr .rgbe. .pic .hdr .rad .pfm
 	 */
 	virtual void  readImage ( const char filePathname[],
 	                          ImageRef&  image )                           const;
 	/**
-	 * @filePathname extension must be one of: .png .ppm
+	 * Read, giving the header, then the rows as they are decoded, to a
+	 * receiver (eg to analyse the image meanwhile).<br/><br/>
+	 *
+	 * PFM pixels are not decoded, so nothing is given for them.
+	 *
+	 * @pReceiver  (or 0)
+	 */
+	virtual void  readImage ( const char           filePathname[],
+	                          ImageRef&            image,
+	                          ImageDecodeReceiver* pReceiver )             const;
+	/**
+	 * Read from memory (eg an image received by IPC). Pixels are always
+	 * copied out of the bytes, so they need not outlive the image.
+	 * <br/><br/>
+	 *
+	 * @formatName  as a file name extension (eg "hdr"), or 0 or empty to
+	 *              recognize the format from the bytes
+	 * @pReceiver   (or 0)
+	 */
+	virtual void  readImage ( const ubyte*         pBytes,
+	                          udword               length,
+	                          const char           formatName[],
+	                          ImageRef&            image,
+	                          ImageDecodeReceiver* pReceiver )             const;
+	/**
+	 * Read only metadata, if the image can be read in bands by
+	 * readImageRows (currently: tiled OpenEXR).<br/><br/>
+	 *
+	 * @image   set with no pixels, if bandable
+	 * @return  whether bandable
+	 */
+	virtual bool  readImageHeader( const char filePathname[],
+	                               ImageRef&  image )                      const;
+	/**
+	 * Find the smallest stored reduced level (mip level) of a bandable image
+	 * that is still at least the given size.<br/><br/>
+	 *
+	 * @return  level (0 if none, which is the full image)
+	 */
+	virtual dword findImageLevel( const char filePathname[],
+	                              dword      minWidth,
+	                              dword      minHeight,
+	                              dword&     levelWidth,
+	                              dword&     levelHeight )                 const;
+	/**
+	 * Read pixels in bands of rows, as halfs (for a bandable image).
+	 *
+	 * @level  from findImageLevel, or 0 for the full image
+	 */
+	virtual void  readImageRows( const char         filePathname[],
+	                             dword              level,
+	                             ImageRowsReceiver& rowsReceiver )         const;
+	/**
+	 * @filePathname extension must be one of: .png .ppm .qoi (QOI is 8 bit
+	 *               only)
 	 */
 	virtual void  writeImage( const char      filePathname[],
 	                          const ImageRef& image )                      const;
+	/**
+	 * Write into memory (eg an image to send by IPC).
+	 *
+	 * @formatName  as a file name extension: png ppm qoi
+	 * @bytes       appended to (growing as needed)
+	 */
+	virtual void  writeImage( const char          formatName[],
+	                          const ImageRef&     image,
+	                          std::vector<ubyte>& bytes )                  const;
+	/**
+	 * Write to a stream (eg the standard output).
+	 *
+	 * @formatName  as a file name extension: png ppm qoi
+	 */
+	virtual void  writeImage( const char      formatName[],
+	                          const ImageRef& image,
+	                          std::ostream&   outBytes )                   const;
+	/**
+	 * Recognize the format of an image from its first bytes.
+	 *
+	 * @return  name as a file name extension (exr hdr pfm png ppm qoi), or
+	 *          empty if not recognized
+	 */
+	static std::string getFormatName( const ubyte* pBytes,
+	                                  udword       length );
+	/**
+	 * Make an output image inside its file, if the format allows (currently:
+	 * PPM). The file is made full size and mapped, and the image pixels are
+	 * its body: so filling them writes the file, with no writeImage.
+	 * <br/><br/>
+	 *
+	 * Pixels are then top row first, R then G then B, words most significant
+	 * byte first.
+	 *
+	 * @image   set with the pixels and their mapping, if made
+	 * @return  whether made (else write with writeImage)
+	 */
+	virtual bool  makeImageInFile( const char filePathname[],
+	                               dword      width,
+	                               dword      height,
+	                               bool       is48Bit,
+	                               ImageRef&  image )                      const;
+	/**
+	 * Read an image in a shared-memory segment, in place: its pixels are the
+	 * segment's own (read-only), with nothing decoded or copied.<br/><br/>
+	 *
+	 * @isHalf        channels are halfs, else floats
+	 * @channelCount  channels per pixel, R, G and B first (3 or more)
+	 * @rowBytes      bytes from one row to the next (0 for packed)
+	 * @offset        bytes before the first pixel
+	 * @image         set with the pixels, their layout, and the segment
+	 */
+	virtual void  readSharedImage( const char sharedName[],
+	                               dword      width,
+	                               dword      height,
+	                               bool       isHalf,
+	                               dword      channelCount,
+	                               dword      rowBytes,
+	                               udword     offset,
+	                               ImageRef&  image )                      const;
+	/**
+	 * Make an output image in a shared-memory segment (made, or resized, to
+	 * fit): so filling the pixels hands them over, with no writeImage.
+	 * <br/><br/>
+	 *
+	 * Pixels are packed rows, R then G then B, words in native byte order.
+	 *
+	 * @image  set with the pixels and the segment
+	 */
+	virtual void  makeSharedImage( const char sharedName[],
+	                               dword      width,
+	                               dword      height,
+	                               bool       is48Bit,
+	                               ImageRef&  image )                      const;
+	/**
+	 * Make a writer of an output image a band of rows at a time, if the
+	 * format allows (currently: PNG, size profile). Then the whole image is
+	 * never held, and rows can be written as soon as they are made.
+	 * <br/><br/>
+	 *
+	 * Rows are then top row first, R then G then B.
+	 *
+	 * @pPrimaries8  as ImageRef primaries (or 0)
+	 * @return       new writer, owned by the caller, or 0 if not allowed
+	 *               (else write with writeImage)
+	 */
+	virtual ImageRowsWriter* makeImageRowsWriter( const char   filePathname[],
+	                                              dword        width,
+	                                              dword        height,
+	                                              bool         is48Bit,
+	                                              const float* pPrimaries8 )
+	                                                                       const;
+	/**
+	 * Make a writer of an output image a band of rows at a time, to a stream
+	 * (eg the standard output). Otherwise as above.
+	 *
+	 * @formatName  as a file name extension
+	 * @outBytes    must outlive the writer
+	 */
+	virtual ImageRowsWriter* makeImageRowsWriter( const char    formatName[],
+	                                              dword         width,
+	                                              dword         height,
+	                                              bool          is48Bit,
+	                                              const float*  pPrimaries8,
+	                                              std::ostream& outBytes )
+	                                                                       const;
+
+	/**
+	 * Keep the codec libraries loaded, until released (instead of loading
+	 * them for each image). Any that cannot load are left to load for each
+	 * image, as usual.
+	 *
+	 * @return  bit combination of the libraries loaded, to give to release
+	 */
+	virtual dword acquireLibraries()                                       const;
+	virtual void  releaseLibraries( dword libraries )                      const;
 
 
 /// fields ---------------------------------------------------------------------
 private:
 	std::string exrLibraryPathName_m;
 	std::string pngLibraryPathName_m;
+	dword       pngProfile_m;
 
 	static const char NO_READ_FORMATTER_EXCEPTION_MESSAGE[];
 	static const char NO_WRITE_FORMATTER_EXCEPTION_MESSAGE[];
 	static const char FILE_OPEN_EXCEPTION_MESSAGE[];
+	static const char EXR_IN_MEMORY_EXCEPTION_MESSAGE[];
+	static const char SHARED_LAYOUT_EXCEPTION_MESSAGE[];
 };
 
 
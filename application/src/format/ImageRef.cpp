@@ -28,6 +28,8 @@
 --------------------------------------------------------------------*/
 
 
+#include "MappedFile.hpp"
+
 #include "ImageRef.hpp"   // own header is included last
 
 
@@ -38,6 +40,7 @@ using namespace p3tonemapper_format;
 
 /// standard object services ---------------------------------------------------
 ImageRef::ImageRef()
+ :	pMapping_m( 0 )
 {
 	ImageRef::set( 0, 0, 0, 0.0f, PIXELS_FLOAT, 0 );
 }
@@ -48,6 +51,7 @@ ImageRef::ImageRef
 	const ImageRef&  other,
 	const EPixelType pixelType
 )
+ :	pMapping_m( 0 )
 {
 	void*       pPixels = 0;
 	const dword length  = other.width_m * other.height_m;
@@ -62,6 +66,7 @@ ImageRef::ImageRef
 			break;
 
 		case PIXELS_WORD :
+		case PIXELS_HALF :
 			pPixels = new uword[ length * 3 ];
 			break;
 	}
@@ -81,6 +86,7 @@ ImageRef::ImageRef
 	const EPixelType pixelType,
 	void*const       pPixels
 )
+ :	pMapping_m( 0 )
 {
 	ImageRef::set( width, height, pPrimaries8, scaling, pixelType, pPixels );
 }
@@ -88,19 +94,29 @@ ImageRef::ImageRef
 
 ImageRef::~ImageRef()
 {
-	switch( pixelType_m )
+	// pixels in a mapping
+	if( 0 != pMapping_m )
 	{
-		case PIXELS_FLOAT :
-			delete[] static_cast<float*>( pPixels_m );
-			break;
-
-		case PIXELS_BYTE :
-			delete[] static_cast<ubyte*>( pPixels_m );
-			break;
-
-		case PIXELS_WORD :
-			delete[] static_cast<uword*>( pPixels_m );
-			break;
+		delete pMapping_m;
+	}
+	// pixels alone
+	else
+	{
+		switch( pixelType_m )
+		{
+			case PIXELS_FLOAT :
+				delete[] static_cast<float*>( pPixels_m );
+				break;
+
+			case PIXELS_BYTE :
+				delete[] static_cast<ubyte*>( pPixels_m );
+				break;
+
+			case PIXELS_WORD :
+			case PIXELS_HALF :
+				delete[] static_cast<uword*>( pPixels_m );
+				break;
+		}
 	}
 }
 
@@ -155,6 +171,30 @@ void ImageRef::set
 
 	pixelType_m = pixelType;
 	pPixels_m   = pPixels;
+
+	// packed
+	pixelStep_m = 0;
+	rowStride_m = 0;
+}
+
+
+void ImageRef::setMapping
+(
+	hxa7241_general::MappedFile* pMapping
+)
+{
+	pMapping_m = pMapping;
+}
+
+
+void ImageRef::setLayout
+(
+	const dword pixelStep,
+	const dword rowStride
+)
+{
+	pixelStep_m = pixelStep;
+	rowStride_m = rowStride;
 }
 
 
@@ -195,3 +235,29 @@ void* ImageRef::getPixels() const
 {
 	return pPixels_m;
 }
+
+
+bool ImageRef::isMapped() const
+{
+	return 0 != pMapping_m;
+}
+
+
+dword ImageRef::getPixelStep() const
+{
+	static const dword CHANNEL_SIZES[] = { 4, 1, 2, 2 };
+
+	return (0 != pixelStep_m) ? pixelStep_m : 3 * CHANNEL_SIZES[pixelType_m];
+}
+
+
+dword ImageRef::getRowStride() const
+{
+	return (0 != rowStride_m) ? rowStride_m : width_m * getPixelStep();
+}
+
+
+bool ImageRef::isPacked() const
+{
+	return (0 == pixelStep_m) & (0 == rowStride_m);
+}
@@ -34,6 +34,11 @@
 
 
 
+#include "hxa7241_general.hpp"
+
+
+
+
 #include "p3tonemapper_format.hpp"
 namespace p3tonemapper_format
 {
@@ -42,6 +47,9 @@ namespace p3tonemapper_format
 /**
  * A simple adopting image wrapper.<br/><br/>
  *
+ * The pixels may instead be inside an adopted file mapping (then they are
+ * read-only, unless the file was made for output). There they may also be
+ * laid out other than as packed RGB rows (eg RGBA, or padded rows).
  */
 class ImageRef
 {
@@ -50,7 +58,8 @@ public:
 	{
 		PIXELS_FLOAT,
 		PIXELS_BYTE,
-		PIXELS_WORD
+		PIXELS_WORD,
+		PIXELS_HALF
 	};
 
 
@@ -80,6 +89,18 @@ public:
 	                   float        scaling,
 	                   EPixelType   pixelType,
 	                   void*        pPixels );
+	/**
+	 * Adopt the file mapping the pixels are inside (freed with it, instead of
+	 * the pixels).
+	 */
+	        void  setMapping( hxa7241_general::MappedFile* pMapping );
+	/**
+	 * Set the pixels layout: bytes from one pixel to the next in a row, and
+	 * from one row to the next (R, G and B are adjacent within each pixel).
+	 * (set resets it to packed)
+	 */
+	        void  setLayout( dword pixelStep,
+	                         dword rowStride );
 
 
 /// queries --------------------------------------------------------------------
@@ -89,6 +110,10 @@ public:
 	        float        getScaling()                                      const;
 	        EPixelType   getPixelType()                                    const;
 	        void*        getPixels()                                       const;
+	        bool         isMapped()                                        const;
+	        dword        getPixelStep()                                    const;
+	        dword        getRowStride()                                    const;
+	        bool         isPacked()                                        const;
 
 
 /// fields ---------------------------------------------------------------------
@@ -103,6 +128,10 @@ private:
 
 	EPixelType pixelType_m;
 	void*      pPixels_m;
+	dword      pixelStep_m;
+	dword      rowStride_m;
+
+	hxa7241_general::MappedFile* pMapping_m;
 };
 
 
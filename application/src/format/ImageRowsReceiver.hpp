@@ -0,0 +1,75 @@
+/*--------------------------------------------------------------------
+
+   Perceptuum3 rendering components
+   Copyright (c) 2005, Harrison Ainsworth / HXA7241.
+
+   http://www.hxa7241.org/
+
+--------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later
+   version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+   MA  02110-1301  USA
+
+--------------------------------------------------------------------*/
+
+
+
+#ifndef ImageRowsReceiver_h
+#define ImageRowsReceiver_h
+
+
+
+
+#include "p3tonemapper_format.hpp"
+namespace p3tonemapper_format
+{
+
+
+/**
+ * Receiver of an image in bands of rows, as it is read.<br/><br/>
+ *
+ * Bands come in image order, lowest row first. Each band is only valid
+ * during the call.
+ */
+class ImageRowsReceiver
+{
+/// standard object services ---------------------------------------------------
+public:
+	virtual ~ImageRowsReceiver() {}
+
+
+/// commands -------------------------------------------------------------------
+	/**
+	 * @rowCount   number of rows in the band
+	 * @pChannels  first r, g and b half of the band's lowest row
+	 * @pixelStep  bytes from one pixel to the next
+	 * @rowStride  bytes from one row to the next up (may be negative)
+	 */
+	virtual void  receiveRows( dword              rowCount,
+	                           const uword*const* pChannels,
+	                           dword              pixelStep,
+	                           dword              rowStride )                = 0;
+};
+
+
+}//namespace
+
+
+
+
+#endif//ImageRowsReceiver_h
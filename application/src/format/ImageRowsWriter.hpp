@@ -0,0 +1,74 @@
+/*--------------------------------------------------------------------
+
+   Perceptuum3 rendering components
+   Copyright (c) 2005, Harrison Ainsworth / HXA7241.
+
+   http://www.hxa7241.org/
+
+--------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later
+   version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+   MA  02110-1301  USA
+
+--------------------------------------------------------------------*/
+
+
+
+#ifndef ImageRowsWriter_h
+#define ImageRowsWriter_h
+
+
+
+
+#include "p3tonemapper_format.hpp"
+namespace p3tonemapper_format
+{
+
+
+/**
+ * Writer of an image in bands of rows, as they are made.<br/><br/>
+ *
+ * Bands go in file order, top row first. After the last, finish completes
+ * the file.
+ *
+ * @exceptions throws char[] message exceptions
+ */
+class ImageRowsWriter
+{
+/// standard object services ---------------------------------------------------
+public:
+	virtual ~ImageRowsWriter() {}
+
+
+/// commands -------------------------------------------------------------------
+	/**
+	 * @rowCount  number of rows in the band
+	 * @pRows     packed RGB pixels of the band, top row first
+	 */
+	virtual void  writeRows( dword       rowCount,
+	                         const void* pRows )                             = 0;
+	virtual void  finish()                                                   = 0;
+};
+
+
+}//namespace
+
+
+
+
+#endif//ImageRowsWriter_h
@@ -32,8 +32,13 @@
 #include <string>
 
 #include "DynamicLibraryInterface.hpp"
+#include "HalfFloat.hpp"
+#include "Processors.hpp"
+#include "Thread.hpp"
 
 #include "ImfCRgbaFile.h"
+#include "ImageRowsReceiver.hpp"
+#include "ImageDecodeReceiver.hpp"
 
 #include "exr.hpp"   // own header is included last
 
@@ -46,6 +51,8 @@ using namespace p3tonemapper_format;
 /// constants ------------------------------------------------------------------
 static const char OPEN_FILE_EXCEPTION_MESSAGE[] =
 	"EXR open file failed";
+static const char READ_TILE_EXCEPTION_MESSAGE[] =
+	"EXR read tile failed";
 
 static const char LIB_PATHNAME_DEFAULT[] =
 #ifdef _PLATFORM_WIN
@@ -57,13 +64,92 @@ static const char LIB_PATHNAME_DEFAULT[] =
 #endif
 
 
+/// OpenEXR thread count setter names (C++ only), by namespace version
+static const char* SET_THREAD_COUNT_NAMES[] = {
+#ifdef _PLATFORM_WIN
+	"?setGlobalThreadCount@Imf@@YAXH@Z"
+#else
+	"_ZN3Imf20setGlobalThreadCountEi",
+	"_ZN7Imf_2_020setGlobalThreadCountEi",
+	"_ZN7Imf_2_120setGlobalThreadCountEi",
+	"_ZN7Imf_2_220setGlobalThreadCountEi",
+	"_ZN7Imf_2_320setGlobalThreadCountEi",
+	"_ZN7Imf_2_420setGlobalThreadCountEi",
+	"_ZN7Imf_2_520setGlobalThreadCountEi"
+#endif
+};
+
+
+/// library functions, bound when loaded (indexes of FUNCTION_NAMES)
+enum EFunction
+{
+	IMF_OPEN_INPUT_FILE,
+	IMF_CLOSE_INPUT_FILE,
+	IMF_INPUT_HEADER,
+	IMF_HEADER_LINE_ORDER,
+	IMF_HEADER_FLOAT_ATTRIBUTE,
+	IMF_HEADER_DATA_WINDOW,
+	IMF_INPUT_SET_FRAME_BUFFER,
+	IMF_INPUT_READ_PIXELS,
+	IMF_HEADER_COMPRESSION,
+	IMF_ERROR_MESSAGE,
+	IMF_OPEN_TILED_INPUT_FILE,
+	IMF_CLOSE_TILED_INPUT_FILE,
+	IMF_TILED_INPUT_HEADER,
+	IMF_TILED_INPUT_SET_FRAME_BUFFER,
+	IMF_TILED_INPUT_READ_TILE,
+	IMF_TILED_INPUT_TILE_X_SIZE,
+	IMF_TILED_INPUT_TILE_Y_SIZE,
+	IMF_TILED_INPUT_LEVEL_MODE,
+	IMF_TILED_INPUT_LEVEL_ROUNDING_MODE
+};
+
+static const char* const FUNCTION_NAMES[] = {
+	"ImfOpenInputFile",
+	"ImfCloseInputFile",
+	"ImfInputHeader",
+	"ImfHeaderLineOrder",
+	"ImfHeaderFloatAttribute",
+	"ImfHeaderDataWindow",
+	"ImfInputSetFrameBuffer",
+	"ImfInputReadPixels",
+	"ImfHeaderCompression",
+	"ImfErrorMessage",
+	"ImfOpenTiledInputFile",
+	"ImfCloseTiledInputFile",
+	"ImfTiledInputHeader",
+	"ImfTiledInputSetFrameBuffer",
+	"ImfTiledInputReadTile",
+	"ImfTiledInputTileXSize",
+	"ImfTiledInputTileYSize",
+	"ImfTiledInputLevelMode",
+	"ImfTiledInputLevelRoundingMode"
+};
+
+
 /// globals (well, file scope really)
-static void* libraries_g[] = { 0, 0, 0, 0 };
+static hxa7241_general::DynamicLibrary library_g( FUNCTION_NAMES,
+	sizeof(FUNCTION_NAMES) / sizeof(FUNCTION_NAMES[0]) );
 
 
 
 
 /// read sub-procedure declarations --------------------------------------------
+template<class CHANNEL>
+static void readImage
+(
+	const char           exrLibraryPathName[],
+	const char           filePathName[],
+	dword                orderingFlags,
+	dword&               width,
+	dword&               height,
+	float*               pPrimaries8,
+	float&               scalingToGetCdm2,
+	CHANNEL*&            pTriples,
+	ImageDecodeReceiver* pReceiver
+);
+
+
 static void loadLibraries
 (
 	const char exrLibraryPathName[]
@@ -73,25 +159,56 @@ static void loadLibraries
 static void freeLibraries();
 
 
+static void setThreadCount();
+
+
 static void readHeader
 (
-	const ImfInputFile* pExrInFile,
-	dword&              width,
-	dword&              height,
-	bool&               isLowTop,
-	float*              pPrimaries8,
-	float&              scalingToGetCdm2
+	const ImfHeader* pExrHeader,
+	dword&           xMin,
+	dword&           yMin,
+	dword&           width,
+	dword&           height,
+	bool&            isLowTop,
+	float*           pPrimaries8,
+	float&           scalingToGetCdm2
 );
 
 
+static dword getChunkHeight
+(
+	int compression
+);
+
+
+template<class CHANNEL>
 static void readPixels
 (
-	ImfInputFile* pExrInFile,
-	dword         width,
-	dword         height,
-	bool          isLowTop,
-	dword         orderingFlags,
-	float*&       pTriples
+	ImfInputFile*        pExrInFile,
+	dword                xMin,
+	dword                yMin,
+	dword                width,
+	dword                height,
+	bool                 isLowTop,
+	dword                orderingFlags,
+	CHANNEL*&            pTriples,
+	ImageDecodeReceiver* pReceiver
+);
+
+
+static void convertChannels
+(
+	const ImfHalf* pHalfs,
+	dword          count,
+	float*         pChannels
+);
+
+
+static void convertChannels
+(
+	const ImfHalf* pHalfs,
+	dword          count,
+	uword*         pChannels
 );
 
 
@@ -100,14 +217,52 @@ static void readPixels
 /// ----------------------------------------------------------------------------
 void p3tonemapper_format::exr::read
 (
-	const char  exrLibraryPathName[],
-	const char  filePathName[],
-	const dword orderingFlags,
-	dword&      width,
-	dword&      height,
-	float*      pPrimaries8,
-	float&      scalingToGetCdm2,
-	float*&     pTriples
+	const char                 exrLibraryPathName[],
+	const char                 filePathName[],
+	const dword                orderingFlags,
+	dword&                     width,
+	dword&                     height,
+	float*                     pPrimaries8,
+	float&                     scalingToGetCdm2,
+	float*&                    pTriples,
+	ImageDecodeReceiver* const pReceiver
+)
+{
+	readImage( exrLibraryPathName, filePathName, orderingFlags, width, height,
+		pPrimaries8, scalingToGetCdm2, pTriples, pReceiver );
+}
+
+
+void p3tonemapper_format::exr::read
+(
+	const char                 exrLibraryPathName[],
+	const char                 filePathName[],
+	const dword                orderingFlags,
+	dword&                     width,
+	dword&                     height,
+	float*                     pPrimaries8,
+	float&                     scalingToGetCdm2,
+	uword*&                    pHalfTriples,
+	ImageDecodeReceiver* const pReceiver
+)
+{
+	readImage( exrLibraryPathName, filePathName, orderingFlags, width, height,
+		pPrimaries8, scalingToGetCdm2, pHalfTriples, pReceiver );
+}
+
+
+template<class CHANNEL>
+void readImage
+(
+	const char                 exrLibraryPathName[],
+	const char                 filePathName[],
+	const dword                orderingFlags,
+	dword&                     width,
+	dword&                     height,
+	float*                     pPrimaries8,
+	float&                     scalingToGetCdm2,
+	CHANNEL*&                  pTriples,
+	ImageDecodeReceiver* const pReceiver
 )
 {
 	loadLibraries( exrLibraryPathName );
@@ -126,13 +281,21 @@ void p3tonemapper_format::exr::read
 		}
 
 		// read header
-		bool isLowTop = true;
-		readHeader( pExrInFile, width, height, isLowTop,
-			pPrimaries8, scalingToGetCdm2 );
+		dword xMin     = 0;
+		dword yMin     = 0;
+		bool  isLowTop = true;
+		readHeader( ::ImfInputHeader( pExrInFile ), xMin, yMin, width, height,
+			isLowTop, pPrimaries8, scalingToGetCdm2 );
+		if( pReceiver )
+		{
+			// (halfs are kept as words)
+			pReceiver->receiveHeader( width, height, pPrimaries8,
+				scalingToGetCdm2, sizeof(CHANNEL) != sizeof(float) );
+		}
 
 		// read pixels
-		readPixels( pExrInFile, width, height, isLowTop, orderingFlags,
-			pTriples );
+		readPixels( pExrInFile, xMin, yMin, width, height, isLowTop,
+			orderingFlags, pTriples, pReceiver );
 
 		// close file
 		::ImfCloseInputFile( pExrInFile );
@@ -165,9 +328,10 @@ void loadLibraries
 		pExrLibraryPathName = LIB_PATHNAME_DEFAULT;
 	}
 
+	std::vector<std::string> supportPathNames;
+
 #ifdef _PLATFORM_LINUX
 	// some auxiliary ILM libs must be explicitly loaded too...
-	try
 	{
 		// analyse lib pathname
 		std::string path;
@@ -190,50 +354,70 @@ void loadLibraries
 			version = name.substr( versionPos );
 		}
 
-		// load auxiliary library set
-		// (load in this order, store handles in reverse order)
+		// auxiliary library set
+		// (load in this order)
 		static const char* SUPPORT_LIBS[] = {
 			"libIex.so", "libHalf.so" };//, "libImath.so" };
 		for( dword i = 0;  i < 2;  ++i )
 		{
-			const std::string libPathName( path + SUPPORT_LIBS[i] + version );
-			hxa7241_general::loadLibrary(
-				libPathName.c_str(), libraries_g[3 - i] );
+			supportPathNames.push_back( path + SUPPORT_LIBS[i] + version );
 		}
 	}
-	catch( ... )
-	{
-		freeLibraries();
-		throw;
-	}
 #endif
 
-	hxa7241_general::loadLibrary( pExrLibraryPathName, libraries_g[0] );
+	// load and bind, if not already by another reader
+	if( library_g.acquire( pExrLibraryPathName, supportPathNames ) )
+	{
+		setThreadCount();
+	}
 }
 
 
 void freeLibraries()
 {
-	// free in array forwards order
-	for( udword i = 0;  i < sizeof(libraries_g)/sizeof(libraries_g[0]);  ++i )
+	library_g.release();
+}
+
+
+void setThreadCount()
+{
+	// optional: only in thread-capable library versions, and only by
+	// C++ name
+	for( udword i = 0;  i < sizeof(SET_THREAD_COUNT_NAMES) /
+		sizeof(SET_THREAD_COUNT_NAMES[0]);  ++i )
 	{
-		hxa7241_general::freeLibrary( libraries_g[i] );
+		try
+		{
+			typedef void (*PFunction)( int );
+
+			PFunction function = reinterpret_cast<PFunction>(
+				library_g.getFunction( SET_THREAD_COUNT_NAMES[i] ) );
+
+			(function)( hxa7241_general::getProcessorCount() );
+
+			break;
+		}
+		catch( ... )
+		{
+			// not this version
+		}
 	}
 }
 
 
 void readHeader
 (
-	const ImfInputFile* pExrInFile,
-	dword&              width,
-	dword&              height,
-	bool&               isLowTop,
-	float*              pPrimaries8,
-	float&              scalingToGetCdm2
+	const ImfHeader* pExrHeader,
+	dword&           xMinOut,
+	dword&           yMinOut,
+	dword&           width,
+	dword&           height,
+	bool&            isLowTop,
+	float*           pPrimaries8,
+	float&           scalingToGetCdm2
 )
 {
-	// get header
-	const ImfHeader* pExrHeader = ::ImfInputHeader( pExrInFile );
+	// check header
 	if( 0 == pExrHeader )
 	{
 		//const char* ::ImfErrorMessage();
@@ -247,6 +431,8 @@ void readHeader
 		int yMin;
 		int yMax;
 		::ImfHeaderDataWindow( pExrHeader, &xMin, &yMin, &xMax, &yMax );
+		xMinOut = xMin;
+		yMinOut = yMin;
 		width  = xMax - xMin + 1;
 		height = yMax - yMin + 1;
 
@@ -287,46 +473,549 @@ void readHeader
 }
 
 
+dword getChunkHeight
+(
+	const int compression
+)
+{
+	// scanlines per compressed chunk, for each compression type
+	static const dword CHUNK_HEIGHTS[] = {
+		1, 1, 1, 16, 32, 16, 32, 32, 32, 256 };
+
+	return (compression >= 0) && (udword(compression) <
+		sizeof(CHUNK_HEIGHTS) / sizeof(CHUNK_HEIGHTS[0])) ?
+		CHUNK_HEIGHTS[compression] : 16;
+}
+
+
+template<class CHANNEL>
 void readPixels
 (
-	ImfInputFile* pExrInFile,
-	const dword   width,
-	const dword   height,
-	const bool    isLowTop,
-	const dword   orderingFlags,
-	float*&       pTriples
+	ImfInputFile*              pExrInFile,
+	const dword                xMin,
+	const dword                yMin,
+	const dword                width,
+	const dword                height,
+	const bool                 isLowTop,
+	const dword                orderingFlags,
+	CHANNEL*&                  pTriples,
+	ImageDecodeReceiver* const pReceiver
+)
+{
+	// read whole compression chunks at a time, so each is decoded once, and
+	// the library threads can decode them together
+	const dword blockHeight = getChunkHeight( ::ImfHeaderCompression(
+		::ImfInputHeader( pExrInFile ) ) );
+
+	const bool isFlipped = ((orderingFlags & exr::IS_LOW_TOP) != 0) ^ isLowTop;
+	const bool isBgr     = (orderingFlags & exr::IS_BGR) != 0;
+
+	// allocate storage and buffers
+	pTriples = new CHANNEL[ width * height * 3 ];
+	std::vector<ImfRgba> exrBlock( width * blockHeight );
+	std::vector<ImfHalf> halfLine( width * 3 );
+
+	// step thru blocks of rows
+	// (when giving rows, in image order, lowest first: so last block first,
+	// if flipped)
+	const dword blockCount = (height + blockHeight - 1) / blockHeight;
+	const bool  isBackward = (0 != pReceiver) & isFlipped;
+	for( dword b = 0;  b < blockCount;  ++b )
+	{
+		const dword y0   = (isBackward ? (blockCount - 1) - b : b) * blockHeight;
+		const dword rows = (height - y0) < blockHeight ?
+			(height - y0) : blockHeight;
+
+		// read into block buffer
+		// (frame buffer base is at the data window origin, so offset back)
+		::ImfInputSetFrameBuffer( pExrInFile, &(exrBlock[0]) - xMin -
+			((yMin + y0) * width), 1, width );
+		::ImfInputReadPixels( pExrInFile, yMin + y0, yMin + y0 + rows - 1 );
+
+		// step thru rows of block
+		for( dword r = 0;  r < rows;  ++r )
+		{
+			const ImfRgba* pExrLine = &(exrBlock[r * width]);
+
+			// pick channels
+			for( dword x = 0;  x < width;  ++x )
+			{
+				halfLine[(x * 3) + 0] = isBgr ? pExrLine[x].b : pExrLine[x].r;
+				halfLine[(x * 3) + 1] = pExrLine[x].g;
+				halfLine[(x * 3) + 2] = isBgr ? pExrLine[x].r : pExrLine[x].b;
+			}
+
+			// convert channels into place
+			const dword y   = y0 + r;
+			const dword row = isFlipped ? height - y - 1 : y;
+			convertChannels( &(halfLine[0]), width * 3,
+				pTriples + (row * width * 3) );
+		}
+
+		// give rows of block
+		if( pReceiver )
+		{
+			const dword rowFirst = isFlipped ? height - (y0 + rows) : y0;
+			pReceiver->receiveRows( rows, pTriples + (rowFirst * width * 3) );
+		}
+	}
+}
+
+
+void convertChannels
+(
+	const ImfHalf* pHalfs,
+	const dword    count,
+	float*         pChannels
 )
 {
-	// allocate storage and buffer
-	pTriples = new float[ width * height * 3 ];
-	std::vector<ImfRgba> exrLine( width );
+	hxa7241_general::halfsToFloats( pHalfs, count, pChannels );
+}
+
 
-	// step thru rows
-	for( dword y = 0;  y < height;  ++y )
+void convertChannels
+(
+	const ImfHalf* pHalfs,
+	const dword    count,
+	uword*         pChannels
+)
+{
+	// keep as half
+	for( dword i = count;  i-- > 0; )
 	{
-		// read into line buffer (subtracting from pointer? wtf???)
-		::ImfInputSetFrameBuffer(
-			pExrInFile, &(exrLine[0]) - (y * width), 1, width );
-		::ImfInputReadPixels( pExrInFile, y, y );
+		pChannels[i] = pHalfs[i];
+	}
+}
 
-		const dword row = ((orderingFlags & exr::IS_LOW_TOP) != 0) ^ isLowTop ?
-			height - y - 1 : y;
-		float* pPixel = pTriples + (row * width * 3);
 
-		// step thru pixels
-		for( dword x = 0;  x < width;  ++x )
+
+
+/// tiled read -----------------------------------------------------------------
+namespace
+{
+
+/**
+ * Decodes every step-th tile of a row of tiles, through its own file handle.
+ */
+class TileBandDecoder : public hxa7241_general::Thread
+{
+public:
+	TileBandDecoder()
+	 :	pExrInFile_m( 0 )
+	 ,	level_m     ( 0 )
+	 ,	tileFirst_m ( 0 )
+	 ,	tileStep_m  ( 1 )
+	 ,	tilesX_m    ( 0 )
+	 ,	tileY_m     ( 0 )
+	{
+	}
+
+	void set
+	(
+		ImfTiledInputFile* pExrInFile,
+		const dword        level,
+		const dword        tileFirst,
+		const dword        tileStep,
+		const dword        tilesX
+	)
+	{
+		pExrInFile_m = pExrInFile;
+		level_m      = level;
+		tileFirst_m  = tileFirst;
+		tileStep_m   = tileStep;
+		tilesX_m     = tilesX;
+	}
+
+	void setBand
+	(
+		const dword tileY
+	)
+	{
+		tileY_m = tileY;
+	}
+
+	void decode()
+	{
+		for( dword x = tileFirst_m;  x < tilesX_m;  x += tileStep_m )
+		{
+			if( 0 == ::ImfTiledInputReadTile( pExrInFile_m, x, tileY_m,
+				level_m, level_m ) )
+			{
+				throw READ_TILE_EXCEPTION_MESSAGE;
+			}
+		}
+	}
+
+protected:
+	virtual void run()
+	{
+		decode();
+	}
+
+private:
+	ImfTiledInputFile* pExrInFile_m;
+	dword              level_m;
+	dword              tileFirst_m;
+	dword              tileStep_m;
+	dword              tilesX_m;
+	dword              tileY_m;
+};
+
+}
+
+
+static void decodeBand
+(
+	TileBandDecoder* pDecoders,
+	const dword      decoderCount,
+	const dword      tileY
+)
+{
+	const char* pFailMessage = 0;
+
+	// run all but the first on other threads, and the first on this one
+	dword started = 1;
+	try
+	{
+		for( ;  started < decoderCount;  ++started )
+		{
+			pDecoders[started].setBand( tileY );
+			pDecoders[started].start();
+		}
+
+		pDecoders[0].setBand( tileY );
+		pDecoders[0].decode();
+	}
+	catch( const char*const pMessage )
+	{
+		pFailMessage = pMessage;
+	}
+	catch( ... )
+	{
+		pFailMessage = READ_TILE_EXCEPTION_MESSAGE;
+	}
+
+	// wait for all started
+	for( dword i = 1;  i < started;  ++i )
+	{
+		try
+		{
+			pDecoders[i].join();
+		}
+		catch( const char*const pMessage )
+		{
+			pFailMessage = pMessage;
+		}
+	}
+
+	if( 0 != pFailMessage )
+	{
+		throw pFailMessage;
+	}
+}
+
+
+/**
+ * Size of a dimension at a mip/rip level, as OpenEXR makes it.
+ */
+static dword getLevelSize
+(
+	const dword size,
+	const dword level,
+	const bool  isRoundUp
+)
+{
+	dword levelSize = size >> level;
+	if( isRoundUp && ((levelSize << level) < size) )
+	{
+		++levelSize;
+	}
+
+	return (levelSize > 1) ? levelSize : 1;
+}
+
+
+bool p3tonemapper_format::exr::readTiledHeader
+(
+	const char exrLibraryPathName[],
+	const char filePathName[],
+	dword&     width,
+	dword&     height,
+	float*     pPrimaries8,
+	float&     scalingToGetCdm2
+)
+{
+	loadLibraries( exrLibraryPathName );
+
+	ImfTiledInputFile* pExrInFile = 0;
+
+	try
+	{
+		// open file (fails if not tiled)
+		pExrInFile = ::ImfOpenTiledInputFile( filePathName );
+		if( 0 != pExrInFile )
+		{
+			// read header
+			dword xMin     = 0;
+			dword yMin     = 0;
+			bool  isLowTop = true;
+			readHeader( ::ImfTiledInputHeader( pExrInFile ), xMin, yMin,
+				width, height, isLowTop, pPrimaries8, scalingToGetCdm2 );
+
+			::ImfCloseTiledInputFile( pExrInFile );
+		}
+
+		freeLibraries();
+	}
+	catch( ... )
+	{
+		if( 0 != pExrInFile )
+		{
+			::ImfCloseTiledInputFile( pExrInFile );
+		}
+
+		freeLibraries();
+
+		throw;
+	}
+
+	return 0 != pExrInFile;
+}
+
+
+dword p3tonemapper_format::exr::findTiledLevel
+(
+	const char  exrLibraryPathName[],
+	const char  filePathName[],
+	const dword minWidth,
+	const dword minHeight,
+	dword&      levelWidth,
+	dword&      levelHeight
+)
+{
+	loadLibraries( exrLibraryPathName );
+
+	ImfTiledInputFile* pExrInFile = 0;
+	dword              level      = 0;
+
+	try
+	{
+		// open file
+		pExrInFile = ::ImfOpenTiledInputFile( filePathName );
+		if( 0 == pExrInFile )
 		{
-			ImfHalf rgb[3] = { exrLine[x].r, exrLine[x].g, exrLine[x].b };
+			throw OPEN_FILE_EXCEPTION_MESSAGE;
+		}
 
-			// convert channels
-			for( dword c = 0;  c < 3;  ++c )
+		// read header
+		dword width  = 0;
+		dword height = 0;
+		{
+			dword xMin     = 0;
+			dword yMin     = 0;
+			bool  isLowTop = true;
+			float primaries[8];
+			float scalingToGetCdm2 = 0.0f;
+			readHeader( ::ImfTiledInputHeader( pExrInFile ), xMin, yMin,
+				width, height, isLowTop, primaries, scalingToGetCdm2 );
+		}
+		levelWidth  = width;
+		levelHeight = height;
+
+		// step down levels while both dimensions stay big enough
+		// (mip levels end when the larger dimension is 1, rip levels (the
+		// diagonal of them) when the smaller is)
+		const int levelMode = ::ImfTiledInputLevelMode( pExrInFile );
+		if( IMF_ONE_LEVEL != levelMode )
+		{
+			const bool isRoundUp = IMF_ROUND_UP ==
+				::ImfTiledInputLevelRoundingMode( pExrInFile );
+			const dword larger  = (width > height) ? width  : height;
+			const dword smaller = (width > height) ? height : width;
+			const dword span    = (IMF_MIPMAP_LEVELS == levelMode) ?
+				larger : smaller;
+
+			for( dword l = 1;  getLevelSize( span, l - 1, isRoundUp ) > 1;  ++l )
 			{
-				const dword i = ((orderingFlags & exr::IS_BGR) != 0) ? 2 - c : c;
-				pPixel[x * 3 + c] = ::ImfHalfToFloat( rgb[ i ] );
-				//*(pPixel++) = ::ImfHalfToFloat( rgb[ i ] );
+				const dword w = getLevelSize( width,  l, isRoundUp );
+				const dword h = getLevelSize( height, l, isRoundUp );
+				if( (w < minWidth) | (h < minHeight) )
+				{
+					break;
+				}
+
+				level       = l;
+				levelWidth  = w;
+				levelHeight = h;
 			}
 		}
+
+		::ImfCloseTiledInputFile( pExrInFile );
+		freeLibraries();
 	}
+	catch( ... )
+	{
+		if( 0 != pExrInFile )
+		{
+			::ImfCloseTiledInputFile( pExrInFile );
+		}
+
+		freeLibraries();
+
+		throw;
+	}
+
+	return level;
+}
+
+
+void p3tonemapper_format::exr::readTiled
+(
+	const char         exrLibraryPathName[],
+	const char         filePathName[],
+	const dword        level,
+	ImageRowsReceiver& rowsReceiver
+)
+{
+	loadLibraries( exrLibraryPathName );
+
+	// a file handle and decoder per thread
+	std::vector<ImfTiledInputFile*> exrInFiles;
+	TileBandDecoder*                pDecoders = 0;
+
+	try
+	{
+		// open file
+		exrInFiles.push_back( ::ImfOpenTiledInputFile( filePathName ) );
+		if( 0 == exrInFiles[0] )
+		{
+			throw OPEN_FILE_EXCEPTION_MESSAGE;
+		}
+
+		// read header and tiling
+		dword xMin   = 0;
+		dword yMin   = 0;
+		dword width  = 0;
+		dword height = 0;
+		{
+			bool  isLowTop = true;
+			float primaries[8];
+			float scalingToGetCdm2 = 0.0f;
+			readHeader( ::ImfTiledInputHeader( exrInFiles[0] ), xMin, yMin,
+				width, height, isLowTop, primaries, scalingToGetCdm2 );
+		}
+		// (a level keeps the data window origin, only its size shrinks)
+		if( 0 != level )
+		{
+			const bool isRoundUp = IMF_ROUND_UP ==
+				::ImfTiledInputLevelRoundingMode( exrInFiles[0] );
+			width  = getLevelSize( width,  level, isRoundUp );
+			height = getLevelSize( height, level, isRoundUp );
+		}
+		const dword tileWidth  = ::ImfTiledInputTileXSize( exrInFiles[0] );
+		const dword tileHeight = ::ImfTiledInputTileYSize( exrInFiles[0] );
+		const dword tilesX     = (width  + tileWidth  - 1) / tileWidth;
+		const dword tilesY     = (height + tileHeight - 1) / tileHeight;
+
+		// open more, for the other threads
+		const dword processorCount = hxa7241_general::getProcessorCount();
+		const dword decoderCount   = (tilesX < processorCount) ?
+			(tilesX > 1 ? tilesX : 1) : processorCount;
+		while( dword(exrInFiles.size()) < decoderCount )
+		{
+			exrInFiles.push_back( ::ImfOpenTiledInputFile( filePathName ) );
+			if( 0 == exrInFiles.back() )
+			{
+				throw OPEN_FILE_EXCEPTION_MESSAGE;
+			}
+		}
+
+		pDecoders = new TileBandDecoder[ decoderCount ];
+		for( dword i = 0;  i < decoderCount;  ++i )
+		{
+			pDecoders[i].set( exrInFiles[i], level, i, decoderCount, tilesX );
+		}
+
+		// allocate band buffer
+		std::vector<ImfRgba> band( width * tileHeight );
+
+		// step thru bands, lowest first (data window y is downward)
+		for( dword ty = tilesY;  ty-- > 0; )
+		{
+			const dword bandTop  = ty * tileHeight;
+			const dword rowCount = (height - bandTop) < tileHeight ?
+				(height - bandTop) : tileHeight;
+
+			// set frame buffers to band
+			// (frame buffer base is at the data window origin, so offset back)
+			ImfRgba* pBase = &(band[0]) - xMin - ((yMin + bandTop) * width);
+			for( dword i = 0;  i < decoderCount;  ++i )
+			{
+				::ImfTiledInputSetFrameBuffer( exrInFiles[i], pBase, 1, width );
+			}
+
+			decodeBand( pDecoders, decoderCount, ty );
+
+			// give band, from its lowest row, upward
+			const ImfRgba* pLowest = &(band[(rowCount - 1) * width]);
+			const uword* channels[3] = {
+				&(pLowest->r), &(pLowest->g), &(pLowest->b) };
+			rowsReceiver.receiveRows( rowCount, channels, sizeof(ImfRgba),
+				-dword(sizeof(ImfRgba) * width) );
+		}
+	}
+	catch( ... )
+	{
+		delete[] pDecoders;
+		for( udword i = 0;  i < exrInFiles.size();  ++i )
+		{
+			if( 0 != exrInFiles[i] )
+			{
+				::ImfCloseTiledInputFile( exrInFiles[i] );
+			}
+		}
+
+		freeLibraries();
+
+		throw;
+	}
+
+	delete[] pDecoders;
+	for( udword i = 0;  i < exrInFiles.size();  ++i )
+	{
+		::ImfCloseTiledInputFile( exrInFiles[i] );
+	}
+
+	freeLibraries();
+}
+
+
+
+
+/// library holding ------------------------------------------------------------
+bool p3tonemapper_format::exr::acquireLibraries
+(
+	const char exrLibraryPathName[]
+)
+{
+	bool isLoaded = false;
+	try
+	{
+		loadLibraries( exrLibraryPathName );
+		isLoaded = true;
+	}
+	catch( ... )
+	{
+		// leave unloaded
+	}
+
+	return isLoaded;
+}
+
+
+void p3tonemapper_format::exr::releaseLibraries()
+{
+	freeLibraries();
 }
 
 
@@ -343,7 +1032,7 @@ ImfInputFile* ImfOpenInputFile
 	);
 
 	PFunction function = reinterpret_cast<PFunction>(
-		hxa7241_general::getFunction( libraries_g[0], "ImfOpenInputFile" ) );
+		library_g.getFunction( IMF_OPEN_INPUT_FILE ) );
 
 	return (function)(
 		name
@@ -361,7 +1050,7 @@ int ImfCloseInputFile
 	);
 
 	PFunction function = reinterpret_cast<PFunction>(
-		hxa7241_general::getFunction( libraries_g[0], "ImfCloseInputFile" ) );
+		library_g.getFunction( IMF_CLOSE_INPUT_FILE ) );
 
 	return (function)(
 		pIn
@@ -379,7 +1068,7 @@ const ImfHeader* ImfInputHeader
 	);
 
 	PFunction function = reinterpret_cast<PFunction>(
-		hxa7241_general::getFunction( libraries_g[0], "ImfInputHeader" ) );
+		library_g.getFunction( IMF_INPUT_HEADER ) );
 
 	return (function)(
 		pIn
@@ -397,7 +1086,7 @@ int ImfHeaderLineOrder
 	);
 
 	PFunction function = reinterpret_cast<PFunction>(
-		hxa7241_general::getFunction( libraries_g[0], "ImfHeaderLineOrder" ) );
+		library_g.getFunction( IMF_HEADER_LINE_ORDER ) );
 
 	return (function)(
 		pHdr
@@ -419,7 +1108,7 @@ int ImfHeaderFloatAttribute
 	);
 
 	PFunction function = reinterpret_cast<PFunction>(
-		hxa7241_general::getFunction( libraries_g[0], "ImfHeaderFloatAttribute" ) );
+		library_g.getFunction( IMF_HEADER_FLOAT_ATTRIBUTE ) );
 
 	return (function)(
 		pHdr,
@@ -447,7 +1136,7 @@ void ImfHeaderDataWindow
 	);
 
 	PFunction function = reinterpret_cast<PFunction>(
-		hxa7241_general::getFunction( libraries_g[0], "ImfHeaderDataWindow" ) );
+		library_g.getFunction( IMF_HEADER_DATA_WINDOW ) );
 
 	(function)(
 		pHdr,
@@ -475,7 +1164,7 @@ int ImfInputSetFrameBuffer
 	);
 
 	PFunction function = reinterpret_cast<PFunction>(
-		hxa7241_general::getFunction( libraries_g[0], "ImfInputSetFrameBuffer" ) );
+		library_g.getFunction( IMF_INPUT_SET_FRAME_BUFFER ) );
 
 	return (function)(
 		pIn,
@@ -500,7 +1189,7 @@ int ImfInputReadPixels
 	);
 
 	PFunction function = reinterpret_cast<PFunction>(
-		hxa7241_general::getFunction( libraries_g[0], "ImfInputReadPixels" ) );
+		library_g.getFunction( IMF_INPUT_READ_PIXELS ) );
 
 	return (function)(
 		pIn,
@@ -510,20 +1199,203 @@ int ImfInputReadPixels
 }
 
 
-float ImfHalfToFloat
+int ImfHeaderCompression
+(
+	const ImfHeader* pHdr
+)
+{
+	typedef int (*PFunction)(
+		const ImfHeader*
+	);
+
+	PFunction function = reinterpret_cast<PFunction>(
+		library_g.getFunction( IMF_HEADER_COMPRESSION ) );
+
+	return (function)(
+		pHdr
+	);
+}
+
+
+ImfTiledInputFile* ImfOpenTiledInputFile
+(
+	const char name[]
+)
+{
+	typedef ImfTiledInputFile* (*PFunction)(
+		const char[]
+	);
+
+	PFunction function = reinterpret_cast<PFunction>(
+		library_g.getFunction( IMF_OPEN_TILED_INPUT_FILE ) );
+
+	return (function)(
+		name
+	);
+}
+
+
+int ImfCloseTiledInputFile
+(
+	ImfTiledInputFile* pIn
+)
+{
+	typedef int (*PFunction)(
+		ImfTiledInputFile*
+	);
+
+	PFunction function = reinterpret_cast<PFunction>(
+		library_g.getFunction( IMF_CLOSE_TILED_INPUT_FILE ) );
+
+	return (function)(
+		pIn
+	);
+}
+
+
+const ImfHeader* ImfTiledInputHeader
+(
+	const ImfTiledInputFile* pIn
+)
+{
+	typedef const ImfHeader* (*PFunction)(
+		const ImfTiledInputFile*
+	);
+
+	PFunction function = reinterpret_cast<PFunction>(
+		library_g.getFunction( IMF_TILED_INPUT_HEADER ) );
+
+	return (function)(
+		pIn
+	);
+}
+
+
+int ImfTiledInputSetFrameBuffer
+(
+	ImfTiledInputFile* pIn,
+	ImfRgba*           pBase,
+	size_t             xStride,
+	size_t             yStride
+)
+{
+	typedef int (*PFunction)(
+		ImfTiledInputFile*,
+		ImfRgba*,
+		size_t,
+		size_t
+	);
+
+	PFunction function = reinterpret_cast<PFunction>(
+		library_g.getFunction( IMF_TILED_INPUT_SET_FRAME_BUFFER ) );
+
+	return (function)(
+		pIn,
+		pBase,
+		xStride,
+		yStride
+	);
+}
+
+
+int ImfTiledInputReadTile
+(
+	ImfTiledInputFile* pIn,
+	int                dx,
+	int                dy,
+	int                lx,
+	int                ly
+)
+{
+	typedef int (*PFunction)(
+		ImfTiledInputFile*,
+		int,
+		int,
+		int,
+		int
+	);
+
+	PFunction function = reinterpret_cast<PFunction>(
+		library_g.getFunction( IMF_TILED_INPUT_READ_TILE ) );
+
+	return (function)(
+		pIn,
+		dx,
+		dy,
+		lx,
+		ly
+	);
+}
+
+
+int ImfTiledInputTileXSize
+(
+	const ImfTiledInputFile* pIn
+)
+{
+	typedef int (*PFunction)(
+		const ImfTiledInputFile*
+	);
+
+	PFunction function = reinterpret_cast<PFunction>(
+		library_g.getFunction( IMF_TILED_INPUT_TILE_X_SIZE ) );
+
+	return (function)(
+		pIn
+	);
+}
+
+
+int ImfTiledInputTileYSize
+(
+	const ImfTiledInputFile* pIn
+)
+{
+	typedef int (*PFunction)(
+		const ImfTiledInputFile*
+	);
+
+	PFunction function = reinterpret_cast<PFunction>(
+		library_g.getFunction( IMF_TILED_INPUT_TILE_Y_SIZE ) );
+
+	return (function)(
+		pIn
+	);
+}
+
+
+int ImfTiledInputLevelMode
 (
-	ImfHalf h
+	const ImfTiledInputFile* pIn
 )
 {
-	typedef float (*PFunction)(
-		ImfHalf
+	typedef int (*PFunction)(
+		const ImfTiledInputFile*
 	);
 
 	PFunction function = reinterpret_cast<PFunction>(
-		hxa7241_general::getFunction( libraries_g[0], "ImfHalfToFloat" ) );
+		library_g.getFunction( IMF_TILED_INPUT_LEVEL_MODE ) );
 
 	return (function)(
-		h
+		pIn
+	);
+}
+
+
+int ImfTiledInputLevelRoundingMode
+(
+	const ImfTiledInputFile* pIn
+)
+{
+	typedef int (*PFunction)(
+		const ImfTiledInputFile*
+	);
+
+	PFunction function = reinterpret_cast<PFunction>(
+		library_g.getFunction( IMF_TILED_INPUT_LEVEL_ROUNDING_MODE ) );
+
+	return (function)(
+		pIn
 	);
 }
 
@@ -533,7 +1405,7 @@ const char* ImfErrorMessage()
 	typedef const char* (*PFunction)();
 
 	PFunction function = reinterpret_cast<PFunction>(
-		hxa7241_general::getFunction( libraries_g[0], "ImfErrorMessage" ) );
+		library_g.getFunction( IMF_ERROR_MESSAGE ) );
 
 	return (function)();
 }
@@ -594,7 +1466,8 @@ bool test_exr
 				height,
 				pPrimaries8,
 				scalingToGetCdm2,
-				pTriples
+				pTriples,
+				0
 			);
 
 			if( pOut && isVerbose ) *pOut << "width " << width << "\n";
@@ -654,7 +1527,7 @@ bool test_exr
 				p3tonemapper_format::png::write(
 					"",
 					width, height,
-					pPrimaries8, 0.0f, false, 0,
+					pPrimaries8, 0.0f, false, 0, png::PROFILE_SIZE,
 					&(pixels[0]), outf );
 
 				if( pOut && isVerbose ) *pOut << "wrote image to zzztest.png" <<
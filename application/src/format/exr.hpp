@@ -65,22 +65,114 @@ namespace exr
 	 *               { rx, ry, gx, gy, bx, by, wx, wy }.
 	 *               all 0 if not present.
 	 * @scalingToGetCdm2   scaling needed to make cd/m^2, 0 if not present
+	 * @pReceiver          given the header, then the rows as they are decoded
+	 *                     (or 0)
 	 *
 	 * @exceptions throws allocation and char[] message exceptions
 	 */
 	void  read
+	(
+		const char           exrLibraryPathName[],
+		const char           filePathName[],
+		dword                orderingFlags,
+		dword&               width,
+		dword&               height,
+		float*               pPrimaries8,
+		float&               scalingToGetCdm2,
+		float*&              pTriples,
+		ImageDecodeReceiver* pReceiver
+	);
+
+
+	/**
+	 * Read EXR image, leaving pixels as halfs (16-bit floats).<br/><br/>
+	 *
+	 * Same as above, except pHalfTriples holds the half bit patterns, as
+	 * stored in the file (avoiding a float copy twice the size).
+	 */
+	void  read
+	(
+		const char           exrLibraryPathName[],
+		const char           filePathName[],
+		dword                orderingFlags,
+		dword&               width,
+		dword&               height,
+		float*               pPrimaries8,
+		float&               scalingToGetCdm2,
+		uword*&              pHalfTriples,
+		ImageDecodeReceiver* pReceiver
+	);
+
+
+	/**
+	 * Read header of a tiled EXR image.<br/><br/>
+	 *
+	 * Parameters as for read.
+	 *
+	 * @return  whether the image is tiled (if not, nothing is set)
+	 */
+	bool  readTiledHeader
 	(
 		const char exrLibraryPathName[],
 		const char filePathName[],
-		dword      orderingFlags,
 		dword&     width,
 		dword&     height,
 		float*     pPrimaries8,
-		float&     scalingToGetCdm2,
-		float*&    pTriples
+		float&     scalingToGetCdm2
+	);
+
+
+	/**
+	 * Find the smallest mip level of a tiled EXR image that is still at least
+	 * the given size.<br/><br/>
+	 *
+	 * Rip-mapped images give the levels reduced equally in x and y.
+	 *
+	 * @return  level (0 if the file has no levels, or none are big enough)
+	 */
+	dword findTiledLevel
+	(
+		const char exrLibraryPathName[],
+		const char filePathName[],
+		dword      minWidth,
+		dword      minHeight,
+		dword&     levelWidth,
+		dword&     levelHeight
 	);
 
 
+	/**
+	 * Read a tiled EXR image, in bands of one row of tiles.<br/><br/>
+	 *
+	 * The tiles of each band are decoded in parallel. Only one band is held
+	 * at a time. Bands are given as halfs, in RGBA layout.
+	 *
+	 * @level  mip level (0 is full size)
+	 */
+	void  readTiled
+	(
+		const char         exrLibraryPathName[],
+		const char         filePathName[],
+		dword              level,
+		ImageRowsReceiver& rowsReceiver
+	);
+
+
+	/**
+	 * Keep the OpenEXR libraries loaded, until released (instead of loading
+	 * them for each image read).
+	 *
+	 * @return  whether they loaded (if not, nothing is to be released, and
+	 *          each read loads them itself, as usual)
+	 */
+	bool  acquireLibraries
+	(
+		const char exrLibraryPathName[]
+	);
+
+	void  releaseLibraries();
+
+
 //	void  write
 //	(
 //		const char   exrLibraryPathName[],
@@ -45,8 +45,11 @@ namespace p3tonemapper_format
 	//namespace png;
 	//namespace ppm;
 	//namespace rgbe;
+	class ImageDecodeReceiver;
 	class ImageFormatter;
 	class ImageRef;
+	class ImageRowsReceiver;
+	class ImageRowsWriter;
 }
 
 
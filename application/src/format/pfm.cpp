@@ -0,0 +1,362 @@
+/*--------------------------------------------------------------------
+
+   Perceptuum3 rendering components
+   Copyright (c) 2005, Harrison Ainsworth / HXA7241.
+
+   http://www.hxa7241.org/
+
+--------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later
+   version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+   MA  02110-1301  USA
+
+--------------------------------------------------------------------*/
+
+
+
+#include <ctype.h>
+#include <string.h>
+#include <sstream>
+#include <string>
+
+#include "pfm.hpp"   /// own header is included last
+
+
+using namespace p3tonemapper_format;
+
+
+
+
+/*
+	PF
+	346 512
+	-1.000000
+	<bottom row> ... <top row>
+*/
+
+
+
+
+/// constants ------------------------------------------------------------------
+static const char READ_EXCEPTION_MESSAGE[] =
+	"invalid or truncated file, in PFM read";
+
+
+
+
+/// declarations ---------------------------------------------------------------
+static const ubyte* readToken
+(
+	const ubyte* pBytes,
+	const ubyte* pEnd,
+	std::string& token
+);
+
+
+static bool isLittleEndian();
+
+
+
+
+/// ----------------------------------------------------------------------------
+void p3tonemapper_format::pfm::read
+(
+	const ubyte* pBytes,
+	const udword length,
+	dword&       width,
+	dword&       height,
+	const void*& pRgbTriples,
+	bool&        isCopy
+)
+{
+	const ubyte*const pEnd = pBytes + length;
+
+	width       = 0;
+	height      = 0;
+	pRgbTriples = 0;
+	isCopy      = false;
+
+	// read header: ID, width, height, scale
+	bool  isColor = false;
+	float scale   = 0.0f;
+	{
+		std::string token;
+
+		pBytes = readToken( pBytes, pEnd, token );
+		isColor = (std::string("PF") == token);
+		if( !isColor & (std::string("Pf") != token) )
+		{
+			throw READ_EXCEPTION_MESSAGE;
+		}
+
+		pBytes = readToken( pBytes, pEnd, token );
+		std::istringstream( token ) >> width;
+		pBytes = readToken( pBytes, pEnd, token );
+		std::istringstream( token ) >> height;
+		pBytes = readToken( pBytes, pEnd, token );
+		std::istringstream( token ) >> scale;
+
+		// (then one whitespace char)
+		if( (width <= 0) | (height <= 0) | (0.0f == scale) |
+			(pBytes >= pEnd) )
+		{
+			throw READ_EXCEPTION_MESSAGE;
+		}
+		++pBytes;
+	}
+
+	// check all pixels are there
+	const dword channels = isColor ? 3 : 1;
+	const dword rowBytes = width * channels * sizeof(float);
+	if( ((pEnd - pBytes) / rowBytes) < height )
+	{
+		throw READ_EXCEPTION_MESSAGE;
+	}
+
+	// negative scale means little-endian
+	const bool isSwapped = (scale < 0.0f) != isLittleEndian();
+
+	// use in place
+	if( isColor & !isSwapped )
+	{
+		pRgbTriples = pBytes;
+	}
+	// convert: swap bytes, and/or spread grey
+	else
+	{
+		const dword pixelCount = width * height;
+		float*      pRgb       = new float[ pixelCount * 3 ];
+
+		for( dword i = 0;  i < pixelCount;  ++i )
+		{
+			for( dword c = 0;  c < channels;  ++c, pBytes += sizeof(float) )
+			{
+				ubyte bytes[sizeof(float)];
+				for( dword b = sizeof(float);  b-- > 0; )
+				{
+					bytes[b] = pBytes[isSwapped ? (sizeof(float) - 1 - b) : b];
+				}
+
+				::memcpy( pRgb + (i * 3) + c, bytes, sizeof(float) );
+			}
+
+			if( !isColor )
+			{
+				pRgb[(i * 3) + 2] = pRgb[(i * 3) + 1] = pRgb[(i * 3)];
+			}
+		}
+
+		pRgbTriples = pRgb;
+		isCopy      = true;
+	}
+}
+
+
+const ubyte* readToken
+(
+	const ubyte* pBytes,
+	const ubyte* pEnd,
+	std::string& token
+)
+{
+	// skip whitespace
+	for( ;  (pBytes < pEnd) && ::isspace( *pBytes );  ++pBytes )
+	{
+	}
+
+	// take non-whitespace (up to a limit)
+	token.erase();
+	for( ;  (pBytes < pEnd) && !::isspace( *pBytes ) && (token.size() < 32);
+		++pBytes )
+	{
+		token += char(*pBytes);
+	}
+
+	return pBytes;
+}
+
+
+bool isLittleEndian()
+{
+	const udword one = 1;
+	return 1 == *reinterpret_cast<const ubyte*>( &one );
+}
+
+
+
+
+
+
+
+
+/// test -----------------------------------------------------------------------
+#ifdef TESTING
+
+
+#include <ostream>
+
+
+namespace p3tonemapper_format
+{
+namespace pfm
+{
+	using namespace hxa7241;
+
+
+bool test_pfm
+(
+	std::ostream* pOut,
+	const bool    isVerbose,
+	const dword   //seed
+)
+{
+	bool isOk = true;
+
+	if( pOut ) *pOut << "[ test_pfm ]\n\n";
+
+
+	// color, grey, both byte orders
+	{
+		bool isFail = false;
+
+		// 3 x 2 image: pixel value is (row * 10) + column (+ channel / 4)
+		static const float PIXELS[] = {
+			0.0f, 0.25f, 0.5f,  1.0f, 1.25f, 1.5f,  2.0f, 2.25f, 2.5f,
+			10.0f, 10.25f, 10.5f,  11.0f, 11.25f, 11.5f,  12.0f, 12.25f, 12.5f };
+
+		for( dword i = 0;  i < 4;  ++i )
+		{
+			const bool isColor    = 0 == (i & 1);
+			const bool isNative   = 0 == (i & 2);
+			const bool isLittle   = isLittleEndian() == isNative;
+			const dword channels  = isColor ? 3 : 1;
+
+			// make file
+			std::string file( isColor ? "PF" : "Pf" );
+			file += isLittle ? "\n3 2\n-1.000000\n" : "\n3 2\n1.0\n";
+			for( dword p = 0;  p < 6;  ++p )
+			{
+				for( dword c = 0;  c < channels;  ++c )
+				{
+					ubyte bytes[sizeof(float)];
+					::memcpy( bytes, PIXELS + (p * 3) + c, sizeof(float) );
+					for( dword b = 0;  b < dword(sizeof(float));  ++b )
+					{
+						file += char(bytes[isNative ? b : (sizeof(float) - 1 - b)]);
+					}
+				}
+			}
+
+			// read
+			dword       width   = 0;
+			dword       height  = 0;
+			const void* pPixels = 0;
+			bool        isCopy  = false;
+			try
+			{
+				p3tonemapper_format::pfm::read(
+					reinterpret_cast<const ubyte*>(file.data()),
+					udword(file.size()), width, height, pPixels, isCopy );
+			}
+			catch( ... )
+			{
+			}
+
+			// compare
+			isFail |= (3 != width) | (2 != height) | (0 == pPixels);
+			isFail |= isCopy != !(isColor & isNative);
+			for( dword p = 0;  !isFail && (p < 6);  ++p )
+			{
+				for( dword c = 0;  c < 3;  ++c )
+				{
+					float value;
+					::memcpy( &value, static_cast<const ubyte*>(pPixels) +
+						(((p * 3) + c) * sizeof(float)), sizeof(float) );
+					isFail |= value != PIXELS[(p * 3) + (isColor ? c : 0)];
+				}
+			}
+
+			if( isCopy )
+			{
+				delete[] static_cast<const float*>( pPixels );
+			}
+
+			if( pOut && isVerbose ) *pOut << (isColor ? "color " : "grey ") <<
+				(isNative ? "native " : "swapped ") << isCopy << "  " <<
+				isFail << "\n";
+		}
+		if( pOut && isVerbose ) *pOut << "\n";
+
+		if( pOut ) *pOut << "read : " <<
+			(!isFail ? "--- succeeded" : "*** failed") << "\n\n";
+		isOk &= !isFail;
+	}
+
+
+	// invalid: truncated pixels, bad ID, no scale
+	{
+		static const char FILE0[] = "PF\n3 2\n-1.0\n\0\0\0\0";
+		static const char FILE1[] = "P6\n3 2\n-1.0\n\0\0\0\0";
+		static const char FILE2[] = "PF\n3 2\n";
+		static const char*const FILES[]   = { FILE0, FILE1, FILE2 };
+		static const dword      LENGTHS[] = {
+			sizeof(FILE0) - 1, sizeof(FILE1) - 1, sizeof(FILE2) - 1 };
+
+		bool isFail = false;
+		for( dword i = 0;  i < 3;  ++i )
+		{
+			dword       width   = 0;
+			dword       height  = 0;
+			const void* pPixels = 0;
+			bool        isCopy  = false;
+			bool        isThrown = false;
+			try
+			{
+				p3tonemapper_format::pfm::read(
+					reinterpret_cast<const ubyte*>(FILES[i]), LENGTHS[i],
+					width, height, pPixels, isCopy );
+			}
+			catch( ... )
+			{
+				isThrown = true;
+			}
+
+			isFail |= !isThrown;
+		}
+
+		if( pOut ) *pOut << "invalid : " <<
+			(!isFail ? "--- succeeded" : "*** failed") << "\n\n";
+		isOk &= !isFail;
+	}
+
+
+	if( pOut ) *pOut << (isOk ? "--- successfully" : "*** failurefully") <<
+		" completed " << "\n\n\n";
+
+	if( pOut ) pOut->flush();
+
+
+	return isOk;
+}
+
+
+}//namespace
+}//namespace
+
+
+#endif//TESTING
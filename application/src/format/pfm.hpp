@@ -0,0 +1,87 @@
+/*--------------------------------------------------------------------
+
+   Perceptuum3 rendering components
+   Copyright (c) 2005, Harrison Ainsworth / HXA7241.
+
+   http://www.hxa7241.org/
+
+--------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later
+   version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+   MA  02110-1301  USA
+
+--------------------------------------------------------------------*/
+
+
+
+
+#ifndef pfm_h
+#define pfm_h
+
+
+
+
+#include "p3tonemapper_format.hpp"
+namespace p3tonemapper_format
+{
+
+
+/**
+ * Input for the PFM (Portable Float Map) format.<br/><br/>
+ *
+ * PFMs are uncompressed 32-bit float RGB (or grey) images: ID, then width and
+ * height, then a scale whose sign gives the byte order, then rows bottom
+ * first. So RGB pixels in this machine's byte order are already as the mapper
+ * wants them, and can be used straight from a mapped file.<br/><br/>
+ *
+ * <cite>http://www.pauldebevec.com/Research/HDR/PFM/</cite>
+ */
+namespace pfm
+{
+	/**
+	 * Read PFM image from memory (eg a mapped file).<br/><br/>
+	 *
+	 * Color ("PF") pixels in this machine's byte order are used in place:
+	 * pRgbTriples then points into pBytes (maybe not aligned for floats), and
+	 * isCopy is false. Otherwise (grey "Pf", or the other byte order) they are
+	 * converted to a new float array (free with delete[]), and isCopy is true.
+	 * <br/><br/>
+	 *
+	 * triples are bottom row first, R then G then B. The scale's magnitude is
+	 * ignored (it has no agreed meaning).
+	 *
+	 * @exceptions throws char[] message and allocation exceptions
+	 */
+	void  read
+	(
+		const ubyte* pBytes,
+		udword       length,
+		dword&       width,
+		dword&       height,
+		const void*& pRgbTriples,
+		bool&        isCopy
+	);
+}
+
+
+}//namespace
+
+
+
+
+#endif//pfm_h
@@ -28,6 +28,7 @@
 --------------------------------------------------------------------*/
 
 
+#include <string.h>
 #include <ostream>
 #include <string>
 #include <vector>
@@ -37,6 +38,9 @@
 
 #include "StringConstants.hpp"
 #include "DynamicLibraryInterface.hpp"
+#include "Processors.hpp"
+#include "Thread.hpp"
+#include "ImageRowsWriter.hpp"
 
 #include "png.hpp"   // own header is included last
 
@@ -53,6 +57,8 @@ static const char PNG_EXCEPTION_MESSAGE[] =
 	"PNG library failure";
 static const char STREAM_EXCEPTION_MESSAGE[] =
 	"stream write failure, in PNG write";
+static const char ZLIB_EXCEPTION_MESSAGE[] =
+	"zlib library failure, in PNG write";
 
 static const char LIB_PATHNAME_DEFAULT[] =
 #ifdef _PLATFORM_WIN
@@ -63,9 +69,193 @@ static const char LIB_PATHNAME_DEFAULT[] =
 	"";
 #endif
 
+static const char ZLIB_PATHNAME_DEFAULT[] =
+#ifdef _PLATFORM_WIN
+	"zlib1.dll";
+#elif _PLATFORM_LINUX
+	"libz.so.1";
+#else
+	"";
+#endif
+
+
+/// library functions, bound when loaded (indexes of FUNCTION_NAMES)
+enum EFunction
+{
+	PNG_CREATE_WRITE_STRUCT,
+	PNG_CREATE_INFO_STRUCT,
+	PNG_SET_WRITE_FN,
+	PNG_SET_FILTER,
+	PNG_SET_COMPRESSION_LEVEL,
+	PNG_SET_IHDR,
+	PNG_SET_CHRM,
+	PNG_SET_GAMA,
+	PNG_SET_TEXT,
+	PNG_WRITE_INFO,
+	PNG_SET_BGR,
+	PNG_SET_SWAP,
+	PNG_WRITE_ROWS,
+	PNG_WRITE_END,
+	PNG_GET_IO_PTR,
+	PNG_GET_ERROR_PTR,
+	PNG_DESTROY_WRITE_STRUCT
+};
+
+static const char* const FUNCTION_NAMES[] = {
+	"png_create_write_struct",
+	"png_create_info_struct",
+	"png_set_write_fn",
+	"png_set_filter",
+	"png_set_compression_level",
+	"png_set_IHDR",
+	"png_set_cHRM",
+	"png_set_gAMA",
+	"png_set_text",
+	"png_write_info",
+	"png_set_bgr",
+	"png_set_swap",
+	"png_write_rows",
+	"png_write_end",
+	"png_get_io_ptr",
+	"png_get_error_ptr",
+	"png_destroy_write_struct"
+};
+
+
+/// zlib library functions, bound when loaded (indexes of ZLIB_FUNCTION_NAMES)
+enum EZlibFunction
+{
+	DEFLATE_INIT2_,
+	DEFLATE_SET_DICTIONARY,
+	DEFLATE_BOUND,
+	DEFLATE,
+	DEFLATE_END,
+	ADLER32,
+	ADLER32_COMBINE,
+	CRC32
+#ifdef TESTING
+	,UNCOMPRESS
+#endif
+};
+
+static const char* const ZLIB_FUNCTION_NAMES[] = {
+	"deflateInit2_",
+	"deflateSetDictionary",
+	"deflateBound",
+	"deflate",
+	"deflateEnd",
+	"adler32",
+	"adler32_combine",
+	"crc32"
+#ifdef TESTING
+	,"uncompress"
+#endif
+};
+
 
 /// globals
-static void* library_g = 0;
+static hxa7241_general::DynamicLibrary library_g( FUNCTION_NAMES,
+	sizeof(FUNCTION_NAMES) / sizeof(FUNCTION_NAMES[0]) );
+static hxa7241_general::DynamicLibrary zlib_g( ZLIB_FUNCTION_NAMES,
+	sizeof(ZLIB_FUNCTION_NAMES) / sizeof(ZLIB_FUNCTION_NAMES[0]) );
+
+
+
+
+/// parallel banded writing interface ------------------------------------------
+static void writeBanded
+(
+	dword        width,
+	dword        height,
+	const float* pPrimaries42,
+	float        gamma,
+	bool         is48Bit,
+	dword        orderingFlags,
+	dword        profile,
+	const void*  pTriples,
+	ostream&     out
+);
+
+static void filterRows
+(
+	const void* pTriples,
+	dword       width,
+	dword       height,
+	bool        is48Bit,
+	dword       orderingFlags,
+	dword       profile,
+	dword       rowBegin,
+	dword       rowEnd,
+	ubyte*      pFiltered
+);
+
+static void writeChunk
+(
+	const char   type[4],
+	const ubyte* pData,
+	udword       length,
+	ostream&     out
+);
+
+static void writeBigEndian
+(
+	udword value,
+	ubyte* pBytes
+);
+
+
+
+
+/// libpng row writing interface ----------------------------------------------
+namespace
+{
+
+class PngRowsWriter
+	: public ImageRowsWriter
+{
+/// standard object services ---------------------------------------------------
+public:
+	         PngRowsWriter( const char   pngLibraryPathName[],
+	                        dword        width,
+	                        dword        height,
+	                        const float* pPrimaries42,
+	                        float        gamma,
+	                        bool         is48Bit,
+	                        dword        orderingFlags,
+	                        ostream&     out );
+
+	virtual ~PngRowsWriter();
+private:
+	         PngRowsWriter( const PngRowsWriter& );
+	PngRowsWriter& operator=( const PngRowsWriter& );
+
+
+/// commands -------------------------------------------------------------------
+public:
+	virtual void  writeRows( dword       rowCount,
+	                         const void* pRows );
+	virtual void  finish();
+
+
+/// implementation -------------------------------------------------------------
+protected:
+	        void  close();
+
+
+/// fields ---------------------------------------------------------------------
+private:
+	dword                  rowBytes_m;
+	ostream&               out_m;
+	std::ios_base::iostate originalExceptionFlags_m;
+
+	png_structp            pPngObj_m;
+	png_infop              pPngInfo_m;
+	std::string            pngErrorMsg_m;
+
+	bool                   isOpen_m;
+};
+
+}
 
 
 
@@ -115,11 +305,124 @@ void p3tonemapper_format::png::write
 	const float  gamma,
 	const bool   is48Bit,
 	const dword  orderingFlags,
+	const dword  profile,
 	const void*  pTriples,
 	ostream&     out
 )
 {
-	// load library
+	// faster profiles are done without libpng
+	if( PROFILE_SIZE != profile )
+	{
+		writeBanded( width, height, pPrimaries42, gamma, is48Bit,
+			orderingFlags, profile, pTriples, out );
+
+		return;
+	}
+
+	// write rows with libpng, top row first
+	PngRowsWriter writer( pngLibraryPathName, width, height, pPrimaries42, gamma,
+		is48Bit, orderingFlags, out );
+
+	if( 0 != (orderingFlags & IS_TOP_FIRST) )
+	{
+		writer.writeRows( height, pTriples );
+	}
+	else
+	{
+		const dword rowBytes = width * (3 << dword(is48Bit));
+		for( dword row = height;  row-- > 0; )
+		{
+			writer.writeRows( 1, static_cast<const ubyte*>(pTriples) +
+				(row * rowBytes) );
+		}
+	}
+
+	writer.finish();
+}
+
+
+ImageRowsWriter* p3tonemapper_format::png::makeRowsWriter
+(
+	const char   pngLibraryPathName[],
+	dword        width,
+	dword        height,
+	const float* pPrimaries42,
+	const float  gamma,
+	const bool   is48Bit,
+	const dword  orderingFlags,
+	ostream&     out
+)
+{
+	return new PngRowsWriter( pngLibraryPathName, width, height, pPrimaries42,
+		gamma, is48Bit, orderingFlags, out );
+}
+
+
+bool p3tonemapper_format::png::acquireLibraries
+(
+	const char pngLibraryPathName[]
+)
+{
+	// use default name if needed
+	const char* pPngLibraryPathName = pngLibraryPathName;
+	if( (0 == pngLibraryPathName) || (0 == pngLibraryPathName[0]) )
+	{
+		pPngLibraryPathName = LIB_PATHNAME_DEFAULT;
+	}
+
+	bool isLoaded = false;
+	try
+	{
+		library_g.acquire( pPngLibraryPathName );
+		try
+		{
+			zlib_g.acquire( ZLIB_PATHNAME_DEFAULT );
+			isLoaded = true;
+		}
+		catch( ... )
+		{
+			library_g.release();
+		}
+	}
+	catch( ... )
+	{
+		// leave unloaded
+	}
+
+	return isLoaded;
+}
+
+
+void p3tonemapper_format::png::releaseLibraries()
+{
+	zlib_g.release();
+	library_g.release();
+}
+
+
+
+
+/// libpng row writing ---------------------------------------------------------
+PngRowsWriter::PngRowsWriter
+(
+	const char   pngLibraryPathName[],
+	dword        width,
+	dword        height,
+	const float* pPrimaries42,
+	const float  gamma,
+	const bool   is48Bit,
+	const dword  orderingFlags,
+	ostream&     out
+)
+ :	rowBytes_m              ( 0 )
+ ,	out_m                   ( out )
+ ,	originalExceptionFlags_m( out.exceptions() )
+ ,	pPngObj_m               ( 0 )
+ ,	pPngInfo_m              ( 0 )
+ ,	pngErrorMsg_m           ()
+ ,	isOpen_m                ( false )
+{
+	// load library (if not already by another writer)
 	{
 		// use default name if needed
 		const char* pPngLibraryPathName = pngLibraryPathName;
@@ -128,64 +431,61 @@ void p3tonemapper_format::png::write
 			pPngLibraryPathName = LIB_PATHNAME_DEFAULT;
 		}
 
-		hxa7241_general::loadLibrary( pPngLibraryPathName, library_g );
+		library_g.acquire( pPngLibraryPathName );
+		isOpen_m = true;
 	}
 
 	// enable stream exceptions
-	std::ios_base::iostate originalExceptionFlags = out.exceptions();
-	out.exceptions( ostream::goodbit );
-
-	png_structp pPngObj  = 0;
-	png_infop   pPngInfo = 0;
-	std::string pngErrorMsg;
+	out_m.exceptions( ostream::goodbit );
 
 	try
 	{
 		width  = (width  >= 0) ? width  : 0;
 		height = (height >= 0) ? height : 0;
+		rowBytes_m = width * (3 << dword(is48Bit));
 
 		// create basic png objects
 		{
-			pPngObj = ::png_create_write_struct( PNG_LIBPNG_VER_STRING,
-				&pngErrorMsg, attendToPngError, attendToPngWarning );
-			if( 0 == pPngObj )
+			pPngObj_m = ::png_create_write_struct( PNG_LIBPNG_VER_STRING,
+				&pngErrorMsg_m, attendToPngError, attendToPngWarning );
+			if( 0 == pPngObj_m )
 			{
 				throw PNG_INIT_FAIL_MESSAGE;
 			}
 
-			pPngInfo = ::png_create_info_struct( pPngObj );
-			if( 0 == pPngInfo)
+			pPngInfo_m = ::png_create_info_struct( pPngObj_m );
+			if( 0 == pPngInfo_m )
 			{
 				throw PNG_INIT_FAIL_MESSAGE;
 			}
 		}
 
 		// set the target for the png 'exception' jump
-		if( ::setjmp( pPngObj->jmpbuf ) )
+		if( ::setjmp( pPngObj_m->jmpbuf ) )
 		{
 			throw PNG_EXCEPTION_MESSAGE;
 		}
 
 		// set some general callbacks and options
 		{
-			::png_set_write_fn( pPngObj, &out, writePngData, flushPngData );
-			//::png_set_write_status_fn( pPngObj, attendToPngRowWritten );
+			::png_set_write_fn( pPngObj_m, &out_m, writePngData, flushPngData );
+			//::png_set_write_status_fn( pPngObj_m, attendToPngRowWritten );
 				//void attendToPngRowWritten( png_ptr, png_uint_32 row, int pass );
 
-			::png_set_filter( pPngObj, 0, PNG_ALL_FILTERS );
-			::png_set_compression_level( pPngObj, 9 );//Z_BEST_COMPRESSION );
+			::png_set_filter( pPngObj_m, 0, PNG_ALL_FILTERS );
+			::png_set_compression_level( pPngObj_m, 9 );//Z_BEST_COMPRESSION );
 		}
 
 		// set some specific chunks
 		{
-			::png_set_IHDR( pPngObj, pPngInfo,
+			::png_set_IHDR( pPngObj_m, pPngInfo_m,
 				width, height, 8 << dword(is48Bit),
 				PNG_COLOR_TYPE_RGB, PNG_INTERLACE_NONE,
 				PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT );
 
 			if( 0 != pPrimaries42 )
 			{
-				::png_set_cHRM( pPngObj, pPngInfo,
+				::png_set_cHRM( pPngObj_m, pPngInfo_m,
 					pPrimaries42[6], pPrimaries42[7],
 					pPrimaries42[0], pPrimaries42[1],
 					pPrimaries42[2], pPrimaries42[3],
@@ -194,7 +494,7 @@ void p3tonemapper_format::png::write
 
 			if( 0.0f != gamma )
 			{
-				::png_set_gAMA( pPngObj, pPngInfo, gamma );
+				::png_set_gAMA( pPngObj_m, pPngInfo_m, gamma );
 			}
 
 			png_text texts[] = { {
@@ -202,139 +502,691 @@ void p3tonemapper_format::png::write
 					const_cast<char*>("Software"),
 					const_cast<char*>(hxa7241_general::HXA7241_URI()),
 					0 } };
-			::png_set_text( pPngObj, pPngInfo, texts, 1 );
+			::png_set_text( pPngObj_m, pPngInfo_m, texts, 1 );
 		}
 
 		// write before-image stuff
-		::png_write_info( pPngObj, pPngInfo );
+		::png_write_info( pPngObj_m, pPngInfo_m );
 
 		// set pixel byte ordering
 		{
-			if( 0 != (orderingFlags & IS_BGR) )
+			if( 0 != (orderingFlags & png::IS_BGR) )
+			{
+				::png_set_bgr( pPngObj_m );
+			}
+
+			if( is48Bit & (0 == (orderingFlags & png::IS_LO_ENDIAN)) )
+			{
+				::png_set_swap( pPngObj_m );
+			}
+
+			//::png_set_write_user_transform_fn( pPngObj_m, reOrderBytes );
+		}
+	}
+	catch( ... )
+	{
+		close();
+
+		throw;
+	}
+}
+
+
+PngRowsWriter::~PngRowsWriter()
+{
+	close();
+}
+
+
+void PngRowsWriter::writeRows
+(
+	const dword rowCount,
+	const void* pRows
+)
+{
+	std::vector<png_bytep> rowPtrs( rowCount );
+	for( dword i = rowCount;  i-- > 0; )
+	{
+		rowPtrs[i] = static_cast<ubyte*>(const_cast<void*>(pRows)) +
+			(i * rowBytes_m);
+	}
+
+	// set the target for the png 'exception' jump (in this frame)
+	if( ::setjmp( pPngObj_m->jmpbuf ) )
+	{
+		throw PNG_EXCEPTION_MESSAGE;
+	}
+
+	if( 0 != rowCount )
+	{
+		::png_write_rows( pPngObj_m, &(rowPtrs[0]), rowCount );
+	}
+}
+
+
+void PngRowsWriter::finish()
+{
+	// set the target for the png 'exception' jump (in this frame)
+	if( ::setjmp( pPngObj_m->jmpbuf ) )
+	{
+		throw PNG_EXCEPTION_MESSAGE;
+	}
+
+	// finish writing
+	::png_write_end( pPngObj_m, 0 );
+
+	close();
+}
+
+
+void PngRowsWriter::close()
+{
+	if( isOpen_m )
+	{
+		// delete basic png objects
+		if( 0 != pPngObj_m )
+		{
+			::png_destroy_write_struct( &pPngObj_m, &pPngInfo_m );
+		}
+
+		// free library
+		library_g.release();
+
+		out_m.exceptions( originalExceptionFlags_m );
+
+		isOpen_m = false;
+	}
+}
+
+
+
+
+/// libpng callbacks -----------------------------------------------------------
+void writePngData
+(
+	png_structp pPngObj,
+	png_bytep   pData,
+	png_size_t  length
+)
+{
+	ostream* pOstream =
+		reinterpret_cast<ostream*>( ::png_get_io_ptr( pPngObj ) );
+
+	pOstream->write( reinterpret_cast<const char*>(pData), length );
+	if( pOstream->fail() )
+	{
+		throw STREAM_EXCEPTION_MESSAGE;
+	}
+}
+
+
+void flushPngData
+(
+	png_structp pPngObj
+)
+{
+	ostream* pOstream =
+		reinterpret_cast<ostream*>( ::png_get_io_ptr( pPngObj ) );
+
+	pOstream->flush();
+	if( pOstream->fail() )
+	{
+		throw STREAM_EXCEPTION_MESSAGE;
+	}
+}
+
+
+//void reOrderBytes
+//(
+//	png_structp   pPngObj,
+//	png_row_infop pRowInfo,
+//	png_bytep     pData
+//)
+//{
+//}
+
+
+void attendToPngError
+(
+	png_structp     pPngObj,
+	png_const_charp pErrorMsg
+)
+{
+	std::string* pString =
+		reinterpret_cast<std::string*>( ::png_get_error_ptr(pPngObj) );
+	*pString = pErrorMsg;
+
+	::longjmp( pPngObj->jmpbuf, 1 );
+}
+
+
+void attendToPngWarning
+(
+	png_structp,
+	png_const_charp //pWarningMsg
+)
+{
+//	using hxa7241_general::Logger;
+//	Logger() << Logger::EXC1 << PngWriter::CLASS_NAME() << " : " << pWarningMsg;
+}
+
+
+
+
+/// parallel banded writing ----------------------------------------------------
+namespace
+{
+
+/**
+ * Filters and deflates a band of rows, as one part of a zlib stream.<br/><br/>
+ *
+ * The deflate is primed with the (re-filtered) tail of the rows before, so the
+ * parts compress nearly as well as one whole. Non-last parts end with a sync
+ * flush, so they join on byte boundaries.
+ */
+class BandEncoder : public hxa7241_general::Thread
+{
+public:
+	BandEncoder()
+	 :	pTriples_m     ( 0 )
+	 ,	width_m        ( 0 )
+	 ,	height_m       ( 0 )
+	 ,	is48Bit_m      ( false )
+	 ,	orderingFlags_m( 0 )
+	 ,	profile_m      ( 0 )
+	 ,	rowBegin_m     ( 0 )
+	 ,	rowEnd_m       ( 0 )
+	 ,	bytes_m        ()
+	 ,	adler_m        ( 0 )
+	{
+	}
+
+	virtual ~BandEncoder();
+
+	void set
+	(
+		const void* pTriples,
+		const dword width,
+		const dword height,
+		const bool  is48Bit,
+		const dword orderingFlags,
+		const dword profile,
+		const dword rowBegin,
+		const dword rowEnd
+	)
+	{
+		pTriples_m      = pTriples;
+		width_m         = width;
+		height_m        = height;
+		is48Bit_m       = is48Bit;
+		orderingFlags_m = orderingFlags;
+		profile_m       = profile;
+		rowBegin_m      = rowBegin;
+		rowEnd_m        = rowEnd;
+	}
+
+	void encode()
+	{
+		static const dword WINDOW_SIZE = 32768;
+
+		const int   level     = (p3tonemapper_format::png::PROFILE_SPEED ==
+			profile_m) ? 1 : 6;
+		const dword rowLength = 1 + (width_m * (3 << dword(is48Bit_m)));
+
+		// filter the band, after enough rows before it to fill the window
+		dword primeRows = (WINDOW_SIZE + rowLength - 1) / rowLength;
+		primeRows = (primeRows < rowBegin_m) ? primeRows : rowBegin_m;
+
+		std::vector<ubyte> filtered( ((rowEnd_m - rowBegin_m) + primeRows) *
+			rowLength + 1 );
+		filterRows( pTriples_m, width_m, height_m, is48Bit_m, orderingFlags_m,
+			profile_m, rowBegin_m - primeRows, rowEnd_m, &(filtered[0]) );
+
+		const ubyte* pBand       = &(filtered[0]) + (primeRows * rowLength);
+		const udword bandLength  = (rowEnd_m - rowBegin_m) * rowLength;
+		udword       primeLength = primeRows * rowLength;
+		primeLength = (primeLength < WINDOW_SIZE) ? primeLength : WINDOW_SIZE;
+
+		// zlib header goes before the first part
+		// (deflate, 32K window, compression level, check bits)
+		dword headerLength = 0;
+		ubyte header[2]    = { 0x78, ubyte((1 == level) ? 0x01 : 0x9C) };
+		if( 0 == rowBegin_m )
+		{
+			headerLength = 2;
+		}
+
+		// deflate, raw (no zlib header or checksum)
+		z_stream stream;
+		::memset( &stream, 0, sizeof(stream) );
+		if( Z_OK != ::deflateInit2( &stream, level, Z_DEFLATED, -15, 8,
+			Z_FILTERED ) )
+		{
+			throw ZLIB_EXCEPTION_MESSAGE;
+		}
+
+		try
+		{
+			if( (0 != primeLength) && (Z_OK != ::deflateSetDictionary( &stream,
+				pBand - primeLength, primeLength )) )
 			{
-				::png_set_bgr( pPngObj );
+				throw ZLIB_EXCEPTION_MESSAGE;
 			}
 
-			if( is48Bit & (0 == (orderingFlags & IS_LO_ENDIAN)) )
+			// (the bound allows for one call, so add room for the flush)
+			bytes_m.resize( headerLength + ::deflateBound( &stream, bandLength )
+				+ 64 );
+			::memcpy( &(bytes_m[0]), header, headerLength );
+
+			stream.next_in   = const_cast<ubyte*>( pBand );
+			stream.avail_in  = bandLength;
+			stream.next_out  = &(bytes_m[0]) + headerLength;
+			stream.avail_out = bytes_m.size() - headerLength;
+
+			const bool isLast = (height_m == rowEnd_m);
+			const int  result = ::deflate( &stream,
+				isLast ? Z_FINISH : Z_SYNC_FLUSH );
+			if( ((isLast ? Z_STREAM_END : Z_OK) != result) |
+				(0 != stream.avail_in) | (0 == stream.avail_out) )
 			{
-				::png_set_swap( pPngObj );
+				throw ZLIB_EXCEPTION_MESSAGE;
 			}
 
-			//::png_set_write_user_transform_fn( pPngObj, reOrderBytes );
+			bytes_m.resize( bytes_m.size() - stream.avail_out );
+
+			adler_m = ::adler32( ::adler32( 0, 0, 0 ), pBand, bandLength );
+		}
+		catch( ... )
+		{
+			::deflateEnd( &stream );
+			throw;
 		}
 
-		// write pixels
+		::deflateEnd( &stream );
+	}
+
+	std::vector<ubyte>& getBytes()
+	{
+		return bytes_m;
+	}
+
+	udword getAdler() const
+	{
+		return adler_m;
+	}
+
+	udword getLength() const
+	{
+		return (rowEnd_m - rowBegin_m) *
+			(1 + (width_m * (3 << dword(is48Bit_m))));
+	}
+
+protected:
+	virtual void run()
+	{
+		encode();
+	}
+
+private:
+	const void*        pTriples_m;
+	dword              width_m;
+	dword              height_m;
+	bool               is48Bit_m;
+	dword              orderingFlags_m;
+	dword              profile_m;
+	dword              rowBegin_m;
+	dword              rowEnd_m;
+
+	std::vector<ubyte> bytes_m;
+	udword             adler_m;
+};
+
+
+BandEncoder::~BandEncoder()
+{
+}
+
+}
+
+
+void writeBanded
+(
+	dword        width,
+	dword        height,
+	const float* pPrimaries42,
+	const float  gamma,
+	const bool   is48Bit,
+	const dword  orderingFlags,
+	const dword  profile,
+	const void*  pTriples,
+	ostream&     out
+)
+{
+	// load library (if not already by another writer)
+	zlib_g.acquire( ZLIB_PATHNAME_DEFAULT );
+
+	BandEncoder* pEncoders = 0;
+
+	try
+	{
+		width  = (width  >= 0) ? width  : 0;
+		height = (height >= 0) ? height : 0;
+
+		// a band of rows per processor (but not too small a band)
+		static const dword MIN_BAND_ROWS = 16;
+		const dword processorCount = hxa7241_general::getProcessorCount();
+		dword bandCount = height / MIN_BAND_ROWS;
+		bandCount = (bandCount < processorCount) ? bandCount : processorCount;
+		bandCount = (bandCount > 1) ? bandCount : 1;
+
+		pEncoders = new BandEncoder[ bandCount ];
+		for( dword i = 0;  i < bandCount;  ++i )
+		{
+			pEncoders[i].set( pTriples, width, height, is48Bit, orderingFlags,
+				profile, (height * i) / bandCount, (height * (i + 1)) / bandCount );
+		}
+
+		// run all but the first on other threads, and the first on this one
+		{
+			const char* pFailMessage = 0;
+			dword       started      = 1;
+			try
+			{
+				for( ;  started < bandCount;  ++started )
+				{
+					pEncoders[started].start();
+				}
+
+				pEncoders[0].encode();
+			}
+			catch( const char*const pMessage )
+			{
+				pFailMessage = pMessage;
+			}
+			catch( ... )
+			{
+				pFailMessage = ZLIB_EXCEPTION_MESSAGE;
+			}
+
+			// wait for all started
+			for( dword i = 1;  i < started;  ++i )
+			{
+				try
+				{
+					pEncoders[i].join();
+				}
+				catch( const char*const pMessage )
+				{
+					pFailMessage = pMessage;
+				}
+			}
+
+			if( 0 != pFailMessage )
+			{
+				throw pFailMessage;
+			}
+		}
+
+		// end the zlib stream with the checksum of all parts
 		{
-			std::vector<void*> rowPtrs( height );
-			for( dword i = height;  i-- > 0; )
+			udword adler = pEncoders[0].getAdler();
+			for( dword i = 1;  i < bandCount;  ++i )
 			{
-				const dword row = (0 != (orderingFlags & IS_TOP_FIRST)) ?
-					i : (height - 1) - i;
-				const dword offset = row * (width * (3 << dword(is48Bit)));
-				rowPtrs[i] =
-					static_cast<ubyte*>(const_cast<void*>(pTriples)) + offset;
+				adler = ::adler32_combine( adler, pEncoders[i].getAdler(),
+					pEncoders[i].getLength() );
 			}
 
-			::png_write_image(
-				pPngObj, reinterpret_cast<png_bytepp>(&(rowPtrs[0])) );
+			std::vector<ubyte>& last = pEncoders[bandCount - 1].getBytes();
+			last.resize( last.size() + 4 );
+			writeBigEndian( adler, &(last[last.size() - 4]) );
+		}
+
+		// write signature
+		{
+			static const ubyte SIGNATURE[] =
+				{ 0x89, 0x50, 0x4E, 0x47, 0x0D, 0x0A, 0x1A, 0x0A };
+			out.write( reinterpret_cast<const char*>(SIGNATURE),
+				sizeof(SIGNATURE) );
+		}
+
+		// write before-image chunks (in the same order as libpng)
+		{
+			ubyte header[13];
+			writeBigEndian( width,  header + 0 );
+			writeBigEndian( height, header + 4 );
+			header[ 8] = ubyte(8 << dword(is48Bit));
+			header[ 9] = PNG_COLOR_TYPE_RGB;
+			header[10] = PNG_COMPRESSION_TYPE_DEFAULT;
+			header[11] = PNG_FILTER_TYPE_DEFAULT;
+			header[12] = PNG_INTERLACE_NONE;
+			writeChunk( "IHDR", header, sizeof(header), out );
+
+			if( 0.0f != gamma )
+			{
+				ubyte fixedGamma[4];
+				writeBigEndian( udword(gamma * 100000.0f + 0.5f), fixedGamma );
+				writeChunk( "gAMA", fixedGamma, sizeof(fixedGamma), out );
+			}
+
+			if( 0 != pPrimaries42 )
+			{
+				// white first, then red, green, blue
+				ubyte chromaticities[32];
+				for( dword i = 0;  i < 8;  ++i )
+				{
+					writeBigEndian( udword(pPrimaries42[(i + 6) % 8] *
+						100000.0f + 0.5f), chromaticities + (i * 4) );
+				}
+				writeChunk( "cHRM", chromaticities, sizeof(chromaticities), out );
+			}
+
+			std::string text( "Software" );
+			text += '\0';
+			text += hxa7241_general::HXA7241_URI();
+			writeChunk( "tEXt", reinterpret_cast<const ubyte*>(text.data()),
+				text.size(), out );
+		}
+
+		// write pixels: a chunk per part
+		for( dword i = 0;  i < bandCount;  ++i )
+		{
+			const std::vector<ubyte>& bytes = pEncoders[i].getBytes();
+			writeChunk( "IDAT", &(bytes[0]), bytes.size(), out );
 		}
 
 		// finish writing
-		::png_write_end( pPngObj, 0 );
+		writeChunk( "IEND", 0, 0, out );
 
-		// delete basic png objects
-		::png_destroy_write_struct( &pPngObj, &pPngInfo );
+		delete[] pEncoders;
 
 		// free library
-		hxa7241_general::freeLibrary( library_g );
+		zlib_g.release();
 	}
 	catch( ... )
 	{
-		if( 0 != pPngObj )
+		delete[] pEncoders;
+
+		zlib_g.release();
+
+		throw;
+	}
+}
+
+
+void filterRows
+(
+	const void* pTriples,
+	const dword width,
+	const dword height,
+	const bool  is48Bit,
+	const dword orderingFlags,
+	const dword profile,
+	const dword rowBegin,
+	const dword rowEnd,
+	ubyte*      pFiltered
+)
+{
+	// filters to try on each row, keeping the smallest sum of absolute values
+	static const dword FILTERS_BALANCED[] = { PNG_FILTER_VALUE_NONE,
+		PNG_FILTER_VALUE_SUB, PNG_FILTER_VALUE_UP, PNG_FILTER_VALUE_AVG,
+		PNG_FILTER_VALUE_PAETH };
+	static const dword FILTERS_SPEED[]    = { PNG_FILTER_VALUE_SUB,
+		PNG_FILTER_VALUE_UP };
+
+	const bool   isSpeed     = (p3tonemapper_format::png::PROFILE_SPEED ==
+		profile);
+	const dword* pFilters    = isSpeed ? FILTERS_SPEED : FILTERS_BALANCED;
+	const dword  filterCount = isSpeed ?
+		sizeof(FILTERS_SPEED)    / sizeof(FILTERS_SPEED[0]) :
+		sizeof(FILTERS_BALANCED) / sizeof(FILTERS_BALANCED[0]);
+
+	const dword bytesPerChannel = 1 << dword(is48Bit);
+	const dword pixelBytes      = 3 * bytesPerChannel;
+	const dword length          = width * pixelBytes;
+
+	const bool isTopFirst = 0 != (orderingFlags & p3tonemapper_format::png::
+		IS_TOP_FIRST);
+	const bool isBgr      = 0 != (orderingFlags & p3tonemapper_format::png::
+		IS_BGR);
+	const bool isSwap     = is48Bit & (0 == (orderingFlags &
+		p3tonemapper_format::png::IS_LO_ENDIAN));
+
+	// (the row before the first is zeros)
+	std::vector<ubyte> rows( (length * 2) + 1 );
+	std::vector<ubyte> trial( length + 1 );
+	ubyte* pPrior = &(rows[0]);
+	ubyte* pRow   = &(rows[0]) + length;
+
+	for( dword row = (rowBegin > 0) ? rowBegin - 1 : 0;  row < rowEnd;  ++row )
+	{
+		// make row in png byte order (top first, RGB, big-endian)
 		{
-			::png_destroy_write_struct( &pPngObj, &pPngInfo );
+			const ubyte* pIn = static_cast<const ubyte*>(pTriples) +
+				((isTopFirst ? row : (height - 1) - row) * length);
+
+			if( !isBgr & !isSwap )
+			{
+				::memcpy( pRow, pIn, length );
+			}
+			else
+			{
+				for( dword i = 0;  i < length;  ++i )
+				{
+					const dword channelByte = i % pixelBytes;
+					const dword channel     = channelByte / bytesPerChannel;
+					const dword byte        = channelByte % bytesPerChannel;
+
+					pRow[i] = pIn[(i - channelByte) +
+						((isBgr ? 2 - channel : channel) * bytesPerChannel) +
+						(isSwap ? (bytesPerChannel - 1) - byte : byte)];
+				}
+			}
 		}
 
-		hxa7241_general::freeLibrary( library_g );
+		if( row >= rowBegin )
+		{
+			ubyte* pOut    = pFiltered + ((row - rowBegin) * (length + 1));
+			udword minimum = udword(-1);
+
+			for( dword f = 0;  f < filterCount;  ++f )
+			{
+				const dword filter = pFilters[f];
+				trial[0] = ubyte(filter);
+
+				udword sum = 0;
+				for( dword i = 0;  i < length;  ++i )
+				{
+					const dword a = (i >= pixelBytes) ? pRow[i - pixelBytes] : 0;
+					const dword b = pPrior[i];
+					const dword c = (i >= pixelBytes) ? pPrior[i - pixelBytes] :
+						0;
+
+					dword predictor = 0;
+					switch( filter )
+					{
+					case PNG_FILTER_VALUE_SUB :
+						predictor = a;
+						break;
+					case PNG_FILTER_VALUE_UP :
+						predictor = b;
+						break;
+					case PNG_FILTER_VALUE_AVG :
+						predictor = (a + b) >> 1;
+						break;
+					case PNG_FILTER_VALUE_PAETH :
+						{
+							const dword p  = a + b - c;
+							const dword pa = (p > dword(a)) ? p - a : a - p;
+							const dword pb = (p > dword(b)) ? p - b : b - p;
+							const dword pc = (p > dword(c)) ? p - c : c - p;
+							predictor = ((pa <= pb) & (pa <= pc)) ? a :
+								((pb <= pc) ? b : c);
+						}
+						break;
+					}
+
+					const ubyte value = ubyte(pRow[i] - predictor);
+					trial[1 + i] = value;
+					sum += (value < 128) ? value : 256 - value;
+				}
 
-		out.exceptions( originalExceptionFlags );
+				if( sum < minimum )
+				{
+					minimum = sum;
+					::memcpy( pOut, &(trial[0]), length + 1 );
+				}
+			}
+		}
 
-		throw;
+		ubyte* pSwap = pPrior;
+		pPrior = pRow;
+		pRow   = pSwap;
 	}
-
-	out.exceptions( originalExceptionFlags );
 }
 
 
-
-
-/// libpng callbacks -----------------------------------------------------------
-void writePngData
+void writeChunk
 (
-	png_structp pPngObj,
-	png_bytep   pData,
-	png_size_t  length
+	const char   type[4],
+	const ubyte* pData,
+	const udword length,
+	ostream&     out
 )
 {
-	ostream* pOstream =
-		reinterpret_cast<ostream*>( ::png_get_io_ptr( pPngObj ) );
+	// length, type, data, crc of type and data
+	ubyte head[8];
+	writeBigEndian( length, head );
+	::memcpy( head + 4, type, 4 );
 
-	pOstream->write( reinterpret_cast<const char*>(pData), length );
-	if( pOstream->fail() )
+	udword crc = ::crc32( ::crc32( 0, 0, 0 ), head + 4, 4 );
+	if( 0 != length )
 	{
-		throw STREAM_EXCEPTION_MESSAGE;
+		crc = ::crc32( crc, pData, length );
 	}
-}
 
+	ubyte tail[4];
+	writeBigEndian( crc, tail );
 
-void flushPngData
-(
-	png_structp pPngObj
-)
-{
-	ostream* pOstream =
-		reinterpret_cast<ostream*>( ::png_get_io_ptr( pPngObj ) );
-
-	pOstream->flush();
-	if( pOstream->fail() )
+	out.write( reinterpret_cast<const char*>(head), sizeof(head) );
+	out.write( reinterpret_cast<const char*>(pData), length );
+	out.write( reinterpret_cast<const char*>(tail), sizeof(tail) );
+	if( out.fail() )
 	{
 		throw STREAM_EXCEPTION_MESSAGE;
 	}
 }
 
 
-//void reOrderBytes
-//(
-//	png_structp   pPngObj,
-//	png_row_infop pRowInfo,
-//	png_bytep     pData
-//)
-//{
-//}
-
-
-void attendToPngError
-(
-	png_structp     pPngObj,
-	png_const_charp pErrorMsg
-)
-{
-	std::string* pString =
-		reinterpret_cast<std::string*>( ::png_get_error_ptr(pPngObj) );
-	*pString = pErrorMsg;
-
-	::longjmp( pPngObj->jmpbuf, 1 );
-}
-
-
-void attendToPngWarning
+void writeBigEndian
 (
-	png_structp,
-	png_const_charp //pWarningMsg
+	const udword value,
+	ubyte*       pBytes
 )
 {
-//	using hxa7241_general::Logger;
-//	Logger() << Logger::EXC1 << PngWriter::CLASS_NAME() << " : " << pWarningMsg;
+	pBytes[0] = ubyte(value >> 24);
+	pBytes[1] = ubyte(value >> 16);
+	pBytes[2] = ubyte(value >>  8);
+	pBytes[3] = ubyte(value);
 }
 
 
@@ -363,7 +1215,7 @@ png_structp  png_create_write_struct
 	);
 
 	PFunction function = reinterpret_cast<PFunction>(
-		hxa7241_general::getFunction( library_g, "png_create_write_struct" ) );
+		library_g.getFunction( PNG_CREATE_WRITE_STRUCT ) );
 
 	return (function)(
 		user_png_ver,
@@ -384,7 +1236,7 @@ png_infop  png_create_info_struct
 	);
 
 	PFunction function = reinterpret_cast<PFunction>(
-		hxa7241_general::getFunction( library_g, "png_create_info_struct" ) );
+		library_g.getFunction( PNG_CREATE_INFO_STRUCT ) );
 
 	return (function)(
 		png_ptr
@@ -408,7 +1260,7 @@ void  png_set_write_fn
 	);
 
 	PFunction function = reinterpret_cast<PFunction>(
-		hxa7241_general::getFunction( library_g, "png_set_write_fn" ) );
+		library_g.getFunction( PNG_SET_WRITE_FN ) );
 
 	return (function)(
 		png_ptr,
@@ -442,7 +1294,7 @@ void  png_set_filter
 	);
 
 	PFunction function = reinterpret_cast<PFunction>(
-		hxa7241_general::getFunction( library_g, "png_set_filter" ) );
+		library_g.getFunction( PNG_SET_FILTER ) );
 
 	return (function)(
 		png_ptr,
@@ -464,7 +1316,7 @@ void  png_set_compression_level
 	);
 
 	PFunction function = reinterpret_cast<PFunction>(
-		hxa7241_general::getFunction( library_g, "png_set_compression_level" ) );
+		library_g.getFunction( PNG_SET_COMPRESSION_LEVEL ) );
 
 	return (function)(
 		png_ptr,
@@ -499,7 +1351,7 @@ void  png_set_IHDR
 	);
 
 	PFunction function = reinterpret_cast<PFunction>(
-		hxa7241_general::getFunction( library_g, "png_set_IHDR" ) );
+		library_g.getFunction( PNG_SET_IHDR ) );
 
 	return (function)(
 		png_ptr,
@@ -543,7 +1395,7 @@ void  png_set_cHRM
 	);
 
 	PFunction function = reinterpret_cast<PFunction>(
-		hxa7241_general::getFunction( library_g, "png_set_cHRM" ) );
+		library_g.getFunction( PNG_SET_CHRM ) );
 
 	return (function)(
 		png_ptr,
@@ -574,7 +1426,7 @@ void  png_set_gAMA
 	);
 
 	PFunction function = reinterpret_cast<PFunction>(
-		hxa7241_general::getFunction( library_g, "png_set_gAMA" ) );
+		library_g.getFunction( PNG_SET_GAMA ) );
 
 	return (function)(
 		png_ptr,
@@ -600,7 +1452,7 @@ void  png_set_text
 	);
 
 	PFunction function = reinterpret_cast<PFunction>(
-		hxa7241_general::getFunction( library_g, "png_set_text" ) );
+		library_g.getFunction( PNG_SET_TEXT ) );
 
 	return (function)(
 		png_ptr,
@@ -623,7 +1475,7 @@ void  png_write_info
 	);
 
 	PFunction function = reinterpret_cast<PFunction>(
-		hxa7241_general::getFunction( library_g, "png_write_info" ) );
+		library_g.getFunction( PNG_WRITE_INFO ) );
 
 	return (function)(
 		png_ptr,
@@ -642,7 +1494,7 @@ void  png_set_bgr
 	);
 
 	PFunction function = reinterpret_cast<PFunction>(
-		hxa7241_general::getFunction( library_g, "png_set_bgr" ) );
+		library_g.getFunction( PNG_SET_BGR ) );
 
 	return (function)(
 		png_ptr
@@ -660,7 +1512,7 @@ void  png_set_swap
 	);
 
 	PFunction function = reinterpret_cast<PFunction>(
-		hxa7241_general::getFunction( library_g, "png_set_swap" ) );
+		library_g.getFunction( PNG_SET_SWAP ) );
 
 	return (function)(
 		png_ptr
@@ -677,23 +1529,26 @@ void  png_set_swap
 //}
 
 
-void  png_write_image
+void  png_write_rows
 (
 	png_structp png_ptr,
-	png_bytepp  image
+	png_bytepp  row,
+	png_uint_32 num_rows
 )
 {
 	typedef void (*PFunction)(
 		png_structp,
-		png_bytepp
+		png_bytepp,
+		png_uint_32
 	);
 
 	PFunction function = reinterpret_cast<PFunction>(
-		hxa7241_general::getFunction( library_g, "png_write_image" ) );
+		library_g.getFunction( PNG_WRITE_ROWS ) );
 
 	return (function)(
 		png_ptr,
-		image
+		row,
+		num_rows
 	);
 }
 
@@ -710,7 +1565,7 @@ void  png_write_end
 	);
 
 	PFunction function = reinterpret_cast<PFunction>(
-		hxa7241_general::getFunction( library_g, "png_write_end" ) );
+		library_g.getFunction( PNG_WRITE_END ) );
 
 	return (function)(
 		png_ptr,
@@ -729,7 +1584,7 @@ png_voidp  png_get_io_ptr
 	);
 
 	PFunction function = reinterpret_cast<PFunction>(
-		hxa7241_general::getFunction( library_g, "png_get_io_ptr" ) );
+		library_g.getFunction( PNG_GET_IO_PTR ) );
 
 	return (function)(
 		png_ptr
@@ -747,7 +1602,7 @@ png_voidp  png_get_error_ptr
 	);
 
 	PFunction function = reinterpret_cast<PFunction>(
-		hxa7241_general::getFunction( library_g, "png_get_error_ptr" ) );
+		library_g.getFunction( PNG_GET_ERROR_PTR ) );
 
 	return (function)(
 		png_ptr
@@ -767,7 +1622,7 @@ void  png_destroy_write_struct
 	);
 
 	PFunction function = reinterpret_cast<PFunction>(
-		hxa7241_general::getFunction( library_g, "png_destroy_write_struct" ) );
+		library_g.getFunction( PNG_DESTROY_WRITE_STRUCT ) );
 
 	return (function)(
 		png_ptr_ptr,
@@ -778,6 +1633,234 @@ void  png_destroy_write_struct
 
 
 
+/// zlib dynamic library forwarders --------------------------------------------
+
+int  deflateInit2_
+(
+	z_streamp   strm,
+	int         level,
+	int         method,
+	int         windowBits,
+	int         memLevel,
+	int         strategy,
+	const char* version,
+	int         stream_size
+)
+{
+	typedef int (*PFunction)(
+		z_streamp,
+		int,
+		int,
+		int,
+		int,
+		int,
+		const char*,
+		int
+	);
+
+	PFunction function = reinterpret_cast<PFunction>(
+		zlib_g.getFunction( DEFLATE_INIT2_ ) );
+
+	return (function)(
+		strm,
+		level,
+		method,
+		windowBits,
+		memLevel,
+		strategy,
+		version,
+		stream_size
+	);
+}
+
+
+int  deflateSetDictionary
+(
+	z_streamp    strm,
+	const Bytef* dictionary,
+	uInt         dictLength
+)
+{
+	typedef int (*PFunction)(
+		z_streamp,
+		const Bytef*,
+		uInt
+	);
+
+	PFunction function = reinterpret_cast<PFunction>(
+		zlib_g.getFunction( DEFLATE_SET_DICTIONARY ) );
+
+	return (function)(
+		strm,
+		dictionary,
+		dictLength
+	);
+}
+
+
+uLong  deflateBound
+(
+	z_streamp strm,
+	uLong     sourceLen
+)
+{
+	typedef uLong (*PFunction)(
+		z_streamp,
+		uLong
+	);
+
+	PFunction function = reinterpret_cast<PFunction>(
+		zlib_g.getFunction( DEFLATE_BOUND ) );
+
+	return (function)(
+		strm,
+		sourceLen
+	);
+}
+
+
+int  deflate
+(
+	z_streamp strm,
+	int       flush
+)
+{
+	typedef int (*PFunction)(
+		z_streamp,
+		int
+	);
+
+	PFunction function = reinterpret_cast<PFunction>(
+		zlib_g.getFunction( DEFLATE ) );
+
+	return (function)(
+		strm,
+		flush
+	);
+}
+
+
+int  deflateEnd
+(
+	z_streamp strm
+)
+{
+	typedef int (*PFunction)(
+		z_streamp
+	);
+
+	PFunction function = reinterpret_cast<PFunction>(
+		zlib_g.getFunction( DEFLATE_END ) );
+
+	return (function)(
+		strm
+	);
+}
+
+
+uLong  adler32
+(
+	uLong        adler,
+	const Bytef* buf,
+	uInt         len
+)
+{
+	typedef uLong (*PFunction)(
+		uLong,
+		const Bytef*,
+		uInt
+	);
+
+	PFunction function = reinterpret_cast<PFunction>(
+		zlib_g.getFunction( ADLER32 ) );
+
+	return (function)(
+		adler,
+		buf,
+		len
+	);
+}
+
+
+uLong  adler32_combine
+(
+	uLong   adler1,
+	uLong   adler2,
+	z_off_t len2
+)
+{
+	typedef uLong (*PFunction)(
+		uLong,
+		uLong,
+		z_off_t
+	);
+
+	PFunction function = reinterpret_cast<PFunction>(
+		zlib_g.getFunction( ADLER32_COMBINE ) );
+
+	return (function)(
+		adler1,
+		adler2,
+		len2
+	);
+}
+
+
+uLong  crc32
+(
+	uLong        crc,
+	const Bytef* buf,
+	uInt         len
+)
+{
+	typedef uLong (*PFunction)(
+		uLong,
+		const Bytef*,
+		uInt
+	);
+
+	PFunction function = reinterpret_cast<PFunction>(
+		zlib_g.getFunction( CRC32 ) );
+
+	return (function)(
+		crc,
+		buf,
+		len
+	);
+}
+
+
+#ifdef TESTING
+int  uncompress
+(
+	Bytef*       dest,
+	uLongf*      destLen,
+	const Bytef* source,
+	uLong        sourceLen
+)
+{
+	typedef int (*PFunction)(
+		Bytef*,
+		uLongf*,
+		const Bytef*,
+		uLong
+	);
+
+	PFunction function = reinterpret_cast<PFunction>(
+		zlib_g.getFunction( UNCOMPRESS ) );
+
+	return (function)(
+		dest,
+		destLen,
+		source,
+		sourceLen
+	);
+}
+#endif
+
+
+
+
 
 
 
@@ -786,6 +1869,7 @@ void  png_destroy_write_struct
 #ifdef TESTING
 
 
+#include <algorithm>
 #include <fstream>
 #include <sstream>
 
@@ -868,7 +1952,7 @@ bool test_png
 			try
 			{
 				p3tonemapper_format::png::write( LIB_FILE, width, height,
-					SRGB_PRIMARIES, 1.0f, is48Bit, 0,
+					SRGB_PRIMARIES, 1.0f, is48Bit, 0, PROFILE_SIZE,
 					pPixels, outf );
 
 				if( pOut && isVerbose ) *pOut << "wrote image to " <<
@@ -940,7 +2024,7 @@ bool test_png
 		std::ostringstream out24( std::ostringstream::binary );
 
 		p3tonemapper_format::png::write( LIB_FILE, width, height,
-			SRGB_PRIMARIES, 1.0f, false, 0,
+			SRGB_PRIMARIES, 1.0f, false, 0, PROFILE_SIZE,
 			pixels, out24 );
 
 
@@ -1034,7 +2118,7 @@ bool test_png
 		std::ostringstream out48( std::ostringstream::binary );
 
 		p3tonemapper_format::png::write( LIB_FILE, width, height,
-			SRGB_PRIMARIES, 1.0f, true, 0,
+			SRGB_PRIMARIES, 1.0f, true, 0, PROFILE_SIZE,
 			pixels, out48 );
 
 
@@ -1098,6 +2182,205 @@ bool test_png
 	}
 
 
+	// faster profiles: chunks are sound, and pixels decode the same
+	{
+		bool isFail = false;
+
+		zlib_g.acquire( ZLIB_PATHNAME_DEFAULT );
+
+		// (tall enough for several bands, when there are several processors)
+		static const dword WIDTH  = 29;
+		static const dword HEIGHT = 70;
+
+		uword pixels[ WIDTH * HEIGHT * 3 ];
+		for( dword i = WIDTH * HEIGHT * 3;  i-- > 0; )
+		{
+			// smooth, with some noise
+			const dword x = (i / 3) % WIDTH;
+			const dword y = (i / 3) / WIDTH;
+			pixels[i] = uword( (x * 1500) + (y * 700) + ((i % 3) * 9000) +
+				((i * 2654435761u) >> 24) );
+		}
+
+		for( dword i = 0;  i < 8;  ++i )
+		{
+			const dword profile = (i & 1) ? PROFILE_SPEED : PROFILE_BALANCED;
+			const bool  is48Bit = 0 != (i & 2);
+			const dword flags   = (i & 4) ? (IS_TOP_FIRST | IS_BGR) : 0;
+
+			// write (bytes are the low halves of the words)
+			std::vector<ubyte> bytes( WIDTH * HEIGHT * 3 );
+			for( dword b = bytes.size();  b-- > 0; )
+			{
+				bytes[b] = ubyte(pixels[b]);
+			}
+
+			std::ostringstream outs( std::ostringstream::binary );
+			p3tonemapper_format::png::write( LIB_FILE, WIDTH, HEIGHT,
+				SRGB_PRIMARIES, 1.0f, is48Bit, flags, profile,
+				is48Bit ? static_cast<const void*>(pixels) : &(bytes[0]), outs );
+			const std::string file( outs.str() );
+			const ubyte* pFile = reinterpret_cast<const ubyte*>( file.data() );
+
+			// read chunks, checking crcs, and gathering IDAT data
+			std::string types;
+			std::vector<ubyte> idat;
+			for( udword pos = 8;  (pos + 12) <= file.size(); )
+			{
+				const udword length = (udword(pFile[pos]) << 24) |
+					(udword(pFile[pos + 1]) << 16) |
+					(udword(pFile[pos + 2]) << 8) | udword(pFile[pos + 3]);
+				if( (pos + 12 + length) > file.size() )
+				{
+					isFail = true;
+					break;
+				}
+
+				ubyte crc[4];
+				writeBigEndian( ::crc32( ::crc32( 0, 0, 0 ), pFile + pos + 4,
+					length + 4 ), crc );
+				isFail |= (0 != ::memcmp( crc, pFile + pos + 8 + length, 4 ));
+
+				const std::string type( file.substr( pos + 4, 4 ) );
+				types += (types.empty() || (type != "IDAT") ||
+					(types.substr( types.size() - 4 ) != "IDAT")) ? type : "";
+				if( type == "IDAT" )
+				{
+					idat.insert( idat.end(), pFile + pos + 8,
+						pFile + pos + 8 + length );
+				}
+
+				pos += 12 + length;
+			}
+			isFail |= (types != "IHDRgAMAcHRMtEXtIDATIEND");
+
+			// decompress and unfilter
+			const dword pixelBytes = 3 << dword(is48Bit);
+			const dword rowLength  = 1 + (WIDTH * pixelBytes);
+			std::vector<ubyte> rows( (HEIGHT + 1) * rowLength );
+			uLongf rowsLength = HEIGHT * rowLength;
+			isFail |= idat.empty() || (Z_OK != ::uncompress( &(rows[0]) +
+				rowLength, &rowsLength, &(idat[0]), idat.size() )) ||
+				(rowsLength != uLongf(HEIGHT * rowLength));
+
+			dword diffs = 0;
+			for( dword y = 1;  !isFail && (y <= HEIGHT);  ++y )
+			{
+				ubyte*       pRow   = &(rows[y * rowLength]);
+				const ubyte* pPrior = pRow - rowLength;
+				for( dword b = 1;  b < rowLength;  ++b )
+				{
+					const dword a = (b > pixelBytes) ? pRow[b - pixelBytes] : 0;
+					const dword u = (y > 1) ? pPrior[b] : 0;
+					const dword c = ((b > pixelBytes) & (y > 1)) ?
+						pPrior[b - pixelBytes] : 0;
+					const dword p = a + u - c;
+					const dword pa = (p > a) ? p - a : a - p;
+					const dword pu = (p > u) ? p - u : u - p;
+					const dword pc = (p > c) ? p - c : c - p;
+					const dword predictors[] = { 0, a, u, (a + u) >> 1,
+						((pa <= pu) & (pa <= pc)) ? a : ((pu <= pc) ? u : c) };
+					pRow[b] = ubyte(pRow[b] + predictors[pRow[0] % 5]);
+					isFail |= (pRow[0] > 4);
+
+					// compare with the original
+					const dword x       = (b - 1) / pixelBytes;
+					const dword channel = ((b - 1) % pixelBytes) >>
+						dword(is48Bit);
+					const dword row     = (flags & IS_TOP_FIRST) ? y - 1 :
+						HEIGHT - y;
+					const dword index   = (((row * WIDTH) + x) * 3) +
+						((flags & IS_BGR) ? 2 - channel : channel);
+					const ubyte value   = !is48Bit ? bytes[index] :
+						ubyte(pixels[index] >> (((b - 1) & 1) ? 0 : 8));
+					diffs += dword(pRow[b] != value);
+				}
+			}
+			isFail |= (0 != diffs);
+
+			if( pOut && isVerbose ) *pOut << "profile " << profile <<
+				"  48bit " << is48Bit << "  flags " << flags << "  size " <<
+				file.size() << "  diffs " << diffs << "\n";
+		}
+		if( pOut && isVerbose ) *pOut << "\n";
+
+		zlib_g.release();
+
+		if( pOut ) *pOut << "profiles : " <<
+			(!isFail ? "--- succeeded" : "*** failed") << "\n\n";
+		isOk &= !isFail;
+	}
+
+
+	// rows writer: same file as writing the whole image
+	{
+		bool isFail = false;
+
+		static const dword WIDTH  = 23;
+		static const dword HEIGHT = 41;
+
+		uword pixels[ WIDTH * HEIGHT * 3 ];
+		for( dword i = WIDTH * HEIGHT * 3;  i-- > 0; )
+		{
+			pixels[i] = uword( (i * 2654435761u) >> 16 );
+		}
+
+		for( dword i = 0;  i < 2;  ++i )
+		{
+			const bool is48Bit = 0 != i;
+
+			// whole image, bottom row first
+			std::ostringstream outWhole( std::ostringstream::binary );
+			p3tonemapper_format::png::write( LIB_FILE, WIDTH, HEIGHT,
+				SRGB_PRIMARIES, 1.0f, is48Bit, 0, PROFILE_SIZE, pixels,
+				outWhole );
+
+			// uneven bands of rows, top row first
+			std::ostringstream outRows( std::ostringstream::binary );
+			try
+			{
+				ImageRowsWriter* pWriter = makeRowsWriter( LIB_FILE, WIDTH,
+					HEIGHT, SRGB_PRIMARIES, 1.0f, is48Bit, 0, outRows );
+
+				const dword rowBytes = WIDTH * (3 << dword(is48Bit));
+				for( dword y = 0, band = 1;  y < HEIGHT;  y += band, band += 2 )
+				{
+					band = band > (HEIGHT - y) ? (HEIGHT - y) : band;
+
+					// gather band rows top first
+					std::vector<ubyte> rows( band * rowBytes );
+					for( dword r = band;  r-- > 0; )
+					{
+						const ubyte* pRow = reinterpret_cast<const ubyte*>(
+							pixels ) + (((HEIGHT - 1) - (y + r)) * rowBytes);
+						std::copy( pRow, pRow + rowBytes,
+							rows.begin() + (r * rowBytes) );
+					}
+
+					pWriter->writeRows( band, &(rows[0]) );
+				}
+				pWriter->finish();
+
+				delete pWriter;
+			}
+			catch( ... )
+			{
+				isFail = true;
+			}
+
+			isFail |= (outWhole.str() != outRows.str());
+
+			if( pOut && isVerbose ) *pOut << "48bit " << is48Bit <<
+				"  size " << outRows.str().size() << "\n";
+		}
+		if( pOut && isVerbose ) *pOut << "\n";
+
+		if( pOut ) *pOut << "rows writer : " <<
+			(!isFail ? "--- succeeded" : "*** failed") << "\n\n";
+		isOk &= !isFail;
+	}
+
+
 	if( pOut ) *pOut << (isOk ? "--- successfully" : "*** failurefully") <<
 		" completed " << "\n\n\n";
 
@@ -52,11 +52,15 @@ namespace p3tonemapper_format
  * * 24 or 48 bit pixels
  * * can include primaries and gamma
  * * allows byte, pixel, and row re-ordering
+ * * a choice of speed or size of compression
  * <br/>
  *
  * This implementation requires the libpng and zlib dynamic libraries when run.
  * (from, for example, libpng-1.2.8-bin and libpng-1.2.8-dep archives)<br/><br/>
  *
+ * The faster profiles use only zlib: they filter and deflate bands of rows in
+ * parallel, as independent parts of the one compressed stream.<br/><br/>
+ *
  * <cite>http://www.libpng.org/</cite>
  */
 namespace png
@@ -68,6 +72,16 @@ namespace png
 		IS_LO_ENDIAN = 4
 	};
 
+	enum EProfile
+	{
+		/// libpng, all filters tried, most compression
+		PROFILE_SIZE     = 0,
+		/// parallel, filters chosen per row, medium compression
+		PROFILE_BALANCED = 1,
+		/// parallel, sub or up filter chosen per row, least compression
+		PROFILE_SPEED    = 2
+	};
+
 
 	/**
 	 * Write PNG image.<br/><br/>
@@ -82,6 +96,7 @@ namespace png
 	 * @gamma              if zero, it is not written to image metadata
 	 * @is48Bit            true for 48 bit triples, false for 24
 	 * @orderingFlags      bit combination of EOrderingFlags values
+	 * @profile            EProfile value
 	 * @pTriples           array of byte triples, or word triples if is48Bit is
 	 *                     true
 	 *
@@ -96,9 +111,49 @@ namespace png
 		float        gamma,
 		bool         is48Bit,
 		dword        orderingFlags,
+		dword        profile,
 		const void*  pTriples,
 		ostream&     outBytes
 	);
+
+	/**
+	 * Start writing PNG image a band of rows at a time, as they are made
+	 * (with libpng, as PROFILE_SIZE).<br/><br/>
+	 *
+	 * Rows are then given top row first, R then G then B (IS_TOP_FIRST is
+	 * implied).
+	 *
+	 * (parameters as write)
+	 *
+	 * @return  new writer, owned by the caller (outBytes must outlive it)
+	 *
+	 * @exceptions throws char[] message exceptions
+	 */
+	ImageRowsWriter* makeRowsWriter
+	(
+		const char   pngLibraryPathName[],
+		dword        width,
+		dword        height,
+		const float* pPrimaries42,
+		float        gamma,
+		bool         is48Bit,
+		dword        orderingFlags,
+		ostream&     outBytes
+	);
+
+	/**
+	 * Keep the libpng and zlib libraries loaded, until released (instead of
+	 * loading them for each image written).
+	 *
+	 * @return  whether they loaded (if not, nothing is to be released, and
+	 *          each write loads them itself, as usual)
+	 */
+	bool  acquireLibraries
+	(
+		const char pngLibraryPathName[]
+	);
+
+	void  releaseLibraries();
 }
 
 
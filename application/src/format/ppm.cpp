@@ -29,6 +29,8 @@
 
 
 #include <ostream>
+#include <sstream>
+#include <vector>
 #include "StringConstants.hpp"
 
 #include "ppm.hpp"   /// own header is included last
@@ -153,28 +155,26 @@ void p3tonemapper_format::ppm::write
 		}
 
 		// write header
-		{
-			// write ID
-			out << PPM_ID << '\n';
-			out << "# " << hxa7241_general::HXA7241_URI() << "\n\n";
-
-			// write width, height, maxval
-			out << width <<  ' ' << height << '\n';
-			out << (is48Bit ? 65535 : 255) << '\n';
-		}
+		out << makeHeader( width, height, is48Bit );
 
 		// write pixels
 		if( 0 != pTriples)
 		{
+			// (a row is assembled, then written whole)
+			const dword       channelBytes = is48Bit ? 2 : 1;
+			std::vector<char> row( (width * 3 * channelBytes) + 1 );
+
 			// write rows (top first)
 			for( dword y = height;  y-- > 0; )
 			{
+				const dword rowIndex = (orderingFlags & IS_TOP_FIRST) != 0 ?
+					height - 1 - y : y;
+				char*       pRow     = &row[0];
+
 				// write pixels (left first)
 				for( dword x = 0;  x < width;  ++x )
 				{
-					const dword row    = (orderingFlags & IS_TOP_FIRST) != 0 ?
-						height - 1 - y : y;
-					const dword offset = ((row * width) + x) * 3;
+					const dword offset = ((rowIndex * width) + x) * 3;
 
 					// write channels (R then G then B)
 					for( dword c = 0;  c < 3;  ++c )
@@ -187,7 +187,7 @@ void p3tonemapper_format::ppm::write
 							const ubyte* pTriple =
 								static_cast<const ubyte*>(pTriples) + offset;
 
-							out << ubyte(pTriple[i]);
+							*(pRow++) = char(pTriple[i]);
 						}
 						// 48 bit
 						else
@@ -196,11 +196,13 @@ void p3tonemapper_format::ppm::write
 								static_cast<const uword*>(pTriples) + offset;
 
 							// msb first
-							out << ubyte((pTriple[i] & 0xFF00) >> 8);
-							out << ubyte( pTriple[i] & 0xFF);
+							*(pRow++) = char((pTriple[i] & 0xFF00) >> 8);
+							*(pRow++) = char( pTriple[i] & 0xFF);
 						}
 					}
 				}
+
+				out.write( &row[0], width * 3 * channelBytes );
 			}
 		}
 	}
@@ -215,6 +217,37 @@ void p3tonemapper_format::ppm::write
 }
 
 
+std::string p3tonemapper_format::ppm::makeHeader
+(
+	dword      width,
+	dword      height,
+	const bool is48Bit
+)
+{
+	// clamp dimensions to positive
+	if( width < 0 )
+	{
+		width = 0;
+	}
+	if( height < 0 )
+	{
+		height = 0;
+	}
+
+	std::ostringstream header;
+
+	// ID
+	header << PPM_ID << '\n';
+	header << "# " << hxa7241_general::HXA7241_URI() << "\n\n";
+
+	// width, height, maxval
+	header << width <<  ' ' << height << '\n';
+	header << (is48Bit ? 65535 : 255) << '\n';
+
+	return header.str();
+}
+
+
 
 
 
@@ -430,6 +463,30 @@ bool test_ppm
 	}
 
 
+	// header alone
+	{
+		bool isFail = false;
+
+		static const char* CORRECT[] = {
+			"P6\n# http://www.hxa7241.org/\n\n7 5\n255\n",
+			"P6\n# http://www.hxa7241.org/\n\n7 5\n65535\n" };
+
+		for( dword i = 0;  i < 2;  ++i )
+		{
+			const std::string header( makeHeader( 7, 5, 0 != i ) );
+			isFail |= (std::string(CORRECT[i]) != header);
+
+			if( pOut && isVerbose ) *pOut << header;
+		}
+
+		if( pOut && isVerbose ) *pOut << "\n";
+
+		if( pOut ) *pOut << "header : " <<
+			(!isFail ? "--- succeeded" : "*** failed") << "\n\n";
+		isOk &= !isFail;
+	}
+
+
 	if( pOut ) *pOut << (isOk ? "--- successfully" : "*** failurefully") <<
 		" completed " << "\n\n\n";
 
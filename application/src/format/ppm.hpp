@@ -33,6 +33,7 @@
 
 
 #include <iosfwd>
+#include <string>
 
 
 
@@ -98,6 +99,20 @@ namespace ppm
 		const void* pTriples,
 		ostream&    outBytes
 	);
+
+	/**
+	 * Make PPM header, for pixels put after it some other way (eg mapped
+	 * straight into the file).<br/><br/>
+	 *
+	 * pixels then are top row first, R then G then B, 48 bit words most
+	 * significant byte first.
+	 */
+	std::string  makeHeader
+	(
+		dword width,
+		dword height,
+		bool  is48Bit
+	);
 }
 
 
@@ -0,0 +1,464 @@
+/*--------------------------------------------------------------------
+
+   Perceptuum3 rendering components
+   Copyright (c) 2005, Harrison Ainsworth / HXA7241.
+
+   http://www.hxa7241.org/
+
+--------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later
+   version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+   MA  02110-1301  USA
+
+--------------------------------------------------------------------*/
+
+
+
+#include <string.h>
+#include <ostream>
+#include <vector>
+
+#include "qoi.hpp"   /// own header is included last
+
+
+using namespace p3tonemapper_format;
+
+
+
+
+/*
+
+https://qoiformat.org/qoi-specification.pdf
+
+A QOI file consists of a 14-byte header, followed by any number of data
+"chunks" and an 8-byte end marker.
+
+* header: magic "qoif", width and height (32 bit big-endian), channels (3 = RGB,
+  4 = RGBA), colorspace (0 = sRGB with linear alpha, 1 = all channels linear).
+* Images are encoded row by row, left to right, top to bottom. The decoder and
+  encoder start with {r: 0, g: 0, b: 0, a: 255} as the previous pixel value.
+* A running array[64] (zero-initialized) of previously seen pixel values is
+  maintained, indexed by: (r * 3 + g * 5 + b * 7 + a * 11) % 64.
+* chunks (tag bits first, values unsigned, differences wrapping):
+  QOI_OP_INDEX  00iiiiii              index into the array
+  QOI_OP_DIFF   01rrggbb              difference from previous, each -2..1,
+                                      with a bias of 2
+  QOI_OP_LUMA   10gggggg rrrrbbbb     green difference -32..31 (bias 32), then
+                                      red and blue minus green difference,
+                                      each -8..7 (bias 8)
+  QOI_OP_RUN    11rrrrrr              run of the previous pixel, 1..62 (bias -1)
+  QOI_OP_RGB    11111110 r g b
+  QOI_OP_RGBA   11111111 r g b a
+* end marker: seven 0x00 bytes, then 0x01.
+
+*/
+
+
+
+
+/// constants ------------------------------------------------------------------
+static const char QOI_ID[] = "qoif";
+
+static const ubyte QOI_OP_INDEX = 0x00;
+static const ubyte QOI_OP_DIFF  = 0x40;
+static const ubyte QOI_OP_LUMA  = 0x80;
+static const ubyte QOI_OP_RUN   = 0xC0;
+static const ubyte QOI_OP_RGB   = 0xFE;
+
+static const dword RUN_MAX = 62;
+
+static const char STREAM_EXCEPTION_MESSAGE[] =
+	"stream write failure, in QOI write";
+
+
+
+
+/// implementation -------------------------------------------------------------
+static ubyte* writeBigEndian
+(
+	udword value,
+	ubyte* pBytes
+);
+
+
+
+
+/// ----------------------------------------------------------------------------
+void p3tonemapper_format::qoi::write
+(
+	dword       width,
+	dword       height,
+	const bool  is48Bit,
+	const dword orderingFlags,
+	const void* pTriples,
+	ostream&    out
+)
+{
+	// enable stream exceptions
+	std::ios_base::iostate originalExceptionFlags = out.exceptions();
+	out.exceptions( ostream::badbit | ostream::failbit | ostream::eofbit );
+
+	try
+	{
+		// clamp dimensions to positive
+		width  = (width  >= 0) ? width  : 0;
+		height = (height >= 0) ? height : 0;
+
+		// a row of encoding at a time
+		// (header or end marker, and every pixel given whole, fits)
+		std::vector<ubyte> bytes( 14 + 8 + (width * 4) );
+		ubyte* pBytes = &(bytes[0]);
+
+		// write header
+		{
+			::memcpy( pBytes, QOI_ID, 4 );
+			pBytes = writeBigEndian( width,  pBytes + 4 );
+			pBytes = writeBigEndian( height, pBytes );
+			*(pBytes++) = 3;
+			*(pBytes++) = 0;
+		}
+
+		// write pixels
+		if( 0 != pTriples )
+		{
+			// recent pixels, as rgba, with previous starting opaque black
+			udword recents[64];
+			::memset( recents, 0, sizeof(recents) );
+			udword previous = 0x000000FFu;
+			dword  run      = 0;
+
+			const dword channel0 = (orderingFlags & IS_BGR) ? 2 : 0;
+			const dword channel2 = 2 - channel0;
+
+			// write rows (top first)
+			for( dword y = height;  y-- > 0; )
+			{
+				const dword row = (orderingFlags & IS_TOP_FIRST) ?
+					height - 1 - y : y;
+				const dword offset = row * width * 3;
+
+				const ubyte* pBytes8  = static_cast<const ubyte*>(pTriples) +
+					offset;
+				const uword* pWords16 = static_cast<const uword*>(pTriples) +
+					offset;
+
+				// write pixels (left first)
+				for( dword x = 0;  x < width * 3;  x += 3 )
+				{
+					// get channels (high bytes of words)
+					const dword r = !is48Bit ? pBytes8[x + channel0] :
+						(pWords16[x + channel0] >> 8);
+					const dword g = !is48Bit ? pBytes8[x + 1] :
+						(pWords16[x + 1] >> 8);
+					const dword b = !is48Bit ? pBytes8[x + channel2] :
+						(pWords16[x + channel2] >> 8);
+
+					const udword pixel = (udword(r) << 24) | (udword(g) << 16) |
+						(udword(b) << 8) | 0xFFu;
+
+					// same as previous: extend run
+					if( pixel == previous )
+					{
+						if( ++run == RUN_MAX )
+						{
+							*(pBytes++) = ubyte(QOI_OP_RUN | (run - 1));
+							run = 0;
+						}
+						continue;
+					}
+
+					// end run
+					if( 0 != run )
+					{
+						*(pBytes++) = ubyte(QOI_OP_RUN | (run - 1));
+						run = 0;
+					}
+
+					// recent, or new
+					const dword hash = ((r * 3) + (g * 5) + (b * 7) + (0xFF * 11))
+						& 63;
+					if( recents[hash] == pixel )
+					{
+						*(pBytes++) = ubyte(QOI_OP_INDEX | hash);
+					}
+					else
+					{
+						recents[hash] = pixel;
+
+						// differences from previous (wrapping)
+						const dword dr = byte( r - (previous >> 24) );
+						const dword dg = byte( g - ((previous >> 16) & 0xFF) );
+						const dword db = byte( b - ((previous >>  8) & 0xFF) );
+						const dword drg = dr - dg;
+						const dword dbg = db - dg;
+
+						if( (udword(dr + 2) < 4) & (udword(dg + 2) < 4) &
+							(udword(db + 2) < 4) )
+						{
+							*(pBytes++) = ubyte(QOI_OP_DIFF | ((dr + 2) << 4) |
+								((dg + 2) << 2) | (db + 2));
+						}
+						else if( (udword(dg + 32) < 64) & (udword(drg + 8) < 16) &
+							(udword(dbg + 8) < 16) )
+						{
+							*(pBytes++) = ubyte(QOI_OP_LUMA | (dg + 32));
+							*(pBytes++) = ubyte(((drg + 8) << 4) | (dbg + 8));
+						}
+						else
+						{
+							*(pBytes++) = QOI_OP_RGB;
+							*(pBytes++) = ubyte(r);
+							*(pBytes++) = ubyte(g);
+							*(pBytes++) = ubyte(b);
+						}
+					}
+
+					previous = pixel;
+				}
+
+				// write row's encoding
+				out.write( reinterpret_cast<const char*>(&(bytes[0])),
+					pBytes - &(bytes[0]) );
+				pBytes = &(bytes[0]);
+			}
+
+			// end run
+			if( 0 != run )
+			{
+				*(pBytes++) = ubyte(QOI_OP_RUN | (run - 1));
+			}
+		}
+
+		// write end marker
+		{
+			::memset( pBytes, 0, 7 );
+			pBytes[7] = 1;
+			pBytes += 8;
+
+			out.write( reinterpret_cast<const char*>(&(bytes[0])),
+				pBytes - &(bytes[0]) );
+		}
+	}
+	catch( ... )
+	{
+		out.exceptions( originalExceptionFlags );
+
+		throw STREAM_EXCEPTION_MESSAGE;
+	}
+
+	out.exceptions( originalExceptionFlags );
+}
+
+
+ubyte* writeBigEndian
+(
+	const udword value,
+	ubyte*       pBytes
+)
+{
+	pBytes[0] = ubyte(value >> 24);
+	pBytes[1] = ubyte(value >> 16);
+	pBytes[2] = ubyte(value >>  8);
+	pBytes[3] = ubyte(value);
+
+	return pBytes + 4;
+}
+
+
+
+
+
+
+
+
+/// test -----------------------------------------------------------------------
+#ifdef TESTING
+
+
+#include <sstream>
+#include <string>
+
+
+namespace p3tonemapper_format
+{
+namespace qoi
+{
+	using namespace hxa7241;
+
+
+bool test_qoi
+(
+	std::ostream* pOut,
+	const bool    isVerbose,
+	const dword   //seed
+)
+{
+	bool isOk = true;
+
+	if( pOut ) *pOut << "[ test_qoi ]\n\n";
+
+
+	// every kind of chunk
+	{
+		// one row: run, diff, rgb, luma, rgb (zero-initialized recent is not
+		// opaque black), index, run at end
+		static const ubyte PIXELS[] = {
+			0, 0, 0,  0, 0, 0,  1, 255, 0,  10, 250, 4,  12, 0, 6,  1, 255, 0,
+			1, 255, 0 };
+
+		static const ubyte CORRECT[] = {
+			0x71, 0x6F, 0x69, 0x66, 0x00, 0x00, 0x00, 0x07,
+			0x00, 0x00, 0x00, 0x01, 0x03, 0x00,
+			0xC1, 0x76, 0xFE, 0x0A, 0xFA, 0x04, 0xA6, 0x44, 0x33, 0xC0,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01 };
+
+		std::ostringstream outs( std::ostringstream::binary );
+		p3tonemapper_format::qoi::write( 7, 1, false, 0, PIXELS, outs );
+		const std::string buf( outs.str() );
+
+		bool isFail = (buf.size() != sizeof(CORRECT));
+		for( dword i = 0;  !isFail && (i < dword(sizeof(CORRECT)));  ++i )
+		{
+			isFail |= (CORRECT[i] != ubyte(buf[i]));
+		}
+
+		if( pOut && isVerbose ) *pOut << "size " << buf.size() << "\n\n";
+
+		if( pOut ) *pOut << "chunks : " <<
+			(!isFail ? "--- succeeded" : "*** failed") << "\n\n";
+		isOk &= !isFail;
+	}
+
+
+	// decodes the same, for each pixel size and ordering
+	{
+		bool isFail = false;
+
+		static const dword WIDTH  = 37;
+		static const dword HEIGHT = 23;
+
+		// smooth, with flat areas (runs), and some noise
+		uword words[ WIDTH * HEIGHT * 3 ];
+		ubyte bytes[ WIDTH * HEIGHT * 3 ];
+		for( dword i = WIDTH * HEIGHT * 3;  i-- > 0; )
+		{
+			const dword x = (i / 3) % WIDTH;
+			const dword y = (i / 3) / WIDTH;
+			words[i] = (x < 9) ? uword(0x4000) : uword( (x * 900) + (y * 500) +
+				((i % 3) * 7000) + (((i * 2654435761u) >> 22) & 0x3FF) );
+			bytes[i] = ubyte(words[i] >> 8);
+		}
+
+		for( dword t = 0;  t < 4;  ++t )
+		{
+			const bool  is48Bit = 0 != (t & 1);
+			const dword flags   = (t & 2) ? (IS_TOP_FIRST | IS_BGR) : 0;
+
+			std::ostringstream outs( std::ostringstream::binary );
+			p3tonemapper_format::qoi::write( WIDTH, HEIGHT, is48Bit, flags,
+				is48Bit ? static_cast<const void*>(words) : bytes, outs );
+			const std::string buf( outs.str() );
+
+			// decode
+			std::vector<ubyte> decoded;
+			{
+				ubyte recents[64][4];
+				::memset( recents, 0, sizeof(recents) );
+				ubyte pixel[4] = { 0, 0, 0, 255 };
+
+				for( udword pos = 14;  (pos + 8) < buf.size(); )
+				{
+					const ubyte tag = ubyte(buf[pos++]);
+					dword run = 1;
+
+					if( QOI_OP_RGB == tag )
+					{
+						pixel[0] = ubyte(buf[pos++]);
+						pixel[1] = ubyte(buf[pos++]);
+						pixel[2] = ubyte(buf[pos++]);
+					}
+					else if( QOI_OP_INDEX == (tag & 0xC0) )
+					{
+						::memcpy( pixel, recents[tag], 4 );
+					}
+					else if( QOI_OP_DIFF == (tag & 0xC0) )
+					{
+						pixel[0] = ubyte(pixel[0] + ((tag >> 4) & 3) - 2);
+						pixel[1] = ubyte(pixel[1] + ((tag >> 2) & 3) - 2);
+						pixel[2] = ubyte(pixel[2] + ( tag       & 3) - 2);
+					}
+					else if( QOI_OP_LUMA == (tag & 0xC0) )
+					{
+						const ubyte next = ubyte(buf[pos++]);
+						const dword dg   = (tag & 0x3F) - 32;
+						pixel[0] = ubyte(pixel[0] + dg + (next >> 4) - 8);
+						pixel[1] = ubyte(pixel[1] + dg);
+						pixel[2] = ubyte(pixel[2] + dg + (next & 0x0F) - 8);
+					}
+					else
+					{
+						run = (tag & 0x3F) + 1;
+					}
+
+					::memcpy( recents[((pixel[0] * 3) + (pixel[1] * 5) +
+						(pixel[2] * 7) + (pixel[3] * 11)) & 63], pixel, 4 );
+					for( ;  run-- > 0; )
+					{
+						decoded.insert( decoded.end(), pixel, pixel + 3 );
+					}
+				}
+			}
+
+			// compare
+			dword diffs = (decoded.size() != (WIDTH * HEIGHT * 3)) ? 1 : 0;
+			for( dword i = 0;  (0 == diffs) && (i < WIDTH * HEIGHT * 3);  ++i )
+			{
+				const dword y = (i / 3) / WIDTH;
+				const dword c = ((flags & IS_BGR) ? 2 - (i % 3) : (i % 3));
+				const dword j = ((((flags & IS_TOP_FIRST) ? y :
+					HEIGHT - 1 - y) * WIDTH) + ((i / 3) % WIDTH)) * 3 + c;
+				diffs += dword(decoded[i] != bytes[j]);
+			}
+			isFail |= (0 != diffs);
+
+			if( pOut && isVerbose ) *pOut << "48bit " << is48Bit << "  flags " <<
+				flags << "  size " << buf.size() << "  diffs " << diffs << "\n";
+		}
+		if( pOut && isVerbose ) *pOut << "\n";
+
+		if( pOut ) *pOut << "round trip : " <<
+			(!isFail ? "--- succeeded" : "*** failed") << "\n\n";
+		isOk &= !isFail;
+	}
+
+
+	if( pOut ) *pOut << (isOk ? "--- successfully" : "*** failurefully") <<
+		" completed " << "\n\n\n";
+
+	if( pOut ) pOut->flush();
+
+
+	return isOk;
+}
+
+
+}//namespace
+}//namespace
+
+
+#endif//TESTING
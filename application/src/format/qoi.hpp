@@ -0,0 +1,95 @@
+/*--------------------------------------------------------------------
+
+   Perceptuum3 rendering components
+   Copyright (c) 2005, Harrison Ainsworth / HXA7241.
+
+   http://www.hxa7241.org/
+
+--------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later
+   version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+   MA  02110-1301  USA
+
+--------------------------------------------------------------------*/
+
+
+
+#ifndef qoi_h
+#define qoi_h
+
+
+#include <iosfwd>
+
+
+
+
+#include "p3tonemapper_format.hpp"
+namespace p3tonemapper_format
+{
+	using std::ostream;
+
+
+/**
+ * Output for the QOI (Quite OK Image) format.<br/><br/>
+ *
+ * QOIs are losslessly compressed 24 or 32 bit images, encoded in one simple
+ * pass: each pixel is a run of the last, a recently seen color, a small
+ * difference from the last, or given whole. So they are much smaller than a
+ * PPM, and much faster to make than a PNG.<br/><br/>
+ *
+ * <cite>https://qoiformat.org/qoi-specification.pdf</cite>
+ */
+namespace qoi
+{
+	enum EOrderingFlags
+	{
+		IS_TOP_FIRST = 1,
+		IS_BGR       = 2
+	};
+
+
+	/**
+	 * Write QOI image.<br/><br/>
+	 *
+	 * triples are bottom row first, R then G then B.
+	 *
+	 * QOI channels are only 8 bit, so 48 bit triples are reduced to their
+	 * high bytes.
+	 *
+	 * @is48Bit  true for 48 bit triples, false for 24
+	 *
+	 * @exceptions throws char[] message exceptions
+	 */
+	void  write
+	(
+		dword       width,
+		dword       height,
+		bool        is48Bit,
+		dword       orderingFlags,
+		const void* pTriples,
+		ostream&    outBytes
+	);
+}
+
+
+}//namespace
+
+
+
+
+#endif//qoi_h
@@ -30,11 +30,20 @@
 
 #include <math.h>
 
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
 #include <istream>
+#include <sstream>
 #include <string>
 #include <vector>
 #include <exception>
 
+#include "Processors.hpp"
+#include "Thread.hpp"
+#include "ImageDecodeReceiver.hpp"
+
 #include "rgbe.hpp"   /// own header is included last
 
 
@@ -60,9 +69,61 @@ static const char STREAM_EXCEPTION_MESSAGE[] =
 	"stream read failure, in RGBE read";
 
 
+/// statics
+
+// scale for each exponent byte: 2^(e - (128 + 8)), or 0 for tiny values
+// (built once, at load, so no locking is needed)
+namespace
+{
+
+class RgbeScales
+{
+public:
+	RgbeScales()
+	{
+		for( dword i = 0;  i < 256;  ++i )
+		{
+			scales_m[i] = (10 < i) ? ::ldexpf( 1.0f, i - (128 + 8) ) : 0.0f;
+		}
+	}
+
+	float operator[]( const ubyte exponent ) const
+	{
+		return scales_m[ exponent ];
+	}
+
+private:
+	float scales_m[256];
+};
+
+const RgbeScales RGBE_SCALES;
+
+}
+
+
 
 
 /// declarations ---------------------------------------------------------------
+static void readAll
+(
+	istream&            in,
+	std::vector<ubyte>& bytes
+);
+
+
+static udword readHeader
+(
+	const ubyte* pBytes,
+	udword       length,
+	float*       pPrimaries8,
+	float&       exposure,
+	dword&       width,
+	dword&       height,
+	bool&        isRle,
+	bool&        isInverted
+);
+
+
 static bool readTaggedValues
 (
 	istream& in,
@@ -81,76 +142,330 @@ static bool readDimensions
 
 static void readImage
 (
-	istream&    in,
-	const dword width,
-	const dword height,
-	const bool  isRle,
-	const bool  isInverted,
-	float*      pRgbTriples
+	const ubyte*         pBytes,
+	const ubyte*         pEnd,
+	const dword          width,
+	const dword          height,
+	const bool           isRle,
+	const bool           isInverted,
+	float*               pRgbTriples,
+	ImageDecodeReceiver* pReceiver
 );
 
 
-static void convertRgbeToFloats
+static void readRleRows
 (
-	ubyte rgbe[4],
-	float rgb[3]
+	const ubyte*         pBytes,
+	const ubyte*         pEnd,
+	const dword          width,
+	const dword          height,
+	const bool           isInverted,
+	float*               pRgbTriples,
+	ImageDecodeReceiver* pReceiver
 );
 
 
+static const ubyte* readRleRow
+(
+	const ubyte* pBytes,
+	const ubyte* pEnd,
+	dword        width,
+	ubyte*       pRgbeRow
+);
+
+
+static const ubyte* skipRleRow
+(
+	const ubyte* pBytes,
+	const ubyte* pEnd,
+	dword        width
+);
+
+
+static void convertRgbesToFloats
+(
+	const ubyte* pRgbes,
+	dword        count,
+	float*       pRgbTriples
+);
+
+
+
+
+/// parallel run-length decoding -----------------------------------------------
+namespace
+{
+
+/**
+ * Decodes a band of run-length rows, from their indexed starts.<br/><br/>
+ *
+ * The band is of image rows (lowest first), read from wherever they are in
+ * the file.
+ */
+class RleBandDecoder : public hxa7241_general::Thread
+{
+public:
+	RleBandDecoder()
+	 :	ppRowStarts_m( 0 )
+	 ,	pEnd_m       ( 0 )
+	 ,	width_m      ( 0 )
+	 ,	height_m     ( 0 )
+	 ,	rowBegin_m   ( 0 )
+	 ,	rowEnd_m     ( 0 )
+	 ,	isInverted_m ( false )
+	 ,	pRgbTriples_m( 0 )
+	{
+	}
+
+	void set
+	(
+		const ubyte*const* ppRowStarts,
+		const ubyte*       pEnd,
+		const dword        width,
+		const dword        height,
+		const dword        rowBegin,
+		const dword        rowEnd,
+		const bool         isInverted,
+		float*             pRgbTriples
+	)
+	{
+		ppRowStarts_m = ppRowStarts;
+		pEnd_m        = pEnd;
+		width_m       = width;
+		height_m      = height;
+		rowBegin_m    = rowBegin;
+		rowEnd_m      = rowEnd;
+		isInverted_m  = isInverted;
+		pRgbTriples_m = pRgbTriples;
+	}
+
+	void decode
+	(
+		ImageDecodeReceiver* pReceiver
+	)
+	{
+		std::vector<ubyte> rgbeRow( width_m * 4 );
+
+		for( dword row = rowBegin_m;  row < rowEnd_m;  ++row )
+		{
+			readRleRow( ppRowStarts_m[isInverted_m ? height_m - 1 - row : row],
+				pEnd_m, width_m, &(rgbeRow[0]) );
+
+			float* pRow = pRgbTriples_m + (row * width_m * 3);
+
+			convertRgbesToFloats( &(rgbeRow[0]), width_m, pRow );
+
+			// give each row as soon as it is decoded
+			if( pReceiver )
+			{
+				pReceiver->receiveRows( 1, pRow );
+			}
+		}
+	}
+
+	void giveRows
+	(
+		ImageDecodeReceiver& receiver
+	) const
+	{
+		receiver.receiveRows( rowEnd_m - rowBegin_m,
+			pRgbTriples_m + (rowBegin_m * width_m * 3) );
+	}
+
+protected:
+	virtual void run()
+	{
+		decode( 0 );
+	}
+
+private:
+	const ubyte*const* ppRowStarts_m;
+	const ubyte*       pEnd_m;
+	dword              width_m;
+	dword              height_m;
+	dword              rowBegin_m;
+	dword              rowEnd_m;
+	bool               isInverted_m;
+	float*             pRgbTriples_m;
+};
+
+}
+
+
 
 
 /// ----------------------------------------------------------------------------
 void p3tonemapper_format::rgbe::read
 (
-	istream&   in,
-	const bool isInvert,
-	dword&     width,
-	dword&     height,
-	float*     pPrimaries8,
-	float&     exposure,
-	float*&    pRgbTriples
+	istream&                   in,
+	const bool                 isInvert,
+	dword&                     width,
+	dword&                     height,
+	float*                     pPrimaries8,
+	float&                     exposure,
+	float*&                    pRgbTriples,
+	ImageDecodeReceiver* const pReceiver
 )
 {
 	pRgbTriples = 0;
 
-	// enable stream exceptions
-	std::ios_base::iostate originalExceptionFlags = in.exceptions();
-	in.exceptions( istream::badbit | istream::eofbit );   // istream::failbit
+	// read rest of stream, in large blocks
+	std::vector<ubyte> bytes;
+	{
+		// enable stream exceptions (eof is expected now)
+		std::ios_base::iostate originalExceptionFlags = in.exceptions();
+		in.exceptions( istream::badbit );
+
+		try
+		{
+			readAll( in, bytes );
+		}
+		catch( ... )
+		{
+			in.exceptions( originalExceptionFlags );
+
+			throw STREAM_EXCEPTION_MESSAGE;
+		}
+
+		in.clear();
+		in.exceptions( originalExceptionFlags );
+	}
+
+	p3tonemapper_format::rgbe::read( bytes.empty() ? 0 : &(bytes[0]),
+		udword(bytes.size()), isInvert, width, height, pPrimaries8, exposure,
+		pRgbTriples, pReceiver );
+}
+
+
+void p3tonemapper_format::rgbe::read
+(
+	const ubyte*               pBytes,
+	const udword               length,
+	const bool                 isInvert,
+	dword&                     width,
+	dword&                     height,
+	float*                     pPrimaries8,
+	float&                     exposure,
+	float*&                    pRgbTriples,
+	ImageDecodeReceiver* const pReceiver
+)
+{
+	pRgbTriples = 0;
 
 	try
 	{
 		// read header
 		bool isRle      = false;
 		bool isInverted = false;
+		const udword headerLength = readHeader( pBytes, length, pPrimaries8,
+			exposure, width, height, isRle, isInverted );
+		if( pReceiver )
 		{
-			// skip ID line
-			// "#?RADIANCE\0x0A"
-			in.ignore( DWORD_MAX, ubyte(0x0A) );
-
-			// read info
-			isRle = readTaggedValues( in, pPrimaries8, exposure );
-
-			// read dimensions
-			isInverted = readDimensions( in, width, height );
+			pReceiver->receiveHeader( width, height, pPrimaries8,
+				(exposure != 0.0f) ? 1.0f / exposure : 0.0f, false );
 		}
 
 		// allocate pixels storage
 		pRgbTriples = new float[ width * height * 3 ];
 
 		// read image
-		readImage( in, width, height, isRle, isInverted ^ isInvert, pRgbTriples );
+		readImage( pBytes + headerLength, pBytes + length, width, height, isRle,
+			isInverted ^ isInvert, pRgbTriples, pReceiver );
 	}
 	catch( ... )
 	{
 		delete[] pRgbTriples;
 		pRgbTriples = 0;
 
-		in.exceptions( originalExceptionFlags );
+		throw STREAM_EXCEPTION_MESSAGE;
+	}
+}
+
+
+void readAll
+(
+	istream&            in,
+	std::vector<ubyte>& bytes
+)
+{
+	// size known by seeking: read in one
+	const istream::pos_type start = in.tellg();
+	if( istream::pos_type(-1) != start )
+	{
+		in.seekg( 0, std::ios_base::end );
+		const std::streamoff size = in.tellg() - start;
+		in.seekg( start );
 
+		bytes.resize( size_t(size) );
+		if( 0 < size )
+		{
+			in.read( reinterpret_cast<char*>(&(bytes[0])), size );
+			bytes.resize( size_t(in.gcount()) );
+		}
+	}
+	// size unknown (eg a pipe): read blocks until the end
+	else
+	{
+		static const dword BLOCK_SIZE = 1 << 20;
+		for( ;; )
+		{
+			const size_t filled = bytes.size();
+			bytes.resize( filled + BLOCK_SIZE );
+			in.read( reinterpret_cast<char*>(&(bytes[filled])), BLOCK_SIZE );
+			bytes.resize( filled + size_t(in.gcount()) );
+
+			if( in.gcount() < BLOCK_SIZE )
+			{
+				break;
+			}
+		}
+	}
+}
+
+
+udword readHeader
+(
+	const ubyte* pBytes,
+	const udword length,
+	float*       pPrimaries8,
+	float&       exposure,
+	dword&       width,
+	dword&       height,
+	bool&        isRle,
+	bool&        isInverted
+)
+{
+	// find header end: after the blank line, then the dimensions line
+	udword end = 1;
+	for( ;  (end < length) && !((0x0A == pBytes[end - 1]) &
+		(0x0A == pBytes[end]));  ++end )
+	{
+	}
+	for( ++end;  (end < length) && (0x0A != pBytes[end]);  ++end )
+	{
+	}
+	if( end >= length )
+	{
 		throw STREAM_EXCEPTION_MESSAGE;
 	}
+	++end;
+
+	// parse header text as a stream
+	std::istringstream in( std::string( reinterpret_cast<const char*>(pBytes),
+		end ), std::istringstream::in | std::istringstream::binary );
+	in.exceptions( istream::badbit | istream::eofbit );   // istream::failbit
+
+	// skip ID line
+	// "#?RADIANCE\0x0A"
+	in.ignore( DWORD_MAX, ubyte(0x0A) );
+
+	// read info
+	isRle = readTaggedValues( in, pPrimaries8, exposure );
 
-	in.exceptions( originalExceptionFlags );
+	// read dimensions
+	isInverted = readDimensions( in, width, height );
+
+	return end;
 }
 
 
@@ -334,142 +649,314 @@ bool readDimensions
 }
 
 
+
+
 void readImage
 (
-	istream&    in,
-	const dword width,
-	const dword height,
-	const bool  isRle,
-	const bool  isInverted,
-	float*      pRgbTriples
+	const ubyte*               pBytes,
+	const ubyte*               pEnd,
+	const dword                width,
+	const dword                height,
+	const bool                 isRle,
+	const bool                 isInverted,
+	float*                     pRgbTriples,
+	ImageDecodeReceiver* const pReceiver
 )
 {
 	// plain
 	if( !isRle | ((width < 8) | (width > 0x7FFF)) )
 	{
-		// read rows
-		for( dword y = 0;  y < height;  ++y )
+		// check all rows are there
+		const dword rowBytes = width * 4;
+		if( (0 != rowBytes) && (((pEnd - pBytes) / rowBytes) < height) )
 		{
-			float* pPixel = pRgbTriples +
-				((isInverted ? height - 1 - y : y) * width * 3);
+			throw STREAM_EXCEPTION_MESSAGE;
+		}
 
-			// read pixels
-			for( dword x = 0;  x < width;  ++x, pPixel += 3 )
-			{
-				char rgbe[4];
-				in.read( rgbe, sizeof(rgbe) );
+		// read rows, lowest first, from wherever they are in the file
+		for( dword row = 0;  row < height;  ++row )
+		{
+			float* pRow = pRgbTriples + (row * width * 3);
+
+			convertRgbesToFloats( pBytes +
+				((isInverted ? height - 1 - row : row) * rowBytes), width, pRow );
 
-				convertRgbeToFloats( reinterpret_cast<ubyte*>(rgbe), pPixel );
+			if( pReceiver )
+			{
+				pReceiver->receiveRows( 1, pRow );
 			}
 		}
 	}
 	// run-length encoded
 	else
 	{
-		using std::vector;
-		vector<ubyte> channels[] = {
-			vector<ubyte>( width ),
-			vector<ubyte>( width ),
-			vector<ubyte>( width ),
-			vector<ubyte>( width ) };
+		readRleRows( pBytes, pEnd, width, height, isInverted, pRgbTriples,
+			pReceiver );
+	}
+}
 
-		// read rows
-		for( dword row = 0;  row < height;  ++row )
+
+void readRleRows
+(
+	const ubyte*               pBytes,
+	const ubyte*               pEnd,
+	const dword                width,
+	const dword                height,
+	const bool                 isInverted,
+	float*                     pRgbTriples,
+	ImageDecodeReceiver* const pReceiver
+)
+{
+	// index row starts, by walking the run headers
+	// (rows are independent, but their lengths vary)
+	std::vector<const ubyte*> rowStarts( height + 1 );
+	for( dword row = 0;  row < height;  ++row )
+	{
+		rowStarts[row] = pBytes;
+		pBytes = skipRleRow( pBytes, pEnd, width );
+	}
+	rowStarts[height] = pBytes;
+
+	// a band of rows per processor (but not too small a band)
+	static const dword MIN_BAND_ROWS = 16;
+	const dword processorCount = hxa7241_general::getProcessorCount();
+	dword bandCount = height / MIN_BAND_ROWS;
+	bandCount = (bandCount < processorCount) ? bandCount : processorCount;
+	bandCount = (bandCount > 1) ? bandCount : 1;
+
+	RleBandDecoder* pDecoders = new RleBandDecoder[ bandCount ];
+	for( dword i = 0;  i < bandCount;  ++i )
+	{
+		pDecoders[i].set( &(rowStarts[0]), pEnd, width, height,
+			(height * i) / bandCount, (height * (i + 1)) / bandCount,
+			isInverted, pRgbTriples );
+	}
+
+	// run all but the first on other threads, and the first on this one
+	// (giving its rows as it goes)
+	const char* pFailMessage = 0;
+	dword       started      = 1;
+	try
+	{
+		for( ;  started < bandCount;  ++started )
+		{
+			pDecoders[started].start();
+		}
+
+		pDecoders[0].decode( pReceiver );
+	}
+	catch( const char*const pMessage )
+	{
+		pFailMessage = pMessage;
+	}
+	catch( ... )
+	{
+		pFailMessage = STREAM_EXCEPTION_MESSAGE;
+	}
+
+	// wait for all started (giving the rows of each band in turn)
+	for( dword i = 1;  i < started;  ++i )
+	{
+		try
 		{
-			// ignore leader
+			pDecoders[i].join();
+
+			if( pReceiver && !pFailMessage )
 			{
-				in.ignore( 4 );
+				pDecoders[i].giveRows( *pReceiver );
+			}
+		}
+		catch( const char*const pMessage )
+		{
+			pFailMessage = pMessage;
+		}
+		catch( ... )
+		{
+			pFailMessage = STREAM_EXCEPTION_MESSAGE;
+		}
+	}
+
+	delete[] pDecoders;
 
-				// read 4 bytes
-				//char bytes[4];
-				//in.read( bytes, sizeof(bytes) );
+	if( 0 != pFailMessage )
+	{
+		throw pFailMessage;
+	}
+}
 
-				// check
-				// (bytes[0] == 2) & (bytes[1] == 2) & ((bytes[2] & 0x80) == 0)
-				// (dword(ubyte(bytes[2])) << 8) | dword(ubyte(bytes[3]))) == width
 
-				// ... why bother ?
+const ubyte* readRleRow
+(
+	const ubyte* pBytes,
+	const ubyte* pEnd,
+	const dword  width,
+	ubyte*       pRgbeRow
+)
+{
+	// ignore leader
+	// (2, 2, width high byte, width low byte ... why bother checking ?)
+	if( (pEnd - pBytes) < 4 )
+	{
+		throw STREAM_EXCEPTION_MESSAGE;
+	}
+	pBytes += 4;
+
+	// read channels, interleaving them into pixels
+	for( dword c = 0;  c < 4;  ++c )
+	{
+		// read runs
+		ubyte* pChannel = pRgbeRow + c;
+		for( dword p = 0;  p < width; )
+		{
+			if( pBytes >= pEnd )
+			{
+				throw STREAM_EXCEPTION_MESSAGE;
+			}
+
+			// read run prefix byte
+			const dword runPrefix = *(pBytes++);
+			const bool  isRunSame = runPrefix > 128;
+
+			// clamp length
+			dword runLength = runPrefix - (isRunSame ? 128 : 0);
+			{
+				const dword remaining = width - p;
+				runLength = (runLength <= remaining) ? runLength : remaining;
 			}
 
-			// read pixels
+			// read or duplicate bytes
+			if( isRunSame )
 			{
-				// read channels
-				for( dword c = 0;  c < 4;  ++c )
+				// read value
+				if( pBytes >= pEnd )
 				{
-					// read runs
-					ubyte* pChannel = &(channels[c][0]);
-					for( dword p = 0;  p < width; )
-					{
-						// read run prefix byte
-						const dword runPrefix = ubyte(in.get());
-						const bool  isRunSame = runPrefix > 128;
-
-						// clamp length
-						dword runLength = runPrefix - (isRunSame ? 128 : 0);
-						{
-							const dword remaining = width - p;
-							runLength = (runLength <= remaining) ? runLength : remaining;
-						}
-
-						// read or duplicate bytes
-						if( isRunSame )
-						{
-							// read value
-							const ubyte value = ubyte(in.get());
-
-							// duplicate value
-							for( dword r = runLength;  r-- > 0;  ++p )
-							{
-								pChannel[ p ] = value;
-							}
-						}
-						else
-						{
-							// read values
-							in.read( reinterpret_cast<char*>(pChannel + p), runLength );
-							p += runLength;
-						}
-					}
+					throw STREAM_EXCEPTION_MESSAGE;
 				}
+				const ubyte value = *(pBytes++);
 
-				// collate channels into pixels
-				float* pPixel = pRgbTriples +
-					((isInverted ? height - 1 - row : row) * width * 3);
-				for( dword p = 0;  p < width;  ++p, pPixel += 3 )
+				// duplicate value
+				for( dword r = runLength;  r-- > 0;  ++p )
 				{
-					ubyte rgbe[4];
-					for( dword c = 4;  c-- > 0; )
-					{
-						rgbe[c] = channels[c][p];
-					}
-
-					convertRgbeToFloats( rgbe, pPixel );
+					pChannel[ p * 4 ] = value;
+				}
+			}
+			else
+			{
+				// read values
+				if( (pEnd - pBytes) < runLength )
+				{
+					throw STREAM_EXCEPTION_MESSAGE;
+				}
+				for( dword r = runLength;  r-- > 0;  ++p )
+				{
+					pChannel[ p * 4 ] = *(pBytes++);
 				}
 			}
 		}
 	}
+
+	return pBytes;
 }
 
 
-void convertRgbeToFloats
+const ubyte* skipRleRow
 (
-	ubyte rgbe[4],
-	float rgb[3]
+	const ubyte* pBytes,
+	const ubyte* pEnd,
+	const dword  width
 )
 {
-	if( 10 < rgbe[3] )
+	// skip leader
+	if( (pEnd - pBytes) < 4 )
 	{
-		const float a = ::ldexpf( 1.0f, dword(rgbe[3]) - (128 + 8) );
+		throw STREAM_EXCEPTION_MESSAGE;
+	}
+	pBytes += 4;
 
-		rgb[0] = (float(rgbe[0]) + 0.5f) * a;
-		rgb[1] = (float(rgbe[1]) + 0.5f) * a;
-		rgb[2] = (float(rgbe[2]) + 0.5f) * a;
+	// skip channels, run by run (as readRleRow, but without writing)
+	for( dword c = 0;  c < 4;  ++c )
+	{
+		for( dword p = 0;  p < width; )
+		{
+			if( pBytes >= pEnd )
+			{
+				throw STREAM_EXCEPTION_MESSAGE;
+			}
+
+			const dword runPrefix = *(pBytes++);
+			const bool  isRunSame = runPrefix > 128;
+
+			dword runLength = runPrefix - (isRunSame ? 128 : 0);
+			{
+				const dword remaining = width - p;
+				runLength = (runLength <= remaining) ? runLength : remaining;
+			}
+
+			// a same-run has one value byte, a literal-run has all
+			const dword runBytes = isRunSame ? 1 : runLength;
+			if( (pEnd - pBytes) < runBytes )
+			{
+				throw STREAM_EXCEPTION_MESSAGE;
+			}
+			pBytes += runBytes;
+			p      += runLength;
+		}
 	}
-	else
+
+	return pBytes;
+}
+
+
+void convertRgbesToFloats
+(
+	const ubyte* pRgbes,
+	dword        count,
+	float*       pRgbTriples
+)
+{
+#if defined(__SSE2__) || defined(_M_X64)
+	// eight at a time
+	// (each pixel is stored as four floats, the last overwritten by the next
+	// pixel, so one more must follow)
+	const __m128i zero = _mm_setzero_si128();
+	const __m128  half = _mm_set1_ps( 0.5f );
+	for( ;  count > 8;  count -= 8, pRgbes += 32, pRgbTriples += 24 )
+	{
+		for( dword i = 0;  i < 32;  i += 16 )
+		{
+			const ubyte* pIn  = pRgbes + i;
+			float*       pOut = pRgbTriples + ((i / 4) * 3);
+
+			// widen bytes to a dword vector per pixel
+			const __m128i bytes = _mm_loadu_si128(
+				reinterpret_cast<const __m128i*>( pIn ) );
+			const __m128i words[2] = {
+				_mm_unpacklo_epi8( bytes, zero ),
+				_mm_unpackhi_epi8( bytes, zero ) };
+			const __m128i pixels[4] = {
+				_mm_unpacklo_epi16( words[0], zero ),
+				_mm_unpackhi_epi16( words[0], zero ),
+				_mm_unpacklo_epi16( words[1], zero ),
+				_mm_unpackhi_epi16( words[1], zero ) };
+
+			for( dword p = 0;  p < 4;  ++p )
+			{
+				const __m128 scale = _mm_set1_ps( RGBE_SCALES[ pIn[(p * 4) + 3] ] );
+				_mm_storeu_ps( pOut + (p * 3), _mm_mul_ps( _mm_add_ps(
+					_mm_cvtepi32_ps( pixels[p] ), half ), scale ) );
+			}
+		}
+	}
+#endif
+
+	// (remainder)
+	for( ;  count > 0;  --count, pRgbes += 4, pRgbTriples += 3 )
 	{
-		rgb[0] = 0.0f;
-		rgb[1] = 0.0f;
-		rgb[2] = 0.0f;
+		const float scale = RGBE_SCALES[ pRgbes[3] ];
+
+		pRgbTriples[0] = (float(pRgbes[0]) + 0.5f) * scale;
+		pRgbTriples[1] = (float(pRgbes[1]) + 0.5f) * scale;
+		pRgbTriples[2] = (float(pRgbes[2]) + 0.5f) * scale;
 	}
 }
 
@@ -511,6 +998,54 @@ bool isRoughly
 }
 
 
+namespace
+{
+
+/**
+ * Collects the rows given while reading.
+ */
+class RowsCollector : public p3tonemapper_format::ImageDecodeReceiver
+{
+public:
+	RowsCollector()
+	 :	width_m ( 0 )
+	 ,	height_m( 0 )
+	 ,	rows_m  ()
+	{
+	}
+
+	virtual void receiveHeader
+	(
+		const dword  width,
+		const dword  height,
+		const float* ,//pPrimaries8,
+		const float  ,//scalingToGetCdm2,
+		const bool   //isHalf
+	)
+	{
+		width_m  = width;
+		height_m = height;
+	}
+
+	virtual void receiveRows
+	(
+		const dword rowCount,
+		const void* pRows
+	)
+	{
+		const float* pFloats = static_cast<const float*>( pRows );
+		rows_m.insert( rows_m.end(), pFloats,
+			pFloats + (rowCount * width_m * 3) );
+	}
+
+	dword              width_m;
+	dword              height_m;
+	std::vector<float> rows_m;
+};
+
+}
+
+
 namespace p3tonemapper_format
 {
 namespace rgbe
@@ -522,7 +1057,7 @@ bool test_rgbe
 (
 	std::ostream* pOut,
 	const bool    isVerbose,
-	const dword   //seed
+	const dword   seed
 )
 {
 	bool isOk = true;
@@ -578,7 +1113,7 @@ bool test_rgbe
 			p3tonemapper_format::rgbe::read(
 				strstr, false, width, height,
 				primaries, exposure,
-				pPixelsFp );
+				pPixelsFp, 0 );
 		}
 		catch( const std::exception& e )
 		{
@@ -646,6 +1181,179 @@ bool test_rgbe
 	}
 
 
+	// expansion (vectored and remainder) against plain ldexpf
+	{
+		bool isFail = false;
+
+		// make flat (no FORMAT) file, with random pixels (and a zero exponent)
+		static const dword WIDTH  = 19;
+		static const dword HEIGHT = 2;
+		std::string file( "#?RADIANCE\n\n+Y 2 +X 19\n" );
+		const dword headerLength = dword(file.size());
+		{
+			udword random = udword(seed);
+			for( dword i = WIDTH * HEIGHT * 4;  i-- > 0; )
+			{
+				random = (random * 1664525u) + 1013904223u;
+				file += char(random >> 24);
+			}
+			file[ headerLength + 3 ] = 0;
+		}
+
+		dword  width;
+		dword  height;
+		float  primaries[8];
+		float  exposure;
+		float* pPixelsFp = 0;
+		try
+		{
+			p3tonemapper_format::rgbe::read(
+				reinterpret_cast<const ubyte*>(file.data()), udword(file.size()),
+				false, width, height, primaries, exposure, pPixelsFp, 0 );
+		}
+		catch( ... )
+		{
+		}
+
+		isFail |= (0 == pPixelsFp);
+		for( dword i = 0;  !isFail && (i < (WIDTH * HEIGHT));  ++i )
+		{
+			const ubyte* pRgbe = reinterpret_cast<const ubyte*>(file.data()) +
+				headerLength + (i * 4);
+			const float a = (10 < pRgbe[3]) ?
+				::ldexpf( 1.0f, dword(pRgbe[3]) - (128 + 8) ) : 0.0f;
+
+			for( dword c = 0;  c < 3;  ++c )
+			{
+				const float target = (float(pRgbe[c]) + 0.5f) * a;
+				isFail |= (target != pPixelsFp[(i * 3) + c]);
+			}
+		}
+		delete[] pPixelsFp;
+
+		if( pOut && isVerbose ) *pOut << "pixels " << (WIDTH * HEIGHT) <<
+			"  " << isFail << "\n\n";
+
+		if( pOut ) *pOut << "expansion : " <<
+			(!isFail ? "--- succeeded" : "*** failed") << "\n\n";
+		isOk &= !isFail;
+	}
+
+
+	// many run-length rows (indexed, maybe in bands), both row orders
+	{
+		// rows of the compare pixels, over and over
+		static const dword HEIGHT = 50;
+		std::string rows;
+		{
+			static const ubyte ROW[] = {
+				2, 2, 0, 8,
+					130, 1, 131, 11, 3, 21, 31, 41,
+					131, 51, 2, 61, 71, 131, 81,
+					3, 91, 101, 111, 131, 121, 2, 131, 141,
+					2, 151, 161, 132, 171, 130, 181 };
+			static const ubyte ROW_FLAT[] = {
+				2, 2, 0, 8,  136, 2,  136, 12,  136, 92,  136, 112 };
+
+			for( dword i = 0;  i < HEIGHT;  ++i )
+			{
+				// (one distinct row, to see the order)
+				rows.append( (0 == i) ?
+					reinterpret_cast<const char*>(ROW_FLAT) :
+					reinterpret_cast<const char*>(ROW),
+					(0 == i) ? sizeof(ROW_FLAT) : sizeof(ROW) );
+			}
+		}
+
+		float*        pPixels[2] = { 0, 0 };
+		RowsCollector collectors[2];
+		for( dword i = 0;  i < 2;  ++i )
+		{
+			const std::string file( std::string( "#?RADIANCE\n"
+				"FORMAT=32-bit_rle_rgbe\n\n" ) + (i ? "-Y" : "+Y") +
+				" 50 +X 8\n" + rows );
+
+			dword width;
+			dword height;
+			float primaries[8];
+			float exposure;
+			try
+			{
+				p3tonemapper_format::rgbe::read(
+					reinterpret_cast<const ubyte*>(file.data()),
+					udword(file.size()), false, width, height, primaries,
+					exposure, pPixels[i], &(collectors[i]) );
+			}
+			catch( ... )
+			{
+			}
+		}
+
+		// compare each row with its flipped counterpart
+		bool isFail = (0 == pPixels[0]) | (0 == pPixels[1]);
+		for( dword y = 0;  !isFail && (y < HEIGHT);  ++y )
+		{
+			for( dword x = 0;  x < (8 * 3);  ++x )
+			{
+				isFail |= pPixels[0][(y * 8 * 3) + x] !=
+					pPixels[1][((HEIGHT - 1 - y) * 8 * 3) + x];
+			}
+		}
+		// (first given row is distinct, and read to the first image row)
+		isFail |= (0 == pPixels[0]) || (pPixels[0][0] == pPixels[0][8 * 3]);
+
+		// rows given while reading are the image rows, in order
+		for( dword i = 0;  !isFail && (i < 2);  ++i )
+		{
+			isFail |= (8 != collectors[i].width_m) |
+				(HEIGHT != collectors[i].height_m) |
+				(collectors[i].rows_m.size() != (HEIGHT * 8 * 3));
+			for( dword p = 0;  !isFail && (p < (HEIGHT * 8 * 3));  ++p )
+			{
+				isFail |= (collectors[i].rows_m[p] != pPixels[i][p]);
+			}
+		}
+
+		delete[] pPixels[0];
+		delete[] pPixels[1];
+
+		if( pOut ) *pOut << "rows : " <<
+			(!isFail ? "--- succeeded" : "*** failed") << "\n\n";
+		isOk &= !isFail;
+	}
+
+
+	// truncated run-length rows
+	{
+		static const char FILE[] =
+			"#?RADIANCE\nFORMAT=32-bit_rle_rgbe\n\n-Y 1 +X 8\n"
+			"\x02\x02\x00\x08\x88\x01\x88\x02\x88";
+
+		dword  width;
+		dword  height;
+		float  primaries[8];
+		float  exposure;
+		float* pPixelsFp = 0;
+		bool   isThrown  = false;
+		try
+		{
+			p3tonemapper_format::rgbe::read(
+				reinterpret_cast<const ubyte*>(FILE), sizeof(FILE) - 1,
+				false, width, height, primaries, exposure, pPixelsFp, 0 );
+		}
+		catch( ... )
+		{
+			isThrown = true;
+		}
+
+		const bool isFail = !isThrown | (0 != pPixelsFp);
+
+		if( pOut ) *pOut << "truncated : " <<
+			(!isFail ? "--- succeeded" : "*** failed") << "\n\n";
+		isOk &= !isFail;
+	}
+
+
 /*	// read a file, scale the pixels, then write it as a PPM
 	// (for non-automated visual inspection)
 
@@ -666,7 +1374,7 @@ bool test_rgbe
 		p3tonemapper_format::rgbe::read(
 			in, false, width, height,
 			primaries, exposure,
-			pPixelsFp );
+			pPixelsFp, 0 );
 
 		pPixelsInt = new byte[ width * height * 3 ];
 
@@ -72,18 +72,40 @@ namespace rgbe
 	 *               { rx, ry, gx, gy, bx, by, wx, wy }.
 	 *               all 0 if not present, and should assume sRGB
 	 * @exposure  divide pixel values by this to get cd/m^2, is 0 if not present.
+	 * @pReceiver  given the header, then the rows as they are decoded (or 0)
 	 *
 	 * @exceptions throws char[] message and allocation exceptions
 	 */
 	void  read
 	(
-		istream& inBytes,
-		bool     isInvert,
-		dword&   width,
-		dword&   height,
-		float*   pPrimaries8,
-		float&   exposure,
-		float*&  pRgbTriples
+		istream&             inBytes,
+		bool                 isInvert,
+		dword&               width,
+		dword&               height,
+		float*               pPrimaries8,
+		float&               exposure,
+		float*&              pRgbTriples,
+		ImageDecodeReceiver* pReceiver
+	);
+
+
+	/**
+	 * Read image from memory (eg a mapped file).<br/><br/>
+	 *
+	 * Same as above, except the image is given as bytes. The stream version
+	 * reads the stream in large blocks, then calls this.
+	 */
+	void  read
+	(
+		const ubyte*         pBytes,
+		udword               length,
+		bool                 isInvert,
+		dword&               width,
+		dword&               height,
+		float*               pPrimaries8,
+		float&               exposure,
+		float*&              pRgbTriples,
+		ImageDecodeReceiver* pReceiver
 	);
 
 
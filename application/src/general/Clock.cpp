@@ -0,0 +1,78 @@
+/*--------------------------------------------------------------------
+
+   Perceptuum3 rendering components
+   Copyright (c) 2005, Harrison Ainsworth / HXA7241.
+
+   http://www.hxa7241.org/
+
+--------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later
+   version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+   MA  02110-1301  USA
+
+--------------------------------------------------------------------*/
+
+
+
+
+
+#ifdef _PLATFORM_WIN
+
+#include <windows.h>   // kernel32.lib
+
+#elif _PLATFORM_LINUX
+
+#include <sys/time.h>
+
+#endif
+
+#include "Clock.hpp"   // own header is included last
+
+
+using namespace hxa7241_general;
+
+
+
+
+/// ----------------------------------------------------------------------------
+double hxa7241_general::getClockSeconds()
+{
+	double seconds = 0.0;
+
+#ifdef _PLATFORM_WIN
+
+	LARGE_INTEGER frequency;
+	LARGE_INTEGER count;
+	if( ::QueryPerformanceFrequency( &frequency ) &&
+		::QueryPerformanceCounter( &count ) )
+	{
+		seconds = double(count.QuadPart) / double(frequency.QuadPart);
+	}
+
+#elif _PLATFORM_LINUX
+
+	struct timeval time;
+	if( 0 == ::gettimeofday( &time, 0 ) )
+	{
+		seconds = double(time.tv_sec) + (double(time.tv_usec) * 1e-6);
+	}
+
+#endif
+
+	return seconds;
+}
@@ -229,3 +229,139 @@ FunctionPtr hxa7241_general::getFunction
 
 #endif
 }
+
+
+
+
+
+
+
+
+/// DynamicLibrary /////////////////////////////////////////////////////////////
+
+
+/// standard object services ---------------------------------------------------
+DynamicLibrary::DynamicLibrary
+(
+	const char* const functionNames[],
+	const dword       functionCount
+)
+ :	functionNames_m  ( functionNames )
+ ,	functionCount_m  ( functionCount )
+ ,	mutex_m          ()
+ ,	acquireCount_m   ( 0 )
+ ,	handle_m         ( 0 )
+ ,	supportHandles_m ()
+ ,	functions_m      ()
+{
+}
+
+
+DynamicLibrary::~DynamicLibrary()
+{
+	freeAll();
+}
+
+
+
+
+/// commands -------------------------------------------------------------------
+bool DynamicLibrary::acquire
+(
+	const char                      libraryPathName[],
+	const std::vector<std::string>& supportPathNames
+)
+{
+	MutexLock lock( mutex_m );
+
+	const bool isLoading = (0 == acquireCount_m);
+	if( isLoading )
+	{
+		try
+		{
+			// load support libraries, then main library
+			for( udword i = 0;  i < supportPathNames.size();  ++i )
+			{
+				void* handle = 0;
+				loadLibrary( supportPathNames[i].c_str(), handle );
+				supportHandles_m.push_back( handle );
+			}
+			loadLibrary( libraryPathName, handle_m );
+
+			// bind all functions
+			functions_m.resize( functionCount_m );
+			for( dword i = 0;  i < functionCount_m;  ++i )
+			{
+				functions_m[i] = hxa7241_general::getFunction( handle_m,
+					functionNames_m[i] );
+			}
+		}
+		catch( ... )
+		{
+			freeAll();
+			throw;
+		}
+	}
+
+	++acquireCount_m;
+
+	return isLoading;
+}
+
+
+bool DynamicLibrary::acquire
+(
+	const char libraryPathName[]
+)
+{
+	return acquire( libraryPathName, std::vector<std::string>() );
+}
+
+
+void DynamicLibrary::release()
+{
+	MutexLock lock( mutex_m );
+
+	if( (acquireCount_m > 0) && (0 == --acquireCount_m) )
+	{
+		freeAll();
+	}
+}
+
+
+
+
+/// queries --------------------------------------------------------------------
+FunctionPtr DynamicLibrary::getFunction
+(
+	const dword index
+) const
+{
+	return functions_m[index];
+}
+
+
+FunctionPtr DynamicLibrary::getFunction
+(
+	const char functionName[]
+) const
+{
+	return hxa7241_general::getFunction( handle_m, functionName );
+}
+
+
+
+
+/// implementation -------------------------------------------------------------
+void DynamicLibrary::freeAll()
+{
+	functions_m.clear();
+
+	// free main library, then support libraries in reverse
+	freeLibrary( handle_m );
+	for( udword i = supportHandles_m.size();  i-- > 0; )
+	{
+		freeLibrary( supportHandles_m[i] );
+	}
+	supportHandles_m.clear();
+}
@@ -34,6 +34,14 @@
 
 
 
+#include <vector>
+#include <string>
+
+#include "Mutex.hpp"
+
+
+
+
 #include "hxa7241_general.hpp"
 namespace hxa7241_general
 {
@@ -60,6 +68,79 @@ namespace hxa7241_general
 		const char functionName[]
 	);
 
+
+
+
+/**
+ * A dynamic library shared by its users: loaded on first acquire, freed on
+ * last release, with all its named functions bound once when loaded.<br/><br/>
+ *
+ * acquire and release are thread-safe. getFunction needs no locking, while
+ * the caller holds an acquire.
+ *
+ * The pathname of the acquire that loads is used for as long as the library
+ * stays loaded.
+ *
+ * @invariants
+ * functions_m is empty or as long as the function names
+ */
+class DynamicLibrary
+{
+/// standard object services ---------------------------------------------------
+public:
+	         DynamicLibrary( const char* const functionNames[],
+	                         dword             functionCount );
+
+	virtual ~DynamicLibrary();
+private:
+	         DynamicLibrary( const DynamicLibrary& );
+	DynamicLibrary& operator=( const DynamicLibrary& );
+
+
+/// commands -------------------------------------------------------------------
+public:
+	/**
+	 * Support libraries are loaded first, in order.
+	 *
+	 * @return whether this call loaded the library
+	 */
+	virtual bool  acquire( const char                      libraryPathName[],
+	                       const std::vector<std::string>& supportPathNames );
+	virtual bool  acquire( const char libraryPathName[] );
+	virtual void  release();
+
+
+/// queries --------------------------------------------------------------------
+	/**
+	 * @param index position in the function names given to the constructor
+	 */
+	virtual FunctionPtr getFunction( dword index )                        const;
+
+	/**
+	 * Lookup of an unbound function (throws if not found).
+	 */
+	virtual FunctionPtr getFunction( const char functionName[] )          const;
+
+
+/// implementation -------------------------------------------------------------
+protected:
+	virtual void  freeAll();
+
+
+/// fields ---------------------------------------------------------------------
+private:
+	const char* const* functionNames_m;
+	dword              functionCount_m;
+
+	Mutex              mutex_m;
+	dword              acquireCount_m;
+
+	void*              handle_m;
+	std::vector<void*> supportHandles_m;
+
+	std::vector<FunctionPtr> functions_m;
+};
+
 }//namespace
 
 
@@ -0,0 +1,245 @@
+/*--------------------------------------------------------------------
+
+   Perceptuum3 rendering components
+   Copyright (c) 2005, Harrison Ainsworth / HXA7241.
+
+   http://www.hxa7241.org/
+
+--------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later
+   version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+   MA  02110-1301  USA
+
+--------------------------------------------------------------------*/
+
+
+
+
+
+#ifdef _PLATFORM_WIN
+
+#include <windows.h>   // kernel32.lib
+
+#elif _PLATFORM_LINUX
+
+#include <glob.h>
+#include <dirent.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#endif
+
+#include <algorithm>
+
+#include "FileList.hpp"   // own header is included last
+
+
+using namespace hxa7241_general;
+
+
+
+
+/// ----------------------------------------------------------------------------
+bool hxa7241_general::listFiles
+(
+	const char                pattern[],
+	std::vector<std::string>& pathnames
+)
+{
+	const std::string patternString( pattern );
+	const bool isWildcards =
+		std::string::npos != patternString.find_first_of( "*?" );
+	bool isDirectory = false;
+
+	const std::vector<std::string>::size_type first = pathnames.size();
+
+#ifdef _PLATFORM_WIN
+
+	const DWORD attributes = ::GetFileAttributesA( pattern );
+	isDirectory = (INVALID_FILE_ATTRIBUTES != attributes) &&
+		(0 != (attributes & FILE_ATTRIBUTE_DIRECTORY));
+
+	if( isDirectory | isWildcards )
+	{
+		// search pattern, and the directory its names are in
+		std::string search( patternString );
+		if( isDirectory )
+		{
+			search += "\\*";
+		}
+		const size_t slashPos = search.find_last_of( "\\/" );
+		const std::string directory( (std::string::npos != slashPos) ?
+			search.substr( 0, slashPos + 1 ) : std::string() );
+
+		WIN32_FIND_DATAA found;
+		const HANDLE hFind = ::FindFirstFileA( search.c_str(), &found );
+		if( INVALID_HANDLE_VALUE != hFind )
+		{
+			do
+			{
+				if( 0 == (found.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) )
+				{
+					pathnames.push_back( directory + found.cFileName );
+				}
+			}
+			while( ::FindNextFileA( hFind, &found ) );
+
+			::FindClose( hFind );
+		}
+	}
+
+#elif _PLATFORM_LINUX
+
+	struct stat status;
+	isDirectory = (0 == ::stat( pattern, &status )) && S_ISDIR(status.st_mode);
+
+	// every entry in the directory
+	if( isDirectory )
+	{
+		DIR* pDirectory = ::opendir( pattern );
+		if( 0 != pDirectory )
+		{
+			const std::string directory( patternString +
+				(('/' != patternString[patternString.length() - 1]) ? "/" : "") );
+
+			while( const dirent* pEntry = ::readdir( pDirectory ) )
+			{
+				pathnames.push_back( directory + pEntry->d_name );
+			}
+
+			::closedir( pDirectory );
+		}
+	}
+	// every pathname matching the wildcards
+	else if( isWildcards )
+	{
+		glob_t found;
+		if( 0 == ::glob( pattern, 0, 0, &found ) )
+		{
+			for( size_t i = 0;  i < found.gl_pathc;  ++i )
+			{
+				pathnames.push_back( found.gl_pathv[i] );
+			}
+		}
+		::globfree( &found );
+	}
+
+	// only files
+	for( std::vector<std::string>::size_type i = pathnames.size();
+		i-- > first; )
+	{
+		if( (0 != ::stat( pathnames[i].c_str(), &status )) ||
+			!S_ISREG(status.st_mode) )
+		{
+			pathnames.erase( pathnames.begin() + i );
+		}
+	}
+
+#endif
+
+	std::sort( pathnames.begin() + first, pathnames.end() );
+
+	return isDirectory | isWildcards;
+}
+
+
+std::string hxa7241_general::getWorkingDirectory()
+{
+	std::vector<char> pathname( 1024 );
+
+#ifdef _PLATFORM_WIN
+
+	const DWORD length = ::GetCurrentDirectoryA( DWORD(pathname.size()),
+		&(pathname[0]) );
+	if( length >= DWORD(pathname.size()) )
+	{
+		pathname.resize( length + 1 );
+		::GetCurrentDirectoryA( DWORD(pathname.size()), &(pathname[0]) );
+	}
+	else if( 0 == length )
+	{
+		pathname[0] = 0;
+	}
+
+#elif _PLATFORM_LINUX
+
+	while( 0 == ::getcwd( &(pathname[0]), pathname.size() ) )
+	{
+		if( ERANGE != errno )
+		{
+			pathname[0] = 0;
+			break;
+		}
+		pathname.resize( pathname.size() * 2 );
+	}
+
+#endif
+
+	return std::string( &(pathname[0]) );
+}
+
+
+bool hxa7241_general::setWorkingDirectory
+(
+	const char pathname[]
+)
+{
+#ifdef _PLATFORM_WIN
+
+	return 0 != ::SetCurrentDirectoryA( pathname );
+
+#elif _PLATFORM_LINUX
+
+	return 0 == ::chdir( pathname );
+
+#endif
+}
+
+
+double hxa7241_general::getFileTime
+(
+	const char pathname[]
+)
+{
+	double seconds = 0.0;
+
+#ifdef _PLATFORM_WIN
+
+	WIN32_FILE_ATTRIBUTE_DATA attributes;
+	if( ::GetFileAttributesExA( pathname, GetFileExInfoStandard,
+		&attributes ) )
+	{
+		// (in 100 nanosecond units)
+		seconds = ((double(attributes.ftLastWriteTime.dwHighDateTime) *
+			4294967296.0) + double(attributes.ftLastWriteTime.dwLowDateTime)) *
+			1e-7;
+	}
+
+#elif _PLATFORM_LINUX
+
+	struct stat status;
+	if( 0 == ::stat( pathname, &status ) )
+	{
+		seconds = double(status.st_mtime);
+	}
+
+#endif
+
+	return seconds;
+}
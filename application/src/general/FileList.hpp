@@ -0,0 +1,94 @@
+/*--------------------------------------------------------------------
+
+   Perceptuum3 rendering components
+   Copyright (c) 2005, Harrison Ainsworth / HXA7241.
+
+   http://www.hxa7241.org/
+
+--------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later
+   version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+   MA  02110-1301  USA
+
+--------------------------------------------------------------------*/
+
+
+
+
+
+#ifndef FileList_h
+#define FileList_h
+
+
+#include <string>
+#include <vector>
+
+
+
+
+#include "hxa7241_general.hpp"
+namespace hxa7241_general
+{
+
+
+/**
+ * List the files a pattern names: every file in it, if a directory, else
+ * those matching its wildcards (* and ?) -- in name order.
+ *
+ * @pathnames  appended to
+ * @return     whether the pattern is a directory or has wildcards (else it is
+ *             a plain file pathname, and nothing is listed)
+ */
+bool listFiles
+(
+	const char                pattern[],
+	std::vector<std::string>& pathnames
+);
+
+
+/**
+ * @return  the working directory (empty if unknown)
+ */
+std::string getWorkingDirectory();
+
+
+/**
+ * @return  whether the working directory was changed
+ */
+bool setWorkingDirectory
+(
+	const char pathname[]
+);
+
+
+/**
+ * @return  time the file was last modified, in seconds from some fixed start
+ *          (0 if not found)
+ */
+double getFileTime
+(
+	const char pathname[]
+);
+
+
+}//namespace
+
+
+
+
+#endif//FileList_h
@@ -0,0 +1,260 @@
+/*--------------------------------------------------------------------
+
+   Perceptuum3 rendering components
+   Copyright (c) 2005, Harrison Ainsworth / HXA7241.
+
+   http://www.hxa7241.org/
+
+--------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later
+   version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+   MA  02110-1301  USA
+
+--------------------------------------------------------------------*/
+
+
+
+#if defined(__F16C__)
+#include <immintrin.h>
+#endif
+
+#include "HalfFloat.hpp"   // own header is included last
+
+
+using namespace hxa7241_general;
+
+
+
+
+/// statics
+
+// float bits = mantissa[ offset[h >> 10] + (h & 0x3FF) ] + exponent[ h >> 10 ]
+// (after: Jeroen van der Zijp; Fast Half Float Conversions; 2008.)
+// (built once, at load, so no locking is needed)
+namespace
+{
+
+class HalfTables
+{
+public:
+	HalfTables()
+	{
+		// mantissas: zero, denormals (normalized), normals
+		mantissa_m[0] = 0u;
+		for( udword i = 1;  i < 1024;  ++i )
+		{
+			udword m = i << 13;
+			udword e = 0u;
+			while( 0u == (m & 0x00800000u) )
+			{
+				e -= 0x00800000u;
+				m <<= 1;
+			}
+			m &= ~0x00800000u;
+			e += 0x38800000u;
+
+			mantissa_m[i] = m | e;
+		}
+		for( udword i = 1024;  i < 2048;  ++i )
+		{
+			mantissa_m[i] = 0x38000000u + ((i - 1024u) << 13);
+		}
+
+		// exponents: positive, then negative, with infinity/NaN at the ends
+		for( udword i = 0;  i < 64;  ++i )
+		{
+			const udword sign = (i & 32u) << 26;
+			const udword e    = i & 31u;
+			exponent_m[i] = sign | ((31u == e) ? 0x47800000u : (e << 23));
+
+			offset_m[i] = (0u == e) ? 0u : 1024u;
+		}
+	}
+
+	float convert( const uword half ) const
+	{
+		const udword e = udword(half) >> 10;
+
+		union { udword u; float f; } bits;
+		bits.u = mantissa_m[ offset_m[e] + (half & 0x3FFu) ] + exponent_m[e];
+
+		return bits.f;
+	}
+
+private:
+	udword mantissa_m[2048];
+	udword exponent_m[64];
+	udword offset_m[64];
+};
+
+const HalfTables HALF_TABLES;
+
+}
+
+
+
+
+/// functions ------------------------------------------------------------------
+float hxa7241_general::halfToFloat
+(
+	const uword half
+)
+{
+	return HALF_TABLES.convert( half );
+}
+
+
+void hxa7241_general::halfsToFloats
+(
+	const uword* pHalfs,
+	dword        count,
+	float*       pFloats
+)
+{
+#if defined(__F16C__)
+	// eight at a time
+	for( ;  count >= 8;  count -= 8, pHalfs += 8, pFloats += 8 )
+	{
+		_mm256_storeu_ps( pFloats, _mm256_cvtph_ps( _mm_loadu_si128(
+			reinterpret_cast<const __m128i*>( pHalfs ) ) ) );
+	}
+#endif
+
+	// (remainder)
+	for( ;  count > 0;  --count )
+	{
+		*(pFloats++) = HALF_TABLES.convert( *(pHalfs++) );
+	}
+}
+
+
+
+
+
+
+
+
+/// test -----------------------------------------------------------------------
+#ifdef TESTING
+
+
+#include <math.h>
+#include <ostream>
+
+
+namespace hxa7241_general
+{
+
+
+bool test_HalfFloat
+(
+	std::ostream* pOut,
+	const bool    isVerbose,
+	const dword   //seed
+)
+{
+	bool isOk = true;
+
+	if( pOut ) *pOut << "[ test_HalfFloat ]\n\n";
+
+
+	// all values, against arithmetic conversion
+	{
+		dword failures = 0;
+
+		for( udword h = 0;  h < 65536;  ++h )
+		{
+			const uword half     = uword(h);
+			const float sign     = (h & 0x8000u) ? -1.0f : 1.0f;
+			const dword exponent = dword((h >> 10) & 0x1Fu);
+			const float mantissa = float(h & 0x3FFu);
+
+			// (compared as bits, since fast-math may not honour NaNs)
+			union { udword u; float f; } converted;
+			union { udword u; float f; } other;
+			union { udword u; float f; } expected;
+
+			converted.f = halfToFloat( half );
+			halfsToFloats( &half, 1, &other.f );
+
+			if( 31 == exponent )
+			{
+				// infinity or NaN: all exponent bits, same mantissa bits
+				expected.u = ((h & 0x8000u) << 16) | 0x7F800000u |
+					((h & 0x3FFu) << 13);
+			}
+			else
+			{
+				// denormal or normal
+				expected.f = (0 == exponent) ?
+					sign * ::ldexpf( mantissa, -24 ) :
+					sign * ::ldexpf( 1024.0f + mantissa, exponent - 25 );
+			}
+
+			const bool isFail = (converted.u != expected.u) |
+				(other.u != expected.u);
+
+			if( isFail && pOut && isVerbose ) *pOut << h << " -> " <<
+				converted.f << "\n";
+
+			failures += dword(isFail);
+		}
+
+		if( pOut ) *pOut << "all values : " <<
+			(0 == failures ? "--- succeeded" : "*** failed") << "\n\n";
+		isOk &= (0 == failures);
+	}
+
+
+	// array, with a remainder
+	{
+		bool isFail = false;
+
+		uword halfs[19];
+		float floats[19];
+		for( dword i = 19;  i-- > 0; )
+		{
+			// 1 + i/1024
+			halfs[i] = uword(0x3C00 + i);
+		}
+		halfsToFloats( halfs, 19, floats );
+		for( dword i = 19;  i-- > 0; )
+		{
+			isFail |= (floats[i] != 1.0f + (float(i) / 1024.0f));
+		}
+
+		if( pOut ) *pOut << "array : " <<
+			(!isFail ? "--- succeeded" : "*** failed") << "\n\n";
+		isOk &= !isFail;
+	}
+
+
+	if( pOut ) *pOut << (isOk ? "--- successfully" : "*** failurefully") <<
+		" completed " << "\n\n\n";
+
+	if( pOut ) pOut->flush();
+
+
+	return isOk;
+}
+
+
+}//namespace
+
+
+#endif//TESTING
@@ -0,0 +1,336 @@
+/*--------------------------------------------------------------------
+
+   Perceptuum3 rendering components
+   Copyright (c) 2005, Harrison Ainsworth / HXA7241.
+
+   http://www.hxa7241.org/
+
+--------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later
+   version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+   MA  02110-1301  USA
+
+--------------------------------------------------------------------*/
+
+
+
+
+#ifdef _PLATFORM_LINUX
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#endif
+
+#include "LocalSocket.hpp"   // own header is included last
+
+
+using namespace hxa7241_general;
+
+
+
+
+/// constants ------------------------------------------------------------------
+const char LocalSocket::EXCEPTION_MESSAGE[] =
+	"local socket failed, in LocalSocket";
+const char LocalListener::EXCEPTION_MESSAGE[] =
+	"could not listen on local socket, in LocalListener";
+const char LocalListener::IN_USE_EXCEPTION_MESSAGE[] =
+	"local socket already in use, in LocalListener";
+
+
+#ifdef _PLATFORM_LINUX
+
+// (no signal if the other end has gone: an error instead)
+#ifdef MSG_NOSIGNAL
+static const int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+static const int SEND_FLAGS = 0;
+#endif
+
+
+/// connect a new socket, or return -1
+static int connectSocket
+(
+	const char socketPathName[]
+)
+{
+	sockaddr_un address;
+	::memset( &address, 0, sizeof(address) );
+	address.sun_family = AF_UNIX;
+	if( ::strlen( socketPathName ) >= sizeof(address.sun_path) )
+	{
+		return -1;
+	}
+	::strcpy( address.sun_path, socketPathName );
+
+	int handle = ::socket( AF_UNIX, SOCK_STREAM, 0 );
+	if( -1 != handle )
+	{
+#ifdef SO_NOSIGPIPE
+		const int isOn = 1;
+		::setsockopt( handle, SOL_SOCKET, SO_NOSIGPIPE, &isOn, sizeof(isOn) );
+#endif
+
+		if( 0 != ::connect( handle, reinterpret_cast<sockaddr*>( &address ),
+			sizeof(address) ) )
+		{
+			::close( handle );
+			handle = -1;
+		}
+	}
+
+	return handle;
+}
+
+#endif
+
+
+
+
+/// standard object services ---------------------------------------------------
+LocalSocket::LocalSocket
+(
+	const char socketPathName[]
+)
+ :	handle_m( -1 )
+{
+#ifdef _PLATFORM_LINUX
+
+	handle_m = connectSocket( socketPathName );
+
+#endif
+
+	if( -1 == handle_m )
+	{
+		throw EXCEPTION_MESSAGE;
+	}
+}
+
+
+LocalSocket::LocalSocket
+(
+	const int handle
+)
+ :	handle_m( handle )
+{
+}
+
+
+LocalSocket::~LocalSocket()
+{
+#ifdef _PLATFORM_LINUX
+
+	::close( handle_m );
+
+#endif
+}
+
+
+
+
+/// commands -------------------------------------------------------------------
+void LocalSocket::send
+(
+	const void*const pBytes,
+	const udword     length
+)
+{
+#ifdef _PLATFORM_LINUX
+
+	const ubyte* pRemaining = static_cast<const ubyte*>( pBytes );
+	for( udword remaining = length;  remaining > 0; )
+	{
+		const ssize_t count = ::send( handle_m, pRemaining, remaining,
+			SEND_FLAGS );
+		if( count < 0 )
+		{
+			if( EINTR != errno )
+			{
+				throw EXCEPTION_MESSAGE;
+			}
+		}
+		else
+		{
+			pRemaining += count;
+			remaining  -= udword(count);
+		}
+	}
+
+#endif
+}
+
+
+void LocalSocket::finishSending()
+{
+#ifdef _PLATFORM_LINUX
+
+	::shutdown( handle_m, SHUT_WR );
+
+#endif
+}
+
+
+udword LocalSocket::receive
+(
+	void*const   pBytes,
+	const udword length
+)
+{
+	ssize_t count = 0;
+
+#ifdef _PLATFORM_LINUX
+
+	do
+	{
+		count = ::recv( handle_m, pBytes, length, 0 );
+	}
+	while( (count < 0) && (EINTR == errno) );
+
+	if( count < 0 )
+	{
+		throw EXCEPTION_MESSAGE;
+	}
+
+#endif
+
+	return udword(count);
+}
+
+
+void LocalSocket::receiveAll
+(
+	std::vector<ubyte>& bytes
+)
+{
+	static const udword BLOCK_SIZE = 1 << 16;
+
+	for( ;; )
+	{
+		const std::vector<ubyte>::size_type filled = bytes.size();
+		bytes.resize( filled + BLOCK_SIZE );
+		const udword count = receive( &(bytes[filled]), BLOCK_SIZE );
+		bytes.resize( filled + count );
+
+		if( 0 == count )
+		{
+			break;
+		}
+	}
+}
+
+
+
+
+/// standard object services ---------------------------------------------------
+LocalListener::LocalListener
+(
+	const char socketPathName[]
+)
+ :	handle_m  ( -1 )
+ ,	pathName_m( socketPathName )
+{
+#ifdef _PLATFORM_LINUX
+
+	sockaddr_un address;
+	::memset( &address, 0, sizeof(address) );
+	address.sun_family = AF_UNIX;
+	if( pathName_m.length() >= sizeof(address.sun_path) )
+	{
+		throw EXCEPTION_MESSAGE;
+	}
+	::strcpy( address.sun_path, socketPathName );
+
+	// replace a socket file left behind (unless still listened to)
+	struct stat status;
+	if( (0 == ::stat( socketPathName, &status )) && S_ISSOCK(status.st_mode) )
+	{
+		const int other = connectSocket( socketPathName );
+		if( -1 != other )
+		{
+			::close( other );
+			throw IN_USE_EXCEPTION_MESSAGE;
+		}
+		::unlink( socketPathName );
+	}
+
+	handle_m = ::socket( AF_UNIX, SOCK_STREAM, 0 );
+	if( -1 == handle_m )
+	{
+		throw EXCEPTION_MESSAGE;
+	}
+	if( (0 != ::bind( handle_m, reinterpret_cast<sockaddr*>( &address ),
+		sizeof(address) )) || (0 != ::listen( handle_m, SOMAXCONN )) )
+	{
+		::close( handle_m );
+		throw EXCEPTION_MESSAGE;
+	}
+
+#else
+
+	throw EXCEPTION_MESSAGE;
+
+#endif
+}
+
+
+LocalListener::~LocalListener()
+{
+#ifdef _PLATFORM_LINUX
+
+	::close( handle_m );
+	::unlink( pathName_m.c_str() );
+
+#endif
+}
+
+
+
+
+/// commands -------------------------------------------------------------------
+LocalSocket* LocalListener::accept()
+{
+	int handle = -1;
+
+#ifdef _PLATFORM_LINUX
+
+	do
+	{
+		handle = ::accept( handle_m, 0, 0 );
+	}
+	while( (-1 == handle) && (EINTR == errno) );
+
+#endif
+
+	if( -1 == handle )
+	{
+		throw EXCEPTION_MESSAGE;
+	}
+
+#ifdef SO_NOSIGPIPE
+	const int isOn = 1;
+	::setsockopt( handle, SOL_SOCKET, SO_NOSIGPIPE, &isOn, sizeof(isOn) );
+#endif
+
+	return new LocalSocket( handle );
+}
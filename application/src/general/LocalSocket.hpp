@@ -0,0 +1,158 @@
+/*--------------------------------------------------------------------
+
+   Perceptuum3 rendering components
+   Copyright (c) 2005, Harrison Ainsworth / HXA7241.
+
+   http://www.hxa7241.org/
+
+--------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later
+   version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+   MA  02110-1301  USA
+
+--------------------------------------------------------------------*/
+
+
+
+
+
+#ifndef LocalSocket_h
+#define LocalSocket_h
+
+
+#include <string>
+#include <vector>
+
+
+
+
+#include "hxa7241_general.hpp"
+namespace hxa7241_general
+{
+
+
+/**
+ * A connection through a local (Unix domain) socket, a byte stream each
+ * way.<br/><br/>
+ *
+ * Not available on Windows (constructors throw).
+ *
+ * @exceptions throws char[] message exceptions
+ */
+class LocalSocket
+{
+/// standard object services ---------------------------------------------------
+public:
+	/**
+	 * Connect to a LocalListener.
+	 */
+	explicit LocalSocket( const char socketPathName[] );
+
+	virtual ~LocalSocket();
+private:
+	         LocalSocket( const LocalSocket& );
+	LocalSocket& operator=( const LocalSocket& );
+
+	/// (accepted by a LocalListener)
+	explicit LocalSocket( int handle );
+	friend class LocalListener;
+
+
+/// commands -------------------------------------------------------------------
+public:
+	virtual void    send( const void* pBytes,
+	                      udword      length );
+	/**
+	 * Send no more: the other end then receives its end.
+	 */
+	virtual void    finishSending();
+
+	/**
+	 * Wait for some bytes.
+	 *
+	 * @return  count received (0 at the end)
+	 */
+	virtual udword  receive( void*  pBytes,
+	                         udword length );
+	/**
+	 * Receive everything until the end.
+	 *
+	 * @bytes  appended to
+	 */
+	virtual void    receiveAll( std::vector<ubyte>& bytes );
+
+
+/// fields ---------------------------------------------------------------------
+private:
+	int handle_m;
+
+	static const char EXCEPTION_MESSAGE[];
+};
+
+
+
+
+/**
+ * A local (Unix domain) socket, listening for connections.<br/><br/>
+ *
+ * A socket file left at the pathname by a listener that did not close is
+ * replaced (one still listening is not). The socket file is removed when
+ * destroyed.
+ *
+ * Not available on Windows (constructor throws).
+ *
+ * @exceptions throws char[] message exceptions
+ */
+class LocalListener
+{
+/// standard object services ---------------------------------------------------
+public:
+	explicit LocalListener( const char socketPathName[] );
+
+	virtual ~LocalListener();
+private:
+	         LocalListener( const LocalListener& );
+	LocalListener& operator=( const LocalListener& );
+
+
+/// commands -------------------------------------------------------------------
+public:
+	/**
+	 * Wait for a connection.
+	 *
+	 * @return  new LocalSocket, owned by the caller
+	 */
+	virtual LocalSocket*  accept();
+
+
+/// fields ---------------------------------------------------------------------
+private:
+	int         handle_m;
+	std::string pathName_m;
+
+	static const char EXCEPTION_MESSAGE[];
+	static const char IN_USE_EXCEPTION_MESSAGE[];
+};
+
+
+}//namespace
+
+
+
+
+#endif//LocalSocket_h
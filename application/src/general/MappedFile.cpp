@@ -0,0 +1,442 @@
+/*--------------------------------------------------------------------
+
+   Perceptuum3 rendering components
+   Copyright (c) 2005, Harrison Ainsworth / HXA7241.
+
+   http://www.hxa7241.org/
+
+--------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later
+   version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+   MA  02110-1301  USA
+
+--------------------------------------------------------------------*/
+
+
+
+
+#ifdef _PLATFORM_WIN
+
+#include <windows.h>   // kernel32.lib
+
+#elif _PLATFORM_LINUX
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+#endif
+
+#include "MappedFile.hpp"   // own header is included last
+
+
+using namespace hxa7241_general;
+
+
+
+
+/// constants ------------------------------------------------------------------
+static const char OPEN_EXCEPTION_MESSAGE[] =
+	"could not open file, in MappedFile";
+static const char MAP_EXCEPTION_MESSAGE[] =
+	"could not map file, in MappedFile";
+static const char CREATE_EXCEPTION_MESSAGE[] =
+	"could not create file, in MappedFile";
+static const char SIZE_EXCEPTION_MESSAGE[] =
+	"file too big (over 2GB) to map, in MappedFile";
+static const char SHARED_OPEN_EXCEPTION_MESSAGE[] =
+	"could not open shared memory, in MappedFile";
+static const char SHARED_CREATE_EXCEPTION_MESSAGE[] =
+	"could not create shared memory, in MappedFile";
+
+
+
+
+/// standard object services ---------------------------------------------------
+MappedFile::MappedFile
+(
+	const char filePathName[]
+)
+ :	pBytes_m    ( 0 )
+ ,	length_m    ( 0 )
+ ,	hMapping_m  ( 0 )
+ ,	isWritable_m( false )
+{
+#ifdef _PLATFORM_WIN
+
+	const HANDLE hFile = ::CreateFileA( filePathName, GENERIC_READ,
+		FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, 0 );
+	if( INVALID_HANDLE_VALUE == hFile )
+	{
+		throw OPEN_EXCEPTION_MESSAGE;
+	}
+
+	DWORD sizeHigh = 0;
+	const DWORD sizeLow = ::GetFileSize( hFile, &sizeHigh );
+	if( (0 != sizeHigh) | (sizeLow > 0x7FFFFFFFu) )
+	{
+		::CloseHandle( hFile );
+		throw SIZE_EXCEPTION_MESSAGE;
+	}
+	length_m = udword(sizeLow);
+
+	// (a mapping of an empty file cannot be made)
+	if( 0 != length_m )
+	{
+		const HANDLE hMapping = ::CreateFileMappingA( hFile, 0, PAGE_READONLY,
+			0, 0, 0 );
+		::CloseHandle( hFile );
+		if( 0 == hMapping )
+		{
+			throw MAP_EXCEPTION_MESSAGE;
+		}
+
+		pBytes_m = static_cast<ubyte*>( ::MapViewOfFile( hMapping,
+			FILE_MAP_READ, 0, 0, 0 ) );
+		if( 0 == pBytes_m )
+		{
+			::CloseHandle( hMapping );
+			throw MAP_EXCEPTION_MESSAGE;
+		}
+		hMapping_m = hMapping;
+	}
+	else
+	{
+		::CloseHandle( hFile );
+	}
+
+#elif _PLATFORM_LINUX
+
+	const int file = ::open( filePathName, O_RDONLY );
+	if( -1 == file )
+	{
+		throw OPEN_EXCEPTION_MESSAGE;
+	}
+
+	struct stat status;
+	if( 0 != ::fstat( file, &status ) )
+	{
+		::close( file );
+		throw OPEN_EXCEPTION_MESSAGE;
+	}
+	if( status.st_size > off_t(DWORD_MAX) )
+	{
+		::close( file );
+		throw SIZE_EXCEPTION_MESSAGE;
+	}
+	length_m = udword(status.st_size);
+
+	// (a mapping of an empty file cannot be made)
+	if( 0 != length_m )
+	{
+		void* pMapping = ::mmap( 0, length_m, PROT_READ, MAP_PRIVATE, file, 0 );
+		::close( file );
+		if( MAP_FAILED == pMapping )
+		{
+			throw MAP_EXCEPTION_MESSAGE;
+		}
+
+		// (mostly read front to back)
+		::madvise( pMapping, length_m, MADV_SEQUENTIAL );
+
+		pBytes_m = static_cast<ubyte*>( pMapping );
+	}
+	else
+	{
+		::close( file );
+	}
+
+#endif
+}
+
+
+MappedFile::MappedFile
+(
+	const char   filePathName[],
+	const udword length
+)
+ :	pBytes_m    ( 0 )
+ ,	length_m    ( length )
+ ,	hMapping_m  ( 0 )
+ ,	isWritable_m( true )
+{
+	if( length_m > 0x7FFFFFFFu )
+	{
+		throw SIZE_EXCEPTION_MESSAGE;
+	}
+
+#ifdef _PLATFORM_WIN
+
+	const HANDLE hFile = ::CreateFileA( filePathName,
+		GENERIC_READ | GENERIC_WRITE, 0, 0, CREATE_ALWAYS,
+		FILE_ATTRIBUTE_NORMAL, 0 );
+	if( INVALID_HANDLE_VALUE == hFile )
+	{
+		throw CREATE_EXCEPTION_MESSAGE;
+	}
+
+	// (the mapping sets the file length; an empty one cannot be made)
+	if( 0 != length_m )
+	{
+		const HANDLE hMapping = ::CreateFileMappingA( hFile, 0, PAGE_READWRITE,
+			0, length_m, 0 );
+		::CloseHandle( hFile );
+		if( 0 == hMapping )
+		{
+			throw MAP_EXCEPTION_MESSAGE;
+		}
+
+		pBytes_m = static_cast<ubyte*>( ::MapViewOfFile( hMapping,
+			FILE_MAP_WRITE, 0, 0, 0 ) );
+		if( 0 == pBytes_m )
+		{
+			::CloseHandle( hMapping );
+			throw MAP_EXCEPTION_MESSAGE;
+		}
+		hMapping_m = hMapping;
+	}
+	else
+	{
+		::CloseHandle( hFile );
+	}
+
+#elif _PLATFORM_LINUX
+
+	const int file = ::open( filePathName, O_RDWR | O_CREAT | O_TRUNC, 0666 );
+	if( -1 == file )
+	{
+		throw CREATE_EXCEPTION_MESSAGE;
+	}
+	if( 0 != ::ftruncate( file, off_t(length_m) ) )
+	{
+		::close( file );
+		throw CREATE_EXCEPTION_MESSAGE;
+	}
+
+	// (a mapping of an empty file cannot be made)
+	if( 0 != length_m )
+	{
+		void* pMapping = ::mmap( 0, length_m, PROT_READ | PROT_WRITE,
+			MAP_SHARED, file, 0 );
+		::close( file );
+		if( MAP_FAILED == pMapping )
+		{
+			throw MAP_EXCEPTION_MESSAGE;
+		}
+
+		pBytes_m = static_cast<ubyte*>( pMapping );
+	}
+	else
+	{
+		::close( file );
+	}
+
+#endif
+}
+
+
+MappedFile::MappedFile
+(
+	const char sharedName[],
+	EShared
+)
+ :	pBytes_m    ( 0 )
+ ,	length_m    ( 0 )
+ ,	hMapping_m  ( 0 )
+ ,	isWritable_m( false )
+{
+#ifdef _PLATFORM_WIN
+
+	const HANDLE hMapping = ::OpenFileMappingA( FILE_MAP_READ, FALSE,
+		sharedName );
+	if( 0 == hMapping )
+	{
+		throw SHARED_OPEN_EXCEPTION_MESSAGE;
+	}
+
+	pBytes_m = static_cast<ubyte*>( ::MapViewOfFile( hMapping, FILE_MAP_READ,
+		0, 0, 0 ) );
+	if( 0 == pBytes_m )
+	{
+		::CloseHandle( hMapping );
+		throw MAP_EXCEPTION_MESSAGE;
+	}
+	hMapping_m = hMapping;
+
+	// (the length is only known in whole pages)
+	MEMORY_BASIC_INFORMATION information;
+	if( 0 != ::VirtualQuery( pBytes_m, &information, sizeof(information) ) )
+	{
+		length_m = (information.RegionSize <= SIZE_T(0x7FFFFFFFu)) ?
+			udword(information.RegionSize) : 0x7FFFFFFFu;
+	}
+
+#elif _PLATFORM_LINUX
+
+	const int file = ::shm_open( sharedName, O_RDONLY, 0 );
+	if( -1 == file )
+	{
+		throw SHARED_OPEN_EXCEPTION_MESSAGE;
+	}
+
+	struct stat status;
+	if( 0 != ::fstat( file, &status ) )
+	{
+		::close( file );
+		throw SHARED_OPEN_EXCEPTION_MESSAGE;
+	}
+	if( status.st_size > off_t(DWORD_MAX) )
+	{
+		::close( file );
+		throw SIZE_EXCEPTION_MESSAGE;
+	}
+	length_m = udword(status.st_size);
+
+	// (shared, so the other process's writes are seen)
+	if( 0 != length_m )
+	{
+		void* pMapping = ::mmap( 0, length_m, PROT_READ, MAP_SHARED, file, 0 );
+		::close( file );
+		if( MAP_FAILED == pMapping )
+		{
+			throw MAP_EXCEPTION_MESSAGE;
+		}
+
+		pBytes_m = static_cast<ubyte*>( pMapping );
+	}
+	else
+	{
+		::close( file );
+	}
+
+#endif
+}
+
+
+MappedFile::MappedFile
+(
+	const char   sharedName[],
+	const udword length,
+	EShared
+)
+ :	pBytes_m    ( 0 )
+ ,	length_m    ( length )
+ ,	hMapping_m  ( 0 )
+ ,	isWritable_m( true )
+{
+	if( length_m > 0x7FFFFFFFu )
+	{
+		throw SIZE_EXCEPTION_MESSAGE;
+	}
+
+#ifdef _PLATFORM_WIN
+
+	// (the segment lasts only while some process has it open; an empty one
+	// cannot be made)
+	if( 0 != length_m )
+	{
+		const HANDLE hMapping = ::CreateFileMappingA( INVALID_HANDLE_VALUE, 0,
+			PAGE_READWRITE, 0, length_m, sharedName );
+		if( 0 == hMapping )
+		{
+			throw SHARED_CREATE_EXCEPTION_MESSAGE;
+		}
+
+		pBytes_m = static_cast<ubyte*>( ::MapViewOfFile( hMapping,
+			FILE_MAP_WRITE, 0, 0, length_m ) );
+		if( 0 == pBytes_m )
+		{
+			::CloseHandle( hMapping );
+			throw MAP_EXCEPTION_MESSAGE;
+		}
+		hMapping_m = hMapping;
+	}
+
+#elif _PLATFORM_LINUX
+
+	// (not truncated first: another process may have it mapped)
+	const int file = ::shm_open( sharedName, O_RDWR | O_CREAT, 0666 );
+	if( -1 == file )
+	{
+		throw SHARED_CREATE_EXCEPTION_MESSAGE;
+	}
+	if( 0 != ::ftruncate( file, off_t(length_m) ) )
+	{
+		::close( file );
+		throw SHARED_CREATE_EXCEPTION_MESSAGE;
+	}
+
+	// (a mapping of an empty segment cannot be made)
+	if( 0 != length_m )
+	{
+		void* pMapping = ::mmap( 0, length_m, PROT_READ | PROT_WRITE,
+			MAP_SHARED, file, 0 );
+		::close( file );
+		if( MAP_FAILED == pMapping )
+		{
+			throw MAP_EXCEPTION_MESSAGE;
+		}
+
+		pBytes_m = static_cast<ubyte*>( pMapping );
+	}
+	else
+	{
+		::close( file );
+	}
+
+#endif
+}
+
+
+MappedFile::~MappedFile()
+{
+	if( 0 != pBytes_m )
+	{
+#ifdef _PLATFORM_WIN
+		::UnmapViewOfFile( pBytes_m );
+		::CloseHandle( static_cast<HANDLE>( hMapping_m ) );
+#elif _PLATFORM_LINUX
+		::munmap( pBytes_m, length_m );
+#endif
+	}
+}
+
+
+
+
+/// commands -------------------------------------------------------------------
+ubyte* MappedFile::getWritableBytes()
+{
+	return isWritable_m ? pBytes_m : 0;
+}
+
+
+
+
+/// queries --------------------------------------------------------------------
+const ubyte* MappedFile::getBytes() const
+{
+	return pBytes_m;
+}
+
+
+udword MappedFile::getLength() const
+{
+	return length_m;
+}
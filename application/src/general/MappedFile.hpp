@@ -0,0 +1,124 @@
+/*--------------------------------------------------------------------
+
+   Perceptuum3 rendering components
+   Copyright (c) 2005, Harrison Ainsworth / HXA7241.
+
+   http://www.hxa7241.org/
+
+--------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later
+   version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+   MA  02110-1301  USA
+
+--------------------------------------------------------------------*/
+
+
+
+
+#ifndef MappedFile_h
+#define MappedFile_h
+
+
+
+
+#include "hxa7241_general.hpp"
+namespace hxa7241_general
+{
+
+
+/**
+ * A whole file mapped into memory: read-only, or made new and writable.
+ * <br/><br/>
+ *
+ * Pages are only read when touched, so opening costs little whatever the
+ * size. A writable file's bytes are the file's own: writes to them go to the
+ * file, with no separate write. Uses mmap or a Windows file mapping.
+ *
+ * A named shared-memory segment (POSIX shm_open, or a Windows named file
+ * mapping) can be mapped the same way, to share bytes with another process
+ * without copying.
+ *
+ * @exceptions constructor throws char[] message exceptions
+ */
+class MappedFile
+{
+public:
+	enum EShared
+	{
+		SHARED_MEMORY
+	};
+
+
+/// standard object services ---------------------------------------------------
+public:
+	explicit MappedFile( const char filePathName[] );
+	/**
+	 * Make (or replace) a file of the given length, mapped writable.
+	 */
+	         MappedFile( const char filePathName[],
+	                     udword     length );
+	/**
+	 * Open a shared-memory segment, read-only.
+	 */
+	         MappedFile( const char sharedName[],
+	                     EShared );
+	/**
+	 * Make a shared-memory segment of the given length (or resize one that
+	 * exists), mapped writable.
+	 */
+	         MappedFile( const char sharedName[],
+	                     udword     length,
+	                     EShared );
+
+	virtual ~MappedFile();
+private:
+	         MappedFile( const MappedFile& );
+	MappedFile& operator=( const MappedFile& );
+
+
+/// commands -------------------------------------------------------------------
+public:
+	/**
+	 * @return  start of the file bytes to write (0 if empty or read-only)
+	 */
+	virtual ubyte*        getWritableBytes();
+
+
+/// queries --------------------------------------------------------------------
+	/**
+	 * @return  start of the file bytes (0 if empty)
+	 */
+	virtual const ubyte*  getBytes()                                       const;
+	virtual udword        getLength()                                      const;
+
+
+/// fields ---------------------------------------------------------------------
+private:
+	ubyte*       pBytes_m;
+	udword       length_m;
+	void*        hMapping_m;
+	bool         isWritable_m;
+};
+
+
+}//namespace
+
+
+
+
+#endif//MappedFile_h
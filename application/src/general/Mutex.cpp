@@ -0,0 +1,133 @@
+/*--------------------------------------------------------------------
+
+   Perceptuum3 rendering components
+   Copyright (c) 2005, Harrison Ainsworth / HXA7241.
+
+   http://www.hxa7241.org/
+
+--------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later
+   version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+   MA  02110-1301  USA
+
+--------------------------------------------------------------------*/
+
+
+
+#ifdef _PLATFORM_WIN
+
+#include <windows.h>   // kernel32.lib
+
+#elif _PLATFORM_LINUX
+
+#include <pthread.h>   // libpthread
+
+#endif
+
+#include "Mutex.hpp"   // own header is included last
+
+
+using namespace hxa7241_general;
+
+
+
+
+/// platform mutex type
+#ifdef _PLATFORM_WIN
+typedef CRITICAL_SECTION PlatformMutex;
+#elif _PLATFORM_LINUX
+typedef pthread_mutex_t  PlatformMutex;
+#endif
+
+
+
+
+/// standard object services ---------------------------------------------------
+Mutex::Mutex()
+ :	pMutex_m( 0 )
+{
+	PlatformMutex* pMutex = new PlatformMutex;
+
+#ifdef _PLATFORM_WIN
+	::InitializeCriticalSection( pMutex );
+#elif _PLATFORM_LINUX
+	::pthread_mutex_init( pMutex, 0 );
+#endif
+
+	pMutex_m = pMutex;
+}
+
+
+Mutex::~Mutex()
+{
+	PlatformMutex* pMutex = static_cast<PlatformMutex*>( pMutex_m );
+
+#ifdef _PLATFORM_WIN
+	::DeleteCriticalSection( pMutex );
+#elif _PLATFORM_LINUX
+	::pthread_mutex_destroy( pMutex );
+#endif
+
+	delete pMutex;
+}
+
+
+
+
+/// commands -------------------------------------------------------------------
+void Mutex::lock()
+{
+#ifdef _PLATFORM_WIN
+	::EnterCriticalSection( static_cast<PlatformMutex*>( pMutex_m ) );
+#elif _PLATFORM_LINUX
+	::pthread_mutex_lock( static_cast<PlatformMutex*>( pMutex_m ) );
+#endif
+}
+
+
+void Mutex::unlock()
+{
+#ifdef _PLATFORM_WIN
+	::LeaveCriticalSection( static_cast<PlatformMutex*>( pMutex_m ) );
+#elif _PLATFORM_LINUX
+	::pthread_mutex_unlock( static_cast<PlatformMutex*>( pMutex_m ) );
+#endif
+}
+
+
+
+
+
+
+
+
+/// ----------------------------------------------------------------------------
+MutexLock::MutexLock
+(
+	Mutex& mutex
+)
+ :	mutex_m( mutex )
+{
+	mutex_m.lock();
+}
+
+
+MutexLock::~MutexLock()
+{
+	mutex_m.unlock();
+}
@@ -0,0 +1,103 @@
+/*--------------------------------------------------------------------
+
+   Perceptuum3 rendering components
+   Copyright (c) 2005, Harrison Ainsworth / HXA7241.
+
+   http://www.hxa7241.org/
+
+--------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later
+   version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+   MA  02110-1301  USA
+
+--------------------------------------------------------------------*/
+
+
+
+#ifndef Mutex_h
+#define Mutex_h
+
+
+
+
+#include "hxa7241_general.hpp"
+namespace hxa7241_general
+{
+
+
+/**
+ * A plain (non-recursive) mutual exclusion lock.<br/><br/>
+ *
+ * Wraps a pthread mutex or a Windows critical section.
+ *
+ * @see
+ * MutexLock
+ */
+class Mutex
+{
+/// standard object services ---------------------------------------------------
+public:
+	         Mutex();
+
+	virtual ~Mutex();
+private:
+	         Mutex( const Mutex& );
+	Mutex& operator=( const Mutex& );
+
+
+/// commands -------------------------------------------------------------------
+public:
+	virtual void  lock();
+	virtual void  unlock();
+
+
+/// fields ---------------------------------------------------------------------
+private:
+	void* pMutex_m;
+};
+
+
+
+
+/**
+ * Holds a Mutex locked for its lifetime (so also through exceptions).
+ */
+class MutexLock
+{
+/// standard object services ---------------------------------------------------
+public:
+	explicit MutexLock( Mutex& );
+
+	        ~MutexLock();
+private:
+	         MutexLock( const MutexLock& );
+	MutexLock& operator=( const MutexLock& );
+
+
+/// fields ---------------------------------------------------------------------
+private:
+	Mutex& mutex_m;
+};
+
+
+}//namespace
+
+
+
+
+#endif//Mutex_h
@@ -0,0 +1,68 @@
+/*--------------------------------------------------------------------
+
+   Perceptuum3 rendering components
+   Copyright (c) 2005, Harrison Ainsworth / HXA7241.
+
+   http://www.hxa7241.org/
+
+--------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later
+   version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+   MA  02110-1301  USA
+
+--------------------------------------------------------------------*/
+
+
+
+#ifdef _PLATFORM_WIN
+
+#include <windows.h>   // kernel32.lib
+
+#elif _PLATFORM_LINUX
+
+#include <unistd.h>
+
+#endif
+
+#include "Processors.hpp"   // own header is included last
+
+
+using namespace hxa7241_general;
+
+
+
+
+/// ----------------------------------------------------------------------------
+dword hxa7241_general::getProcessorCount()
+{
+	dword count = 1;
+
+#ifdef _PLATFORM_WIN
+
+	SYSTEM_INFO systemInfo;
+	::GetSystemInfo( &systemInfo );
+	count = dword(systemInfo.dwNumberOfProcessors);
+
+#elif _PLATFORM_LINUX
+
+	count = dword(::sysconf( _SC_NPROCESSORS_ONLN ));
+
+#endif
+
+	return (count >= 1) ? count : 1;
+}
@@ -0,0 +1,170 @@
+/*--------------------------------------------------------------------
+
+   Perceptuum3 rendering components
+   Copyright (c) 2005, Harrison Ainsworth / HXA7241.
+
+   http://www.hxa7241.org/
+
+--------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later
+   version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+   MA  02110-1301  USA
+
+--------------------------------------------------------------------*/
+
+
+
+#ifdef _PLATFORM_WIN
+
+#include <windows.h>   // kernel32.lib
+
+#elif _PLATFORM_LINUX
+
+#include <pthread.h>   // libpthread
+
+#endif
+
+#include "Thread.hpp"   // own header is included last
+
+
+using namespace hxa7241_general;
+
+
+
+
+/// constants ------------------------------------------------------------------
+const char Thread::START_EXCEPTION_MESSAGE[] =
+	"thread could not be started";
+const char Thread::RUN_EXCEPTION_MESSAGE[] =
+	"thread failed";
+
+
+/// platform thread type, and entry point
+#ifdef _PLATFORM_WIN
+
+typedef HANDLE PlatformThread;
+
+static DWORD WINAPI threadEntry
+(
+	LPVOID pThread
+)
+{
+	static_cast<Thread*>( pThread )->runCatching();
+	return 0;
+}
+
+#elif _PLATFORM_LINUX
+
+typedef pthread_t PlatformThread;
+
+extern "C" void* threadEntry
+(
+	void* pThread
+)
+{
+	static_cast<Thread*>( pThread )->runCatching();
+	return 0;
+}
+
+#endif
+
+
+
+
+/// standard object services ---------------------------------------------------
+Thread::Thread()
+ :	pThread_m      ( 0 )
+ ,	pFailMessage_m ( 0 )
+{
+}
+
+
+Thread::~Thread()
+{
+	delete static_cast<PlatformThread*>( pThread_m );
+}
+
+
+
+
+/// commands -------------------------------------------------------------------
+void Thread::start()
+{
+	PlatformThread* pThread = new PlatformThread;
+	pFailMessage_m = 0;
+
+#ifdef _PLATFORM_WIN
+	*pThread = ::CreateThread( 0, 0, threadEntry, this, 0, 0 );
+	const bool isStarted = (0 != *pThread);
+#elif _PLATFORM_LINUX
+	const bool isStarted =
+		(0 == ::pthread_create( pThread, 0, threadEntry, this ));
+#endif
+
+	if( !isStarted )
+	{
+		delete pThread;
+		throw START_EXCEPTION_MESSAGE;
+	}
+
+	delete static_cast<PlatformThread*>( pThread_m );
+	pThread_m = pThread;
+}
+
+
+void Thread::join()
+{
+	PlatformThread* pThread = static_cast<PlatformThread*>( pThread_m );
+	if( 0 != pThread )
+	{
+#ifdef _PLATFORM_WIN
+		::WaitForSingleObject( *pThread, INFINITE );
+		::CloseHandle( *pThread );
+#elif _PLATFORM_LINUX
+		::pthread_join( *pThread, 0 );
+#endif
+
+		delete pThread;
+		pThread_m = 0;
+	}
+
+	if( 0 != pFailMessage_m )
+	{
+		throw pFailMessage_m;
+	}
+}
+
+
+
+
+/// implementation -------------------------------------------------------------
+void Thread::runCatching()
+{
+	try
+	{
+		run();
+	}
+	catch( const char*const pMessage )
+	{
+		pFailMessage_m = pMessage;
+	}
+	catch( ... )
+	{
+		pFailMessage_m = RUN_EXCEPTION_MESSAGE;
+	}
+}
@@ -0,0 +1,93 @@
+/*--------------------------------------------------------------------
+
+   Perceptuum3 rendering components
+   Copyright (c) 2005, Harrison Ainsworth / HXA7241.
+
+   http://www.hxa7241.org/
+
+--------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later
+   version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+   MA  02110-1301  USA
+
+--------------------------------------------------------------------*/
+
+
+
+#ifndef Thread_h
+#define Thread_h
+
+
+
+
+#include "hxa7241_general.hpp"
+namespace hxa7241_general
+{
+
+
+/**
+ * A thread of execution, running run() between start and join.<br/><br/>
+ *
+ * Subclasses implement run. A char[] message exception (or any other)
+ * escaping run is kept, and rethrown by join (other kinds as a general
+ * message).
+ *
+ * Must be joined before being destroyed, if started.
+ */
+class Thread
+{
+/// standard object services ---------------------------------------------------
+public:
+	         Thread();
+
+	virtual ~Thread();
+private:
+	         Thread( const Thread& );
+	Thread& operator=( const Thread& );
+
+
+/// commands -------------------------------------------------------------------
+public:
+	virtual void  start();
+	virtual void  join();
+
+
+/// implementation -------------------------------------------------------------
+protected:
+	virtual void  run()                                                      = 0;
+
+public:
+	        void  runCatching();
+
+
+/// fields ---------------------------------------------------------------------
+private:
+	void*       pThread_m;
+	const char* pFailMessage_m;
+
+	static const char START_EXCEPTION_MESSAGE[];
+	static const char RUN_EXCEPTION_MESSAGE[];
+};
+
+
+}//namespace
+
+
+
+
+#endif//Thread_h
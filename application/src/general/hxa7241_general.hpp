@@ -43,6 +43,7 @@ namespace hxa7241_general
 
 	//StringConstants
 	//DynamicLibraryInterface
+	class MappedFile;
 }
 
 
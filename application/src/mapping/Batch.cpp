@@ -0,0 +1,265 @@
+/*--------------------------------------------------------------------
+
+   Perceptuum3 rendering components
+   Copyright (c) 2005-2007, Harrison Ainsworth / HXA7241.
+
+   http://www.hxa7241.org/
+
+--------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later
+   version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+   MA  02110-1301  USA
+
+--------------------------------------------------------------------*/
+
+
+#include <iostream>
+
+#include "Thread.hpp"
+#include "Clock.hpp"
+#include "ImageJob.hpp"
+#include "Options.hpp"
+
+#include "Batch.hpp"   // own header is included last
+
+
+using namespace p3tonemapper_mapping;
+
+
+
+
+/// constants
+static const char EXCEPTION_BATCH_NAME[] =
+	"batch output file path name needs %s";
+
+
+namespace
+{
+
+/**
+ * Runner of one stage of an image job, on another thread.
+ */
+class StageRunner
+	: public hxa7241_general::Thread
+{
+public:
+	// no job means nothing to run
+	StageRunner( const ImageFormatter& formatter, ImageJob* pJob,
+		ImageJob::EStage stage )
+	 :	formatter_m( formatter )
+	 ,	pJob_m( pJob )
+	 ,	stage_m( stage )
+	{
+	}
+
+	// run on another thread (or on this one, if a thread cannot start)
+	void startStage();
+
+protected:
+	virtual void run();
+
+private:
+	const ImageFormatter& formatter_m;
+	ImageJob*             pJob_m;
+	ImageJob::EStage      stage_m;
+
+	StageRunner( const StageRunner& );
+	StageRunner& operator=( const StageRunner& );
+};
+
+}
+
+
+
+
+/// ----------------------------------------------------------------------------
+bool p3tonemapper_mapping::mapBatch
+(
+	const ImageFormatter& formatter,
+	const vector<string>  optionSets[2],
+	const vector<string>& inImagePathnames,
+	const vector<string>& outPathnamePatterns,
+	const double          memoryBudget
+)
+{
+	// (without a name per image, all would be written to one file)
+	for( dword i = 0;  i < dword(outPathnamePatterns.size());  ++i )
+	{
+		const string pattern( outPathnamePatterns[i].substr( 0,
+			outPathnamePatterns[i].find( ',' ) ) );
+		if( !pattern.empty() && (string::npos == pattern.find( "%s" )) )
+		{
+			throw EXCEPTION_BATCH_NAME;
+		}
+	}
+
+	const dword       count = dword(inImagePathnames.size());
+	vector<ImageJob*> jobs( count, static_cast<ImageJob*>(0) );
+
+	dword  failureCount = 0;
+	double pixelCount   = 0.0;
+	const double start  = hxa7241_general::getClockSeconds();
+
+	try
+	{
+		// each step: decode the next image, and encode the one mapped last
+		// step, each on another thread, and map the one decoded last step on
+		// this thread
+		// (counts of images through each stage: encoded <= mapped <= decoded)
+		dword decoded = 0;
+		dword mapped  = 0;
+		dword encoded = 0;
+		while( encoded < count )
+		{
+			// decode the next image, unless the images held (decoded, but not
+			// yet written) already fill the memory budget -- but always if
+			// none are held
+			ImageJob* pDecode = 0;
+			{
+				double bytes = 0.0;
+				for( dword i = encoded;  i < decoded;  ++i )
+				{
+					bytes += jobs[i]->getBytes();
+				}
+
+				if( (decoded < count) &&
+					((decoded == encoded) || (bytes < memoryBudget)) )
+				{
+					const string& inImagePathname = inImagePathnames[decoded];
+					vector<string> outImageSpecs( outPathnamePatterns );
+					for( dword i = 0;  i < dword(outImageSpecs.size());  ++i )
+					{
+						outImageSpecs[i] = makeOutPathname( outImageSpecs[i],
+							inImagePathname );
+					}
+					pDecode = jobs[decoded] = new ImageJob( optionSets,
+						inImagePathname, "", outImageSpecs, "png", 0, false );
+				}
+			}
+			ImageJob* pMap    = (mapped  < decoded) ? jobs[mapped]  : 0;
+			ImageJob* pEncode = (encoded < mapped)  ? jobs[encoded] : 0;
+
+			// run the step
+			{
+				StageRunner decoder( formatter, pDecode, ImageJob::DECODE );
+				StageRunner encoder( formatter, pEncode, ImageJob::ENCODE );
+				decoder.startStage();
+				encoder.startStage();
+
+				if( 0 != pMap )
+				{
+					pMap->runStage( ImageJob::MAP, formatter );
+				}
+
+				// (stage failures are kept in the jobs, not thrown)
+				decoder.join();
+				encoder.join();
+			}
+
+			decoded += (0 != pDecode) ? 1 : 0;
+			mapped  += (0 != pMap)    ? 1 : 0;
+
+			// report the written image, and free it
+			if( 0 != pEncode )
+			{
+				const ImageJob& job = *pEncode;
+
+				std::cout << job.inImagePathname_m;
+				if( job.failure_m.empty() )
+				{
+					const double pixels  = double(job.width_m) *
+						double(job.height_m);
+					const double seconds = job.seconds_m[ImageJob::DECODE] +
+						job.seconds_m[ImageJob::MAP] +
+						job.seconds_m[ImageJob::ENCODE];
+					pixelCount += pixels;
+
+					std::cout << "  -> ";
+					for( dword i = 0;  i < dword(job.outImageSpecs_m.size());  ++i )
+					{
+						std::cout << " " << job.outImageSpecs_m[i];
+					}
+					std::cout << "  " <<
+						job.width_m << "x" << job.height_m << "  read " <<
+						job.seconds_m[ImageJob::DECODE] << "s  map " <<
+						job.seconds_m[ImageJob::MAP] << "s  write " <<
+						job.seconds_m[ImageJob::ENCODE] << "s  " <<
+						((seconds > 0.0) ? (pixels / seconds) / 1e6 : 0.0) <<
+						" Mpixel/s\n";
+				}
+				else
+				{
+					++failureCount;
+					std::cout << "\n" << EXCEPTION_PREFIX << job.failure_m <<
+						"\n";
+				}
+				std::cout.flush();
+
+				delete pEncode;
+				jobs[encoded++] = 0;
+			}
+		}
+	}
+	catch( ... )
+	{
+		for( dword i = count;  i-- > 0; )
+		{
+			delete jobs[i];
+		}
+		throw;
+	}
+
+	// report all
+	{
+		const double seconds = hxa7241_general::getClockSeconds() - start;
+
+		std::cout << "\n" << count << " images (" << failureCount <<
+			" failed), " << (pixelCount / 1e6) << " Mpixels, in " << seconds <<
+			"s:  " << ((seconds > 0.0) ? (pixelCount / seconds) / 1e6 : 0.0) <<
+			" Mpixel/s, " << ((seconds > 0.0) ? double(count) / seconds : 0.0) <<
+			" images/s\n";
+	}
+
+	return 0 == failureCount;
+}
+
+
+
+
+
+/// implementation -------------------------------------------------------------
+void StageRunner::startStage()
+{
+	if( 0 != pJob_m )
+	{
+		try
+		{
+			start();
+		}
+		catch( ... )
+		{
+			run();
+		}
+	}
+}
+
+
+void StageRunner::run()
+{
+	pJob_m->runStage( stage_m, formatter_m );
+}
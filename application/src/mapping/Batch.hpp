@@ -0,0 +1,72 @@
+/*--------------------------------------------------------------------
+
+   Perceptuum3 rendering components
+   Copyright (c) 2005-2007, Harrison Ainsworth / HXA7241.
+
+   http://www.hxa7241.org/
+
+--------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later
+   version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+   MA  02110-1301  USA
+
+--------------------------------------------------------------------*/
+
+
+#ifndef Batch_h
+#define Batch_h
+
+
+#include <string>
+#include <vector>
+
+
+
+
+#include "p3tonemapper_mapping.hpp"
+namespace p3tonemapper_mapping
+{
+
+
+/**
+ * Read, map, and write, all the images, pipelined: each step decodes the
+ * next image, and encodes the one mapped the last step, each on another
+ * thread, while mapping the one decoded the last step.<br/><br/>
+ *
+ * Each image's failure is reported, and the rest carry on.
+ *
+ * @outPathnamePatterns  each with '%s' (see makeOutPathname)
+ * @memoryBudget         bytes, for images decoded but not yet written
+ * @return               whether all images succeeded
+ */
+bool  mapBatch
+(
+	const ImageFormatter& formatter,
+	const vector<string>  optionSets[2],
+	const vector<string>& inImagePathnames,
+	const vector<string>& outPathnamePatterns,
+	double                memoryBudget
+);
+
+
+}//namespace
+
+
+
+
+#endif//Batch_h
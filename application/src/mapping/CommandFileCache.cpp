@@ -0,0 +1,91 @@
+/*--------------------------------------------------------------------
+
+   Perceptuum3 rendering components
+   Copyright (c) 2005-2007, Harrison Ainsworth / HXA7241.
+
+   http://www.hxa7241.org/
+
+--------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later
+   version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+   MA  02110-1301  USA
+
+--------------------------------------------------------------------*/
+
+
+#include <fstream>
+
+#include "FileList.hpp"
+
+#include "CommandFileCache.hpp"   // own header is included last
+
+
+using namespace p3tonemapper_mapping;
+
+
+
+
+/// standard object services ---------------------------------------------------
+CommandFileCache::CommandFileCache()
+ :	entries_m()
+{
+}
+
+
+
+
+/// commands -------------------------------------------------------------------
+const vector<string>& CommandFileCache::getTokens
+(
+	const string& commandFilePathname
+)
+{
+	// (a relative pathname is keyed with the working directory)
+	Entry& entry = entries_m[ hxa7241_general::getWorkingDirectory() + '\n' +
+		commandFilePathname ];
+
+	const double time = hxa7241_general::getFileTime(
+		commandFilePathname.c_str() );
+	if( entry.tokens.empty() | (time != entry.time) )
+	{
+		entry.time = time;
+		entry.tokens.clear();
+		tokenizeCommandFile( commandFilePathname.c_str(), entry.tokens );
+	}
+
+	return entry.tokens;
+}
+
+
+
+
+
+/// ----------------------------------------------------------------------------
+void p3tonemapper_mapping::tokenizeCommandFile
+(
+	const char*     commandFilePathname,
+	vector<string>& tokens
+)
+{
+	std::ifstream commandFile( commandFilePathname );
+
+	for( string token;  commandFile >> token; )
+	{
+		tokens.push_back( token );
+	}
+}
@@ -0,0 +1,98 @@
+/*--------------------------------------------------------------------
+
+   Perceptuum3 rendering components
+   Copyright (c) 2005-2007, Harrison Ainsworth / HXA7241.
+
+   http://www.hxa7241.org/
+
+--------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later
+   version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+   MA  02110-1301  USA
+
+--------------------------------------------------------------------*/
+
+
+#ifndef CommandFileCache_h
+#define CommandFileCache_h
+
+
+#include <map>
+#include <string>
+#include <vector>
+
+
+
+
+#include "p3tonemapper_mapping.hpp"
+namespace p3tonemapper_mapping
+{
+
+
+/**
+ * Tokens of command files, kept while serving commands.
+ */
+class CommandFileCache
+{
+/// standard object services ---------------------------------------------------
+public:
+	CommandFileCache();
+
+private:
+	CommandFileCache( const CommandFileCache& );
+	CommandFileCache& operator=( const CommandFileCache& );
+
+
+/// commands -------------------------------------------------------------------
+public:
+	/// tokens of a command file (relative to the working directory), read
+	/// again only if it has changed
+	const vector<string>& getTokens( const string& commandFilePathname );
+
+
+/// fields ---------------------------------------------------------------------
+private:
+	struct Entry
+	{
+		double         time;
+		vector<string> tokens;
+	};
+
+	std::map<string,Entry> entries_m;
+};
+
+
+
+
+/**
+ * @tokens  appended to: the command file's whitespace-separated tokens (none
+ *          if it cannot be read)
+ */
+void  tokenizeCommandFile
+(
+	const char*     commandFilePathname,
+	vector<string>& tokens
+);
+
+
+}//namespace
+
+
+
+
+#endif//CommandFileCache_h
@@ -0,0 +1,498 @@
+/*--------------------------------------------------------------------
+
+   Perceptuum3 rendering components
+   Copyright (c) 2005-2007, Harrison Ainsworth / HXA7241.
+
+   http://www.hxa7241.org/
+
+--------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later
+   version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+   MA  02110-1301  USA
+
+--------------------------------------------------------------------*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#ifdef _PLATFORM_WIN
+#include <io.h>
+#include <fcntl.h>
+#endif
+#include <iostream>
+
+#include "Thread.hpp"
+#include "Clock.hpp"
+#include "Processors.hpp"
+#include "MapperWrapper.hpp"
+#include "Options.hpp"
+
+#include "p3tmPerceptualMap-v13.h"
+
+#include "Frames.hpp"   // own header is included last
+
+
+using namespace p3tonemapper_mapping;
+
+
+
+
+/// constants
+static const char EXCEPTION_FRAME_SIZE[] =
+	"frame stream needs its frame size: -vf:<width>_<height>";
+static const char EXCEPTION_FRAME_LARGE[]  =
+	"frame size too large for frame stream";
+static const char EXCEPTION_FRAMES_OPEN[]  = "could not open frame stream";
+static const char EXCEPTION_FRAMES_READ[]  = "could not read frame stream";
+static const char EXCEPTION_FRAMES_WRITE[] = "could not write frame stream";
+
+
+namespace
+{
+
+/**
+ * Reader, or writer, of raw frames, on another thread.
+ */
+class FrameTransfer
+	: public hxa7241_general::Thread
+{
+public:
+	// reads, or writes, raw frames, of a file (eg the standard input/output,
+	// or a FIFO)
+	FrameTransfer( FILE* pFile, bool isRead )
+	 :	bytesDone_m( 0 )
+	 ,	pFile_m    ( pFile )
+	 ,	isRead_m   ( isRead )
+	 ,	pFrames_m  ( 0 )
+	 ,	bytes_m    ( 0 )
+	{
+	}
+
+	// read, or write, frames, on another thread (or on this one, if a
+	// thread cannot start), then join (which throws a failure)
+	void startFrames( void* pFrames, dword bytes );
+
+	// read, or write, frames, on this thread
+	void transferFrames( void* pFrames, dword bytes );
+
+protected:
+	virtual void run();
+
+public:
+	// (less than all read means the stream ended)
+	dword bytesDone_m;
+
+private:
+	FILE*  pFile_m;
+	bool   isRead_m;
+	ubyte* pFrames_m;
+	dword  bytes_m;
+
+	FrameTransfer( const FrameTransfer& );
+	FrameTransfer& operator=( const FrameTransfer& );
+};
+
+
+
+/**
+ * Mapper of one frame at a time, on another thread.
+ */
+class FrameMapper
+	: public hxa7241_general::Thread
+{
+public:
+	// maps frames, with a mapper shared with others (only read)
+	FrameMapper()
+	 :	pMapper_m     ( 0 )
+	 ,	width_m       ( 0 )
+	 ,	height_m      ( 0 )
+	 ,	outImageType_m( 0 )
+	 ,	pInFrame_m    ( 0 )
+	 ,	pOutFrame_m   ( 0 )
+	{
+		message128_m[0] = 0;
+	}
+
+	void set( const void* pMapper, dword width, dword height,
+		dword outImageType );
+
+	// map a frame (in place: the mapper calibrates the in frame), on another
+	// thread (or on this one, if a thread cannot start, or if not
+	// threaded), then join (which throws a failure)
+	void startFrame( float* pInFrame, void* pOutFrame, bool isThreaded );
+
+protected:
+	virtual void run();
+
+private:
+	const void* pMapper_m;
+	dword       width_m;
+	dword       height_m;
+	dword       outImageType_m;
+	float*      pInFrame_m;
+	void*       pOutFrame_m;
+	char        message128_m[128];
+
+	FrameMapper( const FrameMapper& );
+	FrameMapper& operator=( const FrameMapper& );
+};
+
+}
+
+
+
+
+/// ----------------------------------------------------------------------------
+bool p3tonemapper_mapping::mapFrames
+(
+	const vector<string>  optionSets[2],
+	const string&         frameSize,
+	const string&         inPathname,
+	const string&         outPathname,
+	const double          memoryBudget,
+	const bool            isFeedback
+)
+{
+	// eg: 3840_2160
+	vector<string> fields;
+	tokenize( frameSize, '_', fields );
+	fields.resize( 2 );
+	const dword width  = dword(::atoi( fields[0].c_str() ));
+	const dword height = dword(::atoi( fields[1].c_str() ));
+	if( (width <= 0) | (height <= 0) )
+	{
+		throw EXCEPTION_FRAME_SIZE;
+	}
+
+	// a frame's bytes must fit a dword, for sizing, reading and writing
+	// (worked out wider, since it overflows a dword at 16384 squared)
+	if( (double(width) * double(height) * 3.0 * double(sizeof(float))) >
+		double(DWORD_MAX) )
+	{
+		throw EXCEPTION_FRAME_LARGE;
+	}
+
+	// one mapper for all frames: from the options only (raw frames have no
+	// metadata)
+	MapperWrapper mapper;
+	dword         outImageType = 0;
+	setMapper( optionSets, 0, 0.0f, mapper, outImageType );
+	printMapper( isFeedback, mapper );
+
+	// frames are mapped a group at a time, in parallel: one per processor,
+	// as far as the memory budget allows (for two groups in, and two out)
+	const dword length   = width * height * 3;
+	const dword inBytes  = length * dword(sizeof(float));
+	const dword outBytes = length *
+		((::p3tm11_RGB_WORD == outImageType) ? 2 : 1);
+	dword groupSize = hxa7241_general::getProcessorCount();
+	{
+		const double budgetFrames = memoryBudget /
+			(2.0 * (double(inBytes) + double(outBytes)));
+		const double bytesFrames  = double(DWORD_MAX) / double(inBytes);
+		groupSize = (double(groupSize) <= budgetFrames) ? groupSize :
+			dword(budgetFrames);
+		groupSize = (double(groupSize) <= bytesFrames)  ? groupSize :
+			dword(bytesFrames);
+		groupSize = (groupSize > 1) ? groupSize : 1;
+	}
+
+	// two groups in, and two out, for all frames: each step one of each is
+	// mapped, while the others are read and written
+	vector<float> inGroups[2];
+	vector<ubyte> outGroups[2];
+	for( dword i = 0;  i < 2;  ++i )
+	{
+		inGroups[i].resize( groupSize * length );
+		outGroups[i].resize( groupSize * outBytes );
+	}
+
+	// open the standard input/output, or files (eg FIFOs)
+	const bool isInPiped  = string("-") == inPathname;
+	const bool isOutPiped = string("-") == outPathname;
+#ifdef _PLATFORM_WIN
+	if( isInPiped )
+	{
+		::_setmode( ::_fileno( stdin ), _O_BINARY );
+	}
+	if( isOutPiped )
+	{
+		::_setmode( ::_fileno( stdout ), _O_BINARY );
+	}
+#endif
+	FILE*const pIn  = isInPiped  ? stdin  :
+		::fopen( inPathname.c_str(),  "rb" );
+	FILE*const pOut = isOutPiped ? stdout :
+		::fopen( outPathname.c_str(), "wb" );
+
+	dword  frameCount = 0;
+	dword  endBytes   = 0;
+	const double start = hxa7241_general::getClockSeconds();
+
+	FrameMapper* pMappers = 0;
+	try
+	{
+		if( (0 == pIn) | (0 == pOut) )
+		{
+			throw EXCEPTION_FRAMES_OPEN;
+		}
+
+		pMappers = new FrameMapper[ groupSize ];
+		for( dword i = 0;  i < groupSize;  ++i )
+		{
+			pMappers[i].set( mapper, width, height, outImageType );
+		}
+
+		FrameTransfer reader( pIn,  true );
+		FrameTransfer writer( pOut, false );
+
+		// each step: read the next group, and write the one mapped last step,
+		// each on another thread, and map this one: all but the first frame
+		// on other threads, and the first on this one
+		// (a group of less than all frames means the stream ended)
+		reader.transferFrames( &(inGroups[0][0]), groupSize * inBytes );
+		dword count     = reader.bytesDone_m / inBytes;
+		dword lastCount = 0;
+		for( dword step = 0;  count > 0;  ++step )
+		{
+			const dword n     = step & 1;
+			const bool  isEnd = count < groupSize;
+
+			if( !isEnd )
+			{
+				reader.startFrames( &(inGroups[n ^ 1][0]),
+					groupSize * inBytes );
+			}
+			if( lastCount > 0 )
+			{
+				writer.startFrames( &(outGroups[n ^ 1][0]),
+					lastCount * outBytes );
+			}
+
+			for( dword i = count;  i-- > 0; )
+			{
+				pMappers[i].startFrame( &(inGroups[n][i * length]),
+					&(outGroups[n][i * outBytes]), 0 != i );
+			}
+
+			// (all are joined, whatever fails)
+			const char* pFailure = 0;
+			for( dword i = 0;  i < count + 2;  ++i )
+			{
+				try
+				{
+					if( i < count )
+					{
+						pMappers[i].join();
+					}
+					else if( i == count )
+					{
+						reader.join();
+					}
+					else
+					{
+						writer.join();
+					}
+				}
+				catch( const char*const pMessage )
+				{
+					pFailure = (0 != pFailure) ? pFailure : pMessage;
+				}
+			}
+			if( 0 != pFailure )
+			{
+				throw pFailure;
+			}
+
+			frameCount += count;
+			lastCount   = count;
+			count       = isEnd ? 0 : reader.bytesDone_m / inBytes;
+		}
+		endBytes = reader.bytesDone_m % inBytes;
+
+		// write the last group mapped
+		if( lastCount > 0 )
+		{
+			writer.transferFrames( &(outGroups[((frameCount - 1) /
+				groupSize) & 1][0]), lastCount * outBytes );
+		}
+	}
+	catch( ... )
+	{
+		delete[] pMappers;
+		if( !isInPiped & (0 != pIn) )
+		{
+			::fclose( pIn );
+		}
+		if( !isOutPiped & (0 != pOut) )
+		{
+			::fclose( pOut );
+		}
+		throw;
+	}
+
+	delete[] pMappers;
+	if( !isInPiped )
+	{
+		::fclose( pIn );
+	}
+	const bool isClosed = isOutPiped || (0 == ::fclose( pOut ));
+
+	// report all
+	{
+		const double seconds = hxa7241_general::getClockSeconds() - start;
+		const double pixels  = double(width) * double(height) *
+			double(frameCount);
+
+		std::cout << frameCount << " frames " << width << "x" << height <<
+			", " << groupSize << " at a time, in " << seconds << "s:  " <<
+			((seconds > 0.0) ? double(frameCount) / seconds : 0.0) <<
+			" frames/s, " << ((seconds > 0.0) ? (pixels / seconds) / 1e6 :
+			0.0) << " Mpixel/s\n";
+		if( 0 != endBytes )
+		{
+			std::cout << "(incomplete last frame ignored: " << endBytes <<
+				" bytes)\n";
+		}
+	}
+
+	if( !isClosed )
+	{
+		throw EXCEPTION_FRAMES_WRITE;
+	}
+
+	return true;
+}
+
+
+
+
+
+/// implementation -------------------------------------------------------------
+void FrameTransfer::startFrames
+(
+	void* const pFrames,
+	const dword bytes
+)
+{
+	pFrames_m = static_cast<ubyte*>( pFrames );
+	bytes_m   = bytes;
+
+	try
+	{
+		start();
+	}
+	catch( ... )
+	{
+		// (a failure is kept, and thrown by join)
+		runCatching();
+	}
+}
+
+
+void FrameTransfer::transferFrames
+(
+	void* const pFrames,
+	const dword bytes
+)
+{
+	pFrames_m = static_cast<ubyte*>( pFrames );
+	bytes_m   = bytes;
+
+	run();
+}
+
+
+void FrameTransfer::run()
+{
+	// (a pipe gives, or takes, any amount at a time: fread and fwrite
+	// repeat until all, or the end, or an error)
+	if( isRead_m )
+	{
+		bytesDone_m = dword(::fread( pFrames_m, 1, bytes_m, pFile_m ));
+		if( ::ferror( pFile_m ) )
+		{
+			throw EXCEPTION_FRAMES_READ;
+		}
+	}
+	else
+	{
+		bytesDone_m = dword(::fwrite( pFrames_m, 1, bytes_m, pFile_m ));
+		if( (bytesDone_m < bytes_m) || (0 != ::fflush( pFile_m )) )
+		{
+			throw EXCEPTION_FRAMES_WRITE;
+		}
+	}
+}
+
+
+void FrameMapper::set
+(
+	const void* const pMapper,
+	const dword       width,
+	const dword       height,
+	const dword       outImageType
+)
+{
+	pMapper_m      = pMapper;
+	width_m        = width;
+	height_m       = height;
+	outImageType_m = outImageType;
+}
+
+
+void FrameMapper::startFrame
+(
+	float* const pInFrame,
+	void* const  pOutFrame,
+	const bool   isThreaded
+)
+{
+	pInFrame_m  = pInFrame;
+	pOutFrame_m = pOutFrame;
+
+	bool isStarted = false;
+	if( isThreaded )
+	{
+		try
+		{
+			start();
+			isStarted = true;
+		}
+		catch( ... )
+		{
+			// (run on this thread instead)
+		}
+	}
+
+	// (a failure is kept, and thrown by join)
+	if( !isStarted )
+	{
+		runCatching();
+	}
+}
+
+
+void FrameMapper::run()
+{
+	if( !::p3tmMap( pMapper_m, width_m, height_m, ::p3tm11_RGB_FLOAT,
+		pInFrame_m, outImageType_m, pOutFrame_m, message128_m ) )
+	{
+		throw static_cast<const char*>( message128_m );
+	}
+}
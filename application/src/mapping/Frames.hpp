@@ -0,0 +1,75 @@
+/*--------------------------------------------------------------------
+
+   Perceptuum3 rendering components
+   Copyright (c) 2005-2007, Harrison Ainsworth / HXA7241.
+
+   http://www.hxa7241.org/
+
+--------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later
+   version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+   MA  02110-1301  USA
+
+--------------------------------------------------------------------*/
+
+
+#ifndef Frames_h
+#define Frames_h
+
+
+#include <string>
+#include <vector>
+
+
+
+
+#include "p3tonemapper_mapping.hpp"
+namespace p3tonemapper_mapping
+{
+
+
+/**
+ * Read, map, and write, a stream of raw float RGB frames, pipelined, a group
+ * at a time (one per processor, as far as the memory budget allows).
+ * <br/><br/>
+ *
+ * The mapper is set from the options only (raw frames have no metadata).
+ *
+ * @frameSize     eg: 3840_2160
+ * @inPathname    '-' is the standard input (else eg a FIFO)
+ * @outPathname   '-' is the standard output
+ * @memoryBudget  bytes, for two groups in, and two out
+ * @exceptions    throws char[] message exceptions
+ */
+bool  mapFrames
+(
+	const vector<string>  optionSets[2],
+	const string&         frameSize,
+	const string&         inPathname,
+	const string&         outPathname,
+	double                memoryBudget,
+	bool                  isFeedback
+);
+
+
+}//namespace
+
+
+
+
+#endif//Frames_h
@@ -0,0 +1,853 @@
+/*--------------------------------------------------------------------
+
+   Perceptuum3 rendering components
+   Copyright (c) 2005-2007, Harrison Ainsworth / HXA7241.
+
+   http://www.hxa7241.org/
+
+--------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later
+   version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+   MA  02110-1301  USA
+
+--------------------------------------------------------------------*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#ifdef _PLATFORM_WIN
+#include <io.h>
+#include <fcntl.h>
+#endif
+#include <iostream>
+#include <algorithm>
+#include <exception>
+
+#include "Clock.hpp"
+#include "ImageFormatter.hpp"
+#include "ImageRowsReceiver.hpp"
+#include "ImageRowsWriter.hpp"
+#include "Options.hpp"
+
+#include "p3tmPerceptualMap-v13.h"
+
+#include "ImageJob.hpp"   // own header is included last
+
+
+using namespace p3tonemapper_mapping;
+
+
+
+
+/// constants
+static const char EXCEPTION_STDIN_READ[] = "could not read standard input";
+static const char EXCEPTION_SHARED_LAYOUT[] =
+	"shared memory input needs its layout: -il:<width>_<height>...";
+
+
+static void mapBanded
+(
+	const ImageFormatter& formatter,
+	const string&         inImagePathname,
+	void*                 pMapper,
+	dword                 width,
+	dword                 height,
+	dword                 outRowsType,
+	ubyte*                pOutRows,
+	dword                 outRowStride
+);
+
+static void reverseRows
+(
+	dword  height,
+	dword  rowBytes,
+	ubyte* pRows
+);
+
+
+namespace
+{
+
+/**
+ * Receiver of bands of rows from a file, given to a mapping stream: its pass
+ * one (analysis), or pass two (mapping).
+ */
+class BandStreamer
+	: public p3tonemapper_format::ImageRowsReceiver
+{
+public:
+	// no out rows means analysis pass
+	BandStreamer( void* pStream, ubyte* pOutRows, dword outRowStride )
+	 :	pStream_m( pStream )
+	 ,	pOutRows_m( pOutRows )
+	 ,	outRowStride_m( outRowStride )
+	 ,	outRows_m( 0 )
+	{
+	}
+
+	virtual void receiveRows( dword, const uword*const*, dword, dword );
+
+private:
+	void*  pStream_m;
+	ubyte* pOutRows_m;
+	dword  outRowStride_m;
+	dword  outRows_m;
+
+	BandStreamer( const BandStreamer& );
+	BandStreamer& operator=( const BandStreamer& );
+};
+
+}
+
+
+
+
+/// DecodeAnalyser /////////////////////////////////////////////////////////////
+
+
+/// standard object services ---------------------------------------------------
+DecodeAnalyser::DecodeAnalyser
+(
+	const vector<string> optionSets[2],
+	void* const          pMapper,
+	dword&               outImageType
+)
+ :	optionSets_m      ( optionSets )
+ ,	pMapper_m         ( pMapper )
+ ,	outImageType_m    ( outImageType )
+ ,	isHeaderReceived_m( false )
+ ,	pStream_m         ( 0 )
+{
+}
+
+
+DecodeAnalyser::~DecodeAnalyser()
+{
+	::p3tmFreePerceptualMapStream( pStream_m );
+}
+
+
+
+
+/// commands -------------------------------------------------------------------
+void DecodeAnalyser::receiveHeader
+(
+	const dword        width,
+	const dword        height,
+	const float* const pPrimaries8,
+	const float        scalingToGetCdm2,
+	const bool         isHalf
+)
+{
+	bool isPrimaries = false;
+	for( dword i = 8;  i-- > 0; )
+	{
+		isPrimaries |= (0.0f != pPrimaries8[i]);
+	}
+
+	setMapper( optionSets_m, isPrimaries ? pPrimaries8 : 0, scalingToGetCdm2,
+		pMapper_m, outImageType_m );
+	isHeaderReceived_m = true;
+
+	// (if the stream cannot be made, the image is mapped whole instead)
+	pStream_m = ::p3tmCreatePerceptualMapStream( pMapper_m, width, height,
+		isHalf ? ::p3tm13_RGB_HALF : ::p3tm11_RGB_FLOAT, outImageType_m, 0 );
+}
+
+
+void DecodeAnalyser::receiveRows
+(
+	const dword       rowCount,
+	const void* const pRows
+)
+{
+	// (if analysis fails, the image is mapped whole instead)
+	if( (0 != pStream_m) &&
+		(0 == ::p3tmStreamAnalyseRows( pStream_m, rowCount, pRows, 0 )) )
+	{
+		::p3tmFreePerceptualMapStream( pStream_m );
+		pStream_m = 0;
+	}
+}
+
+
+
+
+
+/// ImageJob ///////////////////////////////////////////////////////////////////
+
+
+/// standard object services ---------------------------------------------------
+ImageJob::ImageJob
+(
+	const vector<string>  optionSets[2],
+	const string&         inImagePathname,
+	const string&         inFormatName,
+	const vector<string>& outImageSpecs,
+	const string&         outFormatName,
+	std::ostream* const   pOutPipe,
+	const bool            isFeedback
+)
+ :	inImagePathname_m ( inImagePathname )
+ ,	outImageSpecs_m   ( outImageSpecs )
+ ,	outImagePathname_m( outImageSpecs.front() )
+ ,	width_m           ( 0 )
+ ,	height_m          ( 0 )
+ ,	failure_m         ()
+ ,	optionSets_m      ( optionSets )
+ ,	inFormatName_m    ( inFormatName )
+ ,	outFormatName_m   ( outFormatName )
+ ,	pOutPipe_m        ( pOutPipe )
+ ,	isFeedback_m      ( isFeedback )
+ ,	mapper_m          ()
+ ,	outImageType_m    ( 0 )
+ ,	analyser_m        ( optionSets, mapper_m, outImageType_m )
+ ,	pInImage_m        ( new ImageRef )
+ ,	isBanded_m        ( false )
+ ,	outImage_m        ()
+ ,	isOutInFile_m     ( false )
+ ,	isOutShared_m     ( false )
+ ,	outRows_m         ( 0 )
+ ,	isMultiOut_m      ( (outImageSpecs.size() > 1) ||
+ 	                    (string::npos != outImageSpecs.front().find( ',' )) )
+ ,	outputs_m         ()
+{
+	seconds_m[DECODE] = 0.0;
+	seconds_m[MAP]    = 0.0;
+	seconds_m[ENCODE] = 0.0;
+}
+
+
+ImageJob::~ImageJob()
+{
+	for( dword i = dword(outputs_m.size());  i-- > 0; )
+	{
+		delete outputs_m[i];
+	}
+
+	delete pInImage_m;
+}
+
+
+
+
+
+/// commands -------------------------------------------------------------------
+void ImageJob::decode
+(
+	const ImageFormatter& formatter
+)
+{
+	ImageRef& inImage = *pInImage_m;
+
+	// read input image, and set mapper from its metadata, and get all
+	// other options, mostly into/overriding mapper
+	// (if it can be read in bands, only its metadata now; else, if its
+	// format allows, analysing it for mapping as it is decoded -- but for
+	// several outputs, always whole, to analyse once they are made)
+	const bool isInPiped  = string("-") == inImagePathname_m;
+	const bool isInShared = 0 == inImagePathname_m.compare( 0, 4,
+		SHARED_PREFIX );
+	DecodeAnalyser*const pAnalyser = isMultiOut_m ? 0 : &analyser_m;
+	isBanded_m = !isInPiped && !isInShared && !isMultiOut_m &&
+		formatter.readImageHeader( inImagePathname_m.c_str(), inImage );
+	{
+		// read image: from the standard input (its format given, or
+		// recognized), or shared memory (in place, as laid out), or a file
+		if( isInPiped )
+		{
+			vector<ubyte> inBytes;
+			readStandardInput( inBytes );
+
+			formatter.readImage( inBytes.empty() ? 0 : &(inBytes[0]),
+				udword(inBytes.size()), inFormatName_m.c_str(), inImage,
+				pAnalyser );
+		}
+		else if( isInShared )
+		{
+			// eg: 1920_1080_f_4_0_0
+			string layout;
+			getOptions( optionSets_m, 0, 0, 0, 0, 0, &layout, 0, 0, 0 );
+			vector<string> fields;
+			tokenize( layout, '_', fields );
+			if( fields.size() < 2 )
+			{
+				throw EXCEPTION_SHARED_LAYOUT;
+			}
+			fields.resize( 6 );
+
+			formatter.readSharedImage( inImagePathname_m.c_str() + 4,
+				dword(::atoi( fields[0].c_str() )),
+				dword(::atoi( fields[1].c_str() )),
+				string("h") == fields[2],
+				fields[3].empty() ? 3 : dword(::atoi( fields[3].c_str() )),
+				dword(::atoi( fields[4].c_str() )),
+				udword(::strtoul( fields[5].c_str(), 0, 10 )), inImage );
+		}
+		else if( !isBanded_m )
+		{
+			formatter.readImage( inImagePathname_m.c_str(), inImage,
+				pAnalyser );
+		}
+
+		// set mapper from input image
+		if( !analyser_m.isHeaderReceived_m )
+		{
+			setMapper( optionSets_m, inImage.getPrimaries(),
+				inImage.getScaling(), mapper_m, outImageType_m );
+		}
+
+		printImageStats( isFeedback_m, inImage );
+	}
+
+	width_m  = inImage.getWidth();
+	height_m = inImage.getHeight();
+}
+
+
+void ImageJob::map
+(
+	const ImageFormatter& formatter
+)
+{
+	// several outputs are made from one mapping
+	if( isMultiOut_m )
+	{
+		mapOutputs( formatter );
+	}
+	else
+	{
+		mapOutput( formatter );
+	}
+
+	// free input image
+	delete pInImage_m;
+	pInImage_m = 0;
+}
+
+
+void ImageJob::mapOutput
+(
+	const ImageFormatter& formatter
+)
+{
+	ImageRef& inImage = *pInImage_m;
+
+	// make output image: inside the output file, if its format allows
+	// (then mapping writes the file), or else as rows written to the file
+	// as they are mapped, if its format allows (and the input is whole
+	// floats), else in memory
+	const dword width      = inImage.getWidth();
+	const dword height     = inImage.getHeight();
+	const bool  isOutWords = ::p3tm11_RGB_WORD == outImageType_m;
+	isOutShared_m = 0 == outImagePathname_m.compare( 0, 4, SHARED_PREFIX );
+	if( isOutShared_m )
+	{
+		formatter.makeSharedImage( outImagePathname_m.c_str() + 4, width,
+			height, isOutWords, outImage_m );
+	}
+	isOutInFile_m = !isOutShared_m && (0 == pOutPipe_m) &&
+		formatter.makeImageInFile( outImagePathname_m.c_str(), width, height,
+		isOutWords, outImage_m );
+	outRows_m.pWriter_m = (isOutShared_m | isOutInFile_m | isBanded_m |
+		inImage.isMapped() |
+		(ImageRef::PIXELS_FLOAT != inImage.getPixelType())) ? 0 :
+		(0 != pOutPipe_m) ? formatter.makeImageRowsWriter(
+		outFormatName_m.c_str(), width, height, isOutWords,
+		inImage.getPrimaries(), *pOutPipe_m ) :
+		formatter.makeImageRowsWriter( outImagePathname_m.c_str(), width,
+		height, isOutWords, inImage.getPrimaries() );
+	if( !isOutShared_m & !isOutInFile_m & (0 == outRows_m.pWriter_m) )
+	{
+		const dword length = width * height * 3;
+		outImage_m.set( width, height, inImage.getPrimaries(),
+			inImage.getScaling(), isOutWords ? ImageRef::PIXELS_WORD :
+			ImageRef::PIXELS_BYTE, isOutWords ?
+			static_cast<void*>( new uword[length] ) :
+			static_cast<void*>( new ubyte[length] ) );
+	}
+
+	// output rows in memory are bottom first; in a file they are top
+	// first, with words msb first
+	const dword outRowBytes = width * 3 * (isOutWords ? 2 : 1);
+	const dword outRowsType = (isOutInFile_m & isOutWords) ?
+		dword(::p3tm13_RGB_WORD_BE) : outImageType_m;
+
+	// call mapper_m to map, streaming bands from the file twice
+	// (into a file: given last row first)
+	if( isBanded_m )
+	{
+		printMapper( isFeedback_m, mapper_m );
+
+		ubyte*const pOutRows = static_cast<ubyte*>(
+			outImage_m.getPixels() ) + ((isOutInFile_m & (height > 0)) ?
+			(height - 1) * outRowBytes : 0);
+
+		mapBanded( formatter, inImagePathname_m, mapper_m, width, height,
+			outRowsType, pOutRows,
+			isOutInFile_m ? -outRowBytes : outRowBytes );
+	}
+	// call mapper_m to finish mapping, from the analysis made as the image
+	// was decoded
+	// (into a file, or as rows: given last row first)
+	else if( 0 != analyser_m.pStream_m )
+	{
+		printMapper( isFeedback_m, mapper_m );
+
+		void*const pStream = analyser_m.pStream_m;
+		::p3tmStreamSetOutPixelsType( pStream, outRowsType );
+
+		char pMessage128[128] = "\0";
+		bool isMapOk = false;
+
+		// floats: whole, in place
+		if( ImageRef::PIXELS_FLOAT == inImage.getPixelType() )
+		{
+			isMapOk = 0 != ::p3tmStreamMapImage( pStream,
+				inImage.getPixels(), isOutInFile_m | (0 != outRows_m.pWriter_m),
+				(0 != outRows_m.pWriter_m) ? RowsSink::writeRows : 0,
+				&outRows_m, outImage_m.getPixels(), pMessage128 );
+		}
+		// halfs: as pass two, all rows at once
+		else
+		{
+			ubyte*const pOutRows = static_cast<ubyte*>(
+				outImage_m.getPixels() ) + ((isOutInFile_m & (height > 0)) ?
+				(height - 1) * outRowBytes : 0);
+			::p3tmStreamSetOutRowStride( pStream,
+				isOutInFile_m ? -outRowBytes : outRowBytes );
+
+			int outRowCount = 0;
+			isMapOk = 0 != ::p3tmStreamMapRows( pStream, height,
+				inImage.getPixels(), pOutRows, &outRowCount, pMessage128 );
+		}
+		if( !isMapOk )
+		{
+			throw outRows_m.exception_m.empty() ?
+				string( pMessage128 ) : outRows_m.exception_m;
+		}
+	}
+	// call mapper_m to map
+	// (into a file: then rows reversed, in place; as rows: given last
+	// row first)
+	else
+	{
+		printMapper( isFeedback_m, mapper_m );
+
+		const int inImageType =
+			(ImageRef::PIXELS_HALF == inImage.getPixelType()) ?
+			::p3tm13_RGB_HALF : ::p3tm11_RGB_FLOAT;
+
+		char pMessage128[128] = "\0";
+		bool isMapOk = false;
+
+		if( 0 != outRows_m.pWriter_m )
+		{
+			isMapOk = 0 != ::p3tmMap4( mapper_m,
+				inImage.getWidth(), inImage.getHeight(), inImageType,
+				inImage.getPixels(), outRowsType, 1, RowsSink::writeRows,
+				&outRows_m, pMessage128 );
+		}
+		// pixels in a file mapping (or shared memory) are read-only (and
+		// maybe unaligned, or not packed), so give them as a layout, which is
+		// only read, a band at a time
+		else if( inImage.isMapped() )
+		{
+			const ubyte* pPixels = static_cast<const ubyte*>(
+				inImage.getPixels() );
+			const dword  channelBytes =
+				(ImageRef::PIXELS_HALF == inImage.getPixelType()) ?
+				dword(sizeof(uword)) : dword(sizeof(float));
+			const p3tmInLayout inLayout = {
+				{ pPixels, pPixels + channelBytes,
+				pPixels + (2 * channelBytes) }, inImage.getPixelStep(),
+				inImage.getRowStride() };
+
+			isMapOk = 0 != ::p3tmMap3( mapper_m,
+				inImage.getWidth(), inImage.getHeight(), inImageType,
+				&inLayout, outRowsType, outImage_m.getPixels(), pMessage128 );
+		}
+		else
+		{
+			isMapOk = 0 != ::p3tmMap( mapper_m,
+				inImage.getWidth(), inImage.getHeight(), inImageType,
+				inImage.getPixels(), outRowsType, outImage_m.getPixels(),
+				pMessage128 );
+		}
+		if( !isMapOk )
+		{
+			throw outRows_m.exception_m.empty() ?
+				string( pMessage128 ) : outRows_m.exception_m;
+		}
+
+		if( isOutInFile_m )
+		{
+			reverseRows( height, outRowBytes,
+				static_cast<ubyte*>( outImage_m.getPixels() ) );
+		}
+	}
+}
+
+
+void ImageJob::mapOutputs
+(
+	const ImageFormatter& formatter
+)
+{
+	// pixels in a file mapping (or shared memory) are read-only (and maybe
+	// not packed), so copy them out, packed, to be mapped in place
+	if( pInImage_m->isMapped() )
+	{
+		ImageRef*const pPacked = copyPacked( *pInImage_m );
+
+		delete pInImage_m;
+		pInImage_m = pPacked;
+	}
+	const ImageRef& inImage = *pInImage_m;
+
+	// make outputs, each as its spec says
+	vector<p3tmOutRows> outs;
+	for( dword i = 0;  i < dword(outImageSpecs_m.size());  ++i )
+	{
+		outputs_m.push_back( 0 );
+		outputs_m.back() = new OutputRows( formatter, outImageSpecs_m[i],
+			outImageType_m, inImage, outFormatName_m, pOutPipe_m );
+
+		const p3tmOutRows out = { int(outputs_m.back()->outImageType_m),
+			OutputRows::writeRows, outputs_m.back() };
+		outs.push_back( out );
+	}
+
+	// call mapper_m to map once, giving each row to every output in turn
+	// (top row first)
+	printMapper( isFeedback_m, mapper_m );
+
+	const int inImageType =
+		(ImageRef::PIXELS_HALF == inImage.getPixelType()) ?
+		::p3tm13_RGB_HALF : ::p3tm11_RGB_FLOAT;
+
+	char pMessage128[128] = "\0";
+	if( !::p3tmMap5( mapper_m, inImage.getWidth(), inImage.getHeight(),
+		inImageType, inImage.getPixels(), 1, int(outs.size()), &(outs[0]),
+		pMessage128 ) )
+	{
+		// (an output's exception is the cause, if there is one)
+		string failure( pMessage128 );
+		for( dword i = dword(outputs_m.size());  i-- > 0; )
+		{
+			if( !outputs_m[i]->exception_m.empty() )
+			{
+				failure = outputs_m[i]->exception_m;
+			}
+		}
+		throw failure;
+	}
+}
+
+
+void ImageJob::encode
+(
+	const ImageFormatter& formatter
+)
+{
+	// write output image (unless already written, inside the file, or
+	// as rows, then only finished)
+	if( isFeedback_m )
+	{
+		for( dword i = 0;  i < dword(outImageSpecs_m.size());  ++i )
+		{
+			std::cout << "\noutput image pathname = " << outImageSpecs_m[i] <<
+				"\n";
+		}
+	}
+
+	if( isMultiOut_m )
+	{
+		for( dword i = 0;  i < dword(outputs_m.size());  ++i )
+		{
+			outputs_m[i]->finish( formatter );
+		}
+	}
+	else if( 0 != outRows_m.pWriter_m )
+	{
+		outRows_m.pWriter_m->finish();
+	}
+	else if( 0 != pOutPipe_m )
+	{
+		formatter.writeImage( outFormatName_m.c_str(), outImage_m,
+			*pOutPipe_m );
+	}
+	else if( !isOutInFile_m & !isOutShared_m )
+	{
+		formatter.writeImage( outImagePathname_m.c_str(), outImage_m );
+	}
+}
+
+
+void ImageJob::runStage
+(
+	const EStage          stage,
+	const ImageFormatter& formatter
+)
+{
+	if( failure_m.empty() )
+	{
+		const double start = hxa7241_general::getClockSeconds();
+
+		try
+		{
+			switch( stage )
+			{
+			case DECODE : decode( formatter );  break;
+			case MAP    : map( formatter );     break;
+			case ENCODE : encode( formatter );  break;
+			}
+		}
+		catch( const std::exception& e )
+		{
+			failure_m = e.what();
+		}
+		catch( const char*const pExceptionString )
+		{
+			failure_m = pExceptionString;
+		}
+		catch( const std::string exceptionString )
+		{
+			failure_m = exceptionString;
+		}
+		catch( ... )
+		{
+			failure_m = EXCEPTION_ABSTRACT;
+		}
+
+		seconds_m[stage] = hxa7241_general::getClockSeconds() - start;
+	}
+}
+
+
+
+
+
+/// queries --------------------------------------------------------------------
+double ImageJob::getBytes() const
+{
+	double bytes = double(width_m) * double(height_m) * 3.0;
+
+	// input pixels (unless in a file mapping, or not read, being banded),
+	// and output pixels (unless inside the file)
+	const bool isIn = (0 != pInImage_m) && (0 != pInImage_m->getPixels()) &&
+		!pInImage_m->isMapped();
+	const bool isOut = (0 != outImage_m.getPixels()) & !isOutInFile_m &
+		!isOutShared_m;
+
+	bytes *= (isIn ? ((ImageRef::PIXELS_FLOAT == pInImage_m->getPixelType()) ?
+		4.0 : 2.0) : 0.0) + (isOut ?
+		((ImageRef::PIXELS_WORD == outImage_m.getPixelType()) ? 2.0 : 1.0) :
+		0.0);
+
+	// and several outputs' pixels
+	for( dword i = 0;  i < dword(outputs_m.size());  ++i )
+	{
+		bytes += outputs_m[i]->getBytes();
+	}
+
+	return bytes;
+}
+
+
+
+
+
+/// image input support --------------------------------------------------------
+void p3tonemapper_mapping::readStandardInput
+(
+	vector<ubyte>& bytes
+)
+{
+#ifdef _PLATFORM_WIN
+	::_setmode( ::_fileno( stdin ), _O_BINARY );
+#endif
+
+	// size unknown (a pipe): read blocks until the end
+	static const size_t BLOCK_SIZE = 1 << 20;
+	for( ;; )
+	{
+		const size_t filled = bytes.size();
+		bytes.resize( filled + BLOCK_SIZE );
+		const size_t count = ::fread( &(bytes[filled]), 1, BLOCK_SIZE, stdin );
+		bytes.resize( filled + count );
+
+		if( count < BLOCK_SIZE )
+		{
+			if( ::ferror( stdin ) )
+			{
+				throw EXCEPTION_STDIN_READ;
+			}
+			break;
+		}
+	}
+}
+
+
+ImageRef* p3tonemapper_mapping::copyPacked
+(
+	const ImageRef& image
+)
+{
+	ImageRef*const pPacked = new ImageRef( image, image.getPixelType() );
+
+	const dword pixelBytes = 3 *
+		((ImageRef::PIXELS_HALF == image.getPixelType()) ?
+		dword(sizeof(uword)) : dword(sizeof(float)));
+	const ubyte* pIn  = static_cast<const ubyte*>( image.getPixels() );
+	ubyte*       pOut = static_cast<ubyte*>( pPacked->getPixels() );
+	for( dword y = 0;  y < image.getHeight();  ++y )
+	{
+		const ubyte* pRow = pIn + (y * image.getRowStride());
+		for( dword x = 0;  x < image.getWidth();  ++x, pOut += pixelBytes )
+		{
+			std::copy( pRow + (x * image.getPixelStep()),
+				pRow + (x * image.getPixelStep()) + pixelBytes, pOut );
+		}
+	}
+
+	return pPacked;
+}
+
+
+
+
+
+/// implementation -------------------------------------------------------------
+void BandStreamer::receiveRows
+(
+	const dword              rowCount,
+	const uword*const* const pChannels,
+	const dword              pixelStep,
+	const dword              rowStride
+)
+{
+	const p3tmInLayout inLayout = {
+		{ pChannels[0], pChannels[1], pChannels[2] }, pixelStep, rowStride };
+
+	char pMessage128[128] = "\0";
+	bool isOk = false;
+
+	// analyse
+	if( 0 == pOutRows_m )
+	{
+		isOk = 0 != ::p3tmStreamAnalyseRows3( pStream_m, rowCount, &inLayout,
+			pMessage128 );
+	}
+	// map, appending to out rows
+	else
+	{
+		int outRowCount = 0;
+		isOk = 0 != ::p3tmStreamMapRows3( pStream_m, rowCount, &inLayout,
+			pOutRows_m + (outRows_m * outRowStride_m), &outRowCount,
+			pMessage128 );
+
+		outRows_m += outRowCount;
+	}
+
+	if( !isOk )
+	{
+		throw string( pMessage128 );
+	}
+}
+
+
+void mapBanded
+(
+	const ImageFormatter& formatter,
+	const string&         inImagePathname,
+	void*const            pMapper,
+	const dword           width,
+	const dword           height,
+	const dword           outRowsType,
+	ubyte*const           pOutRows,
+	const dword           outRowStride
+)
+{
+	char pMessage128[128] = "\0";
+	void* pStream = ::p3tmCreatePerceptualMapStream( pMapper, width, height,
+		::p3tm13_RGB_HALF, outRowsType, pMessage128 );
+	if( 0 == pStream )
+	{
+		throw string( pMessage128 );
+	}
+
+	try
+	{
+		::p3tmStreamSetOutRowStride( pStream, outRowStride );
+
+		// analyse from the smallest stored level that still covers the
+		// foveal resolution (the analysis works no finer), if there is one
+		dword level = 0;
+		{
+			int fovealWidth  = 0;
+			int fovealHeight = 0;
+			::p3tmStreamGetFovealSize( pStream, &fovealWidth, &fovealHeight );
+
+			dword levelWidth  = 0;
+			dword levelHeight = 0;
+			level = formatter.findImageLevel( inImagePathname.c_str(),
+				fovealWidth, fovealHeight, levelWidth, levelHeight );
+
+			if( (0 != level) && (0 == ::p3tmStreamSetProxy( pStream, levelWidth,
+				levelHeight, pMessage128 )) )
+			{
+				throw string( pMessage128 );
+			}
+		}
+
+		// pass one: analyse
+		BandStreamer analyser( pStream, 0, 0 );
+		formatter.readImageRows( inImagePathname.c_str(), level, analyser );
+
+		// pass two: map (full size)
+		BandStreamer mapper( pStream, pOutRows, outRowStride );
+		formatter.readImageRows( inImagePathname.c_str(), 0, mapper );
+	}
+	catch( ... )
+	{
+		::p3tmFreePerceptualMapStream( pStream );
+		throw;
+	}
+
+	::p3tmFreePerceptualMapStream( pStream );
+}
+
+
+void reverseRows
+(
+	const dword  height,
+	const dword  rowBytes,
+	ubyte*const  pRows
+)
+{
+	vector<ubyte> row( rowBytes );
+	for( dword top = 0, bottom = height - 1;  top < bottom;  ++top, --bottom )
+	{
+		ubyte* pTop    = pRows + (top    * rowBytes);
+		ubyte* pBottom = pRows + (bottom * rowBytes);
+		std::copy( pTop,    pTop    + rowBytes, row.begin() );
+		std::copy( pBottom, pBottom + rowBytes, pTop );
+		std::copy( row.begin(), row.end(), pBottom );
+	}
+}
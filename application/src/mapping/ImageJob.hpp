@@ -0,0 +1,217 @@
+/*--------------------------------------------------------------------
+
+   Perceptuum3 rendering components
+   Copyright (c) 2005-2007, Harrison Ainsworth / HXA7241.
+
+   http://www.hxa7241.org/
+
+--------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later
+   version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+   MA  02110-1301  USA
+
+--------------------------------------------------------------------*/
+
+
+#ifndef ImageJob_h
+#define ImageJob_h
+
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#include "ImageRef.hpp"
+#include "ImageDecodeReceiver.hpp"
+#include "MapperWrapper.hpp"
+#include "OutputRows.hpp"
+
+
+
+
+#include "p3tonemapper_mapping.hpp"
+namespace p3tonemapper_mapping
+{
+
+
+/**
+ * Receiver of an image as it is decoded, analysing it for mapping.<br/><br/>
+ *
+ * The header sets the mapper, and the rest of the options, and makes the
+ * stream; rows go to its pass one. (No stream means it failed, so the image
+ * is to be mapped whole instead.)
+ */
+class DecodeAnalyser
+	: public p3tonemapper_format::ImageDecodeReceiver
+{
+/// standard object services ---------------------------------------------------
+public:
+	DecodeAnalyser( const vector<string> optionSets[2], void* pMapper,
+		dword& outImageType );
+
+	virtual ~DecodeAnalyser();
+
+private:
+	DecodeAnalyser( const DecodeAnalyser& );
+	DecodeAnalyser& operator=( const DecodeAnalyser& );
+
+
+/// commands -------------------------------------------------------------------
+public:
+	virtual void receiveHeader( dword, dword, const float*, float, bool );
+	virtual void receiveRows( dword, const void* );
+
+
+/// fields ---------------------------------------------------------------------
+private:
+	const vector<string>* optionSets_m;
+	void*                 pMapper_m;
+	dword&                outImageType_m;
+
+public:
+	bool  isHeaderReceived_m;
+	void* pStream_m;
+};
+
+
+
+
+/**
+ * One image: read, mapped, and written, in three stages (which can each run
+ * on a different thread, one after another).<br/><br/>
+ *
+ * Several out image specs make several outputs from one mapping (see
+ * OutputRows).
+ */
+class ImageJob
+{
+public:
+	enum EStage
+	{
+		DECODE,
+		MAP,
+		ENCODE
+	};
+
+
+/// standard object services ---------------------------------------------------
+public:
+	/// pOutPipe: output there, in outFormatName, instead of to the pathname
+	/// '-' (or 0)
+	ImageJob( const vector<string> optionSets[2],
+		const string& inImagePathname, const string& inFormatName,
+		const vector<string>& outImageSpecs, const string& outFormatName,
+		std::ostream* pOutPipe, bool isFeedback );
+
+	~ImageJob();
+
+private:
+	ImageJob( const ImageJob& );
+	ImageJob& operator=( const ImageJob& );
+
+
+/// commands -------------------------------------------------------------------
+public:
+	/// read input image ('-' is the standard input), and set mapper from its
+	/// metadata, and get all other options, mostly into/overriding mapper
+	void   decode( const ImageFormatter& );
+	/// make output image, and map into it (then input image is freed)
+	void   map( const ImageFormatter& );
+	/// write output image
+	void   encode( const ImageFormatter& );
+
+	/// run a stage, timed, unless one already failed (a failure is kept, not
+	/// thrown)
+	void   runStage( EStage, const ImageFormatter& );
+
+
+/// queries --------------------------------------------------------------------
+	/// bytes of pixels held in memory
+	double getBytes() const;
+
+
+/// implementation -------------------------------------------------------------
+private:
+	/// the map stage, for one output, or several
+	void   mapOutput( const ImageFormatter& );
+	void   mapOutputs( const ImageFormatter& );
+
+
+/// fields ---------------------------------------------------------------------
+public:
+	const string         inImagePathname_m;
+	const vector<string> outImageSpecs_m;
+	const string         outImagePathname_m;
+	dword                width_m;
+	dword                height_m;
+	double               seconds_m[3];
+	string               failure_m;
+
+private:
+	const vector<string>* optionSets_m;
+	const string          inFormatName_m;
+	const string          outFormatName_m;
+	std::ostream*         pOutPipe_m;
+	bool                  isFeedback_m;
+
+	MapperWrapper         mapper_m;
+	dword                 outImageType_m;
+	DecodeAnalyser        analyser_m;
+	ImageRef*             pInImage_m;
+	bool                  isBanded_m;
+	ImageRef              outImage_m;
+	bool                  isOutInFile_m;
+	bool                  isOutShared_m;
+	RowsSink              outRows_m;
+	bool                  isMultiOut_m;
+	vector<OutputRows*>   outputs_m;
+};
+
+
+
+
+/// image input support --------------------------------------------------------
+
+/**
+ * Read all of the standard input (size unknown: a pipe).
+ *
+ * @bytes  appended to
+ */
+void  readStandardInput
+(
+	vector<ubyte>& bytes
+);
+
+/**
+ * Copy an image's pixels out, packed (eg from a read-only file mapping, to be
+ * calibrated in place).
+ *
+ * @return  a new image, for the caller to delete
+ */
+ImageRef*  copyPacked
+(
+	const ImageRef& image
+);
+
+
+}//namespace
+
+
+
+
+#endif//ImageJob_h
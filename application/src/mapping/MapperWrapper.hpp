@@ -0,0 +1,84 @@
+/*--------------------------------------------------------------------
+
+   Perceptuum3 rendering components
+   Copyright (c) 2005-2007, Harrison Ainsworth / HXA7241.
+
+   http://www.hxa7241.org/
+
+--------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later
+   version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+   MA  02110-1301  USA
+
+--------------------------------------------------------------------*/
+
+
+#ifndef MapperWrapper_h
+#define MapperWrapper_h
+
+
+#include "p3tmPerceptualMap-v13.h"
+
+
+
+
+#include "p3tonemapper_mapping.hpp"
+namespace p3tonemapper_mapping
+{
+
+
+/**
+ * Owner of a perceptual map, made with the default options, and freed with
+ * this.
+ */
+class MapperWrapper
+{
+/// standard object services ---------------------------------------------------
+public:
+	MapperWrapper()
+	 :	pMapper_m( ::p3tmCreatePerceptualMapDefault() )
+	{
+	}
+
+	~MapperWrapper()
+	{
+		::p3tmFreePerceptualMap( pMapper_m );
+	}
+
+private:
+	MapperWrapper( const MapperWrapper& );
+	MapperWrapper& operator=( const MapperWrapper& );
+
+
+/// queries --------------------------------------------------------------------
+public:
+	operator void* () { return pMapper_m; }
+
+
+/// fields ---------------------------------------------------------------------
+private:
+	void* pMapper_m;
+};
+
+
+}//namespace
+
+
+
+
+#endif//MapperWrapper_h
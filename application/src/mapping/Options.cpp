@@ -0,0 +1,576 @@
+/*--------------------------------------------------------------------
+
+   Perceptuum3 rendering components
+   Copyright (c) 2005-2007, Harrison Ainsworth / HXA7241.
+
+   http://www.hxa7241.org/
+
+--------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later
+   version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+   MA  02110-1301  USA
+
+--------------------------------------------------------------------*/
+
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <iostream>
+
+#include "ImageRef.hpp"
+#include "ImageFormatter.hpp"
+#include "png.hpp"
+
+#include "p3tmPerceptualMap-v13.h"
+
+#include "Options.hpp"   // own header is included last
+
+
+using namespace p3tonemapper_mapping;
+
+
+
+
+/// constants ------------------------------------------------------------------
+const char p3tonemapper_mapping::SHARED_PREFIX[] = "shm:";
+
+const char p3tonemapper_mapping::EXCEPTION_PREFIX[] =
+	"*** execution failed:  ";
+const char p3tonemapper_mapping::EXCEPTION_ABSTRACT[] =
+	"no annotation for cause";
+
+
+
+
+/// options --------------------------------------------------------------------
+void p3tonemapper_mapping::getOptions
+(
+	const vector<string> tokenSets[2],
+	ImageFormatter*      pFormatter,
+	void*                pMapper,
+	dword*               pOutPixelType,
+	vector<string>*      pOutPathnames,
+	string*              pInFormatName,
+	string*              pInLayout,
+	string*              pOutFormatName,
+	float*               pBatchMegabytes,
+	string*              pFrameSize
+)
+{
+	// get from command file, then override with command line
+	for( dword i = 0;  i < 2;  ++i )
+	{
+		// select token set
+		const vector<string>& tokens = tokenSets[i];
+
+		// (several out image pathnames are kept in order)
+		vector<string> outPathnames;
+
+		// read switches from tokens
+		for( int i = tokens.size();  i-- > 0; )
+		{
+			// eg: -lp:something_4.3
+			const string& token = tokens[i];
+
+			// only read if first char identifies a switch
+			if( (token.length() >= 3) && ('-' == token[0]) )
+			{
+				const char   topKey = token[1];
+				const char   subKey = token[2];
+				const string value( token.substr( 4 ) );
+				switch( topKey )
+				{
+				// libraries
+				case 'l' :
+					if( 0 != pFormatter )
+					{
+						switch( subKey )
+						{
+						// libpng pathname
+						case 'p' :
+							pFormatter->setPngLibrary( value.c_str() );
+							break;
+
+						// openexr pathname
+						case 'e' :
+							pFormatter->setExrLibrary( value.c_str() );
+							break;
+						}
+					}
+					break;
+
+				// batch options
+				case 'b' :
+					// memory for images in progress
+					if( ('m' == subKey) & (0 != pBatchMegabytes) )
+					{
+						*pBatchMegabytes = float(::atof( value.c_str() ));
+					}
+					break;
+
+				// video options
+				case 'v' :
+					// frame size (of a raw frame stream)
+					if( ('f' == subKey) & (0 != pFrameSize) )
+					{
+						*pFrameSize = value;
+					}
+					break;
+
+				// image metadata
+				case 'i' :
+					// input format
+					if( ('f' == subKey) & (0 != pInFormatName) )
+					{
+						*pInFormatName = value;
+					}
+					// input layout (of shared memory)
+					else if( ('l' == subKey) & (0 != pInLayout) )
+					{
+						*pInLayout = value;
+					}
+					else if( 0 != pMapper )
+					{
+						switch( subKey )
+						{
+						// colorspace primaries
+						case 'p' :
+							{
+								float colorspace[8] =
+									{ 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+
+								parseFps( value, colorspace,
+									sizeof(colorspace)/sizeof(colorspace[0]) );
+
+								::p3tmSetInputColorSpace(
+									pMapper, colorspace, colorspace + 6 );
+							}
+							break;
+
+						// calibration
+						case 's' :
+							{
+								float calibration[2] = { 0.0f, 0.0f };
+
+								parseFps( value, calibration,
+									sizeof(calibration)/sizeof(calibration[0]) );
+
+								::p3tmSetInputLuminanceScale( pMapper, calibration );
+							}
+							break;
+
+						// view angle
+						case 'v' :
+							{
+								const float viewAngle = float(::atof( value.c_str() ));
+
+								::p3tmSetInputViewAngle( pMapper, viewAngle );
+							}
+							break;
+						}
+					}
+					break;
+
+				// mapping options
+				case 'm' :
+					if( ('1' == subKey) & (0 != pMapper) )
+					{
+						dword mappingFlags = 0;
+
+						for( dword c = value.length();  c-- > 0; )
+						{
+							switch( value[c] )
+							{
+							case 'h' :
+								mappingFlags |= ::p3tm11_CONTRAST | ::p3tm11_GLARE |
+									::p3tm11_COLOR | ::p3tm11_ACUITY;
+								break;
+
+							case 't' :
+								mappingFlags |= ::p3tm11_CONTRAST;
+								break;
+
+							case 'g' :
+								mappingFlags |= ::p3tm11_GLARE;
+								break;
+
+							case 'c' :
+								mappingFlags |= ::p3tm11_COLOR;
+								break;
+
+							case 'a' :
+								mappingFlags |= ::p3tm11_ACUITY;
+								break;
+							}
+						}
+
+						::p3tmSetMappingFeatures( pMapper, mappingFlags );
+					}
+					break;
+
+				// output options
+				case 'o' :
+					switch( subKey )
+					{
+					// out luminance range
+					case 'r' :
+						if( 0 != pMapper )
+						{
+							float outLuminanceRange[2] = { 0.0f, 0.0f };
+
+							parseFps( value, outLuminanceRange,
+								sizeof(outLuminanceRange)/sizeof(outLuminanceRange[0]));
+
+							::p3tmSetOutputLuminanceRange(
+								pMapper, outLuminanceRange );
+						}
+						break;
+
+					// out gamma
+					case 'g' :
+						if( 0 != pMapper )
+						{
+							const float outGamma = float(::atof( value.c_str() ));
+
+							::p3tmSetOutputGamma( pMapper, outGamma );
+						}
+						break;
+
+					// out pixel type
+					case 'b' :
+						if( 0 != pOutPixelType )
+						{
+							const int i = ::atoi( value.c_str() );
+							*pOutPixelType = (16 == i) ?
+								::p3tm11_RGB_WORD : ::p3tm11_RGB_BYTE;
+						}
+						break;
+
+					// out png compression profile
+					case 'c' :
+						if( 0 != pFormatter )
+						{
+							pFormatter->setPngProfile(
+								(string("speed") == value) ?
+									p3tonemapper_format::png::PROFILE_SPEED :
+								(string("balanced") == value) ?
+									p3tonemapper_format::png::PROFILE_BALANCED :
+									p3tonemapper_format::png::PROFILE_SIZE );
+						}
+						break;
+
+					// out image pathnames
+					case 'n' :
+						if( 0 != pOutPathnames )
+						{
+							outPathnames.insert( outPathnames.begin(), value );
+						}
+						break;
+
+					// out format
+					case 'f' :
+						if( 0 != pOutFormatName )
+						{
+							*pOutFormatName = value;
+						}
+						break;
+					}
+					break;
+
+				default  :
+					;//break;
+				}
+			}
+		}
+
+		if( (0 != pOutPathnames) && !outPathnames.empty() )
+		{
+			*pOutPathnames = outPathnames;
+		}
+
+//    // print all args
+//    std::cout << "   argc    = " << argc << '\n';
+//    for( int i = 0;  i < argc;  ++i )
+//    {
+//       std::cout << "   argv[" << i << "] = " << argv[i] << '\n';
+//    }
+//    std::cout << '\n';
+	}
+}
+
+
+void p3tonemapper_mapping::setMapper
+(
+	const vector<string> optionSets[2],
+	const float* const   pPrimaries8,
+	const float          scaling,
+	void* const          pMapper,
+	dword&               outImageType
+)
+{
+	// set mapper from input image
+	if( 0 != pPrimaries8 )
+	{
+		::p3tmSetInputColorSpace( pMapper, pPrimaries8, pPrimaries8 + 6 );
+	}
+	if( 0.0f != scaling )
+	{
+		const float scalingOffset[2] = { scaling, 0.0f };
+		::p3tmSetInputLuminanceScale( pMapper, scalingOffset );
+	}
+
+	// get all other options, mostly into/overriding mapper
+	getOptions( optionSets, 0, pMapper, &outImageType, 0, 0, 0, 0, 0, 0 );
+}
+
+
+string p3tonemapper_mapping::makeOutPathname
+(
+	const string& pattern,
+	const string& inImagePathname
+)
+{
+	string outPathname;
+
+	// (an output spec's bits and scaling, after the pathname, are kept)
+	const string::size_type pathnameLength = pattern.find( ',' );
+	if( string::npos != pathnameLength )
+	{
+		outPathname = p3tonemapper_mapping::makeOutPathname( pattern.substr( 0, pathnameLength ),
+			inImagePathname ) + pattern.substr( pathnameLength );
+	}
+	// default: the input file path name, with extension replaced
+	else if( pattern.empty() )
+	{
+		outPathname = inImagePathname.substr( 0, inImagePathname.rfind('.') ) +
+			".png";
+	}
+	// each '%s' replaced by the input file name, without directory and
+	// extension
+	else
+	{
+		const string::size_type nameStart =
+			inImagePathname.find_last_of( "/\\" ) + 1;
+		string name( inImagePathname.substr( nameStart ) );
+		name = name.substr( 0, name.rfind('.') );
+
+		outPathname = pattern;
+		for( string::size_type i = outPathname.find( "%s" );
+			string::npos != i;  i = outPathname.find( "%s", i + name.length() ) )
+		{
+			outPathname.replace( i, 2, name );
+		}
+	}
+
+	return outPathname;
+}
+
+
+bool p3tonemapper_mapping::parseFps
+(
+	const string& group,
+	float         fps[],
+	const dword   length
+)
+{
+	vector<string> fpStrings;
+	tokenize( group, '_', fpStrings );
+
+	bool        isAllOk = (udword(length) == fpStrings.size());
+	const dword minLength = length <= dword(fpStrings.size()) ?
+		length : dword(fpStrings.size());
+	for( dword f = minLength;  f-- > 0;  )
+	{
+		isAllOk &= parseFp( fpStrings[f], fps[f] );
+	}
+
+// // do all or nothing
+// bool isAllOk = (length == fpStrings.size());
+// for( udword f = 0;  (f < length) & isAllOk;  ++f )
+// {
+//    isAllOk &= parseFp( fpStrings[f], fps[f] );
+// }
+
+	return isAllOk;
+}
+
+
+bool p3tonemapper_mapping::parseFp
+(
+	const string& s,
+	float&        fp
+)
+{
+	errno = 0;
+
+	const char* pNum = s.c_str();
+	char*       pEnd = 0;
+
+	fp = float( ::strtod( pNum, &pEnd ) );
+
+	return (0 == errno) & (0 == *pEnd) & (pNum != pEnd);
+}
+
+
+void p3tonemapper_mapping::tokenize
+(
+	const string&   str,
+	const char      separator,
+	vector<string>& tokens
+)
+{
+	size_t posToken   = 0;
+	bool   isSepFound = false;
+	do
+	{
+		const size_t posSep = str.find( separator, posToken );
+		isSepFound          = string::npos != posSep;
+
+		tokens.push_back( str.substr( posToken,
+			isSepFound ? posSep - posToken : string::npos ) );
+		posToken = posSep + 1;
+	}
+	while( isSepFound );
+}
+
+
+//void tokenize
+//(
+// const string&   str,
+// vector<string>& tokens
+//)
+//{
+// std::stringstream ss( str );
+//
+// for( string token;  ss >> token; )
+// {
+//    tokens.push_back( token );
+// }
+//}
+
+
+
+
+/// feedback -------------------------------------------------------------------
+void p3tonemapper_mapping::printImageStats
+(
+	const bool      isFeedback,
+	const ImageRef& image
+)
+{
+	if( isFeedback )
+	{
+		ImageRef::EPixelType pixelsType = image.getPixelType();
+		if( ImageRef::PIXELS_FLOAT == pixelsType )
+		{
+			float min  = FLOAT_MAX;
+			float max  = FLOAT_MIN_NEG;
+			float mean = 0.0f;
+			{
+				const float  scaling = image.getScaling();
+				const ubyte* pPixels = static_cast<const ubyte*>(
+					image.getPixels() );
+				const dword  length  = image.getWidth() * image.getHeight();
+
+				// (copied out, since mapped pixels may be unaligned, or not
+				// packed)
+				for( dword i = 0;  i < length;  ++i )
+				{
+					const dword x = i % image.getWidth();
+					const dword y = i / image.getWidth();
+
+					float rgb[3];
+					::memcpy( rgb, pPixels + (y * image.getRowStride()) +
+						(x * image.getPixelStep()), sizeof(rgb) );
+
+					float luminance = (0.2126f * rgb[0]) +
+						(0.7152f * rgb[1]) + (0.0722f * rgb[2]);
+					luminance = (0.0f != scaling) ? luminance * scaling : luminance;
+
+					min   = min <= luminance ? min : luminance;
+					max   = max >= luminance ? max : luminance;
+					mean += luminance;
+				}
+
+				mean /= (length > 0) ? float(length) : 1.0f;
+			}
+
+			std::cout << "\ninput image stats";
+			std::cout << "\n   luminance min, max, mean = " << min << "  " <<
+				max << "  " << mean;
+			std::cout << "\n";
+		}
+		else
+		{
+			// not done yet...
+		}
+	}
+}
+
+
+void p3tonemapper_mapping::printMapper
+(
+	const bool  isFeedback,
+	const void* pMapper
+)
+{
+	if( isFeedback )
+	{
+		float inChromaticities6[6];
+		float inWhitePoint2[2];
+		float inScalingAndOffset2[2];
+		float inViewAngleHorizontal;
+		int   mappingFlags;
+		float outLuminanceRange2[2];
+		float outGamma;
+
+		::p3tmGetOptions( pMapper,
+			inChromaticities6,
+			inWhitePoint2,
+			inScalingAndOffset2,
+			&inViewAngleHorizontal,
+			&mappingFlags,
+			outLuminanceRange2,
+			&outGamma );
+
+		std::cout << "\nmapper fields";
+		std::cout << "\n   inChromaticities      = ";
+		for( dword i = 0;  i < 6;  ++i )
+		{
+			std::cout << inChromaticities6[i] << " ";
+		}
+		std::cout << "\n   inWhitePoint          = " << inWhitePoint2[0] <<
+			" " << inWhitePoint2[1];
+		std::cout << "\n   inScalingAndOffset    = " << inScalingAndOffset2[0] <<
+			" " << inScalingAndOffset2[1];
+		std::cout << "\n   inViewAngleHorizontal = " << inViewAngleHorizontal;
+		std::cout << "\n   mappingFlags          = " <<
+			((mappingFlags & ::p3tm11_CONTRAST ) ? "t" : "") << " " <<
+			((mappingFlags & (::p3tm11_GLARE  & ~::p3tm11_CONTRAST)) ?
+				"g" : "") << " " <<
+			((mappingFlags & (::p3tm11_COLOR  & ~::p3tm11_CONTRAST)) ?
+				"c" : "") << " " <<
+			((mappingFlags & (::p3tm11_ACUITY & ~::p3tm11_CONTRAST)) ?
+				"a" : "");
+		std::cout << "\n   outLuminanceRange2    = " << outLuminanceRange2[0] <<
+			" " << outLuminanceRange2[1];
+		std::cout << "\n   outGamma              = " << outGamma;
+		std::cout << "\n";
+	}
+}
@@ -0,0 +1,161 @@
+/*--------------------------------------------------------------------
+
+   Perceptuum3 rendering components
+   Copyright (c) 2005-2007, Harrison Ainsworth / HXA7241.
+
+   http://www.hxa7241.org/
+
+--------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later
+   version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+   MA  02110-1301  USA
+
+--------------------------------------------------------------------*/
+
+
+#ifndef Options_h
+#define Options_h
+
+
+#include <string>
+#include <vector>
+
+
+
+
+#include "p3tonemapper_mapping.hpp"
+namespace p3tonemapper_mapping
+{
+
+
+/// constants ------------------------------------------------------------------
+
+/// pathname prefix of an image in shared memory, in or out (eg: shm:/frame)
+extern const char SHARED_PREFIX[];
+
+/// failure messages
+extern const char EXCEPTION_PREFIX[];
+extern const char EXCEPTION_ABSTRACT[];
+
+
+
+
+/// options --------------------------------------------------------------------
+
+/**
+ * Read switches from the command file tokens, then override with the command
+ * line tokens. Each pointer not 0 gets what its switches set.
+ *
+ * @pFormatter  libraries, and png compression profile
+ * @pMapper     input metadata, mapping features, and output luminance range
+ *              and gamma
+ */
+void  getOptions
+(
+	const vector<string> tokenSets[2],
+	ImageFormatter*      pFormatter,
+	void*                pMapper,
+	dword*               pOutPixelType,
+	vector<string>*      pOutPathnames,
+	string*              pInFormatName,
+	string*              pInLayout,
+	string*              pOutFormatName,
+	float*               pBatchMegabytes,
+	string*              pFrameSize
+);
+
+/**
+ * Set mapper from an input image's metadata, then get all other options,
+ * mostly into/overriding it.
+ *
+ * @pPrimaries8  0 if not known
+ * @scaling      0 if not known
+ */
+void  setMapper
+(
+	const vector<string> optionSets[2],
+	const float*         pPrimaries8,
+	float                scaling,
+	void*                pMapper,
+	dword&               outImageType
+);
+
+/**
+ * Make an output pathname from a pattern: each '%s' replaced by the input
+ * file name, without directory and extension (empty: the input pathname,
+ * with a png extension). An output spec's bits and scaling are kept.
+ */
+string  makeOutPathname
+(
+	const string& pattern,
+	const string& inImagePathname
+);
+
+/**
+ * Parse floats separated by '_' (eg: 0.64_0.33).
+ *
+ * @return  whether all were parsed, and there were length of them
+ */
+bool  parseFps
+(
+	const string& group,
+	float         fps[],
+	dword         length
+);
+
+bool  parseFp
+(
+	const string& s,
+	float&        fp
+);
+
+/**
+ * @tokens  appended to: the fields between separators (an empty string
+ *          gives one empty field)
+ */
+void  tokenize
+(
+	const string&   str,
+	char            separator,
+	vector<string>& tokens
+);
+
+
+
+
+/// feedback (the -z switch) ---------------------------------------------------
+
+void  printImageStats
+(
+	bool            isFeedback,
+	const ImageRef& image
+);
+
+void  printMapper
+(
+	bool        isFeedback,
+	const void* pMapper
+);
+
+
+}//namespace
+
+
+
+
+#endif//Options_h
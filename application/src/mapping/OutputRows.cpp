@@ -0,0 +1,395 @@
+/*--------------------------------------------------------------------
+
+   Perceptuum3 rendering components
+   Copyright (c) 2005-2007, Harrison Ainsworth / HXA7241.
+
+   http://www.hxa7241.org/
+
+--------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later
+   version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+   MA  02110-1301  USA
+
+--------------------------------------------------------------------*/
+
+
+#include <stdlib.h>
+#include <algorithm>
+#include <exception>
+
+#include "ImageFormatter.hpp"
+#include "ImageRowsWriter.hpp"
+#include "Options.hpp"
+
+#include "p3tmPerceptualMap-v13.h"
+
+#include "OutputRows.hpp"   // own header is included last
+
+
+using namespace p3tonemapper_mapping;
+
+
+
+
+/// RowsSink ///////////////////////////////////////////////////////////////////
+
+
+/// standard object services ---------------------------------------------------
+RowsSink::RowsSink
+(
+	p3tonemapper_format::ImageRowsWriter* pWriter
+)
+ :	pWriter_m  ( pWriter )
+ ,	exception_m()
+{
+}
+
+
+RowsSink::~RowsSink()
+{
+	delete pWriter_m;
+}
+
+
+
+
+/// commands -------------------------------------------------------------------
+int RowsSink::writeRows
+(
+	void*const       pSinkContext,
+	const int        rowCount,
+	const void*const pRows
+)
+{
+	RowsSink& sink = *static_cast<RowsSink*>( pSinkContext );
+
+	try
+	{
+		sink.pWriter_m->writeRows( rowCount, pRows );
+
+		return 1;
+	}
+	catch( const std::exception& e )
+	{
+		sink.exception_m = e.what();
+	}
+	catch( const char*const pExceptionString )
+	{
+		sink.exception_m = pExceptionString;
+	}
+	catch( ... )
+	{
+		sink.exception_m = "unannotated exception";
+	}
+
+	return 0;
+}
+
+
+
+
+
+/// OutputRows /////////////////////////////////////////////////////////////////
+
+
+/// standard object services ---------------------------------------------------
+OutputRows::OutputRows
+(
+	const ImageFormatter& formatter,
+	const string&         spec,
+	const dword           outImageType,
+	const ImageRef&       inImage,
+	const string&         outFormatName,
+	std::ostream* const   pOutPipe
+)
+ :	pathname_m     ()
+ ,	outImageType_m ( outImageType )
+ ,	exception_m    ()
+ ,	outFormatName_m( outFormatName )
+ ,	pOutPipe_m     ( 0 )
+ ,	isShared_m     ( false )
+ ,	inWidth_m      ( inImage.getWidth() )
+ ,	inHeight_m     ( inImage.getHeight() )
+ ,	outWidth_m     ( inWidth_m )
+ ,	outHeight_m    ( inHeight_m )
+ ,	image_m        ()
+ ,	pWriter_m      ( 0 )
+ ,	columns_m      ()
+ ,	columnCounts_m ()
+ ,	sums_m         ()
+ ,	row_m          ()
+ ,	rowsIn_m       ( 0 )
+ ,	rowsSummed_m   ( 0 )
+ ,	rowsOut_m      ( 0 )
+{
+	float scaling = 1.0f;
+	parseSpec( spec, pathname_m, outImageType_m, scaling );
+
+	const bool isWords = ::p3tm11_RGB_WORD == outImageType_m;
+	pOutPipe_m = (string("-") == pathname_m) ? pOutPipe : 0;
+	isShared_m = 0 == pathname_m.compare( 0, 4, SHARED_PREFIX );
+
+	// scaled: at least one pixel, and averaging each output pixel from the
+	// input pixels falling in it
+	if( 1.0f != scaling )
+	{
+		outWidth_m  = (inWidth_m  > 0) ? std::max( dword(1),
+			dword(float(inWidth_m)  * scaling + 0.5f) ) : 0;
+		outHeight_m = (inHeight_m > 0) ? std::max( dword(1),
+			dword(float(inHeight_m) * scaling + 0.5f) ) : 0;
+
+		columns_m.resize( inWidth_m );
+		columnCounts_m.resize( outWidth_m, 0 );
+		for( dword x = 0;  x < inWidth_m;  ++x )
+		{
+			columns_m[x] = dword( (double(x) * double(outWidth_m)) /
+				double(inWidth_m) );
+			++columnCounts_m[columns_m[x]];
+		}
+		sums_m.resize( outWidth_m * 3, 0.0 );
+		row_m.resize( outWidth_m * 3 * (isWords ? 2 : 1) );
+	}
+
+	// make output: in shared memory, or rows written as they come, if its
+	// format allows, else an image in memory
+	if( isShared_m )
+	{
+		formatter.makeSharedImage( pathname_m.c_str() + 4, outWidth_m,
+			outHeight_m, isWords, image_m );
+	}
+	else
+	{
+		pWriter_m = (0 != pOutPipe_m) ? formatter.makeImageRowsWriter(
+			outFormatName_m.c_str(), outWidth_m, outHeight_m, isWords,
+			inImage.getPrimaries(), *pOutPipe_m ) :
+			formatter.makeImageRowsWriter( pathname_m.c_str(), outWidth_m,
+			outHeight_m, isWords, inImage.getPrimaries() );
+	}
+	if( !isShared_m & (0 == pWriter_m) )
+	{
+		const dword length = outWidth_m * outHeight_m * 3;
+		image_m.set( outWidth_m, outHeight_m, inImage.getPrimaries(),
+			inImage.getScaling(), isWords ? ImageRef::PIXELS_WORD :
+			ImageRef::PIXELS_BYTE, isWords ?
+			static_cast<void*>( new uword[length] ) :
+			static_cast<void*>( new ubyte[length] ) );
+	}
+}
+
+
+
+OutputRows::~OutputRows()
+{
+	delete pWriter_m;
+}
+
+
+
+
+/// commands -------------------------------------------------------------------
+void OutputRows::finish
+(
+	const ImageFormatter& formatter
+)
+{
+	if( 0 != pWriter_m )
+	{
+		pWriter_m->finish();
+	}
+	else if( 0 != pOutPipe_m )
+	{
+		formatter.writeImage( outFormatName_m.c_str(), image_m, *pOutPipe_m );
+	}
+	else if( !isShared_m )
+	{
+		formatter.writeImage( pathname_m.c_str(), image_m );
+	}
+}
+
+
+int OutputRows::writeRows
+(
+	void*const       pSinkContext,
+	const int        rowCount,
+	const void*const pRows
+)
+{
+	OutputRows& output = *static_cast<OutputRows*>( pSinkContext );
+
+	try
+	{
+		// scaled: averaged down first
+		if( !output.columns_m.empty() )
+		{
+			output.averageRows( rowCount, static_cast<const ubyte*>( pRows ) );
+		}
+		else
+		{
+			output.putRows( rowCount, static_cast<const ubyte*>( pRows ) );
+		}
+
+		return 1;
+	}
+	catch( const std::exception& e )
+	{
+		output.exception_m = e.what();
+	}
+	catch( const char*const pExceptionString )
+	{
+		output.exception_m = pExceptionString;
+	}
+	catch( ... )
+	{
+		output.exception_m = "unannotated exception";
+	}
+
+	return 0;
+}
+
+
+
+
+
+/// queries --------------------------------------------------------------------
+double OutputRows::getBytes() const
+{
+	// (pixels in shared memory are not held)
+	return ((0 != image_m.getPixels()) & !isShared_m) ?
+		double(outWidth_m) * double(outHeight_m) * 3.0 *
+		((::p3tm11_RGB_WORD == outImageType_m) ? 2.0 : 1.0) : 0.0;
+}
+
+
+
+
+
+/// implementation -------------------------------------------------------------
+void OutputRows::parseSpec
+(
+	const string& spec,
+	string&       pathname,
+	dword&        outImageType,
+	float&        scaling
+)
+{
+	// eg: thumb.png,8,0.25
+	vector<string> fields;
+	tokenize( spec, ',', fields );
+	fields.resize( 3 );
+
+	pathname = fields[0];
+
+	// bits, if given (else as -ob:)
+	if( !fields[1].empty() )
+	{
+		outImageType = (16 == ::atoi( fields[1].c_str() )) ?
+			::p3tm11_RGB_WORD : ::p3tm11_RGB_BYTE;
+	}
+
+	// scaling, if given, and down (else none)
+	scaling = fields[2].empty() ? 1.0f : float(::atof( fields[2].c_str() ));
+	if( (scaling <= 0.0f) | (scaling > 1.0f) )
+	{
+		scaling = 1.0f;
+	}
+}
+
+
+void OutputRows::averageRows
+(
+	const dword        rowCount,
+	const ubyte* const pRows
+)
+{
+	const bool  isWords    = ::p3tm11_RGB_WORD == outImageType_m;
+	const dword inRowBytes = inWidth_m * 3 * (isWords ? 2 : 1);
+
+	for( dword r = 0;  r < rowCount;  ++r )
+	{
+		// sum the row into its output row
+		const ubyte* pBytes = pRows + (r * inRowBytes);
+		const uword* pWords = static_cast<const uword*>(
+			static_cast<const void*>( pBytes ) );
+		for( dword x = 0;  x < inWidth_m;  ++x )
+		{
+			double* pSums = &(sums_m[columns_m[x] * 3]);
+			for( dword c = 0;  c < 3;  ++c )
+			{
+				pSums[c] += isWords ? double(pWords[(x * 3) + c]) :
+					double(pBytes[(x * 3) + c]);
+			}
+		}
+		++rowsSummed_m;
+		++rowsIn_m;
+
+		// output row complete (the next input row falls in the next one, or
+		// there is none): average it, and put it
+		const dword outRow  = dword( (double(rowsIn_m - 1) *
+			double(outHeight_m)) / double(inHeight_m) );
+		const dword nextRow = dword( (double(rowsIn_m) *
+			double(outHeight_m)) / double(inHeight_m) );
+		if( (rowsIn_m == inHeight_m) | (nextRow != outRow) )
+		{
+			uword* pOutWords = static_cast<uword*>(
+				static_cast<void*>( &(row_m[0]) ) );
+			for( dword i = 0;  i < outWidth_m * 3;  ++i )
+			{
+				const double mean = (sums_m[i] /
+					double(columnCounts_m[i / 3] * rowsSummed_m)) + 0.5;
+				if( isWords )
+				{
+					pOutWords[i] = uword(mean);
+				}
+				else
+				{
+					row_m[i] = ubyte(mean);
+				}
+				sums_m[i] = 0.0;
+			}
+			rowsSummed_m = 0;
+
+			putRows( 1, &(row_m[0]) );
+		}
+	}
+}
+
+
+void OutputRows::putRows
+(
+	const dword        rowCount,
+	const ubyte* const pRows
+)
+{
+	if( 0 != pWriter_m )
+	{
+		pWriter_m->writeRows( rowCount, pRows );
+	}
+	// (rows in memory are bottom first)
+	else
+	{
+		const dword rowBytes = outWidth_m * 3 *
+			((::p3tm11_RGB_WORD == outImageType_m) ? 2 : 1);
+		ubyte*const pPixels  = static_cast<ubyte*>( image_m.getPixels() );
+		for( dword r = 0;  r < rowCount;  ++r )
+		{
+			++rowsOut_m;
+			std::copy( pRows + (r * rowBytes), pRows + ((r + 1) * rowBytes),
+				pPixels + ((outHeight_m - rowsOut_m) * rowBytes) );
+		}
+	}
+}
@@ -0,0 +1,162 @@
+/*--------------------------------------------------------------------
+
+   Perceptuum3 rendering components
+   Copyright (c) 2005-2007, Harrison Ainsworth / HXA7241.
+
+   http://www.hxa7241.org/
+
+--------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later
+   version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+   MA  02110-1301  USA
+
+--------------------------------------------------------------------*/
+
+
+#ifndef OutputRows_h
+#define OutputRows_h
+
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#include "ImageRef.hpp"
+
+
+
+
+#include "p3tonemapper_mapping.hpp"
+namespace p3tonemapper_mapping
+{
+
+
+/**
+ * Sink of mapped rows, for a single output, given to a rows writer.
+ */
+class RowsSink
+{
+/// standard object services ---------------------------------------------------
+public:
+	/// owns the writer (if any)
+	explicit RowsSink( p3tonemapper_format::ImageRowsWriter* pWriter );
+
+	~RowsSink();
+
+private:
+	RowsSink( const RowsSink& );
+	RowsSink& operator=( const RowsSink& );
+
+
+/// commands -------------------------------------------------------------------
+public:
+	/// p3tmRowSink: a writer exception is kept, and stops the mapping
+	static int writeRows( void*, int, const void* );
+
+
+/// fields ---------------------------------------------------------------------
+	p3tonemapper_format::ImageRowsWriter* pWriter_m;
+	string                                exception_m;
+};
+
+
+
+
+/**
+ * One of several outputs of one mapping, made from a spec: pathname
+ * [,bits [,scaling]] (eg: thumb.png,8,0.25).<br/><br/>
+ *
+ * Its rows go to a writer, if its format allows, else into an image in
+ * memory (or shared memory) -- averaged down first, if scaled.
+ */
+class OutputRows
+{
+/// standard object services ---------------------------------------------------
+public:
+	/// pOutPipe: output there, in outFormatName, if the pathname is '-'
+	OutputRows( const ImageFormatter&, const string& spec,
+		dword outImageType, const ImageRef& inImage,
+		const string& outFormatName, std::ostream* pOutPipe );
+
+	~OutputRows();
+
+private:
+	OutputRows( const OutputRows& );
+	OutputRows& operator=( const OutputRows& );
+
+
+/// commands -------------------------------------------------------------------
+public:
+	/// write output image (unless already written, as rows, then only
+	/// finished, or in shared memory)
+	void   finish( const ImageFormatter& );
+
+	/// p3tmRowSink: rows top first; an exception is kept, and stops the
+	/// mapping
+	static int writeRows( void*, int, const void* );
+
+
+/// queries --------------------------------------------------------------------
+	/// bytes of pixels held in memory
+	double getBytes() const;
+
+
+/// implementation -------------------------------------------------------------
+private:
+	static void parseSpec( const string& spec, string& pathname,
+		dword& outImageType, float& scaling );
+
+	void   averageRows( dword rowCount, const ubyte* pRows );
+	void   putRows( dword rowCount, const ubyte* pRows );
+
+
+/// fields ---------------------------------------------------------------------
+public:
+	string pathname_m;
+	dword  outImageType_m;
+	string exception_m;
+
+private:
+	const string                          outFormatName_m;
+	std::ostream*                         pOutPipe_m;
+	bool                                  isShared_m;
+	dword                                 inWidth_m;
+	dword                                 inHeight_m;
+	dword                                 outWidth_m;
+	dword                                 outHeight_m;
+	ImageRef                              image_m;
+	p3tonemapper_format::ImageRowsWriter* pWriter_m;
+
+	// scaling: output column of each input column, input columns in each
+	// output column, and sums of the output row being averaged
+	vector<dword>                         columns_m;
+	vector<dword>                         columnCounts_m;
+	vector<double>                        sums_m;
+	vector<ubyte>                         row_m;
+	dword                                 rowsIn_m;
+	dword                                 rowsSummed_m;
+	dword                                 rowsOut_m;
+};
+
+
+}//namespace
+
+
+
+
+#endif//OutputRows_h
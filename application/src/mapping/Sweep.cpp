@@ -0,0 +1,483 @@
+/*--------------------------------------------------------------------
+
+   Perceptuum3 rendering components
+   Copyright (c) 2005-2007, Harrison Ainsworth / HXA7241.
+
+   http://www.hxa7241.org/
+
+--------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later
+   version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+   MA  02110-1301  USA
+
+--------------------------------------------------------------------*/
+
+
+#include <iostream>
+#include <algorithm>
+#include <exception>
+
+#include "Thread.hpp"
+#include "Clock.hpp"
+#include "Processors.hpp"
+#include "ImageRef.hpp"
+#include "ImageFormatter.hpp"
+#include "MapperWrapper.hpp"
+#include "ImageJob.hpp"
+#include "Options.hpp"
+
+#include "p3tmPerceptualMap-v13.h"
+
+#include "Sweep.hpp"   // own header is included last
+
+
+using namespace p3tonemapper_mapping;
+
+
+
+
+/// constants
+static const char EXCEPTION_SWEEP_NAME[] =
+	"sweep output file path name needs %v";
+
+// switches a sweep varies: mapping features, out luminance range, out gamma
+static const char* const SWEEP_SWITCHES[3] = { "-m1:", "-or:", "-og:" };
+
+
+namespace
+{
+
+/**
+ * One variant of a sweep, mapped, and written, on another thread.
+ */
+class SweepVariant
+	: public hxa7241_general::Thread
+{
+public:
+	// one variant of a sweep (set its options, then its sweep, before
+	// running), mapped into an image the size of the input image
+	SweepVariant( const ImageFormatter& formatter, const ImageRef& inImage,
+		dword outImageType )
+	 :	pSweep_m        ( 0 )
+	 ,	tag_m           ()
+	 ,	outPathname_m   ()
+	 ,	mappingFlags_m  ( 0 )
+	 ,	outGamma_m      ( 0.0f )
+	 ,	failure_m       ()
+	 ,	formatter_m     ( formatter )
+	 ,	inImage_m       ( inImage )
+	 ,	outImageType_m  ( outImageType )
+	{
+		outLuminanceRange_m[0] = 0.0f;
+		outLuminanceRange_m[1] = 0.0f;
+		seconds_m[0] = 0.0;
+		seconds_m[1] = 0.0;
+	}
+
+	virtual ~SweepVariant();
+
+	// map, and write the output image, timed (a failure is kept, not thrown)
+	void mapAndWrite();
+
+	// run on another thread (or on this one, if a thread cannot start)
+	void startVariant();
+
+protected:
+	virtual void run();
+
+public:
+	const void* pSweep_m;
+	string      tag_m;
+	string      outPathname_m;
+	int         mappingFlags_m;
+	float       outLuminanceRange_m[2];
+	float       outGamma_m;
+	double      seconds_m[2];
+	string      failure_m;
+
+private:
+	const ImageFormatter& formatter_m;
+	const ImageRef&       inImage_m;
+	dword                 outImageType_m;
+
+	SweepVariant( const SweepVariant& );
+	SweepVariant& operator=( const SweepVariant& );
+};
+
+}
+
+
+
+
+/// ----------------------------------------------------------------------------
+void p3tonemapper_mapping::getSweepOptions
+(
+	const vector<string> tokenSets[2],
+	vector<string>       sweepValues[3]
+)
+{
+	// all values of each switch a sweep varies, in order (from the command
+	// file, then replaced by any on the command line)
+	for( dword i = 0;  i < 2;  ++i )
+	{
+		const vector<string>& tokens = tokenSets[i];
+
+		for( dword s = 0;  s < 3;  ++s )
+		{
+			vector<string> values;
+			for( dword t = 0;  t < dword(tokens.size());  ++t )
+			{
+				if( 0 == tokens[t].compare( 0, 4, SWEEP_SWITCHES[s] ) )
+				{
+					values.push_back( tokens[t].substr( 4 ) );
+				}
+			}
+
+			if( !values.empty() )
+			{
+				sweepValues[s] = values;
+			}
+		}
+	}
+}
+
+
+bool p3tonemapper_mapping::mapSweep
+(
+	const ImageFormatter& formatter,
+	const vector<string>  optionSets[2],
+	const vector<string>  sweepValues[3],
+	const string&         inImagePathname,
+	const string&         inFormatName,
+	const string&         outPathnamePattern,
+	const bool            isFeedback
+)
+{
+	// output file path name: each '%v' replaced by the variant's tag
+	// (default: the input file path name, with '-%v' before the extension)
+	const bool   isInPiped = string("-") == inImagePathname;
+	const string pattern( (outPathnamePattern.empty() & !isInPiped) ?
+		inImagePathname.substr( 0, inImagePathname.rfind('.') ) + "-%v.png" :
+		makeOutPathname( outPathnamePattern, inImagePathname ) );
+	if( string::npos == pattern.find( "%v" ) )
+	{
+		throw EXCEPTION_SWEEP_NAME;
+	}
+
+	// (libraries stay loaded for all the variants' writes)
+	const dword libraries = formatter.acquireLibraries();
+
+	MapperWrapper         mapper;
+	dword                 outImageType = 0;
+	ImageRef*             pInImage     = new ImageRef;
+	void*                 pSweep       = 0;
+	vector<SweepVariant*> variants;
+
+	dword  failureCount = 0;
+	const double start  = hxa7241_general::getClockSeconds();
+
+	try
+	{
+		// read input image, whole ('-' is the standard input), and set mapper
+		// from its metadata, and get all other options, mostly into/
+		// overriding mapper
+		if( isInPiped )
+		{
+			vector<ubyte> inBytes;
+			readStandardInput( inBytes );
+
+			formatter.readImage( inBytes.empty() ? 0 : &(inBytes[0]),
+				udword(inBytes.size()), inFormatName.c_str(), *pInImage, 0 );
+		}
+		else
+		{
+			formatter.readImage( inImagePathname.c_str(), *pInImage, 0 );
+		}
+
+		// pixels in a file mapping are read-only (and maybe not packed), so
+		// copy them out, packed, to be calibrated in place
+		if( pInImage->isMapped() )
+		{
+			ImageRef*const pPacked = copyPacked( *pInImage );
+
+			delete pInImage;
+			pInImage = pPacked;
+		}
+		const ImageRef& inImage = *pInImage;
+
+		setMapper( optionSets, inImage.getPrimaries(), inImage.getScaling(),
+			mapper, outImageType );
+
+		printImageStats( isFeedback, inImage );
+		printMapper( isFeedback, mapper );
+
+		const double read = hxa7241_general::getClockSeconds();
+
+		// make variants: every combination of the values (each a copy of
+		// mapper, with its values set), and the distinct mapping features
+		vector<int> mappingFlagSets;
+		{
+			dword counts[3];
+			for( dword s = 0;  s < 3;  ++s )
+			{
+				counts[s] = sweepValues[s].empty() ? 1 :
+					dword(sweepValues[s].size());
+			}
+
+			MapperWrapper variantMapper;
+			for( dword m = 0;  m < counts[0];  ++m )
+			{
+				for( dword r = 0;  r < counts[1];  ++r )
+				{
+					for( dword g = 0;  g < counts[2];  ++g )
+					{
+						const dword indexes[3] = { m, r, g };
+
+						// tokens of the values, and a tag of those varied
+						// (eg: m1h-or1.4_100-og0.45)
+						vector<string> tokenSets[2];
+						string         tag;
+						for( dword s = 0;  s < 3;  ++s )
+						{
+							if( !sweepValues[s].empty() )
+							{
+								const string& value = sweepValues[s][indexes[s]];
+								tokenSets[1].push_back( SWEEP_SWITCHES[s] + value );
+
+								if( sweepValues[s].size() > 1 )
+								{
+									tag += (tag.empty() ? "" : "-") +
+										string( SWEEP_SWITCHES[s] + 1, 2 ) + value;
+								}
+							}
+						}
+
+						variants.push_back( 0 );
+						variants.back() = new SweepVariant( formatter, inImage,
+							outImageType );
+						SweepVariant& variant = *variants.back();
+
+						::p3tmAssignPerceptualMap( mapper, variantMapper );
+						getOptions( tokenSets, 0, variantMapper, 0, 0, 0, 0, 0, 0,
+							0 );
+						::p3tmGetOptions( variantMapper, 0, 0, 0, 0,
+							&variant.mappingFlags_m, variant.outLuminanceRange_m,
+							&variant.outGamma_m );
+
+						variant.tag_m         = tag;
+						variant.outPathname_m = pattern;
+						for( string::size_type i = variant.outPathname_m.find(
+							"%v" );  string::npos != i;
+							i = variant.outPathname_m.find( "%v", i + tag.length() ) )
+						{
+							variant.outPathname_m.replace( i, 2, tag );
+						}
+
+						if( mappingFlagSets.end() == std::find(
+							mappingFlagSets.begin(), mappingFlagSets.end(),
+							variant.mappingFlags_m ) )
+						{
+							mappingFlagSets.push_back( variant.mappingFlags_m );
+						}
+					}
+				}
+			}
+		}
+
+		// make the sweep: the analysis all the variants share
+		{
+			const int inImageType =
+				(ImageRef::PIXELS_HALF == inImage.getPixelType()) ?
+				::p3tm13_RGB_HALF : ::p3tm11_RGB_FLOAT;
+
+			char pMessage128[128] = "\0";
+			pSweep = ::p3tmCreatePerceptualMapSweep( mapper, inImage.getWidth(),
+				inImage.getHeight(), inImageType, inImage.getPixels(),
+				int(mappingFlagSets.size()), &(mappingFlagSets[0]), pMessage128 );
+			if( 0 == pSweep )
+			{
+				throw string( pMessage128 );
+			}
+		}
+
+		const double analysed = hxa7241_general::getClockSeconds();
+
+		std::cout << inImagePathname << "  " << inImage.getWidth() << "x" <<
+			inImage.getHeight() << "  read " << (read - start) <<
+			"s  analyse " << (analysed - read) << "s  (" << variants.size() <<
+			" variants, " << mappingFlagSets.size() <<
+			" sets of mapping features)\n";
+		std::cout.flush();
+
+		// map, and write, the variants a round at a time, one per processor:
+		// all but the first on other threads, and the first on this one
+		// (failures are kept in the variants, not thrown)
+		const dword count          = dword(variants.size());
+		const dword processorCount = hxa7241_general::getProcessorCount();
+		for( dword begin = 0;  begin < count;  begin += processorCount )
+		{
+			const dword end = (count - begin > processorCount) ?
+				begin + processorCount : count;
+
+			for( dword i = begin;  i < end;  ++i )
+			{
+				variants[i]->pSweep_m = pSweep;
+			}
+
+			for( dword i = begin + 1;  i < end;  ++i )
+			{
+				variants[i]->startVariant();
+			}
+			variants[begin]->mapAndWrite();
+			for( dword i = begin + 1;  i < end;  ++i )
+			{
+				variants[i]->join();
+			}
+
+			// report the round's variants
+			for( dword i = begin;  i < end;  ++i )
+			{
+				const SweepVariant& variant = *variants[i];
+
+				std::cout << variant.tag_m;
+				if( variant.failure_m.empty() )
+				{
+					std::cout << "  -> " << variant.outPathname_m << "  map " <<
+						variant.seconds_m[0] << "s  write " <<
+						variant.seconds_m[1] << "s\n";
+				}
+				else
+				{
+					++failureCount;
+					std::cout << "\n" << EXCEPTION_PREFIX << variant.failure_m <<
+						"\n";
+				}
+			}
+			std::cout.flush();
+		}
+	}
+	catch( ... )
+	{
+		::p3tmFreePerceptualMapSweep( pSweep );
+		for( dword i = dword(variants.size());  i-- > 0; )
+		{
+			delete variants[i];
+		}
+		delete pInImage;
+		formatter.releaseLibraries( libraries );
+		throw;
+	}
+
+	::p3tmFreePerceptualMapSweep( pSweep );
+	for( dword i = dword(variants.size());  i-- > 0; )
+	{
+		delete variants[i];
+	}
+	delete pInImage;
+	formatter.releaseLibraries( libraries );
+
+	// report all
+	{
+		const double seconds = hxa7241_general::getClockSeconds() - start;
+		const dword  count   = dword(variants.size());
+
+		std::cout << "\n" << count << " variants (" << failureCount <<
+			" failed), in " << seconds << "s:  " << ((seconds > 0.0) ?
+			double(count) / seconds : 0.0) << " variants/s\n";
+	}
+
+	return 0 == failureCount;
+}
+
+
+
+
+
+/// implementation -------------------------------------------------------------
+SweepVariant::~SweepVariant()
+{
+}
+
+
+void SweepVariant::mapAndWrite()
+{
+	const double start = hxa7241_general::getClockSeconds();
+
+	try
+	{
+		// make output image, in memory
+		const dword width      = inImage_m.getWidth();
+		const dword height     = inImage_m.getHeight();
+		const bool  isOutWords = ::p3tm11_RGB_WORD == outImageType_m;
+		const dword length     = width * height * 3;
+		ImageRef outImage;
+		outImage.set( width, height, inImage_m.getPrimaries(),
+			inImage_m.getScaling(), isOutWords ? ImageRef::PIXELS_WORD :
+			ImageRef::PIXELS_BYTE, isOutWords ?
+			static_cast<void*>( new uword[length] ) :
+			static_cast<void*>( new ubyte[length] ) );
+
+		// map from the sweep
+		char pMessage128[128] = "\0";
+		if( !::p3tmSweepMap( pSweep_m, mappingFlags_m, outLuminanceRange_m,
+			outGamma_m, outImageType_m, outImage.getPixels(), pMessage128 ) )
+		{
+			throw string( pMessage128 );
+		}
+		const double mapped = hxa7241_general::getClockSeconds();
+		seconds_m[0] = mapped - start;
+
+		formatter_m.writeImage( outPathname_m.c_str(), outImage );
+		seconds_m[1] = hxa7241_general::getClockSeconds() - mapped;
+	}
+	catch( const std::exception& e )
+	{
+		failure_m = e.what();
+	}
+	catch( const char*const pExceptionString )
+	{
+		failure_m = pExceptionString;
+	}
+	catch( const std::string exceptionString )
+	{
+		failure_m = exceptionString;
+	}
+	catch( ... )
+	{
+		failure_m = EXCEPTION_ABSTRACT;
+	}
+}
+
+
+void SweepVariant::startVariant()
+{
+	try
+	{
+		start();
+	}
+	catch( ... )
+	{
+		run();
+	}
+}
+
+
+void SweepVariant::run()
+{
+	mapAndWrite();
+}
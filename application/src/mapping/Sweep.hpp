@@ -0,0 +1,85 @@
+/*--------------------------------------------------------------------
+
+   Perceptuum3 rendering components
+   Copyright (c) 2005-2007, Harrison Ainsworth / HXA7241.
+
+   http://www.hxa7241.org/
+
+--------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later
+   version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+   MA  02110-1301  USA
+
+--------------------------------------------------------------------*/
+
+
+#ifndef Sweep_h
+#define Sweep_h
+
+
+#include <string>
+#include <vector>
+
+
+
+
+#include "p3tonemapper_mapping.hpp"
+namespace p3tonemapper_mapping
+{
+
+
+/**
+ * Get all values of each switch a sweep varies: mapping features, out
+ * luminance range, out gamma (from the command file, then replaced by any on
+ * the command line).
+ */
+void  getSweepOptions
+(
+	const vector<string> tokenSets[2],
+	vector<string>       sweepValues[3]
+);
+
+
+/**
+ * Read and analyse one image, then map, and write, every combination of the
+ * values, a round at a time, one per processor.<br/><br/>
+ *
+ * Each variant's failure is reported, and the rest carry on.
+ *
+ * @outPathnamePattern  each '%v' replaced by the variant's tag (empty: the
+ *                      input pathname, with '-%v' before the extension)
+ * @return              whether all variants succeeded
+ */
+bool  mapSweep
+(
+	const ImageFormatter& formatter,
+	const vector<string>  optionSets[2],
+	const vector<string>  sweepValues[3],
+	const string&         inImagePathname,
+	const string&         inFormatName,
+	const string&         outPathnamePattern,
+	bool                  isFeedback
+);
+
+
+}//namespace
+
+
+
+
+#endif//Sweep_h
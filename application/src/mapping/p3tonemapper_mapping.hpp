@@ -0,0 +1,67 @@
+/*--------------------------------------------------------------------
+
+   Perceptuum3 rendering components
+   Copyright (c) 2005-2007, Harrison Ainsworth / HXA7241.
+
+   http://www.hxa7241.org/
+
+--------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later
+   version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+   MA  02110-1301  USA
+
+--------------------------------------------------------------------*/
+
+
+#ifndef p3tonemapper_mapping_p
+#define p3tonemapper_mapping_p
+
+
+#include <string>
+#include <vector>
+
+#include "Primitives.hpp"
+#include "p3tonemapper_format.hpp"
+
+
+
+
+namespace p3tonemapper_mapping
+{
+	using namespace hxa7241;
+	using std::string;
+	using std::vector;
+	using p3tonemapper_format::ImageFormatter;
+	using p3tonemapper_format::ImageRef;
+
+	//Options
+	//Batch
+	//Sweep
+	//Frames
+	class CommandFileCache;
+	class DecodeAnalyser;
+	class ImageJob;
+	class MapperWrapper;
+	class OutputRows;
+	class RowsSink;
+}
+
+
+
+
+#endif//p3tonemapper_mapping_p
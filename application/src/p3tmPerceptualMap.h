@@ -64,6 +64,14 @@
  * implementation to cache things, which might have performance advantages in
  * future versions. The use of pixel type-codes and void*s allows any format to
  * be supported in future versions.<br/><br/>
+ *
+ *
+ * Threads:<br/>
+ * All functions are reentrant. Mapping calls may run concurrently, on the same
+ * or separate mapper objects, as long as no thread is setting options on a
+ * mapper being mapped with. Each mapping call sets its own thread's fp
+ * environment (round to nearest, denormals flushed to zero) for its duration,
+ * and restores it afterwards.<br/><br/>
  */
 
 
@@ -248,6 +256,495 @@ int p3tmMap2
 );
 
 
+/**
+ * Layout of input pixels in memory, for p3tmMap3.<br/><br/>
+ *
+ * Describes interleaved (RGB, RGBA, BGR ...), padded-row and planar images
+ * alike. Channel type is given separately, by the input pixels type.
+ * Pixels are read in place, never repacked as a whole image.<br/><br/>
+ *
+ * eg: RGBA floats, rows pitch bytes apart:
+ *    { { p, p + 4, p + 8 }, 16, pitch }
+ * eg: separate R, G, B float planes:
+ *    { { r, g, b }, 4, width * 4 }
+ * eg: packed RGB floats, bottom row first:
+ *    { { last, last + 4, last + 8 }, 12, -(width * 12) }
+ *    where last is the start of the top row
+ *
+ * @channels   address of the R, G and B channels of the top-left pixel
+ * @pixelStep  bytes from one pixel to the next in a row
+ * @rowStride  bytes from one row to the next below (may be negative)
+ */
+typedef struct p3tmInLayout_
+{
+   const void* channels[3];
+   int         pixelStep;
+   int         rowStride;
+} p3tmInLayout;
+
+
+/**
+ * Map an image (3) -- with input in any layout.<br/><br/>
+ *
+ * Input is only read, not modified.
+ *
+ * @perceptualMap  object from one of the p3tmCreate___ functions
+ * @width          width of input and output images
+ * @height         height of input and output images
+ * @inPixelsType   input pixels type, from the options/constants header
+ * @inLayout       where the input channels are
+ * @outPixelsType  output pixels type, from the options/constants header
+ * @outPixels      array of output RGB pixels
+ * @message128     string for exception message 128 chars long, (or 0)
+ *
+ * @return  1 means succeeded, 0 means failed
+ */
+int p3tmMap3
+(
+   const void*         perceptualMap,
+   int                 width,
+   int                 height,
+   int                 inPixelsType,
+   const p3tmInLayout* inLayout,
+   int                 outPixelsType,
+   void*               outPixels,
+   char*               message128
+);
+
+
+/**
+ * Receiver of output rows, for p3tmMap4.<br/><br/>
+ *
+ * @sinkContext  as given to p3tmMap4
+ * @rowCount     number of rows in rows
+ * @rows         packed output RGB pixels, rowCount rows, valid only during
+ *               the call
+ *
+ * @return  1 means continue, 0 means stop (the mapping then fails)
+ */
+typedef int (*p3tmRowSink)
+(
+   void*       sinkContext,
+   int         rowCount,
+   const void* rows
+);
+
+
+/**
+ * Map an image (4) -- giving output rows to a sink.<br/><br/>
+ *
+ * Instead of into a whole output image, output goes a band of rows at a time
+ * to rowSink, as soon as it is made (eg to encode while mapping). The result
+ * is the same as p3tmMap.<br/><br/>
+ *
+ * Rows are given from first to last, or from last to first if isLastRowFirst
+ * (eg to write a bottom-row-first image top row first). (Half input is then
+ * mapped from its rows reversed, which can differ in the least bit.)
+ *
+ * @perceptualMap   object from one of the p3tmCreate___ functions
+ * @width           width of input and output images
+ * @height          height of input and output images
+ * @inPixelsType    input pixels type, from the options/constants header
+ * @inPixels        array of input RGB pixels (float are used in place)
+ * @outPixelsType   output pixels type, from the options/constants header
+ * @isLastRowFirst  0 or 1
+ * @rowSink         receiver of output rows
+ * @sinkContext     given to rowSink
+ * @message128      string for exception message 128 chars long, (or 0)
+ *
+ * @return  1 means succeeded, 0 means failed
+ */
+int p3tmMap4
+(
+   const void* perceptualMap,
+   int         width,
+   int         height,
+   int         inPixelsType,
+   void*       inPixels,
+   int         outPixelsType,
+   int         isLastRowFirst,
+   p3tmRowSink rowSink,
+   void*       sinkContext,
+   char*       message128
+);
+
+
+/**
+ * One output of p3tmMap5.<br/><br/>
+ *
+ * @pixelsType   output pixels type, from the options/constants header
+ * @rowSink      receiver of output rows (packed pixels of pixelsType)
+ * @sinkContext  given to rowSink
+ */
+typedef struct p3tmOutRows_
+{
+   int         pixelsType;
+   p3tmRowSink rowSink;
+   void*       sinkContext;
+} p3tmOutRows;
+
+
+/**
+ * Map an image (5) -- into several outputs at once.<br/><br/>
+ *
+ * The analysis is done once, then each input row is mapped into every output
+ * in turn, and each output goes a band of rows at a time to its own sink (eg
+ * an 8-bit and a 16-bit image from one run). Each output is the same as from
+ * p3tmMap4 with its pixels type.<br/><br/>
+ *
+ * Half input is first converted to a whole float image (so, unlike p3tmMap4,
+ * it is never mapped as a stream, and can differ in the least bit).
+ *
+ * @perceptualMap   object from one of the p3tmCreate___ functions
+ * @width           width of input and output images
+ * @height          height of input and output images
+ * @inPixelsType    input pixels type, from the options/constants header
+ * @inPixels        array of input RGB pixels (float are used in place)
+ * @isLastRowFirst  0 or 1, for all outputs
+ * @outCount        number of outputs
+ * @outs            array of outCount outputs
+ * @message128      string for exception message 128 chars long, (or 0)
+ *
+ * @return  1 means succeeded, 0 means failed
+ */
+int p3tmMap5
+(
+   const void*        perceptualMap,
+   int                width,
+   int                height,
+   int                inPixelsType,
+   void*              inPixels,
+   int                isLastRowFirst,
+   int                outCount,
+   const p3tmOutRows* outs,
+   char*              message128
+);
+
+
+
+
+/*= streaming object (supplementary) =========================================*/
+
+/**
+ * Mapping of an image given row by row, in two passes, holding only a window
+ * of rows.<br/><br/>
+ *
+ * Pass one: give all rows, in order, any number at a time, to
+ * p3tmStreamAnalyseRows. Pass two: give all rows again, in the same order, to
+ * p3tmStreamMapRows, which returns the mapped rows ready so far. Output lags
+ * input by up to p3tmStreamGetLatency() rows (only with acuity on) -- the rest
+ * come with the last rows. The result is the same as mapping the whole image.
+ * <br/><br/>
+ *
+ * A stream object is used by one thread at a time.<br/><br/>
+ *
+ * @perceptualMap  object from one of the p3tmCreate___ functions (options are
+ *                 copied)
+ * @width          width of input and output images
+ * @height         height of input and output images
+ * @inPixelsType   input pixels type, from the options/constants header
+ * @outPixelsType  output pixels type, from the options/constants header
+ * @message128     string for exception message 128 chars long, (or 0)
+ *
+ * @return  new stream, or 0 for failure
+ */
+void* p3tmCreatePerceptualMapStream
+(
+   const void* perceptualMap,
+   int         width,
+   int         height,
+   int         inPixelsType,
+   int         outPixelsType,
+   char*       message128
+);
+
+
+/**
+ * Free a stream.<br/><br/>
+ *
+ * @stream  object from p3tmCreatePerceptualMapStream
+ *
+ * @return  1 means succeeded, 0 means failed
+ */
+int p3tmFreePerceptualMapStream
+(
+   void* stream
+);
+
+
+/**
+ * Make pass one take a smaller proxy of the image (eg a mip level), instead
+ * of the image.<br/><br/>
+ *
+ * Analysis only needs foveal resolution, so a proxy at least
+ * p3tmStreamGetFovealSize gives nearly the same result. Call before pass one.
+ *
+ * @stream       object from p3tmCreatePerceptualMapStream
+ * @proxyWidth   no more than the image width
+ * @proxyHeight  no more than the image height
+ * @message128   string for exception message 128 chars long, (or 0)
+ *
+ * @return  1 means succeeded, 0 means failed
+ */
+int p3tmStreamSetProxy
+(
+   void* stream,
+   int   proxyWidth,
+   int   proxyHeight,
+   char* message128
+);
+
+
+/**
+ * Set the step, in bytes, from one output row of p3tmStreamMapRows to the
+ * next. Default is packed. A negative step writes rows top first, eg
+ * straight into a PPM file body. Call before pass two.
+ *
+ * @stream     object from p3tmCreatePerceptualMapStream
+ * @rowStride  bytes from one output row to the next
+ */
+void p3tmStreamSetOutRowStride
+(
+   void* stream,
+   int   rowStride
+);
+
+
+/**
+ * Set the output pixels type, instead of the one the stream was made with
+ * (eg if only known after pass one). Resets the output row step to packed.
+ * Call before pass two.
+ *
+ * @stream         object from p3tmCreatePerceptualMapStream
+ * @outPixelsType  output pixels type, from the options/constants header
+ */
+void p3tmStreamSetOutPixelsType
+(
+   void* stream,
+   int   outPixelsType
+);
+
+
+/**
+ * Get the size of the foveal image analysis makes (for choosing a proxy).
+ *
+ * @stream  object from p3tmCreatePerceptualMapStream
+ * @width   foveal width
+ * @height  foveal height
+ */
+void p3tmStreamGetFovealSize
+(
+   const void* stream,
+   int*        width,
+   int*        height
+);
+
+
+/**
+ * Pass one: give the next rows for analysis.<br/><br/>
+ *
+ * @stream      object from p3tmCreatePerceptualMapStream
+ * @rowCount    number of rows in inRows
+ * @inRows      array of input RGB pixels, rowCount rows (of the proxy, if
+ *              set)
+ * @message128  string for exception message 128 chars long, (or 0)
+ *
+ * @return  1 means succeeded, 0 means failed
+ */
+int p3tmStreamAnalyseRows
+(
+   void*       stream,
+   int         rowCount,
+   const void* inRows,
+   char*       message128
+);
+
+
+/**
+ * Pass two: give the next rows, and get mapped rows.<br/><br/>
+ *
+ * @stream       object from p3tmCreatePerceptualMapStream
+ * @rowCount     number of rows in inRows
+ * @inRows       array of input RGB pixels, rowCount rows
+ * @outRows      array of output RGB pixels, with room for
+ *               rowCount + p3tmStreamGetLatency() rows
+ * @outRowCount  number of rows written to outRows
+ * @message128   string for exception message 128 chars long, (or 0)
+ *
+ * @return  1 means succeeded, 0 means failed
+ */
+int p3tmStreamMapRows
+(
+   void*       stream,
+   int         rowCount,
+   const void* inRows,
+   void*       outRows,
+   int*        outRowCount,
+   char*       message128
+);
+
+
+/**
+ * Pass one, with input laid out as described (see p3tmMap3).<br/><br/>
+ *
+ * @inLayout  where the next rowCount rows are, in the stream's input type
+ */
+int p3tmStreamAnalyseRows3
+(
+   void*               stream,
+   int                 rowCount,
+   const p3tmInLayout* inLayout,
+   char*               message128
+);
+
+
+/**
+ * Pass two, with input laid out as described (see p3tmMap3).<br/><br/>
+ *
+ * @inLayout  where the next rowCount rows are, in the stream's input type
+ */
+int p3tmStreamMapRows3
+(
+   void*               stream,
+   int                 rowCount,
+   const p3tmInLayout* inLayout,
+   void*               outRows,
+   int*                outRowCount,
+   char*               message128
+);
+
+
+/**
+ * Pass two all at once, for float input held whole in memory.<br/><br/>
+ *
+ * Maps the whole image in place (so it is modified) with the analysis from
+ * pass one -- eg when pass one was given the rows as the image was decoded.
+ * The result is the same as p3tmMap (or p3tmMap4), however the rows were
+ * given to pass one.<br/><br/>
+ *
+ * Output rows go from first to last, or from last to first if
+ * isLastRowFirst: a band at a time to rowSink, if given, else packed into
+ * outPixels.
+ *
+ * @stream          object from p3tmCreatePerceptualMapStream, with float
+ *                  input, all rows given to pass one, and none to pass two
+ * @inPixels        array of input RGB pixels, the whole image
+ * @isLastRowFirst  0 or 1
+ * @rowSink         receiver of output rows (or 0)
+ * @sinkContext     given to rowSink
+ * @outPixels       array of output RGB pixels (when no rowSink)
+ * @message128      string for exception message 128 chars long, (or 0)
+ *
+ * @return  1 means succeeded, 0 means failed
+ */
+int p3tmStreamMapImage
+(
+   void*       stream,
+   void*       inPixels,
+   int         isLastRowFirst,
+   p3tmRowSink rowSink,
+   void*       sinkContext,
+   void*       outPixels,
+   char*       message128
+);
+
+
+/**
+ * Get the most rows p3tmStreamMapRows output can lag behind its input.
+ *
+ * @stream  object from p3tmCreatePerceptualMapStream
+ *
+ * @return  number of rows
+ */
+int p3tmStreamGetLatency
+(
+   const void* stream
+);
+
+
+
+
+/*= sweep object (supplementary) =============================================*/
+
+/**
+ * Several mappings of one image -- a parameter sweep -- varying mapping
+ * features, output luminance range and output gamma.<br/><br/>
+ *
+ * The analysis the variants share (calibration, foveal image, and the images
+ * limited by each distinct set of human stages) is made once, here. Each
+ * p3tmSweepMap then makes only its tone adjustment and output. p3tmSweepMap
+ * does not change the sweep, so any number of threads can call it at once.
+ * <br/><br/>
+ *
+ * @perceptualMap      object from one of the p3tmCreate___ functions (options
+ *                     are copied)
+ * @width              width of input and output images
+ * @height             height of input and output images
+ * @inPixelsType       input pixels type, from the options/constants header
+ * @inPixels           array of input RGB pixels (float are modified, and
+ *                     used until the sweep is freed)
+ * @mappingFlagsCount  number of mapping flags sets to be used
+ * @mappingFlags       array of mappingFlagsCount mapping flags sets, from the
+ *                     options/constants header
+ * @message128         string for exception message 128 chars long, (or 0)
+ *
+ * @return  new sweep, or 0 for failure
+ */
+void* p3tmCreatePerceptualMapSweep
+(
+   const void* perceptualMap,
+   int         width,
+   int         height,
+   int         inPixelsType,
+   void*       inPixels,
+   int         mappingFlagsCount,
+   const int*  mappingFlags,
+   char*       message128
+);
+
+
+/**
+ * Free a sweep.<br/><br/>
+ *
+ * @sweep  object from p3tmCreatePerceptualMapSweep
+ *
+ * @return  1 means succeeded, 0 means failed
+ */
+int p3tmFreePerceptualMapSweep
+(
+   void* sweep
+);
+
+
+/**
+ * Map one variant of a sweep.<br/><br/>
+ *
+ * The result is the same as p3tmMap with the sweep's options changed to
+ * these.<br/><br/>
+ *
+ * @sweep               object from p3tmCreatePerceptualMapSweep
+ * @mappingFlags        one of the mapping flags sets the sweep was made with
+ * @outLuminanceRange2  array of two floats { min, max } (or 0 for the
+ *                      perceptualMap's)
+ * @outGamma            output gamma (or 0 for the perceptualMap's)
+ * @outPixelsType       output pixels type, from the options/constants header
+ * @outPixels           array of output RGB pixels
+ * @message128          string for exception message 128 chars long, (or 0)
+ *
+ * @return  1 means succeeded, 0 means failed
+ */
+int p3tmSweepMap
+(
+   const void*  sweep,
+   int          mappingFlags,
+   const float* outLuminanceRange2,
+   float        outGamma,
+   int          outPixelsType,
+   void*        outPixels,
+   char*        message128
+);
+
+
 
 
 
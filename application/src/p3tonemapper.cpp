@@ -29,18 +29,33 @@
 
 
 #include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#ifdef _PLATFORM_WIN
+#include <io.h>
+#include <fcntl.h>
+#endif
 
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <string>
 #include <vector>
 #include <exception>
 
 #include "Primitives.hpp"
+#include "FileList.hpp"
+#include "LocalSocket.hpp"
 
-#include "ImageRef.hpp"
 #include "ImageFormatter.hpp"
 
+#include "Options.hpp"
+#include "ImageJob.hpp"
+#include "Batch.hpp"
+#include "Sweep.hpp"
+#include "Frames.hpp"
+#include "CommandFileCache.hpp"
+
 #include "p3tmPerceptualMap-v13.h"
 
 
@@ -50,7 +65,18 @@ using namespace hxa7241;
 using std::string;
 using std::vector;
 using p3tonemapper_format::ImageFormatter;
-using p3tonemapper_format::ImageRef;
+using p3tonemapper_mapping::SHARED_PREFIX;
+using p3tonemapper_mapping::EXCEPTION_PREFIX;
+using p3tonemapper_mapping::EXCEPTION_ABSTRACT;
+using p3tonemapper_mapping::getOptions;
+using p3tonemapper_mapping::makeOutPathname;
+using p3tonemapper_mapping::ImageJob;
+using p3tonemapper_mapping::mapBatch;
+using p3tonemapper_mapping::getSweepOptions;
+using p3tonemapper_mapping::mapSweep;
+using p3tonemapper_mapping::mapFrames;
+using p3tonemapper_mapping::CommandFileCache;
+using p3tonemapper_mapping::tokenizeCommandFile;
 
 
 
@@ -75,15 +101,27 @@ static const char HELP_MESSAGE[] =
 "usage:\n"
 "  p3tonemapper {-help|-?}\n"
 "  p3tonemapper [options] [-x:commandFilePathName] [-z] imageFilePathName\n"
+"  p3tonemapper [options] [-x:commandFilePathName] [-z] - < in > out\n"
+"  p3tonemapper [options] [-x:commandFilePathName] {@listFilePathName |\n"
+"                  imageDirectoryPathName | imageFilePathNamePattern}\n"
+"  p3tonemapper [options] {-m1:.. | -or:.. | -og:..}... imageFilePathName\n"
+"  p3tonemapper [options] -vf:<w_h> {- | framesFilePathName}\n"
+"  p3tonemapper --serve socketPathName [-lp:<string>] [-le:<string>]\n"
+"  p3tonemapper --client socketPathName {any of the above | --stop}\n"
 "\n"
 "options (with defaults shown):\n"
 "  image formatting libraries:\n"
 "   -lp:<string>    libpng pathname\n"
 "   -le:<string>    openexr pathname\n"
+"  image formats (of '-', the standard input/output):\n"
+"   -if:<hdr|pfm>   input format: recognized from its first bytes\n"
+"   -of:<png|ppm|qoi>  output format: png\n"
 "  image metadata:\n"
 "   -ip:<8 floats>  primaries: 0.64_0.33_0.30_0.60_0.15_0.06_0.313_0.329\n"
 "   -is:<2 floats>  pixel values scaling and offset: 1.0_0.0\n"
 "   -iv:<1 float>   view angle horizontal degrees: 65.0\n"
+"   -il:<w_h_f|h_channels_rowBytes_offset>  layout of 'shm:' input, only\n"
+"                   size needed: w_h_f_3_0_0 (rowBytes 0 means packed)\n"
 "  mapping options:\n"
 "   -m1:<htgca>     combination of sub-options (default is none):\n"
 "     h               human (= all below)\n"
@@ -95,11 +133,58 @@ static const char HELP_MESSAGE[] =
 "   -or:<2 floats>  luminance range, max and min: 2.0_150.0\n"
 "   -og:<float>     gamma transform to apply to output pixels: 0.45\n"
 "   -ob:<8 | 16>    output pixel bits per channel: 8\n"
+"   -oc:<size | balanced | speed>  png compression: size\n"
 "  output file name:\n"
-"   -on:<string>    output file path name <.png|.ppm>: inputFilePathName.png\n"
+"   -on:<string>[,<8|16>[,<float>]]  output file path name\n"
+"                   <.png|.ppm|.qoi>, or '-': inputFilePathName.png (or\n"
+"                   '-' if input is '-'); then maybe its own pixel bits,\n"
+"                   and size scaling (0 to 1): none. may be repeated\n"
+"  batch options:\n"
+"   -bm:<float>     memory for images (or frames) in progress,\n"
+"                   megabytes: 1024\n"
+"  video options:\n"
+"   -vf:<w_h>       size of raw frames, for a frame stream: none\n"
 "\n"
 "image file name must be last, and must end in '.exr' or '.hdr', '.pic',\n"
-"'.rad', '.rgbe'.\n"
+"'.rad', '.rgbe' or '.pfm' -- or be '-', to read the standard input.\n"
+"\n"
+"several -on: make several outputs from one mapping: the image is read\n"
+"and analysed once, then each row is mapped into every output in turn.\n"
+"scaled outputs are averaged down from the mapped pixels.\n"
+"eg: -on:web.png -on:print.ppm,16 -on:thumb.png,8,0.125\n"
+"\n"
+"an image file path name of 'shm:name' is a shared-memory segment\n"
+"(POSIX shm_open, or Windows named mapping) instead: input is read in\n"
+"place, laid out as -il: says, and output is written, as packed RGB\n"
+"rows (native byte order) in the same row order, into a segment made to\n"
+"fit. shared-memory input needs -on:.\n"
+"\n"
+"a batch of images -- listed one per line in a file, or all in a\n"
+"directory, or all matching a pattern with '*' and '?' -- is read,\n"
+"mapped and written in a pipeline, and the times reported. '%s' in the\n"
+"output file path name is replaced by each image file name (without\n"
+"directory and extension).\n"
+"\n"
+"a sweep -- several of any of -m1:, -or: and -og: -- maps every\n"
+"combination of their values from one reading and analysis of the\n"
+"image, the variants in parallel, and reports the times. '%v' in the\n"
+"output file path name is replaced by each variant's values (eg\n"
+"m1h-or1.4_100-og0.45); the default is inputFilePathName-%v.png.\n"
+"\n"
+"a frame stream (-vf:) is raw frames -- each packed float RGB pixels,\n"
+"native byte order -- read from the standard input, or a file (eg a\n"
+"FIFO), and mapped, all with the same options, into raw frames of -ob:\n"
+"bits (words native byte order), rows in the same order, written to the\n"
+"standard output, or -on:. frames are mapped a group at a time, one per\n"
+"processor (as far as -bm: allows), while the next group is read, and\n"
+"the last written. -ip: and -is: give the frames' metadata.\n"
+"\n"
+"--serve keeps running, and runs each command sent to the local socket by\n"
+"'--client socketPathName' (then any usual command), returning its\n"
+"messages and exit status -- so the program, codec libraries and command\n"
+"files are loaded once, not for every command. served commands cannot use\n"
+"'-' (the standard input/output). '--client socketPathName --stop' ends\n"
+"serving.\n"
 "\n"
 "commandFilePathName defaults to 'p3tonemapper-opt.txt'\n"
 "\n"
@@ -108,6 +193,8 @@ static const char HELP_MESSAGE[] =
 "example:\n"
 "  p3tonemapper somerendering.exr\n"
 "  p3tonemapper -m1:g -or:1.4_100.0 -on:resultimage.png somerendering.hdr\n"
+"  p3tonemapper -on:web.png -on:print.ppm,16 somerendering.exr\n"
+"  p3tonemapper -m1: -m1:h -or:2_150 -or:1.4_100 somerendering.exr\n"
 "\n";
 #else//not TESTING
 "*** TESTING BUILD ***\n"
@@ -116,19 +203,30 @@ static const char HELP_MESSAGE[] =
 "   p3tonemapper [-t...] [-o...] [-s...]\n"
 "\n"
 "switches:\n"
-"   -t<int>         which test: 1 to 15 for lib, -1 to -4 for app, 0 for all\n"
+"   -t<int>         which test: 1 to 19 for lib, -1 to -8 for app, 0 for all\n"
 "   -o<0 | 1 | 2>   set output level: 0 = none, 1 = summaries, 2 = verbose\n"
 "   -s<32bit int>   set random seed\n"
 "\n";
 #endif//TESTING
 static const char SWITCH_HELP1[] = "?";
 static const char SWITCH_HELP2[] = "help";
+static const char SWITCH_SERVE[]  = "--serve";
+static const char SWITCH_CLIENT[] = "--client";
+static const char SWITCH_STOP[]   = "--stop";
 
 static const char COMMAND_FILE_NAME_DEFAULT[] = "p3tonemapper-opt.txt";
 
-static const char EXCEPTION_PREFIX[]     = "*** execution failed:  ";
-static const char EXCEPTION_ABSTRACT[]   = "no annotation for cause";
 static const char WARNING_WRONG_SWITCH[] = "unrecognized option";
+static const char EXCEPTION_LIST_READ[]  = "could not read batch list file";
+static const char EXCEPTION_SERVED_PIPE[] =
+   "standard input/output not available to a served command";
+static const char EXCEPTION_SERVED_DIRECTORY[] =
+   "could not change to the client's working directory";
+static const char EXCEPTION_SERVE_REPLY[] = "no reply from server";
+static const char EXCEPTION_SHARED_OUT[] =
+   "shared memory input needs an output path name: -on:...";
+
+static const float BATCH_MEGABYTES_DEFAULT = 1024.0f;
 
 
 
@@ -136,100 +234,62 @@ static const char WARNING_WRONG_SWITCH[] = "unrecognized option";
 /// support declarations -------------------------------------------------------
 #ifndef TESTING
 
-class MapperWrapper
-{
-public:
-   MapperWrapper()
-    : pMapper_m( ::p3tmCreatePerceptualMapDefault() )
-   {
-   }
-
-   ~MapperWrapper()
-   {
-      ::p3tmFreePerceptualMap( pMapper_m );
-   }
-
-   operator void* () { return pMapper_m; }
-
-private:
-   void* pMapper_m;
-
-   MapperWrapper( const MapperWrapper& );
-   MapperWrapper& operator=( const MapperWrapper& );
-};
-
-
-static void getInitialOptions
+static int runCommand
 (
-   const int      argc,
-   char*const     argv[],
-   bool&          isFeedback,
-   string&        inImagePathname,
-   vector<string> optionSets[2]
+   int               argc,
+   char*             argv[],
+   bool              isServed,
+   CommandFileCache* pCommandFiles
 );
 
 
-static void getOptions
+static void serveCommands
 (
-   const vector<string> tokenSets[2],
-   ImageFormatter*      pFormatter,
-   void*                pMapper,
-   dword*               pOutPixelType,
-   string*              pOutPathname
+   int   argc,
+   char* argv[]
 );
 
 
-static bool parseFps
+static bool serveCommand
 (
-   const string& group,
-   float         fps[],
-   const dword   length
+   hxa7241_general::LocalSocket& connection,
+   CommandFileCache&             commandFiles
 );
 
 
-static bool parseFp
+static int sendCommand
 (
-   const string& s,
-   float&        fp
+   int   argc,
+   char* argv[]
 );
 
 
-static void tokenizeCommandLine
+static void getInitialOptions
 (
-   const int       argc,
-   char*const      argv[],
-   vector<string>& tokens
+   const int         argc,
+   char*const        argv[],
+   CommandFileCache* pCommandFiles,
+   bool&             isFeedback,
+   string&           inImagePathname,
+   vector<string>    optionSets[2]
 );
 
 
-static void tokenizeCommandFile
+static void readListFile
 (
-   const char*     commandFilePathname,
-   vector<string>& tokens
+   const char      listFilePathname[],
+   vector<string>& pathnames
 );
 
 
-static void tokenize
+static void tokenizeCommandLine
 (
-   const string&   str,
-   const char      separator,
+   const int       argc,
+   char*const      argv[],
    vector<string>& tokens
 );
 
 
-static void printImageStats
-(
-   bool isFeedback,
-   const ImageRef&
-);
-
-
-static void printMapper
-(
-   bool isFeedback,
-   const void* pMapper
-);
-
 
 #else//not TESTING
 
@@ -290,87 +350,24 @@ int main
       {
 #ifndef TESTING
 
-         // make default mapper
-         MapperWrapper mapper;
-
-         // get input image pathname, and options
-         bool           isFeedback;
-         string         inImagePathname;
-         vector<string> optionSets[2];
-         getInitialOptions( argc, argv,
-            isFeedback, inImagePathname, optionSets );
-
-         // set formatter
-         ImageFormatter formatter;
-         getOptions( optionSets, &formatter, 0, 0, 0 );
-
-         // read input image, and set mapper from its metadata
-         ImageRef inImage;
+         // serve commands sent to a local socket
+         if( (argc > 2) && (string(SWITCH_SERVE) == argv[1]) )
          {
-            // read image
-            formatter.readImage( inImagePathname.c_str(), inImage );
+            serveCommands( argc, argv );
 
-            // set mapper from input image
-            const float* pPrimaries8 = inImage.getPrimaries();
-            if( 0 != pPrimaries8 )
-            {
-               ::p3tmSetInputColorSpace( mapper,
-                  pPrimaries8, pPrimaries8 + 6 );
-            }
-            const float scaling = inImage.getScaling();
-            if( 0.0f != scaling )
-            {
-               const float scalingOffset[2] = { scaling, 0.0f };
-               ::p3tmSetInputLuminanceScale( mapper, scalingOffset );
-            }
-
-            printImageStats( isFeedback, inImage );
+            returnValue = EXIT_SUCCESS;
          }
-
-         // get all other options, mostly into/overriding mapper
-         string outImagePathname;
-         dword  outImageType = 0;
-         getOptions( optionSets, 0, mapper, &outImageType, &outImagePathname );
-
-         // make output image
-         ImageRef outImage( inImage, (::p3tm11_RGB_WORD == outImageType) ?
-            ImageRef::PIXELS_WORD : ImageRef::PIXELS_BYTE );
-
-         // call mapper to map
+         // send this command to be served
+         else if( (argc > 2) && (string(SWITCH_CLIENT) == argv[1]) )
          {
-            printMapper( isFeedback, mapper );
-
-            char pMessage128[128] = "\0";
-            bool isMapOk = 0 != ::p3tmMap( mapper,
-               inImage.getWidth(), inImage.getHeight(), ::p3tm11_RGB_FLOAT,
-               inImage.getPixels(), outImageType, outImage.getPixels(),
-               pMessage128 );
-            if( !isMapOk )
-            {
-               throw string( pMessage128 );
-            }
+            returnValue = sendCommand( argc, argv );
          }
-
-         // write output image
+         // run this command
+         else
          {
-            // maybe make default output image pathname
-            if( outImagePathname.empty() )
-            {
-               const size_t extPos = inImagePathname.rfind( '.' );
-               outImagePathname = inImagePathname.substr( 0, extPos ) + ".png";
-            }
-
-            if( isFeedback )
-            {
-               std::cout << "\noutput image pathname = " << outImagePathname << "\n";
-            }
-
-            formatter.writeImage( outImagePathname.c_str(), outImage );
+            returnValue = runCommand( argc, argv, false, 0 );
          }
 
-         // set return value
-         returnValue = EXIT_SUCCESS;
-
 #else//not TESTING
 
          returnValue = test( argc, argv ) ? EXIT_SUCCESS : EXIT_FAILURE;
@@ -414,464 +411,443 @@ int main
 /// other functions ------------------------------------------------------------
 #ifndef TESTING
 
-void getInitialOptions
+int runCommand
 (
-   const int      argc,
-   char*const     argv[],
-   bool&          isFeedback,
-   string&        inImagePathname,
-   vector<string> tokenSets[2]
+   const int               argc,
+   char*                   argv[],
+   const bool              isServed,
+   CommandFileCache* const pCommandFiles
 )
 {
-   // read input file pathname from command line last arg
-   inImagePathname = argv[argc - 1];
+   // get input image pathname, and options
+   bool           isFeedback;
+   string         inImagePathname;
+   vector<string> optionSets[2];
+   getInitialOptions( argc, argv, pCommandFiles,
+      isFeedback, inImagePathname, optionSets );
+
+   // set formatter, and get output pathnames (or specs), image formats (for
+   // the standard input/output), batch memory, and frame size (of a raw
+   // frame stream)
+   ImageFormatter formatter;
+   vector<string> outImageSpecs;
+   string         inFormatName;
+   string         outFormatName( "png" );
+   float          batchMegabytes = BATCH_MEGABYTES_DEFAULT;
+   string         frameSize;
+   getOptions( optionSets, &formatter, 0, 0, &outImageSpecs,
+      &inFormatName, 0, &outFormatName, &batchMegabytes, &frameSize );
+   if( outImageSpecs.empty() )
+   {
+      outImageSpecs.push_back( string() );
+   }
 
-   // read command file pathname from command line
-   string commandFilePathname( COMMAND_FILE_NAME_DEFAULT );
-   for( int i = argc - 1;  i-- > 1; )
+   // frame stream: raw frames of the size given, in and out
+   const bool isFrames = !frameSize.empty();
+
+   // sweep: several values given of mapping features, out luminance range,
+   // or out gamma
+   vector<string> sweepValues[3];
+   getSweepOptions( optionSets, sweepValues );
+   const bool isSweep = !isFrames && ((sweepValues[0].size() > 1) |
+      (sweepValues[1].size() > 1) | (sweepValues[2].size() > 1));
+
+   // batch: input images listed in a file (named after '@'), or all in
+   // a directory, or all matching a wildcard pattern (not for a sweep, or
+   // a frame stream)
+   vector<string> inImagePathnames;
+   bool           isBatch = !isSweep && !isFrames;
+   if( isBatch && !inImagePathname.empty() && ('@' == inImagePathname[0]) )
    {
-      if( ('-' == argv[i][0]) && ('x' == argv[i][1]) && (':' == argv[i][2]) )
+      readListFile( inImagePathname.c_str() + 1, inImagePathnames );
+   }
+   else if( isBatch )
+   {
+      isBatch = hxa7241_general::listFiles( inImagePathname.c_str(),
+         inImagePathnames );
+   }
+
+   int returnValue = EXIT_FAILURE;
+
+   // read, map, and write, frames pipelined
+   // (the standard output by default)
+   if( isFrames )
+   {
+      const string outPathname( outImageSpecs.front().empty() ?
+         string("-") : outImageSpecs.front() );
+      const bool   isOutPiped = string("-") == outPathname;
+      if( isServed & ((string("-") == inImagePathname) | isOutPiped) )
       {
-         commandFilePathname = argv[i] + 3;
+         throw EXCEPTION_SERVED_PIPE;
       }
-   }
 
-   // read feedback option
-   isFeedback = false;
-   for( int i = argc - 1;  i-- > 1; )
+      // output to the standard output: keep it for the frames only, and
+      // send messages to the error output
+      if( isOutPiped )
+      {
+         std::cout.rdbuf( std::cerr.rdbuf() );
+      }
+
+      returnValue = mapFrames( optionSets, frameSize, inImagePathname,
+         outPathname, double(batchMegabytes) * 1048576.0, isFeedback ) ?
+         EXIT_SUCCESS : EXIT_FAILURE;
+   }
+   // read and analyse one image, then map, and write, every combination
+   // of the values
+   else if( isSweep )
    {
-      if( ('-' == argv[i][0]) && ('z' == argv[i][1]) )
+      if( isServed & (string("-") == inImagePathname) )
       {
-         isFeedback = true;
+         throw EXCEPTION_SERVED_PIPE;
       }
+
+      returnValue = mapSweep( formatter, optionSets, sweepValues,
+         inImagePathname, inFormatName, outImageSpecs.front(), isFeedback ) ?
+         EXIT_SUCCESS : EXIT_FAILURE;
+   }
+   // read, map, and write, all images pipelined
+   else if( isBatch )
+   {
+      returnValue = mapBatch( formatter, optionSets, inImagePathnames,
+         outImageSpecs, double(batchMegabytes) * 1048576.0 ) ?
+         EXIT_SUCCESS : EXIT_FAILURE;
    }
+   // read, map, and write, one image
+   else
+   {
+      // maybe make default output image pathnames
+      // (the standard output, if input is the standard input)
+      const bool isInPiped = string("-") == inImagePathname;
+      if( (0 == inImagePathname.compare( 0, 4, SHARED_PREFIX )) &
+         outImageSpecs.front().empty() )
+      {
+         throw EXCEPTION_SHARED_OUT;
+      }
+      bool isOutPiped = false;
+      for( dword i = 0;  i < dword(outImageSpecs.size());  ++i )
+      {
+         string& spec = outImageSpecs[i];
+         const string::size_type pathnameLength = spec.find( ',' );
 
-   // make command file token set
-   tokenizeCommandFile( commandFilePathname.c_str(), tokenSets[0] );
+         spec = (isInPiped & (0 == pathnameLength)) ?
+            inImagePathname + spec : (isInPiped & spec.empty()) ?
+            inImagePathname : makeOutPathname( spec, inImagePathname );
+         isOutPiped |= string("-") == spec.substr( 0, spec.find( ',' ) );
+      }
 
-   // make command line token set (except first and last)
-   tokenizeCommandLine( argc - 2, argv + 1, tokenSets[1] );
+      // output to the standard output: keep it for the image only, and
+      // send messages to the error output
+      if( isServed & (isInPiped | isOutPiped) )
+      {
+         throw EXCEPTION_SERVED_PIPE;
+      }
+      std::ostream outPipe( std::cout.rdbuf() );
+      if( isOutPiped )
+      {
+#ifdef _PLATFORM_WIN
+         ::_setmode( ::_fileno( stdout ), _O_BINARY );
+#endif
+         std::cout.rdbuf( std::cerr.rdbuf() );
+      }
 
+      ImageJob job( optionSets, inImagePathname, inFormatName,
+         outImageSpecs, outFormatName, isOutPiped ? &outPipe : 0,
+         isFeedback );
+      job.decode( formatter );
+      job.map( formatter );
+      job.encode( formatter );
 
-// // print things
-// std::cout << "\ninImagePathname     = " << inImagePathname;
-// std::cout << "\ncommandFilePathname = " << commandFilePathname;
-// std::cout << "\n";
-//
-// // print all tokens
-// static const char* title[] = { "\ncommand file:", "\ncommand line:" };
-// for( dword t = 0;  t < 2;  ++t )
-// {
-//    std::cout << title[t] << "\n\n";
-//    for( udword i = 0;  i < tokenSets[t].size();  ++i )
-//    {
-//       std::cout << tokenSets[t][i] << "\n";
-//    }
-// }
+      outPipe.flush();
+
+      // set return value
+      returnValue = EXIT_SUCCESS;
+   }
+
+   return returnValue;
 }
 
 
-void getOptions
+void serveCommands
 (
-   const vector<string> tokenSets[2],
-   ImageFormatter*      pFormatter,
-   void*                pMapper,
-   dword*               pOutPixelType,
-   string*              pOutPathname
+   const int argc,
+   char*     argv[]
 )
 {
-   // get from command file, then override with command line
-   for( dword i = 0;  i < 2;  ++i )
-   {
-      // select token set
-      const vector<string>& tokens = tokenSets[i];
+   // set formatter from the server's own options, and keep its codec
+   // libraries loaded
+   vector<string> optionSets[2];
+   tokenizeCommandLine( argc - 3, argv + 3, optionSets[1] );
 
-      // read switches from tokens
-      for( int i = tokens.size();  i-- > 0; )
-      {
-         // eg: -lp:something_4.3
-         const string& token = tokens[i];
+   ImageFormatter formatter;
+   getOptions( optionSets, &formatter, 0, 0, 0, 0, 0, 0, 0, 0 );
+   const dword libraries = formatter.acquireLibraries();
 
-         // only read if first char identifies a switch
-         if( (token.length() >= 3) && ('-' == token[0]) )
-         {
-            const char   topKey = token[1];
-            const char   subKey = token[2];
-            const string value( token.substr( 4 ) );
-            switch( topKey )
-            {
-            // libraries
-            case 'l' :
-               if( 0 != pFormatter )
-               {
-                  switch( subKey )
-                  {
-                  // libpng pathname
-                  case 'p' :
-                     pFormatter->setPngLibrary( value.c_str() );
-                     break;
-
-                  // openexr pathname
-                  case 'e' :
-                     pFormatter->setExrLibrary( value.c_str() );
-                     break;
-                  }
-               }
-               break;
-
-            // image metadata
-            case 'i' :
-               if( 0 != pMapper )
-               {
-                  switch( subKey )
-                  {
-                  // colorspace primaries
-                  case 'p' :
-                     {
-                        float colorspace[8] =
-                           { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
-
-                        parseFps( value, colorspace,
-                           sizeof(colorspace)/sizeof(colorspace[0]) );
-
-                        ::p3tmSetInputColorSpace(
-                           pMapper, colorspace, colorspace + 6 );
-                     }
-                     break;
-
-                  // calibration
-                  case 's' :
-                     {
-                        float calibration[2] = { 0.0f, 0.0f };
-
-                        parseFps( value, calibration,
-                           sizeof(calibration)/sizeof(calibration[0]) );
-
-                        ::p3tmSetInputLuminanceScale( pMapper, calibration );
-                     }
-                     break;
-
-                  // view angle
-                  case 'v' :
-                     {
-                        const float viewAngle = float(::atof( value.c_str() ));
-
-                        ::p3tmSetInputViewAngle( pMapper, viewAngle );
-                     }
-                     break;
-                  }
-               }
-               break;
-
-            // mapping options
-            case 'm' :
-               if( ('1' == subKey) & (0 != pMapper) )
-               {
-                  dword mappingFlags = 0;
-
-                  for( dword c = value.length();  c-- > 0; )
-                  {
-                     switch( value[c] )
-                     {
-                     case 'h' :
-                        mappingFlags |= ::p3tm11_CONTRAST | ::p3tm11_GLARE |
-                           ::p3tm11_COLOR | ::p3tm11_ACUITY;
-                        break;
-
-                     case 't' :
-                        mappingFlags |= ::p3tm11_CONTRAST;
-                        break;
-
-                     case 'g' :
-                        mappingFlags |= ::p3tm11_GLARE;
-                        break;
-
-                     case 'c' :
-                        mappingFlags |= ::p3tm11_COLOR;
-                        break;
-
-                     case 'a' :
-                        mappingFlags |= ::p3tm11_ACUITY;
-                        break;
-                     }
-                  }
-
-                  ::p3tmSetMappingFeatures( pMapper, mappingFlags );
-               }
-               break;
+   try
+   {
+      const string workingDirectory( hxa7241_general::getWorkingDirectory() );
+      CommandFileCache commandFiles;
 
-            // output options
-            case 'o' :
-               switch( subKey )
-               {
-               // out luminance range
-               case 'r' :
-                  if( 0 != pMapper )
-                  {
-                     float outLuminanceRange[2] = { 0.0f, 0.0f };
-
-                     parseFps( value, outLuminanceRange,
-                        sizeof(outLuminanceRange)/sizeof(outLuminanceRange[0]));
-
-                     ::p3tmSetOutputLuminanceRange(
-                        pMapper, outLuminanceRange );
-                  }
-                  break;
-
-               // out gamma
-               case 'g' :
-                  if( 0 != pMapper )
-                  {
-                     const float outGamma = float(::atof( value.c_str() ));
-
-                     ::p3tmSetOutputGamma( pMapper, outGamma );
-                  }
-                  break;
-
-               // out pixel type
-               case 'b' :
-                  if( 0 != pOutPixelType )
-                  {
-                     const int i = ::atoi( value.c_str() );
-                     *pOutPixelType = (16 == i) ?
-                        ::p3tm11_RGB_WORD : ::p3tm11_RGB_BYTE;
-                  }
-                  break;
-
-               // out image pathname
-               case 'n' :
-                  if( 0 != pOutPathname )
-                  {
-                     *pOutPathname = value;
-                  }
-                  break;
-               }
-               break;
+      hxa7241_general::LocalListener listener( argv[2] );
+      std::cout << "serving: " << argv[2] << "\n";
+      std::cout.flush();
 
-            default  :
-               ;//break;
-            }
+      // one command at a time, until told to stop
+      for( bool isServing = true;  isServing; )
+      {
+         hxa7241_general::LocalSocket* pConnection = listener.accept();
+         try
+         {
+            isServing = serveCommand( *pConnection, commandFiles );
          }
-      }
+         catch( ... )
+         {
+            // (a failed connection fails only its command)
+         }
+         delete pConnection;
 
-//    // print all args
-//    std::cout << "   argc    = " << argc << '\n';
-//    for( int i = 0;  i < argc;  ++i )
-//    {
-//       std::cout << "   argv[" << i << "] = " << argv[i] << '\n';
-//    }
-//    std::cout << '\n';
+         hxa7241_general::setWorkingDirectory( workingDirectory.c_str() );
+      }
    }
+   catch( ... )
+   {
+      formatter.releaseLibraries( libraries );
+      throw;
+   }
+
+   formatter.releaseLibraries( libraries );
 }
 
 
-bool parseFps
+bool serveCommand
 (
-   const string& group,
-   float         fps[],
-   const dword   length
+   hxa7241_general::LocalSocket& connection,
+   CommandFileCache&             commandFiles
 )
 {
-   vector<string> fpStrings;
-   tokenize( group, '_', fpStrings );
-
-   bool        isAllOk = (udword(length) == fpStrings.size());
-   const dword minLength = length <= dword(fpStrings.size()) ?
-      length : dword(fpStrings.size());
-   for( dword f = minLength;  f-- > 0;  )
+   // receive the client's working directory, then its command line, all
+   // null terminated
+   vector<ubyte> request;
+   connection.receiveAll( request );
+   request.push_back( 0 );
+
+   vector<char*> strings;
+   for( udword i = 0, start = 0;  i < request.size();  ++i )
    {
-      isAllOk &= parseFp( fpStrings[f], fps[f] );
+      if( 0 == request[i] )
+      {
+         strings.push_back( reinterpret_cast<char*>( &(request[start]) ) );
+         start = i + 1;
+      }
    }
+   // (the last is the terminator added)
+   strings.pop_back();
 
-// // do all or nothing
-// bool isAllOk = (length == fpStrings.size());
-// for( udword f = 0;  (f < length) & isAllOk;  ++f )
-// {
-//    isAllOk &= parseFp( fpStrings[f], fps[f] );
-// }
+   const bool isStop = (strings.size() == 3) &&
+      (string(SWITCH_STOP) == strings[2]);
 
-   return isAllOk;
-}
+   // run the command, with its messages collected
+   int                returnValue = EXIT_FAILURE;
+   std::ostringstream messages;
+   std::streambuf*    pCoutBuffer = std::cout.rdbuf( messages.rdbuf() );
+   try
+   {
+      const int argc = int(strings.size()) - 1;
+      char**    argv = (argc > 0) ? &(strings[1]) : 0;
 
+      if( isStop )
+      {
+         std::cout << "stopped serving\n";
 
-bool parseFp
-(
-   const string& s,
-   float&        fp
-)
-{
-   errno = 0;
+         returnValue = EXIT_SUCCESS;
+      }
+      else if( (argc <= 1) ||
+         (('-' == argv[1][0]) &&
+         ( (string(SWITCH_HELP1) == string(argv[1] + 1)) |
+           (string(SWITCH_HELP2) == string(argv[1] + 1)) )) )
+      {
+         std::cout << HELP_MESSAGE;
+
+         returnValue = EXIT_SUCCESS;
+      }
+      else
+      {
+         if( !hxa7241_general::setWorkingDirectory( strings[0] ) )
+         {
+            throw EXCEPTION_SERVED_DIRECTORY;
+         }
 
-   const char* pNum = s.c_str();
-   char*       pEnd = 0;
+         returnValue = runCommand( argc, argv, true, &commandFiles );
+      }
+   }
+   catch( const std::exception& e )
+   {
+      std::cout << '\n' << EXCEPTION_PREFIX << e.what() << '\n';
+   }
+   catch( const char*const pExceptionString )
+   {
+      std::cout << '\n' << EXCEPTION_PREFIX << pExceptionString << '\n';
+   }
+   catch( const std::string exceptionString )
+   {
+      std::cout << '\n' << EXCEPTION_PREFIX << exceptionString << '\n';
+   }
+   catch( ... )
+   {
+      std::cout << '\n' << EXCEPTION_PREFIX << EXCEPTION_ABSTRACT << '\n';
+   }
+   std::cout.rdbuf( pCoutBuffer );
 
-   fp = float( ::strtod( pNum, &pEnd ) );
+   // reply the exit status, then the messages
+   const string reply( string( 1, char(returnValue) ) + messages.str() );
+   connection.send( reply.data(), udword(reply.size()) );
 
-   return (0 == errno) & (0 == *pEnd) & (pNum != pEnd);
+   return !isStop;
 }
 
 
-void tokenizeCommandLine
+int sendCommand
 (
-   const int       argc,
-   char*const      argv[],
-   vector<string>& tokens
+   const int argc,
+   char*     argv[]
 )
 {
-   for( dword i = 0;  i < argc;  ++i )
+   // request: the working directory, then the command line (without the
+   // client switch and socket), all null terminated
+   string request( hxa7241_general::getWorkingDirectory() );
+   request += '\0';
+   request += argv[0];
+   request += '\0';
+   for( int i = 3;  i < argc;  ++i )
    {
-      tokens.push_back( string(argv[i]) );
+      request += argv[i];
+      request += '\0';
    }
-}
 
+   hxa7241_general::LocalSocket connection( argv[2] );
+   connection.send( request.data(), udword(request.size()) );
+   connection.finishSending();
 
-void tokenizeCommandFile
-(
-   const char*     commandFilePathname,
-   vector<string>& tokens
-)
-{
-   std::ifstream commandFile( commandFilePathname );
+   // reply: the exit status, then the messages
+   vector<ubyte> reply;
+   connection.receiveAll( reply );
+   if( reply.empty() )
+   {
+      throw EXCEPTION_SERVE_REPLY;
+   }
 
-   for( string token;  commandFile >> token; )
+   if( reply.size() > 1 )
    {
-      tokens.push_back( token );
+      std::cout.write( reinterpret_cast<const char*>( &(reply[1]) ),
+         std::streamsize(reply.size() - 1) );
    }
+
+   return int(reply[0]);
 }
 
 
-void tokenize
+void getInitialOptions
 (
-   const string&   str,
-   const char      separator,
-   vector<string>& tokens
+   const int               argc,
+   char*const              argv[],
+   CommandFileCache* const pCommandFiles,
+   bool&                   isFeedback,
+   string&                 inImagePathname,
+   vector<string>          tokenSets[2]
 )
 {
-   size_t posToken   = 0;
-   bool   isSepFound = false;
-   do
+   // read input file pathname from command line last arg
+   inImagePathname = argv[argc - 1];
+
+   // read command file pathname from command line
+   string commandFilePathname( COMMAND_FILE_NAME_DEFAULT );
+   for( int i = argc - 1;  i-- > 1; )
    {
-      const size_t posSep = str.find( separator, posToken );
-      isSepFound          = string::npos != posSep;
+      if( ('-' == argv[i][0]) && ('x' == argv[i][1]) && (':' == argv[i][2]) )
+      {
+         commandFilePathname = argv[i] + 3;
+      }
+   }
 
-      tokens.push_back( str.substr( posToken,
-         isSepFound ? posSep - posToken : string::npos ) );
-      posToken = posSep + 1;
+   // read feedback option
+   isFeedback = false;
+   for( int i = argc - 1;  i-- > 1; )
+   {
+      if( ('-' == argv[i][0]) && ('z' == argv[i][1]) )
+      {
+         isFeedback = true;
+      }
    }
-   while( isSepFound );
-}
 
+   // make command file token set (from the cache, if serving)
+   if( 0 != pCommandFiles )
+   {
+      tokenSets[0] = pCommandFiles->getTokens( commandFilePathname );
+   }
+   else
+   {
+      tokenizeCommandFile( commandFilePathname.c_str(), tokenSets[0] );
+   }
 
-//void tokenize
-//(
-// const string&   str,
-// vector<string>& tokens
-//)
-//{
-// std::stringstream ss( str );
+   // make command line token set (except first and last)
+   tokenizeCommandLine( argc - 2, argv + 1, tokenSets[1] );
+
+
+// // print things
+// std::cout << "\ninImagePathname     = " << inImagePathname;
+// std::cout << "\ncommandFilePathname = " << commandFilePathname;
+// std::cout << "\n";
 //
-// for( string token;  ss >> token; )
+// // print all tokens
+// static const char* title[] = { "\ncommand file:", "\ncommand line:" };
+// for( dword t = 0;  t < 2;  ++t )
 // {
-//    tokens.push_back( token );
+//    std::cout << title[t] << "\n\n";
+//    for( udword i = 0;  i < tokenSets[t].size();  ++i )
+//    {
+//       std::cout << tokenSets[t][i] << "\n";
+//    }
 // }
-//}
+}
 
 
-static void printImageStats
+void tokenizeCommandLine
 (
-   const bool      isFeedback,
-   const ImageRef& image
+   const int       argc,
+   char*const      argv[],
+   vector<string>& tokens
 )
 {
-   if( isFeedback )
+   for( dword i = 0;  i < argc;  ++i )
    {
-      ImageRef::EPixelType pixelsType = image.getPixelType();
-      if( ImageRef::PIXELS_FLOAT == pixelsType )
-      {
-         float min  = FLOAT_MAX;
-         float max  = FLOAT_MIN_NEG;
-         float mean = 0.0f;
-         {
-            const float  scaling = image.getScaling();
-            const float* pPixels = static_cast<const float*>(
-               image.getPixels() );
-            const dword  length  = image.getWidth() * image.getHeight();
-
-            for( dword i = 0;  i < length;  ++i, pPixels += 3 )
-            {
-               float luminance = (0.2126f * pPixels[0]) +
-                  (0.7152f * pPixels[1]) + (0.0722f * pPixels[2]);
-               luminance = (0.0f != scaling) ? luminance * scaling : luminance;
-
-               min   = min <= luminance ? min : luminance;
-               max   = max >= luminance ? max : luminance;
-               mean += luminance;
-            }
-
-            mean /= (length > 0) ? float(length) : 1.0f;
-         }
-
-         std::cout << "\ninput image stats";
-         std::cout << "\n   luminance min, max, mean = " << min << "  " <<
-            max << "  " << mean;
-         std::cout << "\n";
-      }
-      else
-      {
-         // not done yet...
-      }
+      tokens.push_back( string(argv[i]) );
    }
 }
 
 
-void printMapper
+void readListFile
 (
-   const bool  isFeedback,
-   const void* pMapper
+   const char      listFilePathname[],
+   vector<string>& pathnames
 )
 {
-   if( isFeedback )
+   std::ifstream listFile( listFilePathname );
+   if( !listFile )
    {
-      float inChromaticities6[6];
-      float inWhitePoint2[2];
-      float inScalingAndOffset2[2];
-      float inViewAngleHorizontal;
-      int   mappingFlags;
-      float outLuminanceRange2[2];
-      float outGamma;
-
-      ::p3tmGetOptions( pMapper,
-         inChromaticities6,
-         inWhitePoint2,
-         inScalingAndOffset2,
-         &inViewAngleHorizontal,
-         &mappingFlags,
-         outLuminanceRange2,
-         &outGamma );
-
-      std::cout << "\nmapper fields";
-      std::cout << "\n   inChromaticities      = ";
-      for( dword i = 0;  i < 6;  ++i )
+      throw EXCEPTION_LIST_READ;
+   }
+
+   // one path name per line, blank lines skipped
+   string line;
+   while( std::getline( listFile, line ) )
+   {
+      if( !line.empty() && ('\r' == line[line.length() - 1]) )
+      {
+         line.erase( line.length() - 1 );
+      }
+      if( !line.empty() )
       {
-         std::cout << inChromaticities6[i] << " ";
+         pathnames.push_back( line );
       }
-      std::cout << "\n   inWhitePoint          = " << inWhitePoint2[0] <<
-         " " << inWhitePoint2[1];
-      std::cout << "\n   inScalingAndOffset    = " << inScalingAndOffset2[0] <<
-         " " << inScalingAndOffset2[1];
-      std::cout << "\n   inViewAngleHorizontal = " << inViewAngleHorizontal;
-      std::cout << "\n   mappingFlags          = " <<
-         ((mappingFlags & ::p3tm11_CONTRAST ) ? "t" : "") << " " <<
-         ((mappingFlags & (::p3tm11_GLARE  & ~::p3tm11_CONTRAST)) ?
-            "g" : "") << " " <<
-         ((mappingFlags & (::p3tm11_COLOR  & ~::p3tm11_CONTRAST)) ?
-            "c" : "") << " " <<
-         ((mappingFlags & (::p3tm11_ACUITY & ~::p3tm11_CONTRAST)) ?
-            "a" : "");
-      std::cout << "\n   outLuminanceRange2    = " << outLuminanceRange2[0] <<
-         " " << outLuminanceRange2[1];
-      std::cout << "\n   outGamma              = " << outGamma;
-      std::cout << "\n";
    }
 }
 
@@ -1028,6 +1004,23 @@ namespace p3tonemapper_format
    {
       bool test_rgbe( std::ostream* pOut, bool isVerbose, dword seed );
    }
+
+   namespace pfm
+   {
+      bool test_pfm ( std::ostream* pOut, bool isVerbose, dword seed );
+   }
+
+   namespace qoi
+   {
+      bool test_qoi ( std::ostream* pOut, bool isVerbose, dword seed );
+   }
+
+   bool test_ImageFormatter( std::ostream* pOut, bool isVerbose, dword seed );
+}
+
+namespace hxa7241_general
+{
+   bool test_HalfFloat( std::ostream* pOut, bool isVerbose, dword seed );
 }
 
 
@@ -1038,6 +1031,10 @@ static bool (*TESTERS[])(std::ostream*, bool, dword) =
 ,  &p3tonemapper_format::png::test_png           // 2
 ,  &p3tonemapper_format::ppm::test_ppm           // 3
 ,  &p3tonemapper_format::rgbe::test_rgbe         // 4
+,  &hxa7241_general::test_HalfFloat              // 5
+,  &p3tonemapper_format::pfm::test_pfm           // 6
+,  &p3tonemapper_format::qoi::test_qoi           // 7
+,  &p3tonemapper_format::test_ImageFormatter     // 8
 };
 
 
@@ -0,0 +1,236 @@
+/*--------------------------------------------------------------------
+
+   Perceptuum3 rendering components
+   Copyright (c) 2005, Harrison Ainsworth / HXA7241.
+
+   http://www.hxa7241.org/
+
+--------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later
+   version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+   MA  02110-1301  USA
+
+--------------------------------------------------------------------*/
+
+
+
+#if defined(_PLATFORM_WIN)
+#include <float.h>
+#else
+#include <fenv.h>
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+#endif
+
+#include "FpEnvironment.hpp"   // own header is included last
+
+
+using namespace hxa7241_general;
+
+
+
+
+/// statics
+#if defined(_PLATFORM_WIN)
+
+// all exceptions masked, round to nearest, denormals flushed
+static const unsigned int CONTROL_MASK = _MCW_EM | _MCW_RC | _MCW_DN;
+static const unsigned int CONTROL_SET  = _MCW_EM | _RC_NEAR | _DN_FLUSH;
+
+#elif defined(__SSE__)
+
+// MXCSR: all exceptions masked, flush-to-zero, denormals-are-zero
+// (denormals-are-zero is not on the first SSE processors)
+static const udword FLUSH_TO_ZERO = 0x8000u;
+#if defined(__SSE2__)
+static const udword CONTROL_SET   = 0x1F80u | FLUSH_TO_ZERO | 0x0040u;
+#else
+static const udword CONTROL_SET   = 0x1F80u | FLUSH_TO_ZERO;
+#endif
+
+#elif defined(__aarch64__)
+
+// FPCR: flush-to-zero (covers inputs and outputs)
+static const udword FLUSH_TO_ZERO = 0x01000000u;
+static const udword CONTROL_SET   = FLUSH_TO_ZERO;
+
+static udword getFpcr()
+{
+	unsigned long fpcr = 0;
+	__asm__ __volatile__( "mrs %0, fpcr" : "=r"(fpcr) );
+	return udword( fpcr );
+}
+
+static void setFpcr( const udword fpcr )
+{
+	const unsigned long fpcrl = fpcr;
+	__asm__ __volatile__( "msr fpcr, %0" : : "r"(fpcrl) );
+}
+
+#endif
+
+
+
+
+/// standard object services ---------------------------------------------------
+FpEnvironment::FpEnvironment()
+ :	controlWord_m ( 0 )
+ ,	roundingMode_m( 0 )
+{
+#if defined(_PLATFORM_WIN)
+
+	controlWord_m = udword( ::_controlfp( 0, 0 ) );
+	::_controlfp( CONTROL_SET, CONTROL_MASK );
+
+#else
+
+	roundingMode_m = dword( ::fegetround() );
+	::fesetround( FE_TONEAREST );
+
+#if defined(__SSE__)
+	controlWord_m = udword( _mm_getcsr() );
+	_mm_setcsr( controlWord_m | CONTROL_SET );
+#elif defined(__aarch64__)
+	controlWord_m = getFpcr();
+	setFpcr( controlWord_m | CONTROL_SET );
+#endif
+
+#endif
+}
+
+
+FpEnvironment::~FpEnvironment()
+{
+#if defined(_PLATFORM_WIN)
+
+	::_controlfp( static_cast<unsigned int>(controlWord_m), CONTROL_MASK );
+
+#else
+
+#if defined(__SSE__)
+	_mm_setcsr( controlWord_m );
+#elif defined(__aarch64__)
+	setFpcr( controlWord_m );
+#endif
+
+	::fesetround( roundingMode_m );
+
+#endif
+}
+
+
+
+
+/// queries --------------------------------------------------------------------
+bool FpEnvironment::isFlushingDenormals()
+{
+#if defined(_PLATFORM_WIN)
+	return _DN_FLUSH == (::_controlfp( 0, 0 ) & _MCW_DN);
+#elif defined(__SSE__)
+	return 0 != (_mm_getcsr() & FLUSH_TO_ZERO);
+#elif defined(__aarch64__)
+	return 0 != (getFpcr() & FLUSH_TO_ZERO);
+#else
+	return false;
+#endif
+}
+
+
+
+
+
+
+
+
+/// test -----------------------------------------------------------------------
+#ifdef TESTING
+
+
+#include <float.h>
+#include <ostream>
+
+
+namespace hxa7241_general
+{
+	using namespace hxa7241;
+
+
+bool test_FpEnvironment
+(
+	std::ostream* pOut,
+	const bool    isVerbose,
+	const dword   //seed
+)
+{
+	bool isOk = true;
+
+	if( pOut ) *pOut << "[ test_FpEnvironment ]\n\n";
+
+
+	// (volatile to keep the arithmetic at run-time)
+	volatile float half = 0.5f;
+	volatile float tiny = FLT_MIN;
+
+	const bool isFlushingBefore = FpEnvironment::isFlushingDenormals();
+	const bool isDenormalBefore = 0.0f != (tiny * half);
+
+	// set, and nest
+	{
+		FpEnvironment fpEnvironment1;
+		const bool isFlushing1 = FpEnvironment::isFlushingDenormals();
+
+		// denormal result flushed, if hardware supports it
+		const bool isDenormal1 = 0.0f != (tiny * half);
+		isOk &= !(isFlushing1 & isDenormal1);
+
+		{
+			FpEnvironment fpEnvironment2;
+			isOk &= (isFlushing1 == FpEnvironment::isFlushingDenormals());
+		}
+		isOk &= (isFlushing1 == FpEnvironment::isFlushingDenormals());
+
+		if( pOut && isVerbose ) *pOut << isFlushing1 << " " << isDenormal1 <<
+			"  ";
+	}
+
+	// restored
+	isOk &= (isFlushingBefore == FpEnvironment::isFlushingDenormals());
+	isOk &= (isDenormalBefore == (0.0f != (tiny * half)));
+
+	if( pOut && isVerbose ) *pOut << isFlushingBefore << " " <<
+		isDenormalBefore << "  " << isOk << "\n\n";
+
+	if( pOut ) *pOut << "set and restore : " <<
+		(isOk ? "--- succeeded" : "*** failed") << "\n\n";
+
+
+	if( pOut ) *pOut << (isOk ? "--- successfully" : "*** failurefully") <<
+		" completed " << "\n\n\n";
+
+	if( pOut ) pOut->flush();
+
+
+	return isOk;
+}
+
+
+}//namespace
+
+
+#endif//TESTING
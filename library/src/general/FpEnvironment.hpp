@@ -0,0 +1,87 @@
+/*--------------------------------------------------------------------
+
+   Perceptuum3 rendering components
+   Copyright (c) 2005, Harrison Ainsworth / HXA7241.
+
+   http://www.hxa7241.org/
+
+--------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later
+   version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+   MA  02110-1301  USA
+
+--------------------------------------------------------------------*/
+
+
+
+#ifndef FpEnvironment_h
+#define FpEnvironment_h
+
+
+
+
+#include "hxa7241_general.hpp"
+namespace hxa7241_general
+{
+
+
+/**
+ * Scoped floating-point environment for the calling thread.<br/><br/>
+ *
+ * Constructing sets rounding to nearest, with exceptions masked, and (where
+ * the hardware has it) flush-to-zero and denormals-are-zero. Destructing
+ * restores the previous settings.<br/><br/>
+ *
+ * The fp control state is per-thread, so simultaneous instances in different
+ * threads do not interfere.<br/><br/>
+ *
+ * Non-copyable.
+ */
+class FpEnvironment
+{
+/// standard object services ---------------------------------------------------
+public:
+	         FpEnvironment();
+
+	        ~FpEnvironment();
+private:
+	         FpEnvironment( const FpEnvironment& );
+	FpEnvironment& operator=( const FpEnvironment& );
+
+
+/// queries --------------------------------------------------------------------
+public:
+	/**
+	 * Whether denormals are being flushed to zero.
+	 */
+	static  bool  isFlushingDenormals();
+
+
+/// fields ---------------------------------------------------------------------
+private:
+	udword controlWord_m;
+	dword  roundingMode_m;
+};
+
+
+}//namespace
+
+
+
+
+#endif//FpEnvironment_h
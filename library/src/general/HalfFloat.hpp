@@ -0,0 +1,65 @@
+/*--------------------------------------------------------------------
+
+   Perceptuum3 rendering components
+   Copyright (c) 2005, Harrison Ainsworth / HXA7241.
+
+   http://www.hxa7241.org/
+
+--------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later
+   version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+   MA  02110-1301  USA
+
+--------------------------------------------------------------------*/
+
+
+
+#ifndef HalfFloat_h
+#define HalfFloat_h
+
+
+
+
+#include "hxa7241_general.hpp"
+namespace hxa7241_general
+{
+
+
+/**
+ * Convert an IEEE 754 half (16-bit float, as OpenEXR) to float.<br/><br/>
+ *
+ * All values are exact, including denormals, infinities and NaNs.
+ */
+float halfToFloat( uword half );
+
+/**
+ * Convert an array of halfs to floats.<br/><br/>
+ *
+ * Uses F16C instructions when built for them, otherwise tables.
+ */
+void  halfsToFloats( const uword* pHalfs,
+                     dword        count,
+                     float*       pFloats );
+
+
+}//namespace
+
+
+
+
+#endif//HalfFloat_h
@@ -37,7 +37,7 @@ using namespace hxa7241_general;
 
 
 /// statics
-static dword MAX_SIZE = dword(WORD_MAX);
+static const dword MAX_SIZE = dword(WORD_MAX);
 
 
 
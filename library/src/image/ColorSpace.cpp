@@ -255,6 +255,12 @@ float ColorSpace::getRgbLuminance
 }
 
 
+const Vector3f& ColorSpace::getRgbLuminanceWeights() const
+{
+   return RgbToXyz_m.getRow1();
+}
+
+
 const float* ColorSpace::getChromaticities() const
 {
    return chromaticities32_m;
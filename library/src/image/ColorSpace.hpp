@@ -107,6 +107,11 @@ public:
 	        Vector3f transRgbToXyz_( const Vector3f& rgb )                 const;
 
 	        float getRgbLuminance( const Vector3f& rgb )                   const;
+	        /**
+	         * the rgb weights for luminance (the Y row of the rgb to xyz
+	         * transform).
+	         */
+	        const Vector3f& getRgbLuminanceWeights()                       const;
 
 	        const float* getChromaticities()                               const;
 	        const float* getWhitePoint()                                   const;
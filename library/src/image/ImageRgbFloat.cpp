@@ -180,6 +180,12 @@ ImageRgbFloatIter ImageRgbFloat::getIterator()
 }
 
 
+float* ImageRgbFloat::getPixels()
+{
+	return sheet_m.getMemory();
+}
+
+
 void ImageRgbFloat::zeroValues()
 {
 	sheet_m.zeroMemory();
@@ -282,6 +288,12 @@ ImageRgbFloatIterConst ImageRgbFloat::getIteratorConst() const
 }
 
 
+const float* ImageRgbFloat::getPixels() const
+{
+	return sheet_m.getMemory();
+}
+
+
 
 
 /// statics --------------------------------------------------------------------
@@ -308,6 +320,20 @@ void ImageRgbFloat::visitBilinear
 	const dword          outWidth,
 	const dword          outHeight
 )
+{
+	visitBilinear( in, visitor, outWidth, outHeight, 0, outHeight );
+}
+
+
+void ImageRgbFloat::visitBilinear
+(
+	const ImageRgbFloat& in,
+	BilinearVisitor&     visitor,
+	const dword          outWidth,
+	const dword          outHeight,
+	const dword          outRowBegin,
+	const dword          outRowEnd
+)
 {
 	const dword inWidth  = in.getWidth();
 	const dword inHeight = in.getHeight();
@@ -321,8 +347,8 @@ void ImageRgbFloat::visitBilinear
 		const float xScale = float(inWidth)  / float(outWidth);
 		const float yScale = float(inHeight) / float(outHeight);
 
-		// loop through output pixels
-		for( dword oy = 0;  oy < outHeight;  ++oy )
+		// loop through output pixels (of the row range)
+		for( dword oy = outRowBegin;  oy < outRowEnd;  ++oy )
 		{
 			for( dword ox = 0;  ox < outWidth;  ++ox )
 			{
@@ -361,7 +387,7 @@ void ImageRgbFloat::visitBilinear
 				//const Vector3f inPixel((right * ixFrac) + (left * (FLOAT_ALMOST_ONE - ixFrac)));
 
 				// operate on interpolated input pixel
-				visitor.operate( inPixel, ox, oy );
+				visitor.operate( inPixel, ox, oy - outRowBegin );
 			}
 		}
 	}
@@ -99,6 +99,7 @@ public:
 	                   const Vector3f& );
 
 	virtual ImageRgbFloatIter getIterator();
+	virtual float* getPixels();
 
 	virtual void  zeroValues();
 	virtual void  clampValues();
@@ -122,6 +123,7 @@ public:
 	virtual Vector3f get( dword i )                                        const;
 
 	virtual ImageRgbFloatIterConst getIteratorConst()                      const;
+	virtual const float* getPixels()                                       const;
 
 
 /// statics --------------------------------------------------------------------
@@ -140,6 +142,17 @@ public:
 	                             BilinearVisitor&,
 	                             dword outWidth,
 	                             dword outHeight );
+	/**
+	 * Visit only output rows outRowBegin to outRowEnd (exclusive).<br/><br/>
+	 *
+	 * The visitor is given outY relative to outRowBegin.
+	 */
+	static  void  visitBilinear( const ImageRgbFloat&,
+	                             BilinearVisitor&,
+	                             dword outWidth,
+	                             dword outHeight,
+	                             dword outRowBegin,
+	                             dword outRowEnd );
 
 
 /// implementation -------------------------------------------------------------
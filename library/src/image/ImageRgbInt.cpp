@@ -62,6 +62,7 @@ ImageRgbInt::ImageRgbInt
  ,	isAdopt_m        ( isAdopt )
  ,	colorSpace_m     ()
  , gamma_m          ( 1.0f )
+ ,	isWordsBigEndian_m( false )
 {
 }
 
@@ -107,6 +108,7 @@ ImageRgbInt& ImageRgbInt::operator=
 
 		colorSpace_m      = other.colorSpace_m;
 		gamma_m           = other.gamma_m;
+		isWordsBigEndian_m = other.isWordsBigEndian_m;
 	}
 
 	return *this;
@@ -139,6 +141,15 @@ void ImageRgbInt::setGamma
 }
 
 
+void ImageRgbInt::setWordsBigEndian
+(
+	const bool isWordsBigEndian
+)
+{
+	isWordsBigEndian_m = isWordsBigEndian;
+}
+
+
 void ImageRgbInt::setElement
 (
 	const dword  index,
@@ -161,7 +172,17 @@ void ImageRgbInt::setElement
 			if( 2 == bytesPerChannel_m )
 			{
 				uword* pWord = static_cast<uword*>(pPixel3s_m) + indexTriple;
-				pWord[i] = uword( fp01ToWord( channel01 ) );
+				const uword w = uword( fp01ToWord( channel01 ) );
+				if( isWordsBigEndian_m )
+				{
+					ubyte* pBytes = reinterpret_cast<ubyte*>( pWord + i );
+					pBytes[0] = ubyte( w >> 8 );
+					pBytes[1] = ubyte( w );
+				}
+				else
+				{
+					pWord[i] = w;
+				}
 			}
 			else
 			{
@@ -173,6 +194,12 @@ void ImageRgbInt::setElement
 }
 
 
+void* ImageRgbInt::getPixels()
+{
+	return pPixel3s_m;
+}
+
+
 
 
 /// queries --------------------------------------------------------------------
@@ -218,6 +245,12 @@ float ImageRgbInt::getGamma() const
 }
 
 
+bool ImageRgbInt::isWordsBigEndian() const
+{
+	return isWordsBigEndian_m;
+}
+
+
 const void* ImageRgbInt::getPixels() const
 {
 	return pPixel3s_m;
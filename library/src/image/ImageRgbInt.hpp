@@ -73,10 +73,17 @@ public:
 	 * give 0.0 for the (partly linear) ITU-R BT.709 transfer function.
 	 */
 	virtual void  setGamma( float );
+	/**
+	 * make 48-bit pixel words most significant byte first (as PPM), instead
+	 * of native order.
+	 */
+	virtual void  setWordsBigEndian( bool );
 
 	virtual void  setElement( dword        index,
 	                          const float* pValue013 );
 
+	virtual void* getPixels();
+
 
 /// queries --------------------------------------------------------------------
 	virtual dword getWidth()                                               const;
@@ -87,6 +94,7 @@ public:
 
 	virtual const ColorSpace& getColorSpace()                              const;
 	virtual float getGamma()                                               const;
+	virtual bool  isWordsBigEndian()                                       const;
 
 	virtual const void* getPixels()                                        const;
 
@@ -102,6 +110,7 @@ private:
 
 	ColorSpace colorSpace_m;
 	float      gamma_m;
+	bool       isWordsBigEndian_m;
 };
 
 
@@ -122,23 +122,33 @@ enum p3tm11EMappingOptions
  * Options for use with p3tmMap() inPixelsType parameter.<br/><br/>
  *
  * @p3tm11_RGB_FLOAT  pixel parts/channels are floats, in storage order R, G, B
+ * @p3tm13_RGB_HALF   pixel parts/channels are IEEE 754 halfs (16-bit floats,
+ *                    as OpenEXR), in storage order R, G, B. They are converted
+ *                    a band of rows at a time, never as a whole float image.
  */
 enum p3tm11EInPixelOptions
 {
-   p3tm11_RGB_FLOAT = 0
+   p3tm11_RGB_FLOAT = 0,
+   p3tm13_RGB_HALF  = 1
 };
 
 
 /**
  * Options for use with p3tmMap() outPixelsType parameter.<br/><br/>
  *
- * @p3tm11_RGB_BYTE  pixel parts/channels are bytes, in storage order R, G, B
- * @p3tm11_RGB_WORD  pixel parts/channels are words, in storage order R, G, B
+ * @p3tm11_RGB_BYTE     pixel parts/channels are bytes, in storage order R,
+ *                      G, B
+ * @p3tm11_RGB_WORD     pixel parts/channels are words, in storage order R,
+ *                      G, B
+ * @p3tm13_RGB_WORD_BE  pixel parts/channels are words, most significant byte
+ *                      first whatever the platform (as PPM), in storage
+ *                      order R, G, B
  */
 enum p3tm11EOutPixelOptions
 {
-   p3tm11_RGB_BYTE = 0,
-   p3tm11_RGB_WORD = 1
+   p3tm11_RGB_BYTE    = 0,
+   p3tm11_RGB_WORD    = 1,
+   p3tm13_RGB_WORD_BE = 2
 };
 
 
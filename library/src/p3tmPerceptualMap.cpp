@@ -29,13 +29,18 @@
 
 
 #include <string.h>
+#include <exception>
 
 #include "PerceptualMap.hpp"
+#include "PerceptualMapStream.hpp"
+#include "PerceptualMapSweep.hpp"
 
 #include "p3tmPerceptualMap-v13.h"
 
 
 using p3tonemapper_tonemap::PerceptualMap;
+using p3tonemapper_tonemap::PerceptualMapStream;
+using p3tonemapper_tonemap::PerceptualMapSweep;
 
 
 
@@ -44,6 +49,20 @@ using p3tonemapper_tonemap::PerceptualMap;
 namespace
 {
    const char MESSAGE_CREATE_FAILED[] = "mapper creation failed";
+
+
+   void setMessage
+   (
+      const char* pMessage,
+      char*       pMessage128
+   )
+   {
+      if( pMessage128 )
+      {
+         ::strncpy( pMessage128, pMessage, 127 );
+         pMessage128[ 127 ] = 0;
+      }
+   }
 }
 
 
@@ -184,6 +203,545 @@ int p3tmMap2
 }
 
 
+int p3tmMap3
+(
+   const void*         pPm,
+   int                 width,
+   int                 height,
+   int                 inPixelsType,
+   const p3tmInLayout* pInLayout,
+   int                 outPixelsType,
+   void*               pOutPixels,
+   char*               pMessage128
+)
+{
+   return static_cast<const PerceptualMap*>( pPm )->map(
+      width,
+      height,
+      inPixelsType,
+      *pInLayout,
+      outPixelsType,
+      pOutPixels,
+      0,
+      pMessage128 ) ? 1 : 0;
+}
+
+
+int p3tmMap4
+(
+   const void* pPm,
+   int         width,
+   int         height,
+   int         inPixelsType,
+   void*       pInPixels,
+   int         outPixelsType,
+   int         isLastRowFirst,
+   p3tmRowSink pRowSink,
+   void*       pSinkContext,
+   char*       pMessage128
+)
+{
+   return static_cast<const PerceptualMap*>( pPm )->map(
+      width,
+      height,
+      inPixelsType,
+      pInPixels,
+      outPixelsType,
+      0 != isLastRowFirst,
+      pRowSink,
+      pSinkContext,
+      pMessage128 ) ? 1 : 0;
+}
+
+
+int p3tmMap5
+(
+   const void*        pPm,
+   int                width,
+   int                height,
+   int                inPixelsType,
+   void*              pInPixels,
+   int                isLastRowFirst,
+   int                outCount,
+   const p3tmOutRows* pOuts,
+   char*              pMessage128
+)
+{
+   return static_cast<const PerceptualMap*>( pPm )->map(
+      width,
+      height,
+      inPixelsType,
+      pInPixels,
+      0 != isLastRowFirst,
+      outCount,
+      pOuts,
+      pMessage128 ) ? 1 : 0;
+}
+
+
+
+
+
+
+
+
+/// streaming object ===========================================================
+
+void* p3tmCreatePerceptualMapStream
+(
+   const void* pPm,
+   int         width,
+   int         height,
+   int         inPixelsType,
+   int         outPixelsType,
+   char*       pMessage128
+)
+{
+   void* pStream = 0;
+   setMessage( "", pMessage128 );
+
+   try
+   {
+      pStream = new PerceptualMapStream(
+         *static_cast<const PerceptualMap*>( pPm ),
+         width,
+         height,
+         inPixelsType,
+         outPixelsType );
+   }
+   catch( const std::exception& exception )
+   {
+      setMessage( exception.what(), pMessage128 );
+   }
+   catch( const char*const exceptionString )
+   {
+      setMessage( exceptionString, pMessage128 );
+   }
+   catch( ... )
+   {
+      setMessage( "unannotated exception", pMessage128 );
+   }
+
+   return pStream;
+}
+
+
+int p3tmFreePerceptualMapStream
+(
+   void* pStream
+)
+{
+   bool isOk = true;
+
+   try
+   {
+      delete static_cast<PerceptualMapStream*>( pStream );
+   }
+   catch( ... )
+   {
+      isOk = false;
+   }
+
+   return isOk ? 1 : 0;
+}
+
+
+int p3tmStreamSetProxy
+(
+   void* pStream,
+   int   proxyWidth,
+   int   proxyHeight,
+   char* pMessage128
+)
+{
+   bool isOk = false;
+   setMessage( "", pMessage128 );
+
+   try
+   {
+      static_cast<PerceptualMapStream*>( pStream )->setProxy(
+         proxyWidth,
+         proxyHeight );
+
+      isOk = true;
+   }
+   catch( const std::exception& exception )
+   {
+      setMessage( exception.what(), pMessage128 );
+   }
+   catch( const char*const exceptionString )
+   {
+      setMessage( exceptionString, pMessage128 );
+   }
+   catch( ... )
+   {
+      setMessage( "unannotated exception", pMessage128 );
+   }
+
+   return isOk ? 1 : 0;
+}
+
+
+void p3tmStreamSetOutRowStride
+(
+   void*     pStream,
+   const int rowStride
+)
+{
+   static_cast<PerceptualMapStream*>( pStream )->setOutRowStride( rowStride );
+}
+
+
+void p3tmStreamSetOutPixelsType
+(
+   void*     pStream,
+   const int outPixelsType
+)
+{
+   static_cast<PerceptualMapStream*>( pStream )->setOutPixelsType(
+      outPixelsType );
+}
+
+
+void p3tmStreamGetFovealSize
+(
+   const void* pStream,
+   int*        pWidth,
+   int*        pHeight
+)
+{
+   hxa7241::dword width  = 0;
+   hxa7241::dword height = 0;
+   static_cast<const PerceptualMapStream*>( pStream )->getFovealSize(
+      width, height );
+
+   *pWidth  = width;
+   *pHeight = height;
+}
+
+
+int p3tmStreamAnalyseRows
+(
+   void*       pStream,
+   int         rowCount,
+   const void* pInRows,
+   char*       pMessage128
+)
+{
+   bool isOk = false;
+   setMessage( "", pMessage128 );
+
+   try
+   {
+      static_cast<PerceptualMapStream*>( pStream )->analyseRows(
+         rowCount,
+         pInRows );
+
+      isOk = true;
+   }
+   catch( const std::exception& exception )
+   {
+      setMessage( exception.what(), pMessage128 );
+   }
+   catch( const char*const exceptionString )
+   {
+      setMessage( exceptionString, pMessage128 );
+   }
+   catch( ... )
+   {
+      setMessage( "unannotated exception", pMessage128 );
+   }
+
+   return isOk ? 1 : 0;
+}
+
+
+int p3tmStreamMapRows
+(
+   void*       pStream,
+   int         rowCount,
+   const void* pInRows,
+   void*       pOutRows,
+   int*        pOutRowCount,
+   char*       pMessage128
+)
+{
+   bool isOk = false;
+   setMessage( "", pMessage128 );
+
+   try
+   {
+      const int outRowCount = static_cast<PerceptualMapStream*>( pStream )->
+         mapRows(
+            rowCount,
+            pInRows,
+            pOutRows );
+
+      if( pOutRowCount )
+      {
+         *pOutRowCount = outRowCount;
+      }
+
+      isOk = true;
+   }
+   catch( const std::exception& exception )
+   {
+      setMessage( exception.what(), pMessage128 );
+   }
+   catch( const char*const exceptionString )
+   {
+      setMessage( exceptionString, pMessage128 );
+   }
+   catch( ... )
+   {
+      setMessage( "unannotated exception", pMessage128 );
+   }
+
+   return isOk ? 1 : 0;
+}
+
+
+int p3tmStreamAnalyseRows3
+(
+   void*               pStream,
+   int                 rowCount,
+   const p3tmInLayout* pInLayout,
+   char*               pMessage128
+)
+{
+   bool isOk = false;
+   setMessage( "", pMessage128 );
+
+   try
+   {
+      static_cast<PerceptualMapStream*>( pStream )->analyseRows(
+         rowCount,
+         *pInLayout );
+
+      isOk = true;
+   }
+   catch( const std::exception& exception )
+   {
+      setMessage( exception.what(), pMessage128 );
+   }
+   catch( const char*const exceptionString )
+   {
+      setMessage( exceptionString, pMessage128 );
+   }
+   catch( ... )
+   {
+      setMessage( "unannotated exception", pMessage128 );
+   }
+
+   return isOk ? 1 : 0;
+}
+
+
+int p3tmStreamMapRows3
+(
+   void*               pStream,
+   int                 rowCount,
+   const p3tmInLayout* pInLayout,
+   void*               pOutRows,
+   int*                pOutRowCount,
+   char*               pMessage128
+)
+{
+   bool isOk = false;
+   setMessage( "", pMessage128 );
+
+   try
+   {
+      const int outRowCount = static_cast<PerceptualMapStream*>( pStream )->
+         mapRows(
+            rowCount,
+            *pInLayout,
+            pOutRows );
+
+      if( pOutRowCount )
+      {
+         *pOutRowCount = outRowCount;
+      }
+
+      isOk = true;
+   }
+   catch( const std::exception& exception )
+   {
+      setMessage( exception.what(), pMessage128 );
+   }
+   catch( const char*const exceptionString )
+   {
+      setMessage( exceptionString, pMessage128 );
+   }
+   catch( ... )
+   {
+      setMessage( "unannotated exception", pMessage128 );
+   }
+
+   return isOk ? 1 : 0;
+}
+
+
+int p3tmStreamMapImage
+(
+   void*       pStream,
+   void*       pInPixels,
+   int         isLastRowFirst,
+   p3tmRowSink pRowSink,
+   void*       pSinkContext,
+   void*       pOutPixels,
+   char*       pMessage128
+)
+{
+   bool isOk = false;
+   setMessage( "", pMessage128 );
+
+   try
+   {
+      static_cast<PerceptualMapStream*>( pStream )->mapImage(
+         pInPixels,
+         0 != isLastRowFirst,
+         pRowSink,
+         pSinkContext,
+         pOutPixels );
+
+      isOk = true;
+   }
+   catch( const std::exception& exception )
+   {
+      setMessage( exception.what(), pMessage128 );
+   }
+   catch( const char*const exceptionString )
+   {
+      setMessage( exceptionString, pMessage128 );
+   }
+   catch( ... )
+   {
+      setMessage( "unannotated exception", pMessage128 );
+   }
+
+   return isOk ? 1 : 0;
+}
+
+
+int p3tmStreamGetLatency
+(
+   const void* pStream
+)
+{
+   return static_cast<const PerceptualMapStream*>( pStream )->getLatency();
+}
+
+
+
+
+/// sweep object ===============================================================
+
+void* p3tmCreatePerceptualMapSweep
+(
+   const void* pPm,
+   int         width,
+   int         height,
+   int         inPixelsType,
+   void*       pInPixels,
+   int         mappingFlagsCount,
+   const int*  pMappingFlags,
+   char*       pMessage128
+)
+{
+   void* pSweep = 0;
+   setMessage( "", pMessage128 );
+
+   try
+   {
+      pSweep = new PerceptualMapSweep(
+         *static_cast<const PerceptualMap*>( pPm ),
+         width,
+         height,
+         inPixelsType,
+         pInPixels,
+         mappingFlagsCount,
+         pMappingFlags );
+   }
+   catch( const std::exception& exception )
+   {
+      setMessage( exception.what(), pMessage128 );
+   }
+   catch( const char*const exceptionString )
+   {
+      setMessage( exceptionString, pMessage128 );
+   }
+   catch( ... )
+   {
+      setMessage( "unannotated exception", pMessage128 );
+   }
+
+   return pSweep;
+}
+
+
+int p3tmFreePerceptualMapSweep
+(
+   void* pSweep
+)
+{
+   bool isOk = true;
+
+   try
+   {
+      delete static_cast<PerceptualMapSweep*>( pSweep );
+   }
+   catch( ... )
+   {
+      isOk = false;
+   }
+
+   return isOk ? 1 : 0;
+}
+
+
+int p3tmSweepMap
+(
+   const void*  pSweep,
+   int          mappingFlags,
+   const float* pOutLuminanceRange2,
+   float        outGamma,
+   int          outPixelsType,
+   void*        pOutPixels,
+   char*        pMessage128
+)
+{
+   bool isOk = false;
+   setMessage( "", pMessage128 );
+
+   try
+   {
+      static_cast<const PerceptualMapSweep*>( pSweep )->map(
+         mappingFlags,
+         pOutLuminanceRange2,
+         outGamma,
+         outPixelsType,
+         pOutPixels );
+
+      isOk = true;
+   }
+   catch( const std::exception& exception )
+   {
+      setMessage( exception.what(), pMessage128 );
+   }
+   catch( const char*const exceptionString )
+   {
+      setMessage( exceptionString, pMessage128 );
+   }
+   catch( ... )
+   {
+      setMessage( "unannotated exception", pMessage128 );
+   }
+
+   return isOk ? 1 : 0;
+}
+
+
 
 
 
@@ -460,6 +1018,8 @@ namespace hxa7241_general
    bool test_Interval       ( std::ostream* pOut, bool isVerbose, dword seed );
    bool test_Histogram      ( std::ostream* pOut, bool isVerbose, dword seed );
    bool test_SamplesRegular1( std::ostream* pOut, bool isVerbose, dword seed );
+   bool test_FpEnvironment  ( std::ostream* pOut, bool isVerbose, dword seed );
+   bool test_HalfFloat      ( std::ostream* pOut, bool isVerbose, dword seed );
 }
 
 namespace p3tonemapper_image
@@ -477,6 +1037,10 @@ namespace p3tonemapper_tonemap
    bool test_AcuityFilter   ( std::ostream* pOut, bool isVerbose, dword seed );
    bool test_ToneAdjustment ( std::ostream* pOut, bool isVerbose, dword seed );
    bool test_PerceptualMap  ( std::ostream* pOut, bool isVerbose, dword seed );
+   bool test_PerceptualMapStream( std::ostream* pOut, bool isVerbose,
+      dword seed );
+   bool test_PerceptualMapSweep ( std::ostream* pOut, bool isVerbose,
+      dword seed );
 }
 
 
@@ -501,6 +1065,11 @@ static bool (*TESTERS[])(std::ostream*, bool, dword) =
 ,  &p3tonemapper_tonemap::test_AcuityFilter      // 13
 ,  &p3tonemapper_tonemap::test_ToneAdjustment    // 14
 ,  &p3tonemapper_tonemap::test_PerceptualMap     // 15
+
+,  &hxa7241_general::test_FpEnvironment          // 16
+,  &p3tonemapper_tonemap::test_PerceptualMapStream  // 17
+,  &hxa7241_general::test_HalfFloat              // 18
+,  &p3tonemapper_tonemap::test_PerceptualMapSweep   // 19
 };
 
 
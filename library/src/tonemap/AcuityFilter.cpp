@@ -52,6 +52,29 @@ AcuityFilter::AcuityFilter
  ,	pInColorSpace_m( &inColorSpace )
  ,	pIntermediate_m( &intermediate )
  ,	pOutImage_m    ( &outImage )
+ ,	intermediateRowBegin_m( 0 )
+ ,	outRowBegin_m         ( 0 )
+ ,	imageHeight_m         ( outImage.getHeight() )
+{
+}
+
+
+AcuityFilter::AcuityFilter
+(
+	const ColorSpace&    inColorSpace,
+	const ImageRgbFloat& intermediate,
+	const dword          intermediateRowBegin,
+	ImageRgbFloat&       outImage,
+	const dword          outRowBegin,
+	const dword          imageHeight
+)
+ :	ImageRgbFloat::BilinearVisitor()
+ ,	pInColorSpace_m( &inColorSpace )
+ ,	pIntermediate_m( &intermediate )
+ ,	pOutImage_m    ( &outImage )
+ ,	intermediateRowBegin_m( intermediateRowBegin )
+ ,	outRowBegin_m         ( outRowBegin )
+ ,	imageHeight_m         ( imageHeight )
 {
 }
 
@@ -69,6 +92,9 @@ AcuityFilter::AcuityFilter
  ,	pInColorSpace_m( other.pInColorSpace_m )
  ,	pIntermediate_m( other.pIntermediate_m )
  ,	pOutImage_m    ( other.pOutImage_m )
+ ,	intermediateRowBegin_m( other.intermediateRowBegin_m )
+ ,	outRowBegin_m         ( other.outRowBegin_m )
+ ,	imageHeight_m         ( other.imageHeight_m )
 {
 }
 
@@ -85,6 +111,10 @@ AcuityFilter& AcuityFilter::operator=
 		pInColorSpace_m = other.pInColorSpace_m;
 		pIntermediate_m = other.pIntermediate_m;
 		pOutImage_m     = other.pOutImage_m;
+
+		intermediateRowBegin_m = other.intermediateRowBegin_m;
+		outRowBegin_m          = other.outRowBegin_m;
+		imageHeight_m          = other.imageHeight_m;
 	}
 
 	return *this;
@@ -104,40 +134,19 @@ void AcuityFilter::operate
 	// convolution only simple implementation, optimize later if needed...
 
 	// calc kernel width
-	dword kernelWidth = 1;
-	{
-		using hxa7241_graphics::ColorConstants::getLuminanceMin;
+	const dword kernelWidth = getKernelWidth(
+		pInColorSpace_m->getRgbLuminance( inValue ) );
 
-		// get adaptation luminance
-		// clamp luminance to minimum
-		float fovealLuminance = pInColorSpace_m->getRgbLuminance( inValue );
-		if( fovealLuminance < getLuminanceMin() )
-		{
-			fovealLuminance = getLuminanceMin();
-		}
-
-		// calc acuity at that luminance, in cycles per degree
-		// ~2 <= acuity <= ~50 (for human eye)
-		static const float ACUITY_MAX = 50.0f;
-		float acuity = 17.25f * ::atanf(1.4f * ::log10f(fovealLuminance) +
-			0.35f) + 25.72f;
-		acuity = acuity > ACUITY_MAX ? ACUITY_MAX : acuity;
-
-		// assume original image is at the resolution equivalent to maximum
-		// acuity
-		// (it is not known how many degrees of visual field each pixel of it
-		// will cover when it is displayed)
-		// 'round' into odd integer kernel width
-		const float kernelWidthFp = float(ACUITY_MAX) / acuity;
-		kernelWidth = (dword(kernelWidthFp * 0.5f) * 2) + 1;
-	}
+	// row in whole image, and offset to intermediate rows
+	const dword imageY             = outY + outRowBegin_m;
+	const dword intermediateOffset = -intermediateRowBegin_m;
 
 	// calc filtered value
 	Vector3f outValue;
 	if( kernelWidth <= 1 )
 	{
 		// just copy
-		outValue = pIntermediate_m->get( outX, outY );
+		outValue = pIntermediate_m->get( outX, imageY + intermediateOffset );
 	}
 	else
 	{
@@ -156,17 +165,18 @@ void AcuityFilter::operate
 
 				if( scaling > 0.0f )
 				{
-					const dword okx = outX + kx;
-					const dword oky = outY + ky;
+					const dword okx = outX   + kx;
+					const dword oky = imageY + ky;
 
 					// clamp to image edge
 					if( (okx >= 0) &
 						 (oky >= 0) &
 						 (okx < pOutImage_m->getWidth()) &
-						 (oky < pOutImage_m->getHeight()) )
+						 (oky < imageHeight_m) )
 					{
 						// accumulate scaled pixel value
-						sum += (pIntermediate_m->get( okx, oky ) *= scaling);
+						sum += (pIntermediate_m->get( okx,
+							oky + intermediateOffset ) *= scaling);
 
 						// accumulate non-zero scalings
 						weight += scaling;
@@ -188,11 +198,47 @@ void AcuityFilter::operate
 
 
 /// queries --------------------------------------------------------------------
+dword AcuityFilter::getKernelRadiusMax()
+{
+	// widest kernel is at lowest luminance
+	return getKernelWidth(
+		hxa7241_graphics::ColorConstants::getLuminanceMin() ) / 2;
+}
 
 
 
 
 /// implementation -------------------------------------------------------------
+dword AcuityFilter::getKernelWidth
+(
+	float adaptationLuminance
+)
+{
+	using hxa7241_graphics::ColorConstants::getLuminanceMin;
+
+	// clamp luminance to minimum
+	if( adaptationLuminance < getLuminanceMin() )
+	{
+		adaptationLuminance = getLuminanceMin();
+	}
+
+	// calc acuity at that luminance, in cycles per degree
+	// ~2 <= acuity <= ~50 (for human eye)
+	static const float ACUITY_MAX = 50.0f;
+	float acuity = 17.25f * ::atanf(1.4f * ::log10f(adaptationLuminance) +
+		0.35f) + 25.72f;
+	acuity = acuity > ACUITY_MAX ? ACUITY_MAX : acuity;
+
+	// assume original image is at the resolution equivalent to maximum
+	// acuity
+	// (it is not known how many degrees of visual field each pixel of it
+	// will cover when it is displayed)
+	// 'round' into odd integer kernel width
+	const float kernelWidthFp = float(ACUITY_MAX) / acuity;
+	return (dword(kernelWidthFp * 0.5f) * 2) + 1;
+}
+
+
 float AcuityFilter::coneFilter
 (
 	float       kernelRadius,
@@ -76,6 +76,21 @@ public:
 		AcuityFilter( const ColorSpace&    inColorSpace,
 		              const ImageRgbFloat& intermediate,
 		              ImageRgbFloat&       outImage );
+	/**
+	 * For a band of rows of an image.<br/><br/>
+	 *
+	 * @intermediateRowBegin  image row of intermediate's first row -- it must
+	 *                        hold the out rows plus getKernelRadiusMax rows
+	 *                        around them (where inside the image)
+	 * @outRowBegin           image row of outImage's first row
+	 * @imageHeight           height of the whole image
+	 */
+		AcuityFilter( const ColorSpace&    inColorSpace,
+		              const ImageRgbFloat& intermediate,
+		              dword                intermediateRowBegin,
+		              ImageRgbFloat&       outImage,
+		              dword                outRowBegin,
+		              dword                imageHeight );
 
 	virtual ~AcuityFilter();
 	         AcuityFilter( const AcuityFilter& );
@@ -89,10 +104,15 @@ public:
 
 
 /// queries --------------------------------------------------------------------
+	/**
+	 * Largest kernel radius, in pixels, for any adaptation luminance.
+	 */
+	static  dword getKernelRadiusMax();
 
 
 /// implementation -------------------------------------------------------------
 protected:
+	static  dword getKernelWidth( float adaptationLuminance );
 	static  float coneFilter( float kernelRadius,
 	                          dword x,
 	                          dword y );
@@ -104,6 +124,10 @@ private:
 	const ImageRgbFloat* pIntermediate_m;
 	ImageRgbFloat*       pOutImage_m;
 
+	dword                intermediateRowBegin_m;
+	dword                outRowBegin_m;
+	dword                imageHeight_m;
+
 //	float (*pFilter_m)(float, dword, dword);
 };
 
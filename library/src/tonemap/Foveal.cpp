@@ -29,6 +29,7 @@
 
 
 #include <math.h>
+#include <string.h>
 #include "ImageRgbFloatIter.hpp"
 
 #include "Foveal.hpp"   // own header is included last
@@ -39,14 +40,30 @@ using namespace p3tonemapper_tonemap;
 
 
 
+/// statics
+static const char SOURCE_ROWS_INVALID_MESSAGE[] =
+	"invalid source rows given to Foveal";
+
+
+
+
 /// standard object services ---------------------------------------------------
 Foveal::Foveal
 (
 	const ImageRgbFloat& imageSource
 )
  :	ImageRgbFloat()
+ ,	sourceWidth_m    ( 0 )
+ ,	sourceHeight_m   ( 0 )
+ ,	sourceRowsAdded_m( 0 )
+ ,	rowsDone_m       ( 0 )
+ ,	rowTemp_m        ()
+ ,	rowSums_m        ()
 {
-	Foveal::construct( imageSource, 65.0f );
+	Foveal::construct( imageSource.getWidth(), imageSource.getHeight(),
+		imageSource.getWidth(), imageSource.getHeight(),
+		imageSource.getColorSpace(), 65.0f );
+	Foveal::addSourceRows( imageSource );
 }
 
 
@@ -56,8 +73,59 @@ Foveal::Foveal
 	const float          viewAngleHorizontal
 )
  :	ImageRgbFloat()
+ ,	sourceWidth_m    ( 0 )
+ ,	sourceHeight_m   ( 0 )
+ ,	sourceRowsAdded_m( 0 )
+ ,	rowsDone_m       ( 0 )
+ ,	rowTemp_m        ()
+ ,	rowSums_m        ()
+{
+	Foveal::construct( imageSource.getWidth(), imageSource.getHeight(),
+		imageSource.getWidth(), imageSource.getHeight(),
+		imageSource.getColorSpace(), viewAngleHorizontal );
+	Foveal::addSourceRows( imageSource );
+}
+
+
+Foveal::Foveal
+(
+	const dword       sourceWidth,
+	const dword       sourceHeight,
+	const ColorSpace& sourceColorSpace,
+	const float       viewAngleHorizontal
+)
+ :	ImageRgbFloat()
+ ,	sourceWidth_m    ( 0 )
+ ,	sourceHeight_m   ( 0 )
+ ,	sourceRowsAdded_m( 0 )
+ ,	rowsDone_m       ( 0 )
+ ,	rowTemp_m        ()
+ ,	rowSums_m        ()
+{
+	Foveal::construct( sourceWidth, sourceHeight, sourceWidth, sourceHeight,
+		sourceColorSpace, viewAngleHorizontal );
+}
+
+
+Foveal::Foveal
+(
+	const dword       imageWidth,
+	const dword       imageHeight,
+	const dword       sourceWidth,
+	const dword       sourceHeight,
+	const ColorSpace& sourceColorSpace,
+	const float       viewAngleHorizontal
+)
+ :	ImageRgbFloat()
+ ,	sourceWidth_m    ( 0 )
+ ,	sourceHeight_m   ( 0 )
+ ,	sourceRowsAdded_m( 0 )
+ ,	rowsDone_m       ( 0 )
+ ,	rowTemp_m        ()
+ ,	rowSums_m        ()
 {
-	Foveal::construct( imageSource, viewAngleHorizontal );
+	Foveal::construct( imageWidth, imageHeight, sourceWidth, sourceHeight,
+		sourceColorSpace, viewAngleHorizontal );
 }
 
 
@@ -71,6 +139,12 @@ Foveal::Foveal
 	const Foveal& other
 )
  :	ImageRgbFloat( other )
+ ,	sourceWidth_m    ( other.sourceWidth_m )
+ ,	sourceHeight_m   ( other.sourceHeight_m )
+ ,	sourceRowsAdded_m( other.sourceRowsAdded_m )
+ ,	rowsDone_m       ( other.rowsDone_m )
+ ,	rowTemp_m        ( other.rowTemp_m )
+ ,	rowSums_m        ( other.rowSums_m )
 {
 }
 
@@ -80,7 +154,17 @@ Foveal& Foveal::operator=
 	const Foveal& other
 )
 {
-	ImageRgbFloat::operator=( other );
+	if( &other != this )
+	{
+		ImageRgbFloat::operator=( other );
+
+		sourceWidth_m     = other.sourceWidth_m;
+		sourceHeight_m    = other.sourceHeight_m;
+		sourceRowsAdded_m = other.sourceRowsAdded_m;
+		rowsDone_m        = other.rowsDone_m;
+		rowTemp_m         = other.rowTemp_m;
+		rowSums_m         = other.rowSums_m;
+	}
 
 	return *this;
 }
@@ -89,11 +173,47 @@ Foveal& Foveal::operator=
 
 
 /// commands -------------------------------------------------------------------
+void Foveal::addSourceRows
+(
+	const ImageRgbFloat& sourceRows
+)
+{
+	const dword rowCount = sourceRows.getHeight();
+
+	// check rows fit source
+	if( (sourceRows.getWidth() != sourceWidth_m) |
+		(rowCount > (sourceHeight_m - sourceRowsAdded_m)) )
+	{
+		throw SOURCE_ROWS_INVALID_MESSAGE;
+	}
+
+	const float* pSourceRow = sourceRows.getPixels();
+	for( dword y = 0;  y < rowCount;  ++y, pSourceRow += sourceWidth_m * 3 )
+	{
+		// shrink, if smaller than source
+		if( getWidth() < sourceWidth_m )
+		{
+			Foveal::scaleRow( pSourceRow );
+		}
+		// copy with no scaling
+		else
+		{
+			::memcpy( getPixels() + (sourceRowsAdded_m * sourceWidth_m * 3),
+				pSourceRow, sourceWidth_m * 3 * sizeof(float) );
+		}
+
+		++sourceRowsAdded_m;
+	}
+}
 
 
 
 
 /// queries --------------------------------------------------------------------
+bool Foveal::isComplete() const
+{
+	return sourceRowsAdded_m == sourceHeight_m;
+}
 
 
 
@@ -101,31 +221,56 @@ Foveal& Foveal::operator=
 /// implementation -------------------------------------------------------------
 void Foveal::construct
 (
-	const ImageRgbFloat& imageSource,
-	const float          viewAngleHorizontal
+	const dword       imageWidth,
+	const dword       imageHeight,
+	const dword       sourceWidth,
+	const dword       sourceHeight,
+	const ColorSpace& sourceColorSpace,
+	const float       viewAngleHorizontal
 )
 {
-	// calculate size
+	sourceWidth_m     = sourceWidth;
+	sourceHeight_m    = sourceHeight;
+	sourceRowsAdded_m = 0;
+	rowsDone_m        = 0;
+
+	// calculate size, from image
 	dword widthFoveal;
 	dword heightFoveal;
-	Foveal::calcSize( imageSource, viewAngleHorizontal,
+	Foveal::calcSize( imageWidth, imageHeight, viewAngleHorizontal,
 	                  widthFoveal, heightFoveal );
 
+	// limit to source (only matters if a proxy smaller than image)
+	if( widthFoveal >= sourceWidth )
+	{
+		widthFoveal  = sourceWidth;
+		heightFoveal = sourceHeight;
+	}
+	else if( heightFoveal > sourceHeight )
+	{
+		heightFoveal = sourceHeight;
+	}
+
 	// set image basics
 	ImageRgbFloat::setImage( widthFoveal, heightFoveal );
-	ImageRgbFloat::setColorSpace( imageSource.getColorSpace() );
+	ImageRgbFloat::setColorSpace( sourceColorSpace );
 
-	// scale and copy pixels
-	Foveal::scale( imageSource, widthFoveal, *this );
+	// shrinking needs a row for each pass
+	if( widthFoveal < sourceWidth )
+	{
+		rowTemp_m.setImage( widthFoveal, 1 );
+		rowSums_m.setLength( widthFoveal );
+	}
 }
 
 
 void Foveal::calcSize
 (
-	const ImageRgbFloat& imageSource,
-	float                viewAngleHorizontal,
-	dword&               width,
-	dword&               height
+	const dword sourceWidth,
+	const dword sourceHeight,
+	float       viewAngleHorizontal,
+	dword&      width,
+	dword&      height
 )
 {
 	// minimum: 1 degree == 1 pixel
@@ -145,129 +290,142 @@ void Foveal::calcSize
 		/ ONE_DEGREE_AS_RADIANS) );
 
 	// allow smaller size than source
-	if( width < imageSource.getWidth() )
+	if( width < sourceWidth )
 	{
 		// calc height from aspect ratio
 		height = dword( float(width) *
-			float(imageSource.getHeight()) / float(imageSource.getWidth()) );
+			float(sourceHeight) / float(sourceWidth) );
 	}
 	// disallow larger size than source
 	else
 	{
 		// copy source size
-		width  = imageSource.getWidth();
-		height = imageSource.getHeight();
+		width  = sourceWidth;
+		height = sourceHeight;
 	}
 }
 
 
-void Foveal::scale
+void Foveal::scaleRow
 (
-	const ImageRgbFloat& imageSource,
-	const dword          widthFoveal,
-	ImageRgbFloat&       imageFoveal
+	const float* pSourceRow
 )
 {
-	// precondition: foveal <= source size
+	// precondition: foveal < source width, and row is the next one
 
-//	// calc height from aspect ratio
-//	const dword heightFoveal = dword( float(widthFoveal) *
-//		float(imageSource.getHeight()) / float(imageSource.getWidth()) );
+	// non-integer size box filter.
+	// separated into two passes: horizontal scaling, into a temporary row, and
+	// vertical scaling, accumulated in a row of sums until each foveal row is
+	// complete.
 
-	// shrink, if smaller than source
-	if( widthFoveal < imageSource.getWidth() )
+	// simple and un-optimized both algorithmically and code-wise --
+	// it just needs to weight pixels similarly, not be high quality or fast.
+
+	using p3tonemapper_image::ImageRgbFloatIter;
+	using p3tonemapper_image::ImageRgbFloatIterConst;
+
+	// horizontal pass
 	{
-		// non-integer size box filter.
-		// separated into two passes: horizontal scaling, and vertical scaling,
-		// through an intermediate temporary image.
+		ImageRgbFloatIterConst pSourcePixel( pSourceRow );
+		ImageRgbFloatIter      pTargetPixel( rowTemp_m.getIterator() );
+		const dword            sourceSize = sourceWidth_m;
+		const dword            targetSize = getWidth();
 
-		// simple and un-optimized both algorithmically and code-wise --
-		// it just needs to weight pixels similarly, not be high quality or fast.
+		const float oneOverKernelSize = float(targetSize) / float(sourceSize);
 
-		ImageRgbFloat imageTemp( imageFoveal.getWidth(), imageSource.getHeight() );
+		dword    sourcePixel = 0;
+		Vector3f lastPixelPart;
 
-		// do two passes
-		for( dword pass = 0;  pass < 2;  ++pass )
+		// loop through pixels in target row
+		for( dword targetPixel = 0;  targetPixel < targetSize;  ++targetPixel )
 		{
-			using hxa7241_graphics::Vector3f;
-			using p3tonemapper_image::ImageRgbFloatIter;
-			using p3tonemapper_image::ImageRgbFloatIterConst;
-
-			// for horizontal pass, first
-			ImageRgbFloatIterConst pSourcePixel( imageSource.getIteratorConst() );
-			ImageRgbFloatIter      pTargetPixel( imageTemp.getIterator() );
-			dword                  sourceSize   = imageSource.getWidth();
-			dword                  targetSize   = imageTemp.getWidth();
-			dword                  sourceStep   = 0;
-			dword                  targetStep   = 0;
-			dword                  sourceInc    = 1;
-			dword                  targetInc    = 1;
-			ImageRgbFloatIter   pTargetEnd( pTargetPixel + imageTemp.getLength() );
-
-			// for vertical pass, second
-			if( 1 == pass )
+			Vector3f kernelSum( lastPixelPart );
+
+			// calc loop end with an expression that will not drift, and will
+			// give the exactly correct last source pixel
+			const float endKernel = (float(targetPixel + 1) /
+				float(targetSize)) * float(sourceSize);
+			const dword endPixel  = dword(endKernel);
+			// loop through kernel
+			for( ;  sourcePixel < endPixel;  ++sourcePixel )
 			{
-				pSourcePixel = imageTemp.getIteratorConst();
-				pTargetPixel = imageFoveal.getIterator();
-				sourceSize   = imageTemp.getHeight();
-				targetSize   = imageFoveal.getHeight();
-				sourceStep   = 1 - imageTemp.getLength();
-				targetStep   = 1 - imageFoveal.getLength();
-				sourceInc    = imageTemp.getWidth();
-				targetInc    = imageFoveal.getWidth();
-				pTargetEnd   = pTargetPixel + targetInc;
+				// add source pixel to kernel sum
+				kernelSum += pSourcePixel.get();
+				++pSourcePixel;
 			}
 
-			const float oneOverKernelSize = float(targetSize) / float(sourceSize);
+			if( sourcePixel < sourceSize )
+			{
+				// calc fractions of end pixel
+				const float lastPixelFraction = endKernel - float(endPixel);
+				kernelSum    += (pSourcePixel.get() *= lastPixelFraction);
+				lastPixelPart = (pSourcePixel.get() *= (1.0f - lastPixelFraction));
 
-			// step along sets (rows or columns)
-			for( ;  pTargetPixel < pTargetEnd;
-			     pSourcePixel += sourceStep, pTargetPixel += targetStep )
+				++pSourcePixel;
+				++sourcePixel;
+			}
+
+			// unitize kernel sum, and write to target pixel
+			pTargetPixel.set( kernelSum * oneOverKernelSize );
+			++pTargetPixel;
+		}
+	}
+
+	// vertical pass
+	const dword sourceSize = sourceHeight_m;
+	const dword targetSize = getHeight();
+	if( rowsDone_m < targetSize )
+	{
+		const dword width = getWidth();
+		const dword sourcePixel = sourceRowsAdded_m;
+
+		const float oneOverKernelSize = float(targetSize) / float(sourceSize);
+
+		// calc end of current target row kernel (as horizontal)
+		const float endKernel = (float(rowsDone_m + 1) /
+			float(targetSize)) * float(sourceSize);
+		const dword endPixel  = dword(endKernel);
+
+		ImageRgbFloatIterConst pSourcePixel( rowTemp_m.getIteratorConst() );
+		Vector3f*              pSum = rowSums_m.getMemory();
+
+		// inside kernel: add source row to kernel sums
+		if( sourcePixel < endPixel )
+		{
+			for( dword x = 0;  x < width;  ++x, ++pSourcePixel )
 			{
-				dword    sourcePixel = 0;
-				Vector3f lastPixelPart;
+				pSum[x] += pSourcePixel.get();
+			}
+		}
+		// end of kernel: add fraction, write target row, keep remainder
+		else
+		{
+			ImageRgbFloatIter pTargetPixel( getIterator() + (rowsDone_m * width) );
 
-				// loop through pixels in target set
-				for( dword targetPixel = 0;  targetPixel < targetSize;  ++targetPixel )
-				{
-					Vector3f kernelSum( lastPixelPart );
-
-					// calc loop end with an expression that will not drift, and will
-					// give the exactly correct last source pixel
-					const float endKernel = (float(targetPixel + 1) /
-						float(targetSize)) * float(sourceSize);
-					const dword endPixel  = dword(endKernel);
-					// loop through kernel
-					for( ;  sourcePixel < endPixel;  ++sourcePixel )
-					{
-						// add source pixel to kernel sum
-						kernelSum    += pSourcePixel.get();
-						pSourcePixel += sourceInc;
-					}
+			const float lastPixelFraction = endKernel - float(endPixel);
+			for( dword x = 0;  x < width;  ++x, ++pSourcePixel, ++pTargetPixel )
+			{
+				pSum[x] += (pSourcePixel.get() *= lastPixelFraction);
+				pTargetPixel.set( pSum[x] * oneOverKernelSize );
+				pSum[x]  = (pSourcePixel.get() *= (1.0f - lastPixelFraction));
+			}
 
-					if( sourcePixel < sourceSize )
-					{
-						// calc fractions of end pixel
-						const float lastPixelFraction = endKernel - float(endPixel);
-						kernelSum    += (pSourcePixel.get() *= lastPixelFraction);
-						lastPixelPart = (pSourcePixel.get() *= (1.0f - lastPixelFraction));
+			++rowsDone_m;
+		}
 
-						pSourcePixel += sourceInc;
-						++sourcePixel;
-					}
+		// last source row ends the last kernel
+		if( (sourcePixel + 1 == sourceSize) & (rowsDone_m < targetSize) )
+		{
+			ImageRgbFloatIter pTargetPixel( getIterator() + (rowsDone_m * width) );
 
-					// unitize kernel sum, and write to target pixel
-					pTargetPixel.set( kernelSum * oneOverKernelSize );
-					pTargetPixel += targetInc;
-				}
+			for( dword x = 0;  x < width;  ++x, ++pTargetPixel )
+			{
+				pTargetPixel.set( pSum[x] * oneOverKernelSize );
 			}
+
+			++rowsDone_m;
 		}
 	}
-	// copy with no scaling
-	else
-	{
-		imageFoveal = imageSource;
-	}
 }
 
 
@@ -565,6 +723,72 @@ bool test_Foveal
 	}
 
 
+	// incremental
+	{
+		// make image of diagonal ramp
+		ImageRgbFloat imageOriginal( 311, 211 );
+		{
+			for( dword y = imageOriginal.getHeight();  y-- > 0; )
+			{
+				for( dword x = imageOriginal.getWidth();  x-- > 0; )
+				{
+					imageOriginal.set( x, y, Vector3f( 128.0f, 64.0f, 1.25f ) *
+						(float(x + y) / 522.0f) );
+				}
+			}
+		}
+
+		// shrink image whole
+		const Foveal imageWhole( imageOriginal, 63.5f );
+
+		// shrink image by uneven bands of rows
+		Foveal imageRows( imageOriginal.getWidth(), imageOriginal.getHeight(),
+			imageOriginal.getColorSpace(), 63.5f );
+		bool isFail = imageRows.isComplete();
+		{
+			const dword width = imageOriginal.getWidth();
+			dword       y     = 0;
+			for( dword band = 1;  y < imageOriginal.getHeight();  band += 7 )
+			{
+				if( band > imageOriginal.getHeight() - y )
+				{
+					band = imageOriginal.getHeight() - y;
+				}
+
+				const ImageRgbFloat rows( width, band,
+					imageOriginal.getPixels() + (y * width * 3), false,
+					imageOriginal.getColorSpace() );
+				imageRows.addSourceRows( rows );
+
+				y += band;
+			}
+		}
+		isFail |= !imageRows.isComplete();
+
+		// check same as whole
+		isFail |= (imageWhole.getWidth()  != imageRows.getWidth()) |
+		          (imageWhole.getHeight() != imageRows.getHeight());
+		for( dword i = imageWhole.getLength();  !isFail && (i-- > 0); )
+		{
+			isFail |= !isDiffTolerable( imageWhole.get(i), imageRows.get(i) );
+		}
+
+		// check excess rows are rejected
+		try
+		{
+			imageRows.addSourceRows( ImageRgbFloat( 311, 1 ) );
+			isFail = true;
+		}
+		catch( ... )
+		{
+		}
+
+		if( pOut ) *pOut << "incremental : " <<
+			(!isFail ? "--- succeeded" : "*** failed") << "\n\n";
+		isOk &= !isFail;
+	}
+
+
 	if( pOut ) *pOut << (isOk ? "--- successfully" : "*** failurefully") <<
 		" completed " << "\n\n\n";
 
@@ -32,6 +32,8 @@
 #define Foveal_h
 
 
+#include "Array.hpp"
+#include "Vector3f.hpp"
 #include "ImageRgbFloat.hpp"
 
 
@@ -40,7 +42,10 @@
 #include "p3tonemapper_tonemap.hpp"
 namespace p3tonemapper_tonemap
 {
+	using hxa7241_general::Array;
+	using hxa7241_graphics::Vector3f;
 	using p3tonemapper_image::ImageRgbFloat;
+	using p3tonemapper_image::ColorSpace;
 
 
 /**
@@ -51,6 +56,14 @@ namespace p3tonemapper_tonemap
  *
  * If the source image this is generated from is lower resolution than 1
  * degree per pixel, this image is just a copy, and >1 degree per pixel.
+ * <br/><br/>
+ *
+ * Can be made incrementally: construct with the source size, then add all the
+ * source rows, in order, any number at a time. Only a row of intermediate
+ * sums is held, not the source image.<br/><br/>
+ *
+ * The source can be a smaller proxy of the image (eg a mip level): the size
+ * is then set by the image, but limited by the proxy.
  *
  * @exceptions constructors can throw
  *
@@ -69,6 +82,16 @@ public:
 	explicit Foveal( const ImageRgbFloat& );
 	         Foveal( const ImageRgbFloat&,
 	                 float viewFrustrumHorizontalAngleDegrees );
+	         Foveal( dword             sourceWidth,
+	                 dword             sourceHeight,
+	                 const ColorSpace& sourceColorSpace,
+	                 float             viewFrustrumHorizontalAngleDegrees );
+	         Foveal( dword             imageWidth,
+	                 dword             imageHeight,
+	                 dword             proxySourceWidth,
+	                 dword             proxySourceHeight,
+	                 const ColorSpace& sourceColorSpace,
+	                 float             viewFrustrumHorizontalAngleDegrees );
 
 	virtual ~Foveal();
 	         Foveal( const Foveal& );
@@ -78,27 +101,55 @@ public:
 /// commands -------------------------------------------------------------------
 	// inherit
 
+	/**
+	 * Add the next rows of the source image.
+	 *
+	 * @exceptions throws if width differs, or rows exceed source height
+	 */
+	virtual void  addSourceRows( const ImageRgbFloat& sourceRows );
+
 
 /// queries --------------------------------------------------------------------
 	// inherit
 
+	/**
+	 * Whether all source rows have been added.
+	 */
+	virtual bool  isComplete()                                             const;
+
+	/**
+	 * Size made for an image of the given size.
+	 */
+	static  void  calcSize( dword  imageWidth,
+	                        dword  imageHeight,
+	                        float  viewAngleHorizontal,
+	                        dword& width,
+	                        dword& height );
+
 
 /// implementation -------------------------------------------------------------
 protected:
-	        void  construct( const ImageRgbFloat&,
-	                         float viewAngleHorizontal );
+	        void  construct( dword             imageWidth,
+	                         dword             imageHeight,
+	                         dword             sourceWidth,
+	                         dword             sourceHeight,
+	                         const ColorSpace& sourceColorSpace,
+	                         float             viewAngleHorizontal );
 
-	static  void  calcSize( const ImageRgbFloat& imageSource,
-	                        float                viewAngleHorizontal,
-	                        dword&               width,
-	                        dword&               height );
-	static  void  scale( const ImageRgbFloat& imageSource,
-	                     dword                widthFoveal,
-	                     ImageRgbFloat&       imageFoveal );
+	        void  scaleRow( const float* pSourceRow );
 
 
 /// fields ---------------------------------------------------------------------
 private:
+	// incremental construction state
+	dword           sourceWidth_m;
+	dword           sourceHeight_m;
+	dword           sourceRowsAdded_m;
+	dword           rowsDone_m;
+
+	// horizontally scaled row, and vertical sums
+	ImageRgbFloat   rowTemp_m;
+	Array<Vector3f> rowSums_m;
 };
 
 
@@ -28,15 +28,16 @@
 --------------------------------------------------------------------*/
 
 
-#include <time.h>   /// DEBUG ///
-#include <iostream>   /// DEBUG ///
-
 #include <float.h>
 #include <math.h>
+#include <stddef.h>
 #include <string.h>
 #include <exception>
 
 #include "Clamps.hpp"
+#include "Array.hpp"
+#include "FpEnvironment.hpp"
+#include "HalfFloat.hpp"
 
 #include "Vector3f.hpp"
 #include "ColorConstants.hpp"
@@ -50,6 +51,7 @@
 #include "ColorAdjustment.hpp"
 #include "AcuityFilter.hpp"
 #include "ToneAdjustment.hpp"
+#include "PerceptualMapStream.hpp"
 
 #include "PerceptualMap.hpp"   // own header is included last
 
@@ -59,6 +61,29 @@ using namespace p3tonemapper_tonemap;
 
 
 
+/// statics
+static const char SINK_STOPPED_MESSAGE[] =
+   "mapping stopped by row sink";
+
+static const dword BAND_ROWS = 64;
+
+
+static void copyMessage
+(
+   const char* pMessage,
+   char*       pMessage128
+)
+{
+   if( pMessage128 )
+   {
+      ::strncpy( pMessage128, pMessage, 127 );
+      pMessage128[ 127 ] = 0;
+   }
+}
+
+
+
+
 /// standard object services ---------------------------------------------------
 PerceptualMap::PerceptualMap()
 {
@@ -305,7 +330,7 @@ bool PerceptualMap::map
 (
    const dword  width,
    const dword  height,
-   const dword  ,//inPixelsType,
+   const dword  inPixelsType,
    void*        pInPixels,
    const dword  outPixelsType,
    void*        pOutPixels,
@@ -314,171 +339,451 @@ bool PerceptualMap::map
 ) const
 {
    bool isOk = false;
-   if( pMessage128 )
+   copyMessage( "", pMessage128 );
+
+   // set this thread's fp environment: rounding mode near, no exceptions,
+   // denormals flushed (restored when leaving)
+   const hxa7241_general::FpEnvironment fpEnvironment;
+
+   try
+   {
+      // half input: convert and map a band of rows at a time, without a
+      // whole float image
+      if( RGB_HALF == inPixelsType )
+      {
+         PerceptualMapStream stream( *this, width, height, inPixelsType,
+            outPixelsType );
+         stream.analyseRows( height, pInPixels );
+         stream.mapRows( height, pInPixels, pOutPixels );
+      }
+      // float input: map in place
+      else
+      {
+         mapFloats( width, height, static_cast<float*>(pInPixels),
+            outPixelsType, pOutPixels, false, 0, 0 );
+      }
+
+      isOk = true;
+   }
+   catch( const std::exception& exception )
+   {
+      copyMessage( exception.what(), pMessage128 );
+   }
+   catch( const char*const exceptionString )
+   {
+      copyMessage( exceptionString, pMessage128 );
+   }
+   catch( ... )
    {
-      pMessage128[ 0 ] = 0;
+      copyMessage( "unannotated exception", pMessage128 );
    }
 
-/// DEBUG ///
-clock_t times[20];
-int     ti = 0;
-times[ti] = ::clock();
-std::cout << "start time = " << times[ti++] << "\n";   /// DEBUG ///
+   return isOk;
+}
+
+
+bool PerceptualMap::map
+(
+   const dword         width,
+   const dword         height,
+   const dword         inPixelsType,
+   const p3tmInLayout& inLayout,
+   const dword         outPixelsType,
+   void*               pOutPixels,
+   int*                ,//pAsyncProgress,
+   char*               pMessage128
+) const
+{
+   bool isOk = false;
+   copyMessage( "", pMessage128 );
 
-#ifndef __STRICT_ANSI__
-   // set fp control word: rounding mode near, no exceptions
-   // (This may not be ANSI. If it won't work, remove it (and the other one
-   // below).)
-   const unsigned int fpControlWord =
-      ::_controlfp( _MCW_EM | _RC_NEAR, _MCW_EM | _MCW_RC );
-#endif //__STRICT_ANSI__
+   // set this thread's fp environment (restored when leaving)
+   const hxa7241_general::FpEnvironment fpEnvironment;
 
    try
    {
-      using p3tonemapper_image::ColorSpace;
-      using p3tonemapper_image::ImageRgbFloat;
+      // gather, convert and map a band of rows at a time
+      PerceptualMapStream stream( *this, width, height, inPixelsType,
+         outPixelsType );
+      stream.analyseRows( height, inLayout );
+      stream.mapRows( height, inLayout, pOutPixels );
 
-      // make color transform for original image
-      const ColorSpace colorSpace(
-         inputChromaticities_m, inputWhitePoint_m );
+      isOk = true;
+   }
+   catch( const std::exception& exception )
+   {
+      copyMessage( exception.what(), pMessage128 );
+   }
+   catch( const char*const exceptionString )
+   {
+      copyMessage( exceptionString, pMessage128 );
+   }
+   catch( ... )
+   {
+      copyMessage( "unannotated exception", pMessage128 );
+   }
 
-times[ti] = ::clock();   /// DEBUG ///
-std::cout << "calibrate start = " << times[ti++] << "\n";   /// DEBUG ///
+   return isOk;
+}
 
-      // make wrapper for original image
-      ImageRgbFloat original( width, height, static_cast<float*>(pInPixels),
-         false, colorSpace );
-      if( (1.0f != inputLuminanceScaling_m) | (0.0f != inputLuminanceOffset_m) )
-      {
-         using hxa7241_graphics::Vector3f;
 
-         // scale and offset image
-         const Vector3f offset( Vector3f::ONE() * inputLuminanceOffset_m );
-         for( dword op = original.getLength();  op-- > 0; )
-         {
-            original.set( op,
-               (original.get( op ) *= inputLuminanceScaling_m) += offset );
-         }
+bool PerceptualMap::map
+(
+   const dword       width,
+   const dword       height,
+   const dword       inPixelsType,
+   void*             pInPixels,
+   const dword       outPixelsType,
+   const bool        isLastRowFirst,
+   const p3tmRowSink pRowSink,
+   void*             pSinkContext,
+   char*             pMessage128
+) const
+{
+   bool isOk = false;
+   copyMessage( "", pMessage128 );
+
+   // set this thread's fp environment (restored when leaving)
+   const hxa7241_general::FpEnvironment fpEnvironment;
+
+   try
+   {
+      // half input: map as a stream
+      if( RGB_HALF == inPixelsType )
+      {
+         mapHalfs( width, height, pInPixels, outPixelsType, isLastRowFirst,
+            pRowSink, pSinkContext );
+      }
+      // float input: map in place
+      else
+      {
+         const p3tmOutRows out = { outPixelsType, pRowSink, pSinkContext };
+         mapFloats( width, height, static_cast<float*>(pInPixels),
+            outPixelsType, 0, isLastRowFirst, 1, &out );
       }
 
-times[ti] = ::clock();   /// DEBUG ///
-std::cout << "foveal start = " << times[ti++] << "\n";   /// DEBUG ///
+      isOk = true;
+   }
+   catch( const std::exception& exception )
+   {
+      copyMessage( exception.what(), pMessage128 );
+   }
+   catch( const char*const exceptionString )
+   {
+      copyMessage( exceptionString, pMessage128 );
+   }
+   catch( ... )
+   {
+      copyMessage( "unannotated exception", pMessage128 );
+   }
+
+   return isOk;
+}
+
+
+bool PerceptualMap::map
+(
+   const dword        width,
+   const dword        height,
+   const dword        inPixelsType,
+   void*              pInPixels,
+   const bool         isLastRowFirst,
+   const dword        outCount,
+   const p3tmOutRows* pOuts,
+   char*              pMessage128
+) const
+{
+   bool isOk = false;
+   copyMessage( "", pMessage128 );
 
-      // make foveal image
-      Foveal foveal( original, inputViewAngleHorizontal_m );
+   // set this thread's fp environment (restored when leaving)
+   const hxa7241_general::FpEnvironment fpEnvironment;
 
-      // apply supplementary human limitations
-      const bool isHumanContrast = (mappingFlags_m & HUMAN) != 0;
-      if( isHumanContrast )
+   try
+   {
+      // (no outputs is nothing to do)
+      if( 0 == outCount )
+      {
+      }
+      // half input: convert to a whole float image, then map that
+      else if( RGB_HALF == inPixelsType )
       {
-times[ti] = ::clock();   /// DEBUG ///
-std::cout << "glare start = " << times[ti++] << "\n";   /// DEBUG ///
+         hxa7241_general::Array<float> floats( width * height * 3 );
+         hxa7241_general::halfsToFloats( static_cast<const uword*>(pInPixels),
+            floats.getLength(), floats.getMemory() );
 
-         // glare
-         if( mappingFlags_m & (GLARE & ~CONTRAST) )
-         {
-            Veil veil( foveal );
+         mapFloats( width, height, floats.getMemory(), RGB_BYTE, 0,
+            isLastRowFirst, outCount, pOuts );
+      }
+      // float input: map in place
+      else
+      {
+         mapFloats( width, height, static_cast<float*>(pInPixels), RGB_BYTE,
+            0, isLastRowFirst, outCount, pOuts );
+      }
 
-times[ti] = ::clock();   /// DEBUG ///
-std::cout << "veil mix 1 start= " << times[ti++] << "\n";   /// DEBUG ///
+      isOk = true;
+   }
+   catch( const std::exception& exception )
+   {
+      copyMessage( exception.what(), pMessage128 );
+   }
+   catch( const char*const exceptionString )
+   {
+      copyMessage( exceptionString, pMessage128 );
+   }
+   catch( ... )
+   {
+      copyMessage( "unannotated exception", pMessage128 );
+   }
 
-            veil.mixInto( foveal );
-times[ti] = ::clock();   /// DEBUG ///
-std::cout << "veil mix 2 start = " << times[ti++] << "\n";   /// DEBUG ///
+   return isOk;
+}
 
-            veil.mixInto( original );
-         }
 
-         // color sensitivity
-         if( mappingFlags_m & (COLOR & ~CONTRAST) )
-         {
-times[ti] = ::clock();   /// DEBUG ///
-std::cout << "color start = " << times[ti++] << "\n";   /// DEBUG ///
 
-            ColorAdjustment colorAdjustment(
-               foveal.getColorSpace(), original );
 
-            ImageRgbFloat::visitBilinear( foveal, colorAdjustment,
-               original.getWidth(), original.getHeight() );
-         }
+/// implementation -------------------------------------------------------------
+void PerceptualMap::mapFloats
+(
+   const dword       width,
+   const dword       height,
+   float*            pInPixels,
+   const dword       outPixelsType,
+   void*             pOutPixels,
+   const bool         isLastRowFirst,
+   const dword        outCount,
+   const p3tmOutRows* pOuts
+) const
+{
+   using p3tonemapper_image::ColorSpace;
 
-         // spatial acuity
-         if( mappingFlags_m & (ACUITY & ~CONTRAST) )
-         {
-times[ti] = ::clock();   /// DEBUG ///
-std::cout << "acuity start = " << times[ti++] << "\n";   /// DEBUG ///
+   // select pipeline stages once, for the whole image
+   const HumanLimits applyHuman = getHumanLimits( mappingFlags_m );
 
-            // copy original to temp
-            ImageRgbFloat intermediate( original );
+   // make color transform for original image
+   const ColorSpace colorSpace(
+      inputChromaticities_m, inputWhitePoint_m );
 
-            AcuityFilter acuityFilter(
-               foveal.getColorSpace(), intermediate, original );
+   // make wrapper for original image
+   ImageRgbFloat original( width, height, pInPixels, false, colorSpace );
+   if( (1.0f != inputLuminanceScaling_m) |
+       (0.0f != inputLuminanceOffset_m) )
+   {
+      using hxa7241_graphics::Vector3f;
 
-            ImageRgbFloat::visitBilinear( foveal, acuityFilter,
-               original.getWidth(), original.getHeight() );
-         }
+      // scale and offset image
+      const Vector3f offset( Vector3f::ONE() * inputLuminanceOffset_m );
+      for( dword op = original.getLength();  op-- > 0; )
+      {
+         original.set( op,
+            (original.get( op ) *= inputLuminanceScaling_m) += offset );
       }
+   }
 
-times[ti] = ::clock();   /// DEBUG ///
-std::cout << "general map start = " << times[ti++] << "\n";   /// DEBUG ///
+   // make foveal image
+   Foveal foveal( original, inputViewAngleHorizontal_m );
+
+   // apply supplementary human limitations
+   if( applyHuman )
+   {
+      (*applyHuman)( foveal, original );
+   }
 
+   // make tone adjustment
+   ToneAdjustment toneAdjustment( foveal,
+      outputBlackLuminance_m, outputWhiteLuminance_m, 0 != applyHuman );
+
+   // do main tone mapping, into whole output image
+   if( 0 == outCount )
+   {
       // make wrapper for output image
-      ImageRgbInt outImage( width, height, RGB_WORD == outPixelsType,
+      ImageRgbInt outImage( width, height, RGB_BYTE != outPixelsType,
          false, pOutPixels );
       outImage.setGamma( outputGamma_m );
+      outImage.setWordsBigEndian( RGB_WORD_BE == outPixelsType );
 
-      // do main tone mapping
-      ToneAdjustment toneAdjustment( foveal,
-         outputBlackLuminance_m, outputWhiteLuminance_m,
-         isHumanContrast );
       toneAdjustment.map( original, outImage );
-
-      isOk = true;
    }
-   catch( const std::exception& exception )
+   // or a band of output rows at a time, into each output's sink
+   else
    {
-      if( pMessage128 )
+      // (a band of word rows is room enough for any output)
+      const dword rowBytes = width * 3 * 2;
+      const dword bandRows = height < BAND_ROWS ? height : BAND_ROWS;
+      hxa7241_general::Array<ubyte> bands( rowBytes * bandRows * outCount );
+
+      for( dword r = 0;  r < height;  r += bandRows )
       {
-         ::strncpy( pMessage128, exception.what(), 127 );
-         pMessage128[ 127 ] = 0;
+         const dword rowCount = (height - r) < bandRows ?
+            (height - r) : bandRows;
+
+         // map each input row into every output, while it is at hand
+         for( dword b = 0;  b < rowCount;  ++b )
+         {
+            const dword row = isLastRowFirst ?
+               (height - 1) - (r + b) : (r + b);
+
+            for( dword o = 0;  o < outCount;  ++o )
+            {
+               const bool  isWords  = RGB_BYTE != pOuts[o].pixelsType;
+               const dword outBytes = rowBytes / (isWords ? 1 : 2);
+
+               ImageRgbInt outRow( width, 1, isWords, false, bands.getMemory()
+                  + (o * rowBytes * bandRows) + (b * outBytes) );
+               outRow.setGamma( outputGamma_m );
+               outRow.setWordsBigEndian(
+                  RGB_WORD_BE == pOuts[o].pixelsType );
+
+               toneAdjustment.map( original, row, outRow );
+            }
+         }
+
+         for( dword o = 0;  o < outCount;  ++o )
+         {
+            if( !(*pOuts[o].rowSink)( pOuts[o].sinkContext, rowCount,
+               bands.getMemory() + (o * rowBytes * bandRows) ) )
+            {
+               throw SINK_STOPPED_MESSAGE;
+            }
+         }
       }
    }
-   catch( const char*const exceptionString )
+}
+
+
+void PerceptualMap::mapHalfs
+(
+   const dword       width,
+   const dword       height,
+   const void*       pInPixels,
+   const dword       outPixelsType,
+   const bool        isLastRowFirst,
+   const p3tmRowSink pRowSink,
+   void*             pSinkContext
+) const
+{
+   PerceptualMapStream stream( *this, width, height, RGB_HALF,
+      outPixelsType );
+
+   // lay out input rows in the order to give them
+   const dword rowStride = width * 3 * 2;
+   const ubyte* pFirst = static_cast<const ubyte*>(pInPixels) +
+      (isLastRowFirst ? ptrdiff_t(height - 1) * ptrdiff_t(rowStride) : 0);
+   p3tmInLayout inRows = { { pFirst, pFirst + 2, pFirst + 4 }, 6,
+      isLastRowFirst ? -rowStride : rowStride };
+
+   stream.analyseRows( height, inRows );
+
+   // map a band at a time, into the sink
+   const dword outRowBytes = width * 3 * (RGB_BYTE != outPixelsType ? 2 : 1);
+   hxa7241_general::Array<ubyte> band( outRowBytes *
+      (BAND_ROWS + stream.getLatency()) );
+
+   for( dword r = 0;  r < height;  r += BAND_ROWS )
    {
-      if( pMessage128 )
+      const dword rowCount = (height - r) < BAND_ROWS ?
+         (height - r) : BAND_ROWS;
+
+      const dword rowsOut = stream.mapRows( rowCount, inRows,
+         band.getMemory() );
+      for( dword c = 3;  c-- > 0; )
       {
-         ::strncpy( pMessage128, exceptionString, 127 );
-         pMessage128[ 127 ] = 0;
+         inRows.channels[c] = static_cast<const ubyte*>(inRows.channels[c]) +
+            (ptrdiff_t(rowCount) * ptrdiff_t(inRows.rowStride));
+      }
+
+      if( (0 != rowsOut) &&
+         !(*pRowSink)( pSinkContext, rowsOut, band.getMemory() ) )
+      {
+         throw SINK_STOPPED_MESSAGE;
       }
    }
-   catch( ... )
+}
+
+
+PerceptualMap::HumanLimits PerceptualMap::getHumanLimits
+(
+   const dword mappingFlags
+)
+{
+   // ideal viewer has no human stages
+   HumanLimits humanLimits = 0;
+   if( mappingFlags & HUMAN )
    {
-      if( pMessage128 )
+      // one specialization for each combination of the other human stages
+      switch( mappingFlags & (HUMAN & ~CONTRAST) )
       {
-         ::strncpy( pMessage128, "unannotated exception", 127 );
-         pMessage128[ 127 ] = 0;
+      case 0 :
+         humanLimits = &applyHumanLimits<CONTRAST>;
+         break;
+      case GLARE & ~CONTRAST :
+         humanLimits = &applyHumanLimits<GLARE>;
+         break;
+      case COLOR & ~CONTRAST :
+         humanLimits = &applyHumanLimits<COLOR>;
+         break;
+      case (GLARE | COLOR) & ~CONTRAST :
+         humanLimits = &applyHumanLimits<GLARE | COLOR>;
+         break;
+      case ACUITY & ~CONTRAST :
+         humanLimits = &applyHumanLimits<ACUITY>;
+         break;
+      case (GLARE | ACUITY) & ~CONTRAST :
+         humanLimits = &applyHumanLimits<GLARE | ACUITY>;
+         break;
+      case (COLOR | ACUITY) & ~CONTRAST :
+         humanLimits = &applyHumanLimits<COLOR | ACUITY>;
+         break;
+      default :
+         humanLimits = &applyHumanLimits<HUMAN>;
+         break;
       }
    }
 
-#ifndef __STRICT_ANSI__
-   // restore fp control word
-   ::_controlfp( fpControlWord, 0xFFFFFFFFu );
-#endif //__STRICT_ANSI__
+   return humanLimits;
+}
+
 
-times[ti] = ::clock();   /// DEBUG ///
-std::cout << "end time = " << times[ti++] << "\n";   /// DEBUG ///
-/// DEBUG ///
-std::cout << "\n";   /// DEBUG ///
-std::cout << 0 << "\n";
-clock_t duration = times[ti - 1] - times[0];
-for( int g = 1;  g < ti;  ++g )
+template<dword FEATURES>
+void PerceptualMap::applyHumanLimits
+(
+   Foveal&        foveal,
+   ImageRgbFloat& original
+)
 {
-   std::cout << (((times[g] - times[0]) * 100.0f) / duration) << "  " <<
-      (((times[g] - times[g - 1]) * 100.0f) / duration) << "  " <<
-      (times[g] - times[g - 1]) << "\n";
-}
+   // (conditions are constant, so unused stages compile away)
 
-   return isOk;
+   // glare
+   if( FEATURES & (GLARE & ~CONTRAST) )
+   {
+      Veil veil( foveal );
+
+      veil.mixInto( foveal );
+      veil.mixInto( original );
+   }
+
+   // color sensitivity
+   if( FEATURES & (COLOR & ~CONTRAST) )
+   {
+      ColorAdjustment colorAdjustment( foveal.getColorSpace(), original );
+
+      ImageRgbFloat::visitBilinear( foveal, colorAdjustment,
+         original.getWidth(), original.getHeight() );
+   }
+
+   // spatial acuity
+   if( FEATURES & (ACUITY & ~CONTRAST) )
+   {
+      // copy original to temp
+      ImageRgbFloat intermediate( original );
+
+      AcuityFilter acuityFilter(
+         foveal.getColorSpace(), intermediate, original );
+
+      ImageRgbFloat::visitBilinear( foveal, acuityFilter,
+         original.getWidth(), original.getHeight() );
+   }
 }
 
 
@@ -492,18 +797,46 @@ for( int g = 1;  g < ti;  ++g )
 #ifdef TESTING
 
 
+#include <algorithm>
 #include <ostream>
 
 
+struct RowsGathered
+{
+   hxa7241_general::Array<ubyte>* pRows;
+   dword                          rowBytes;
+   dword                          rowCount;
+   dword                          rowLimit;
+};
+
+static int gatherRows
+(
+   void*       pSinkContext,
+   const int   rowCount,
+   const void* pRows
+)
+{
+   RowsGathered& gathered = *static_cast<RowsGathered*>( pSinkContext );
+
+   const ubyte* pBytes = static_cast<const ubyte*>( pRows );
+   std::copy( pBytes, pBytes + (rowCount * gathered.rowBytes),
+      gathered.pRows->getMemory() + (gathered.rowCount * gathered.rowBytes) );
+   gathered.rowCount += rowCount;
+
+   return gathered.rowCount <= gathered.rowLimit ? 1 : 0;
+}
+
+
 namespace p3tonemapper_tonemap
 {
    using namespace hxa7241;
+   using hxa7241_general::Array;
 
 
 bool test_PerceptualMap
 (
    std::ostream* pOut,
-   const bool    ,//verbose,
+   const bool    isVerbose,
    const dword   //seed
 )
 {
@@ -512,8 +845,199 @@ bool test_PerceptualMap
    if( pOut ) *pOut << "[ test_PerceptualMap ]\n\n";
 
 
-   if( pOut ) *pOut << "!!! not implemented yet\n\n";
-   //isOk = false;
+   // rows to sink same as whole image map
+   {
+      static const dword WIDTH  = 131;
+      static const dword HEIGHT = 150;
+      static const dword LENGTH = WIDTH * HEIGHT * 3;
+
+      // make image of blobs, over a wide luminance range
+      Array<float> image( LENGTH );
+      for( dword i = LENGTH;  i-- > 0; )
+      {
+         const dword x = (i / 3) % WIDTH;
+         const dword y = (i / 3) / WIDTH;
+         image[i] = ::powf( 10.0f, (::sinf( float(x) * 0.05f ) *
+            ::cosf( float(y) * 0.07f ) * 4.0f) + float(i % 3) * 0.1f );
+      }
+
+      for( dword i = 0;  i < 12;  ++i )
+      {
+         const dword outType = i % 3;
+         const dword order   = (i / 3) % 2;
+         const dword flags   = (i / 6) ? PerceptualMap::HUMAN :
+            PerceptualMap::IDEAL;
+
+         bool isFail = false;
+
+         const PerceptualMap mapper( 0, 0, 0, 0.0f, flags, 0, 0.0f );
+         const dword rowBytes = WIDTH * 3 * (outType ? 2 : 1);
+
+         // map whole image
+         Array<ubyte> outWhole( rowBytes * HEIGHT );
+         {
+            Array<float> in( image );
+            isFail |= !mapper.map( WIDTH, HEIGHT, PerceptualMap::RGB_FLOAT,
+               in.getMemory(), outType, outWhole.getMemory(), 0, 0 );
+         }
+
+         // map to sink
+         Array<ubyte> outRows( rowBytes * HEIGHT );
+         RowsGathered gathered = { &outRows, rowBytes, 0, HEIGHT };
+         {
+            Array<float> in( image );
+            isFail |= !mapper.map( WIDTH, HEIGHT, PerceptualMap::RGB_FLOAT,
+               in.getMemory(), outType, 0 != order, gatherRows,
+               &gathered, 0 );
+         }
+         isFail |= (HEIGHT != gathered.rowCount);
+
+         // compare, row for row
+         for( dword y = HEIGHT;  y-- > 0; )
+         {
+            const dword yWhole = order ? (HEIGHT - 1) - y : y;
+            for( dword b = rowBytes;  b-- > 0; )
+            {
+               isFail |= (outWhole[(yWhole * rowBytes) + b] !=
+                  outRows[(y * rowBytes) + b]);
+            }
+         }
+
+         if( pOut && isVerbose ) *pOut << "flags " << flags << "  out " <<
+            outType << "  last row first " << order << "  " << !isFail << "\n";
+
+         isOk &= !isFail;
+      }
+      if( pOut && isVerbose ) *pOut << "\n";
+
+      // sink stopping fails mapping
+      {
+         const PerceptualMap mapper;
+         Array<ubyte> outRows( WIDTH * 3 * HEIGHT );
+         RowsGathered gathered = { &outRows, WIDTH * 3, 0, 1 };
+         Array<float> in( image );
+         char message[128];
+         isOk &= !mapper.map( WIDTH, HEIGHT, PerceptualMap::RGB_FLOAT, in.getMemory(),
+            PerceptualMap::RGB_BYTE, false, gatherRows, &gathered, message );
+         isOk &= (0 != message[0]) & (gathered.rowCount < HEIGHT);
+      }
+
+      if( pOut ) *pOut << "rows to sink : " <<
+         (isOk ? "--- succeeded" : "*** failed") << "\n\n";
+   }
+
+
+   // half rows to sink same as whole image map
+   {
+      bool isFail = false;
+
+      static const dword WIDTH  = 67;
+      static const dword HEIGHT = 141;
+      static const dword LENGTH = WIDTH * HEIGHT * 3;
+
+      // make positive finite halfs
+      Array<uword> halfs( LENGTH );
+      for( dword i = LENGTH;  i-- > 0; )
+      {
+         halfs[i] = uword( (udword(i) * 2654435761u >> 8) % 0x7C00 );
+      }
+
+      const PerceptualMap mapper( 0, 0, 0, 0.0f, PerceptualMap::HUMAN, 0,
+         0.0f );
+      Array<ubyte> outWhole( LENGTH );
+      isFail |= !mapper.map( WIDTH, HEIGHT, PerceptualMap::RGB_HALF,
+         halfs.getMemory(), PerceptualMap::RGB_BYTE, outWhole.getMemory(),
+         0, 0 );
+
+      for( dword order = 0;  order < 2;  ++order )
+      {
+         Array<ubyte> outRows( LENGTH );
+         RowsGathered gathered = { &outRows, WIDTH * 3, 0, HEIGHT };
+         isFail |= !mapper.map( WIDTH, HEIGHT, PerceptualMap::RGB_HALF,
+            halfs.getMemory(), PerceptualMap::RGB_BYTE, 0 != order,
+            gatherRows, &gathered, 0 );
+         isFail |= (HEIGHT != gathered.rowCount);
+
+         // (reversed is mapped from reversed input, so is not compared)
+         for( dword i = LENGTH;  (0 == order) & (i-- > 0); )
+         {
+            isFail |= (outWhole[i] != outRows[i]);
+         }
+      }
+
+      if( pOut ) *pOut << "half rows to sink : " <<
+         (!isFail ? "--- succeeded" : "*** failed") << "\n\n";
+      isOk &= !isFail;
+   }
+
+
+   // several outputs same as each mapped alone
+   {
+      bool isFail = false;
+
+      static const dword WIDTH  = 93;
+      static const dword HEIGHT = 77;
+      static const dword LENGTH = WIDTH * HEIGHT * 3;
+
+      Array<float> image( LENGTH );
+      for( dword i = LENGTH;  i-- > 0; )
+      {
+         const dword x = (i / 3) % WIDTH;
+         const dword y = (i / 3) / WIDTH;
+         image[i] = ::powf( 10.0f, (::sinf( float(x) * 0.09f ) *
+            ::cosf( float(y) * 0.04f ) * 3.0f) + float(i % 3) * 0.2f );
+      }
+
+      for( dword h = 0;  h < 2;  ++h )
+      {
+         const PerceptualMap mapper( 0, 0, 0, 0.0f,
+            h ? PerceptualMap::HUMAN : PerceptualMap::IDEAL, 0, 0.0f );
+
+         // map each output type alone
+         Array<ubyte> outsAlone[3];
+         for( dword t = 0;  t < 3;  ++t )
+         {
+            const dword rowBytes = WIDTH * 3 * (t ? 2 : 1);
+            outsAlone[t].setLength( rowBytes * HEIGHT );
+            RowsGathered gathered = { &outsAlone[t], rowBytes, 0, HEIGHT };
+            Array<float> in( image );
+            isFail |= !mapper.map( WIDTH, HEIGHT, PerceptualMap::RGB_FLOAT,
+               in.getMemory(), t, true, gatherRows, &gathered, 0 );
+         }
+
+         // map all output types together
+         Array<ubyte> outsTogether[3];
+         RowsGathered gathered[3];
+         p3tmOutRows  outs[3];
+         for( dword t = 0;  t < 3;  ++t )
+         {
+            const dword rowBytes = WIDTH * 3 * (t ? 2 : 1);
+            outsTogether[t].setLength( rowBytes * HEIGHT );
+            const RowsGathered g = { &outsTogether[t], rowBytes, 0, HEIGHT };
+            gathered[t] = g;
+            const p3tmOutRows o = { int(t), gatherRows, &gathered[t] };
+            outs[t] = o;
+         }
+         {
+            Array<float> in( image );
+            isFail |= !mapper.map( WIDTH, HEIGHT, PerceptualMap::RGB_FLOAT,
+               in.getMemory(), true, 3, outs, 0 );
+         }
+
+         for( dword t = 0;  t < 3;  ++t )
+         {
+            isFail |= (HEIGHT != gathered[t].rowCount);
+            for( dword i = outsAlone[t].getLength();  i-- > 0; )
+            {
+               isFail |= (outsAlone[t][i] != outsTogether[t][i]);
+            }
+         }
+      }
+
+      if( pOut ) *pOut << "several outputs : " <<
+         (!isFail ? "--- succeeded" : "*** failed") << "\n\n";
+      isOk &= !isFail;
+   }
 
 
    if( pOut ) *pOut << (isOk ? "--- successfully" : "*** failurefully") <<
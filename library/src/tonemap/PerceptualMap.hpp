@@ -34,12 +34,15 @@
 
 #include "p3tmPerceptualMap-v13.h"
 
+#include "p3tonemapper_image.hpp"
+
 
 
 
 #include "p3tonemapper_tonemap.hpp"
 namespace p3tonemapper_tonemap
 {
+   using p3tonemapper_image::ImageRgbFloat;
 
 
 /**
@@ -204,22 +207,27 @@ public:
     * For use with map inPixelsType parameter.
     *
     * @RGB_FLOAT   R then G then B, each is a float
+    * @RGB_HALF    R then G then B, each is a half (16-bit float)
     */
    enum EInPixelOptions
    {
-      RGB_FLOAT = p3tm11_RGB_FLOAT
+      RGB_FLOAT = p3tm11_RGB_FLOAT,
+      RGB_HALF  = p3tm13_RGB_HALF
    };
 
    /**
     * For use with map outPixelsType parameter.
     *
-    * @RGB_BYTE   R then G then B, each is a byte
-    * @RGB_WORD   R then G then B, each is a word
+    * @RGB_BYTE      R then G then B, each is a byte
+    * @RGB_WORD      R then G then B, each is a word
+    * @RGB_WORD_BE   R then G then B, each is a word, most significant byte
+    *                first
     */
    enum EOutPixelOptions
    {
-      RGB_BYTE = p3tm11_RGB_BYTE,
-      RGB_WORD = p3tm11_RGB_WORD
+      RGB_BYTE    = p3tm11_RGB_BYTE,
+      RGB_WORD    = p3tm11_RGB_WORD,
+      RGB_WORD_BE = p3tm13_RGB_WORD_BE
    };
 
    /**
@@ -235,6 +243,14 @@ public:
     * @pMessage128     string for exception message 128 chars long
     *
     * @return  is successful
+    *
+    * Float input pixels are used in place (so are modified). Half input pixels
+    * are only read: they are mapped as a PerceptualMapStream, so only a
+    * window of rows is ever converted to float.
+    *
+    * Reentrant: concurrent calls, on the same or separate mappers, are safe.
+    * The mapper is only read, and each call sets, and afterwards restores,
+    * the fp environment of its own thread.
     */
    virtual bool  map( dword  width,
                       dword  height,
@@ -244,6 +260,102 @@ public:
                       void*  pOutPixels,
                       int*   pAsyncProgress,
                       char*  pMessage128 )                                const;
+   /**
+    * Map an image, with input in any layout.<br/><br/>
+    *
+    * Input pixels are only read: they are mapped as a PerceptualMapStream,
+    * gathering a window of rows at a time.
+    *
+    * @inLayout  where the input channels are (see p3tmInLayout)
+    *
+    * (other parameters as above)
+    */
+   virtual bool  map( dword               width,
+                      dword               height,
+                      dword               inPixelsType,
+                      const p3tmInLayout& inLayout,
+                      dword               outPixelsType,
+                      void*               pOutPixels,
+                      int*                pAsyncProgress,
+                      char*               pMessage128 )                   const;
+   /**
+    * Map an image, giving the output a band of rows at a time to a sink,
+    * instead of into a whole output image.<br/><br/>
+    *
+    * Analysis is as the first map (so the result is the same), but only a
+    * band of output rows is ever held.
+    *
+    * @isLastRowFirst  give rows from the last to the first (half input is
+    *                  then mapped from its rows reversed, which can differ
+    *                  in the least bit)
+    * @pRowSink        receiver of each band of packed output rows
+    * @pSinkContext    given to pRowSink
+    *
+    * (other parameters as above)
+    */
+   virtual bool  map( dword       width,
+                      dword       height,
+                      dword       inPixelsType,
+                      void*       pInPixels,
+                      dword       outPixelsType,
+                      bool        isLastRowFirst,
+                      p3tmRowSink pRowSink,
+                      void*       pSinkContext,
+                      char*       pMessage128 )                           const;
+   /**
+    * Map an image into several outputs at once, each a band of rows at a time
+    * to its own sink.<br/><br/>
+    *
+    * Analysis is done once for all; then each input row is mapped into every
+    * output in turn, so the input is passed over only once. Each output is
+    * the same as the previous map with its pixels type.
+    *
+    * Half input is first converted to a whole float image (so, unlike the
+    * previous map, can differ from it in the least bit).
+    *
+    * @outCount  number of outputs
+    * @pOuts     array of outCount outputs (see p3tmOutRows)
+    *
+    * (other parameters as above)
+    */
+   virtual bool  map( dword              width,
+                      dword              height,
+                      dword              inPixelsType,
+                      void*              pInPixels,
+                      bool               isLastRowFirst,
+                      dword              outCount,
+                      const p3tmOutRows* pOuts,
+                      char*              pMessage128 )                    const;
+
+
+/// implementation -------------------------------------------------------------
+protected:
+           void  mapFloats( dword              width,
+                            dword              height,
+                            float*             pInPixels,
+                            dword              outPixelsType,
+                            void*              pOutPixels,
+                            bool               isLastRowFirst,
+                            dword              outCount,
+                            const p3tmOutRows* pOuts )                    const;
+           void  mapHalfs( dword       width,
+                           dword       height,
+                           const void* pInPixels,
+                           dword       outPixelsType,
+                           bool        isLastRowFirst,
+                           p3tmRowSink pRowSink,
+                           void*       pSinkContext )                     const;
+
+   // (a sweep shares the human stages between variants)
+   friend class PerceptualMapSweep;
+
+   typedef void (*HumanLimits)( Foveal&, ImageRgbFloat& );
+
+   static  HumanLimits getHumanLimits( dword mappingFlags );
+
+   template<dword FEATURES>
+   static  void  applyHumanLimits( Foveal&        foveal,
+                                   ImageRgbFloat& original );
 
 
 /// fields ---------------------------------------------------------------------
@@ -0,0 +1,1652 @@
+/*--------------------------------------------------------------------
+
+   Perceptuum3 rendering components
+   Copyright (c) 2005-2007, Harrison Ainsworth / HXA7241.
+
+   http://www.hxa7241.org/
+
+--------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later
+   version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+   MA  02110-1301  USA
+
+--------------------------------------------------------------------*/
+
+
+
+#include <stddef.h>
+#include <string.h>
+
+#include "Array.hpp"
+#include "Clamps.hpp"
+#include "FpEnvironment.hpp"
+#include "HalfFloat.hpp"
+
+#include "Vector3f.hpp"
+
+#include "ImageRgbInt.hpp"
+
+#include "Foveal.hpp"
+#include "Veil.hpp"
+#include "ColorAdjustment.hpp"
+#include "AcuityFilter.hpp"
+#include "ToneAdjustment.hpp"
+#include "PerceptualMap.hpp"
+
+#include "PerceptualMapStream.hpp"   // own header is included last
+
+
+using namespace p3tonemapper_tonemap;
+
+
+
+
+/// statics
+static const char SIZE_INVALID_MESSAGE[] =
+   "invalid image size given to PerceptualMapStream";
+static const char ROWS_INVALID_MESSAGE[] =
+   "invalid rows given to PerceptualMapStream";
+static const char PIXELS_TYPE_INVALID_MESSAGE[] =
+   "invalid input pixels type given to PerceptualMapStream";
+static const char SINK_STOPPED_MESSAGE[] =
+   "mapping stopped by row sink";
+
+const dword PerceptualMapStream::BAND_ROWS = 64;
+
+
+
+
+/// standard object services ---------------------------------------------------
+PerceptualMapStream::PerceptualMapStream
+(
+   const PerceptualMap& mapper,
+   const dword          width,
+   const dword          height,
+   const dword          inPixelsType,
+   const dword          outPixelsType
+)
+ : width_m                ( width )
+ , height_m               ( height )
+ , inPixelsType_m         ( inPixelsType )
+ , outPixelsType_m        ( outPixelsType )
+ , outRowStride_m         ( width * 3 *
+                            (PerceptualMap::RGB_BYTE != outPixelsType ? 2 : 1) )
+ , colorSpace_m           ()
+ , viewAngleHorizontal_m  ( 0.0f )
+ , inputLuminanceScaling_m( 1.0f )
+ , inputLuminanceOffset_m ( 0.0f )
+ , mappingFlags_m         ( 0 )
+ , outputBlackLuminance_m ( 0.0f )
+ , outputWhiteLuminance_m ( 0.0f )
+ , outputGamma_m          ( 0.0f )
+ , proxyWidth_m           ( width )
+ , proxyHeight_m          ( height )
+ , pFoveal_m              ( 0 )
+ , pVeil_m                ( 0 )
+ , pToneAdjustment_m      ( 0 )
+ , acuityRadius_m         ( 0 )
+ , window_m               ()
+ , acuityBand_m           ()
+ , rowsAnalysed_m         ( 0 )
+ , windowTop_m            ( 0 )
+ , rowsIn_m               ( 0 )
+ , rowsOut_m              ( 0 )
+{
+   if( (width < 1) | (height < 1) )
+   {
+      throw SIZE_INVALID_MESSAGE;
+   }
+   if( (PerceptualMap::RGB_FLOAT != inPixelsType) &
+       (PerceptualMap::RGB_HALF  != inPixelsType) )
+   {
+      throw PIXELS_TYPE_INVALID_MESSAGE;
+   }
+
+   // copy options
+   float chromaticities[6];
+   float whitePoint[2];
+   float scalingAndOffset[2];
+   float outLuminanceRange[2];
+   mapper.getOptions( chromaticities, whitePoint, scalingAndOffset,
+      &viewAngleHorizontal_m, &mappingFlags_m, outLuminanceRange,
+      &outputGamma_m );
+
+   colorSpace_m            = ColorSpace( chromaticities, whitePoint );
+   inputLuminanceScaling_m = scalingAndOffset[0];
+   inputLuminanceOffset_m  = scalingAndOffset[1];
+   outputBlackLuminance_m  = outLuminanceRange[0];
+   outputWhiteLuminance_m  = outLuminanceRange[1];
+
+   // acuity filter needs rows above and below
+   if( mappingFlags_m & (PerceptualMap::ACUITY & ~PerceptualMap::CONTRAST) )
+   {
+      acuityRadius_m = AcuityFilter::getKernelRadiusMax();
+      acuityBand_m.setImage( width, BAND_ROWS );
+      acuityBand_m.setColorSpace( colorSpace_m );
+   }
+
+   // window of rows: a band, with room for the filter radius either side
+   window_m.setImage( width, hxa7241_general::clampMax(
+      height, (acuityRadius_m * 2) + BAND_ROWS ) );
+   window_m.setColorSpace( colorSpace_m );
+
+   pFoveal_m = new Foveal( width, height, colorSpace_m,
+      viewAngleHorizontal_m );
+}
+
+
+PerceptualMapStream::~PerceptualMapStream()
+{
+   delete pToneAdjustment_m;
+   delete pVeil_m;
+   delete pFoveal_m;
+}
+
+
+
+
+/// commands -------------------------------------------------------------------
+void PerceptualMapStream::setProxy
+(
+   const dword proxyWidth,
+   const dword proxyHeight
+)
+{
+   if( (proxyWidth < 1) | (proxyWidth > width_m) |
+       (proxyHeight < 1) | (proxyHeight > height_m) )
+   {
+      throw SIZE_INVALID_MESSAGE;
+   }
+   if( 0 != rowsAnalysed_m )
+   {
+      throw ROWS_INVALID_MESSAGE;
+   }
+
+   // remake foveal: sized by image, filled from proxy
+   Foveal* pFoveal = new Foveal( width_m, height_m, proxyWidth, proxyHeight,
+      colorSpace_m, viewAngleHorizontal_m );
+   delete pFoveal_m;
+   pFoveal_m = pFoveal;
+
+   proxyWidth_m  = proxyWidth;
+   proxyHeight_m = proxyHeight;
+}
+
+
+void PerceptualMapStream::setOutRowStride
+(
+   const dword rowStride
+)
+{
+   outRowStride_m = rowStride;
+}
+
+
+void PerceptualMapStream::setOutPixelsType
+(
+   const dword outPixelsType
+)
+{
+   outPixelsType_m = outPixelsType;
+   outRowStride_m  = width_m * 3 *
+      (PerceptualMap::RGB_BYTE != outPixelsType ? 2 : 1);
+}
+
+
+void PerceptualMapStream::analyseRows
+(
+   const dword rowCount,
+   const void* pInRows
+)
+{
+   PerceptualMapStream::analyseRows( rowCount,
+      getPackedLayout( pInRows, proxyWidth_m ) );
+}
+
+
+void PerceptualMapStream::analyseRows
+(
+   const dword         rowCount,
+   const p3tmInLayout& inRows
+)
+{
+   // set this thread's fp environment (restored when leaving)
+   const hxa7241_general::FpEnvironment fpEnvironment;
+
+   // check rows fit image (or proxy)
+   if( rowCount > (proxyHeight_m - rowsAnalysed_m) )
+   {
+      throw ROWS_INVALID_MESSAGE;
+   }
+
+   // (window is unused until pass two, so hold copies of input rows there)
+   for( dword given = 0;  given < rowCount; )
+   {
+      const dword count = hxa7241_general::clampMax( rowCount - given,
+         window_m.getHeight() );
+
+      // (wrapped before being read into, so clamped only as the whole image
+      // would be, whatever rows are given at a time)
+      ImageRgbFloat rows( proxyWidth_m, count, window_m.getPixels(), false,
+         colorSpace_m );
+      readRows( inRows, given, count, proxyWidth_m, window_m.getPixels() );
+      clampRows( proxyWidth_m, proxyHeight_m, rowsAnalysed_m, count,
+         window_m.getPixels() );
+      scaleRows( rows );
+
+      // accumulate into foveal image
+      pFoveal_m->addSourceRows( rows );
+
+      rowsAnalysed_m += count;
+      given          += count;
+
+      // make veil and tone curve when all rows are in
+      if( proxyHeight_m == rowsAnalysed_m )
+      {
+         finishAnalysis();
+      }
+   }
+}
+
+
+dword PerceptualMapStream::mapRows
+(
+   const dword rowCount,
+   const void* pInRows,
+   void*       pOutRows
+)
+{
+   return PerceptualMapStream::mapRows( rowCount,
+      getPackedLayout( pInRows, width_m ),
+      pOutRows );
+}
+
+
+dword PerceptualMapStream::mapRows
+(
+   const dword         rowCount,
+   const p3tmInLayout& inRows,
+   void*               pOutRows
+)
+{
+   // set this thread's fp environment (restored when leaving)
+   const hxa7241_general::FpEnvironment fpEnvironment;
+
+   // check analysis done, and rows fit image
+   if( !isAnalysed() | (rowCount > (height_m - rowsIn_m)) )
+   {
+      throw ROWS_INVALID_MESSAGE;
+   }
+
+   const dword  rowLength   = width_m * 3;
+   ubyte*       pOut        = static_cast<ubyte*>( pOutRows );
+
+   dword rowsOutput = 0;
+   for( dword given = 0;  given < rowCount; )
+   {
+      // when window is full, drop rows no longer needed
+      if( (rowsIn_m - windowTop_m) == window_m.getHeight() )
+      {
+         const dword keepTop = rowsOut_m > acuityRadius_m ?
+            rowsOut_m - acuityRadius_m : 0;
+         ::memmove( window_m.getPixels(),
+            window_m.getPixels() + ((keepTop - windowTop_m) * rowLength),
+            (rowsIn_m - keepTop) * rowLength * sizeof(float) );
+         windowTop_m = keepTop;
+      }
+
+      // copy next rows into window
+      const dword windowRow = rowsIn_m - windowTop_m;
+      const dword count     = hxa7241_general::clampMax( rowCount - given,
+         window_m.getHeight() - windowRow );
+      float*const pRows     = window_m.getPixels() + (windowRow * rowLength);
+
+      // (wrapped before being read into, so clamped only as the whole image
+      // would be, whatever rows are given at a time)
+      ImageRgbFloat rows( width_m, count, pRows, false, colorSpace_m );
+      readRows( inRows, given, count, width_m, pRows );
+      clampRows( width_m, height_m, rowsIn_m, count, pRows );
+
+      // apply per-pixel stages
+      scaleRows( rows );
+      applyHumanRows( rows, rowsIn_m );
+
+      rowsIn_m += count;
+      given    += count;
+
+      // map rows that have all the rows below they need
+      const dword rowsReady = (height_m == rowsIn_m) ? height_m :
+         (rowsIn_m > acuityRadius_m ? rowsIn_m - acuityRadius_m : 0);
+      while( rowsOut_m < rowsReady )
+      {
+         const dword bandEnd = hxa7241_general::clampMax( rowsReady,
+            rowsOut_m + BAND_ROWS );
+         mapBand( rowsOut_m, bandEnd, pOut +
+            (ptrdiff_t(rowsOutput) * ptrdiff_t(outRowStride_m)) );
+
+         rowsOutput += bandEnd - rowsOut_m;
+         rowsOut_m   = bandEnd;
+      }
+   }
+
+   return rowsOutput;
+}
+
+
+void PerceptualMapStream::mapImage
+(
+   void*             pInPixels,
+   const bool        isLastRowFirst,
+   const p3tmRowSink pRowSink,
+   void*             pSinkContext,
+   void*             pOutPixels
+)
+{
+   // set this thread's fp environment (restored when leaving)
+   const hxa7241_general::FpEnvironment fpEnvironment;
+
+   // check analysis done, and no rows mapped yet
+   if( !isAnalysed() | (0 != rowsIn_m) )
+   {
+      throw ROWS_INVALID_MESSAGE;
+   }
+   if( PerceptualMap::RGB_FLOAT != inPixelsType_m )
+   {
+      throw PIXELS_TYPE_INVALID_MESSAGE;
+   }
+
+   // apply per-pixel stages to the whole image, in place
+   ImageRgbFloat original( width_m, height_m, static_cast<float*>(pInPixels),
+      false, colorSpace_m );
+   scaleRows( original );
+   applyHumanRows( original, 0 );
+
+   // spatial acuity
+   if( 0 != acuityRadius_m )
+   {
+      // copy original to temp
+      ImageRgbFloat intermediate( original );
+
+      AcuityFilter acuityFilter(
+         pFoveal_m->getColorSpace(), intermediate, original );
+
+      ImageRgbFloat::visitBilinear( *pFoveal_m, acuityFilter,
+         width_m, height_m );
+   }
+
+   rowsIn_m  = height_m;
+   rowsOut_m = height_m;
+
+   // tone map: into the whole output image
+   const bool  isWords  = PerceptualMap::RGB_BYTE != outPixelsType_m;
+   const dword rowBytes = width_m * 3 * (isWords ? 2 : 1);
+   if( !pRowSink & !isLastRowFirst )
+   {
+      ImageRgbInt outImage( width_m, height_m, isWords, false, pOutPixels );
+      outImage.setGamma( outputGamma_m );
+      outImage.setWordsBigEndian(
+         PerceptualMap::RGB_WORD_BE == outPixelsType_m );
+
+      pToneAdjustment_m->map( original, outImage );
+   }
+   // or a band of rows at a time, into the sink, or the output image
+   else
+   {
+      hxa7241_general::Array<ubyte> band( pRowSink ? rowBytes * BAND_ROWS :
+         0 );
+
+      for( dword r = 0;  r < height_m;  r += BAND_ROWS )
+      {
+         const dword rowCount = hxa7241_general::clampMax( height_m - r,
+            BAND_ROWS );
+         ubyte*const pBand    = pRowSink ? band.getMemory() :
+            static_cast<ubyte*>(pOutPixels) +
+            (ptrdiff_t(r) * ptrdiff_t(rowBytes));
+
+         for( dword b = 0;  b < rowCount;  ++b )
+         {
+            const dword row = isLastRowFirst ?
+               (height_m - 1) - (r + b) : (r + b);
+
+            ImageRgbInt outRow( width_m, 1, isWords, false,
+               pBand + (b * rowBytes) );
+            outRow.setGamma( outputGamma_m );
+            outRow.setWordsBigEndian(
+               PerceptualMap::RGB_WORD_BE == outPixelsType_m );
+
+            pToneAdjustment_m->map( original, row, outRow );
+         }
+
+         if( pRowSink && !(*pRowSink)( pSinkContext, rowCount, pBand ) )
+         {
+            throw SINK_STOPPED_MESSAGE;
+         }
+      }
+   }
+}
+
+
+
+
+/// queries --------------------------------------------------------------------
+bool PerceptualMapStream::isAnalysed() const
+{
+   return proxyHeight_m == rowsAnalysed_m;
+}
+
+
+dword PerceptualMapStream::getLatency() const
+{
+   return acuityRadius_m;
+}
+
+
+void PerceptualMapStream::getFovealSize
+(
+   dword& width,
+   dword& height
+) const
+{
+   // (as sized by the image, whatever the proxy)
+   Foveal::calcSize( width_m, height_m, viewAngleHorizontal_m, width, height );
+}
+
+
+
+
+/// implementation -------------------------------------------------------------
+p3tmInLayout PerceptualMapStream::getPackedLayout
+(
+   const void* pInRows,
+   const dword rowWidth
+) const
+{
+   const dword channelSize = (PerceptualMap::RGB_HALF == inPixelsType_m) ?
+      sizeof(uword) : sizeof(float);
+   const ubyte* pChannel0  = static_cast<const ubyte*>( pInRows );
+
+   p3tmInLayout layout;
+   layout.channels[0] = pChannel0;
+   layout.channels[1] = pChannel0 + channelSize;
+   layout.channels[2] = pChannel0 + (channelSize * 2);
+   layout.pixelStep   = channelSize * 3;
+   layout.rowStride   = channelSize * 3 * rowWidth;
+
+   return layout;
+}
+
+
+void PerceptualMapStream::readRows
+(
+   const p3tmInLayout& inRows,
+   const dword         rowBegin,
+   const dword         rowCount,
+   const dword         rowWidth,
+   float*              pWindowRows
+) const
+{
+   const bool  isHalf      = (PerceptualMap::RGB_HALF == inPixelsType_m);
+   const dword channelSize = isHalf ? sizeof(uword) : sizeof(float);
+   const ubyte* pChannels[3];
+   for( dword c = 3;  c-- > 0; )
+   {
+      pChannels[c] = static_cast<const ubyte*>( inRows.channels[c] );
+   }
+
+   // packed RGB rows: copy or convert whole rows
+   if( (inRows.pixelStep == (channelSize * 3)) &
+       (pChannels[1] == (pChannels[0] + channelSize)) &
+       (pChannels[2] == (pChannels[0] + (channelSize * 2))) )
+   {
+      const dword rowLength = rowWidth * 3;
+      for( dword y = rowBegin;  y < (rowBegin + rowCount);  ++y )
+      {
+         const ubyte* pRow = pChannels[0] +
+            (ptrdiff_t(y) * ptrdiff_t(inRows.rowStride));
+
+         if( isHalf )
+         {
+            hxa7241_general::halfsToFloats(
+               reinterpret_cast<const uword*>( pRow ), rowLength,
+               pWindowRows );
+         }
+         else
+         {
+            ::memcpy( pWindowRows, pRow, rowLength * sizeof(float) );
+         }
+
+         pWindowRows += rowLength;
+      }
+   }
+   // anything else: gather channels
+   else
+   {
+      for( dword y = rowBegin;  y < (rowBegin + rowCount);  ++y )
+      {
+         const ptrdiff_t rowOffset = ptrdiff_t(y) *
+            ptrdiff_t(inRows.rowStride);
+
+         for( dword c = 0;  c < 3;  ++c )
+         {
+            const ubyte* pChannel = pChannels[c] + rowOffset;
+            float*       pOut     = pWindowRows + c;
+
+            for( dword x = rowWidth;  x-- > 0;
+               pChannel += inRows.pixelStep, pOut += 3 )
+            {
+               *pOut = isHalf ?
+                  hxa7241_general::halfToFloat(
+                     *reinterpret_cast<const uword*>( pChannel ) ) :
+                  *reinterpret_cast<const float*>( pChannel );
+            }
+         }
+
+         pWindowRows += rowWidth * 3;
+      }
+   }
+}
+
+
+void PerceptualMapStream::clampRows
+(
+   const dword width,
+   const dword height,
+   const dword rowBegin,
+   const dword rowCount,
+   float*      pRows
+) const
+{
+   // clamp values as wrapping the whole image (or proxy), of width and
+   // height, clamps them: only its first length values (a third)
+   // (offsets in the whole image can pass dword range)
+   const ptrdiff_t rowLength   = ptrdiff_t(width) * 3;
+   const ptrdiff_t imageLength = ptrdiff_t(width) * ptrdiff_t(height);
+   const ptrdiff_t begin       = ptrdiff_t(rowBegin) * rowLength;
+   const ptrdiff_t rowsEnd     = begin + (ptrdiff_t(rowCount) * rowLength);
+   const ptrdiff_t end         = rowsEnd < imageLength ? rowsEnd :
+      imageLength;
+
+   for( ptrdiff_t i = begin;  i < end;  ++i )
+   {
+      pRows[i - begin] = hxa7241_general::clamp_( pRows[i - begin], 0.0f,
+         FLOAT_LARGE );
+   }
+}
+
+
+void PerceptualMapStream::scaleRows
+(
+   ImageRgbFloat& rows
+) const
+{
+   if( (1.0f != inputLuminanceScaling_m) | (0.0f != inputLuminanceOffset_m) )
+   {
+      using hxa7241_graphics::Vector3f;
+
+      // scale and offset image
+      const Vector3f offset( Vector3f::ONE() * inputLuminanceOffset_m );
+      for( dword op = rows.getLength();  op-- > 0; )
+      {
+         rows.set( op,
+            (rows.get( op ) *= inputLuminanceScaling_m) += offset );
+      }
+   }
+}
+
+
+void PerceptualMapStream::finishAnalysis()
+{
+   // glare: make veil, and mix into foveal
+   if( mappingFlags_m & (PerceptualMap::GLARE & ~PerceptualMap::CONTRAST) )
+   {
+      pVeil_m = new Veil( *pFoveal_m );
+      pVeil_m->mixInto( *pFoveal_m );
+   }
+
+   // make tone curve
+   pToneAdjustment_m = new ToneAdjustment( *pFoveal_m,
+      outputBlackLuminance_m, outputWhiteLuminance_m,
+      0 != (mappingFlags_m & PerceptualMap::HUMAN) );
+}
+
+
+void PerceptualMapStream::applyHumanRows
+(
+   ImageRgbFloat& rows,
+   const dword    rowBegin
+) const
+{
+   // glare
+   if( pVeil_m )
+   {
+      pVeil_m->mixInto( rows, height_m, rowBegin );
+   }
+
+   // color sensitivity
+   if( mappingFlags_m & (PerceptualMap::COLOR & ~PerceptualMap::CONTRAST) )
+   {
+      ColorAdjustment colorAdjustment( pFoveal_m->getColorSpace(), rows );
+
+      ImageRgbFloat::visitBilinear( *pFoveal_m, colorAdjustment,
+         width_m, height_m, rowBegin, rowBegin + rows.getHeight() );
+   }
+}
+
+
+void PerceptualMapStream::mapBand
+(
+   const dword rowBegin,
+   const dword rowEnd,
+   void*const  pOutRows
+)
+{
+   // precondition: window holds rows rowBegin - acuityRadius_m to
+   // rowEnd + acuityRadius_m (where inside the image)
+
+   const dword rowCount  = rowEnd - rowBegin;
+   const dword rowLength = width_m * 3;
+
+   // spatial acuity: filter from window into band, then tone map band
+   // (else tone map straight from window)
+   // (rows are tone mapped from where they are held, not re-wrapped, since
+   // wrapping would clamp them again)
+   const ImageRgbFloat& rows = (0 != acuityRadius_m) ? acuityBand_m :
+      window_m;
+   const dword rowTop = (0 != acuityRadius_m) ? 0 : rowBegin - windowTop_m;
+   if( 0 != acuityRadius_m )
+   {
+      // (wrapped before being filtered into)
+      ImageRgbFloat band( width_m, rowCount, acuityBand_m.getPixels(), false,
+         colorSpace_m );
+      AcuityFilter acuityFilter( pFoveal_m->getColorSpace(),
+         window_m, windowTop_m, band, rowBegin, height_m );
+
+      ImageRgbFloat::visitBilinear( *pFoveal_m, acuityFilter,
+         width_m, height_m, rowBegin, rowEnd );
+   }
+
+   // tone map into output rows: all at once when packed, else row by row
+   const bool  isWords  = PerceptualMap::RGB_BYTE != outPixelsType_m;
+   const dword rowBytes = rowLength * (isWords ? 2 : 1);
+   const dword rowsEach = (rowBytes == outRowStride_m) ? rowCount : 1;
+   for( dword r = 0;  r < rowCount;  r += rowsEach )
+   {
+      ImageRgbInt outRows( width_m, rowsEach, isWords, false,
+         static_cast<ubyte*>(pOutRows) + (r * outRowStride_m) );
+      outRows.setGamma( outputGamma_m );
+      outRows.setWordsBigEndian(
+         PerceptualMap::RGB_WORD_BE == outPixelsType_m );
+
+      pToneAdjustment_m->map( rows, rowTop + r, outRows );
+   }
+}
+
+
+
+
+
+
+
+
+/// test -----------------------------------------------------------------------
+#ifdef TESTING
+
+
+#include <math.h>
+#include <ostream>
+
+#include "Array.hpp"
+
+
+static dword random_m;
+
+static void setRand( const dword seed )
+{
+   random_m = seed;
+}
+
+static dword getRand()
+{
+   random_m = dword(1664525) * random_m + dword(1013904223);
+   return random_m;
+}
+
+static float getRand01()
+{
+   return float(udword(getRand())) / 4294967296.0f;
+}
+
+
+namespace
+{
+
+struct RowsCollected
+{
+   ubyte* pNext;
+   dword  rowBytes;
+};
+
+int collectRows
+(
+   void*       pContext,
+   const int   rowCount,
+   const void* pRows
+)
+{
+   RowsCollected& collected = *static_cast<RowsCollected*>( pContext );
+   ::memcpy( collected.pNext, pRows, rowCount * collected.rowBytes );
+   collected.pNext += rowCount * collected.rowBytes;
+
+   return 1;
+}
+
+}
+
+
+namespace p3tonemapper_tonemap
+{
+   using namespace hxa7241;
+   using hxa7241_general::Array;
+
+
+bool test_PerceptualMapStream
+(
+   std::ostream* pOut,
+   const bool    isVerbose,
+   const dword   seed
+)
+{
+   bool isOk = true;
+
+   if( pOut ) *pOut << "[ test_PerceptualMapStream ]\n\n";
+
+
+   setRand( seed );
+
+   // same as whole image map
+   {
+      static const dword WIDTH  = 301;
+      static const dword HEIGHT = 211;
+
+      // make image of random blobs, over a wide luminance range
+      Array<float> image( WIDTH * HEIGHT * 3 );
+      {
+         for( dword y = HEIGHT;  y-- > 0; )
+         {
+            for( dword x = WIDTH;  x-- > 0; )
+            {
+               const float blob = ::sinf( float(x) * 0.05f ) *
+                  ::cosf( float(y) * 0.07f );
+               for( dword c = 3;  c-- > 0; )
+               {
+                  image[((y * WIDTH) + x) * 3 + c] = ::powf( 10.0f,
+                     (blob * 4.0f) + (getRand01() * 0.5f) - 1.0f );
+               }
+            }
+         }
+      }
+
+      static const dword FLAGS[] = { PerceptualMap::IDEAL,
+         PerceptualMap::CONTRAST, PerceptualMap::GLARE, PerceptualMap::COLOR,
+         PerceptualMap::ACUITY, PerceptualMap::HUMAN };
+
+      for( dword f = sizeof(FLAGS) / sizeof(FLAGS[0]);  f-- > 0; )
+      {
+         for( dword outType = 0;  outType < 2;  ++outType )
+         {
+            bool isFail = false;
+
+            const float scaling[2] = { 0.5f, 0.01f };
+            const PerceptualMap mapper( 0, 0, scaling, 0.0f, FLAGS[f], 0,
+               0.0f );
+            const dword outRowBytes = WIDTH * 3 * (outType ? 2 : 1);
+
+            // map whole image
+            Array<ubyte> outWhole( outRowBytes * HEIGHT );
+            {
+               Array<float> in( image );
+               isFail |= !mapper.map( WIDTH, HEIGHT, PerceptualMap::RGB_FLOAT,
+                  in.getMemory(), outType, outWhole.getMemory(), 0, 0 );
+            }
+
+            // map by uneven bands of rows
+            Array<ubyte> outRows( outRowBytes * HEIGHT );
+            try
+            {
+               PerceptualMapStream stream( mapper, WIDTH, HEIGHT,
+                  PerceptualMap::RGB_FLOAT, outType );
+
+               // pass one
+               for( dword y = 0, band = 1;  y < HEIGHT;  y += band, band += 3 )
+               {
+                  band = band > (HEIGHT - y) ? (HEIGHT - y) : band;
+                  stream.analyseRows( band, image.getMemory() +
+                     (y * WIDTH * 3) );
+               }
+               isFail |= !stream.isAnalysed();
+
+               // pass two
+               dword rowsOut = 0;
+               for( dword y = 0, band = 50;  y < HEIGHT;  y += band, band -= 7 )
+               {
+                  band = band > (HEIGHT - y) ? (HEIGHT - y) : band;
+                  band = band < 1 ? 1 : band;
+                  const dword count = stream.mapRows( band,
+                     image.getMemory() + (y * WIDTH * 3),
+                     outRows.getMemory() + (rowsOut * outRowBytes) );
+
+                  isFail |= (rowsOut + count) < (y + band) -
+                     stream.getLatency();
+                  rowsOut += count;
+               }
+               isFail |= (HEIGHT != rowsOut);
+            }
+            catch( ... )
+            {
+               isFail = true;
+            }
+
+            // compare
+            dword diffs = 0;
+            for( dword i = outWhole.getLength();  i-- > 0; )
+            {
+               diffs += dword(outWhole[i] != outRows[i]);
+            }
+            isFail |= (0 != diffs);
+
+            if( pOut && isVerbose ) *pOut << "flags " << FLAGS[f] <<
+               "  out " << outType << "  diffs " << diffs << "\n";
+
+            isOk &= !isFail;
+         }
+      }
+      if( pOut && isVerbose ) *pOut << "\n";
+
+      if( pOut ) *pOut << "same as whole : " <<
+         (isOk ? "--- succeeded" : "*** failed") << "\n\n";
+   }
+
+
+   // values out of range, in any bands of rows, same as whole image map
+   // (clamped as the whole image is, whatever rows are given at a time)
+   {
+      bool isFail = false;
+
+      static const dword WIDTH  = 120;
+      static const dword HEIGHT = 90;
+      static const dword LENGTH = WIDTH * HEIGHT * 3;
+
+      // make random image, with some negative values
+      Array<float> image( LENGTH );
+      for( dword i = LENGTH;  i-- > 0; )
+      {
+         image[i] = (0 == (getRand() % 20)) ? -(getRand01() * 100.0f) :
+            ::powf( 10.0f, (getRand01() * 5.0f) - 2.0f );
+      }
+
+      static const dword FLAGS[] = { PerceptualMap::CONTRAST,
+         PerceptualMap::HUMAN };
+      static const dword BANDS[] = { HEIGHT, 1, 7, 31 };
+
+      for( dword f = sizeof(FLAGS) / sizeof(FLAGS[0]);  f-- > 0; )
+      {
+         for( dword outType = 0;  outType < 2;  ++outType )
+         {
+            const PerceptualMap mapper( 0, 0, 0, 0.0f, FLAGS[f], 0, 0.0f );
+            const dword outRowBytes = WIDTH * 3 * (outType ? 2 : 1);
+
+            // map whole image
+            Array<ubyte> outWhole( outRowBytes * HEIGHT );
+            {
+               Array<float> in( image );
+               isFail |= !mapper.map( WIDTH, HEIGHT, PerceptualMap::RGB_FLOAT,
+                  in.getMemory(), outType, outWhole.getMemory(), 0, 0 );
+            }
+
+            // map by bands of rows, in both passes
+            for( dword b = sizeof(BANDS) / sizeof(BANDS[0]);  b-- > 0; )
+            {
+               Array<ubyte> outRows( outRowBytes * HEIGHT );
+               try
+               {
+                  PerceptualMapStream stream( mapper, WIDTH, HEIGHT,
+                     PerceptualMap::RGB_FLOAT, outType );
+
+                  for( dword y = 0;  y < HEIGHT;  y += BANDS[b] )
+                  {
+                     stream.analyseRows( hxa7241_general::clampMax( BANDS[b],
+                        HEIGHT - y ), image.getMemory() + (y * WIDTH * 3) );
+                  }
+
+                  dword rowsOut = 0;
+                  for( dword y = 0;  y < HEIGHT;  y += BANDS[b] )
+                  {
+                     rowsOut += stream.mapRows( hxa7241_general::clampMax(
+                        BANDS[b], HEIGHT - y ), image.getMemory() +
+                        (y * WIDTH * 3), outRows.getMemory() +
+                        (rowsOut * outRowBytes) );
+                  }
+                  isFail |= (HEIGHT != rowsOut);
+               }
+               catch( ... )
+               {
+                  isFail = true;
+               }
+
+               dword diffs = 0;
+               for( dword i = outWhole.getLength();  i-- > 0; )
+               {
+                  diffs += dword(outWhole[i] != outRows[i]);
+               }
+               isFail |= (0 != diffs);
+
+               if( pOut && isVerbose ) *pOut << "flags " << FLAGS[f] <<
+                  "  out " << outType << "  band " << BANDS[b] << "  diffs " <<
+                  diffs << "\n";
+            }
+         }
+      }
+      if( pOut && isVerbose ) *pOut << "\n";
+
+      if( pOut ) *pOut << "out of range : " <<
+         (!isFail ? "--- succeeded" : "*** failed") << "\n\n";
+      isOk &= !isFail;
+   }
+
+
+   // half input same as float input
+   {
+      bool isFail = false;
+
+      static const dword WIDTH  = 97;
+      static const dword HEIGHT = 75;
+      static const dword LENGTH = WIDTH * HEIGHT * 3;
+
+      // make random positive finite halfs, and the same as floats
+      Array<uword> halfs( LENGTH );
+      Array<float> floats( LENGTH );
+      for( dword i = LENGTH;  i-- > 0; )
+      {
+         halfs[i] = uword( (getRand() >> 8) % 0x7C00 );
+      }
+      hxa7241_general::halfsToFloats( halfs.getMemory(), LENGTH,
+         floats.getMemory() );
+
+      const PerceptualMap mapper( 0, 0, 0, 0.0f, PerceptualMap::HUMAN, 0,
+         0.0f );
+      Array<ubyte> outFloat( LENGTH );
+      Array<ubyte> outHalf( LENGTH );
+      isFail |= !mapper.map( WIDTH, HEIGHT, PerceptualMap::RGB_FLOAT,
+         floats.getMemory(), PerceptualMap::RGB_BYTE, outFloat.getMemory(),
+         0, 0 );
+      isFail |= !mapper.map( WIDTH, HEIGHT, PerceptualMap::RGB_HALF,
+         halfs.getMemory(), PerceptualMap::RGB_BYTE, outHalf.getMemory(),
+         0, 0 );
+
+      for( dword i = LENGTH;  i-- > 0; )
+      {
+         isFail |= (outFloat[i] != outHalf[i]);
+      }
+
+      if( pOut ) *pOut << "half input : " <<
+         (!isFail ? "--- succeeded" : "*** failed") << "\n\n";
+      isOk &= !isFail;
+   }
+
+
+   // signed half input, whole or in bands, same as float input
+   // (clamped as the whole float image is)
+   {
+      bool isFail = false;
+
+      static const dword WIDTH  = 89;
+      static const dword HEIGHT = 67;
+      static const dword LENGTH = WIDTH * HEIGHT * 3;
+
+      // make random finite halfs, some negative, and the same as floats
+      Array<uword> halfs( LENGTH );
+      Array<float> floats( LENGTH );
+      for( dword i = LENGTH;  i-- > 0; )
+      {
+         halfs[i] = uword( ((getRand() >> 8) % 0x7C00) |
+            ((0 == (getRand() % 16)) ? 0x8000 : 0) );
+      }
+      hxa7241_general::halfsToFloats( halfs.getMemory(), LENGTH,
+         floats.getMemory() );
+
+      const PerceptualMap mapper( 0, 0, 0, 0.0f, PerceptualMap::CONTRAST, 0,
+         0.0f );
+
+      for( dword outType = 0;  outType < 2;  ++outType )
+      {
+         const dword outLength = LENGTH * (outType ? 2 : 1);
+
+         // map floats (a copy, since it is modified)
+         Array<ubyte> outFloat( outLength );
+         {
+            Array<float> in( floats );
+            isFail |= !mapper.map( WIDTH, HEIGHT, PerceptualMap::RGB_FLOAT,
+               in.getMemory(), outType, outFloat.getMemory(), 0, 0 );
+         }
+
+         // map halfs whole
+         Array<ubyte> outHalf( outLength );
+         isFail |= !mapper.map( WIDTH, HEIGHT, PerceptualMap::RGB_HALF,
+            halfs.getMemory(), outType, outHalf.getMemory(), 0, 0 );
+
+         // map halfs by uneven bands of rows
+         Array<ubyte> outRows( outLength );
+         try
+         {
+            PerceptualMapStream stream( mapper, WIDTH, HEIGHT,
+               PerceptualMap::RGB_HALF, outType );
+
+            for( dword y = 0, band = 2;  y < HEIGHT;  y += band, band += 5 )
+            {
+               band = band > (HEIGHT - y) ? (HEIGHT - y) : band;
+               stream.analyseRows( band, halfs.getMemory() +
+                  (y * WIDTH * 3) );
+            }
+
+            dword rowsOut = 0;
+            for( dword y = 0, band = 13;  y < HEIGHT;  y += band )
+            {
+               band = band > (HEIGHT - y) ? (HEIGHT - y) : band;
+               rowsOut += stream.mapRows( band, halfs.getMemory() +
+                  (y * WIDTH * 3), outRows.getMemory() +
+                  (rowsOut * (outLength / HEIGHT)) );
+            }
+            isFail |= (HEIGHT != rowsOut);
+         }
+         catch( ... )
+         {
+            isFail = true;
+         }
+
+         dword diffsHalf = 0;
+         dword diffsRows = 0;
+         for( dword i = outLength;  i-- > 0; )
+         {
+            diffsHalf += dword(outFloat[i] != outHalf[i]);
+            diffsRows += dword(outFloat[i] != outRows[i]);
+         }
+         isFail |= (0 != diffsHalf) | (0 != diffsRows);
+
+         if( pOut && isVerbose ) *pOut << "out " << outType <<
+            "  whole diffs " << diffsHalf << "  bands diffs " << diffsRows <<
+            "\n";
+      }
+      if( pOut && isVerbose ) *pOut << "\n";
+
+      if( pOut ) *pOut << "signed half input : " <<
+         (!isFail ? "--- succeeded" : "*** failed") << "\n\n";
+      isOk &= !isFail;
+   }
+
+
+   // input layouts same as packed
+   {
+      bool isFail = false;
+
+      static const dword WIDTH  = 53;
+      static const dword HEIGHT = 41;
+      static const dword LENGTH = WIDTH * HEIGHT * 3;
+
+      // make random half-exact image, packed
+      Array<uword> halfs( LENGTH );
+      Array<float> floats( LENGTH );
+      for( dword i = LENGTH;  i-- > 0; )
+      {
+         halfs[i] = uword( (getRand() >> 8) % 0x7C00 );
+      }
+      hxa7241_general::halfsToFloats( halfs.getMemory(), LENGTH,
+         floats.getMemory() );
+
+      const PerceptualMap mapper( 0, 0, 0, 0.0f, PerceptualMap::HUMAN, 0,
+         0.0f );
+
+      // map packed (a copy, since it is modified)
+      Array<ubyte> outPacked( LENGTH );
+      {
+         Array<float> in( floats );
+         isFail |= !mapper.map( WIDTH, HEIGHT, PerceptualMap::RGB_FLOAT,
+            in.getMemory(), PerceptualMap::RGB_BYTE, outPacked.getMemory(),
+            0, 0 );
+      }
+
+      // make other layouts:
+      // RGBA floats padded rows, BGR floats bottom-up, planar floats,
+      // RGBA halfs
+      static const dword PITCH = (WIDTH * 4) + 5;
+      Array<float> rgba  ( PITCH * HEIGHT );
+      Array<float> bgr   ( LENGTH );
+      Array<float> planar( LENGTH );
+      Array<uword> rgbaH ( WIDTH * 4 * HEIGHT );
+      for( dword y = HEIGHT;  y-- > 0; )
+      {
+         for( dword x = WIDTH;  x-- > 0; )
+         {
+            for( dword c = 3;  c-- > 0; )
+            {
+               const dword i = (((y * WIDTH) + x) * 3) + c;
+               rgba  [(y * PITCH) + (x * 4) + c] = floats[i];
+               bgr   [(((HEIGHT - 1 - y) * WIDTH) + x) * 3 + (2 - c)] =
+                  floats[i];
+               planar[(c * WIDTH * HEIGHT) + (y * WIDTH) + x] = floats[i];
+               rgbaH [(((y * WIDTH) + x) * 4) + c] = halfs[i];
+            }
+         }
+      }
+
+      p3tmInLayout layouts[4];
+      {
+         const float* pRgba = rgba.getMemory();
+         const p3tmInLayout l0 = { { pRgba, pRgba + 1, pRgba + 2 },
+            sizeof(float) * 4, sizeof(float) * PITCH };
+         layouts[0] = l0;
+
+         const float* pBgr = bgr.getMemory() + ((HEIGHT - 1) * WIDTH * 3);
+         const p3tmInLayout l1 = { { pBgr + 2, pBgr + 1, pBgr },
+            sizeof(float) * 3, -dword(sizeof(float) * WIDTH * 3) };
+         layouts[1] = l1;
+
+         const float* pPlanar = planar.getMemory();
+         const p3tmInLayout l2 = { { pPlanar, pPlanar + (WIDTH * HEIGHT),
+            pPlanar + (WIDTH * HEIGHT * 2) }, sizeof(float),
+            sizeof(float) * WIDTH };
+         layouts[2] = l2;
+
+         const uword* pRgbaH = rgbaH.getMemory();
+         const p3tmInLayout l3 = { { pRgbaH, pRgbaH + 1, pRgbaH + 2 },
+            sizeof(uword) * 4, sizeof(uword) * 4 * WIDTH };
+         layouts[3] = l3;
+      }
+
+      for( dword l = 0;  l < 4;  ++l )
+      {
+         Array<ubyte> out( LENGTH );
+         isFail |= !mapper.map( WIDTH, HEIGHT, (3 == l) ?
+            PerceptualMap::RGB_HALF : PerceptualMap::RGB_FLOAT, layouts[l],
+            PerceptualMap::RGB_BYTE, out.getMemory(), 0, 0 );
+
+         dword diffs = 0;
+         for( dword i = LENGTH;  i-- > 0; )
+         {
+            diffs += dword(out[i] != outPacked[i]);
+         }
+         isFail |= (0 != diffs);
+
+         if( pOut && isVerbose ) *pOut << "layout " << l << "  diffs " <<
+            diffs << "\n";
+      }
+      if( pOut && isVerbose ) *pOut << "\n";
+
+      if( pOut ) *pOut << "layouts : " <<
+         (!isFail ? "--- succeeded" : "*** failed") << "\n\n";
+      isOk &= !isFail;
+   }
+
+
+   // input layouts, with values out of range, same as packed
+   // (clamped as the packed whole image is, whatever the layout)
+   {
+      bool isFail = false;
+
+      static const dword WIDTH  = 61;
+      static const dword HEIGHT = 47;
+      static const dword LENGTH = WIDTH * HEIGHT * 3;
+
+      // make random image, with some negative values, packed
+      Array<float> floats( LENGTH );
+      for( dword i = LENGTH;  i-- > 0; )
+      {
+         floats[i] = (0 == (getRand() % 16)) ? -(getRand01() * 10.0f) :
+            ::powf( 10.0f, (getRand01() * 4.0f) - 1.0f );
+      }
+
+      // make other layouts:
+      // RGBA floats padded rows, BGR floats bottom-up, planar floats
+      static const dword PITCH = (WIDTH * 4) + 3;
+      Array<float> rgba  ( PITCH * HEIGHT );
+      Array<float> bgr   ( LENGTH );
+      Array<float> planar( LENGTH );
+      for( dword y = HEIGHT;  y-- > 0; )
+      {
+         for( dword x = WIDTH;  x-- > 0; )
+         {
+            for( dword c = 3;  c-- > 0; )
+            {
+               const dword i = (((y * WIDTH) + x) * 3) + c;
+               rgba  [(y * PITCH) + (x * 4) + c] = floats[i];
+               bgr   [(((HEIGHT - 1 - y) * WIDTH) + x) * 3 + (2 - c)] =
+                  floats[i];
+               planar[(c * WIDTH * HEIGHT) + (y * WIDTH) + x] = floats[i];
+            }
+         }
+      }
+
+      p3tmInLayout layouts[3];
+      {
+         const float* pRgba = rgba.getMemory();
+         const p3tmInLayout l0 = { { pRgba, pRgba + 1, pRgba + 2 },
+            sizeof(float) * 4, sizeof(float) * PITCH };
+         layouts[0] = l0;
+
+         const float* pBgr = bgr.getMemory() + ((HEIGHT - 1) * WIDTH * 3);
+         const p3tmInLayout l1 = { { pBgr + 2, pBgr + 1, pBgr },
+            sizeof(float) * 3, -dword(sizeof(float) * WIDTH * 3) };
+         layouts[1] = l1;
+
+         const float* pPlanar = planar.getMemory();
+         const p3tmInLayout l2 = { { pPlanar, pPlanar + (WIDTH * HEIGHT),
+            pPlanar + (WIDTH * HEIGHT * 2) }, sizeof(float),
+            sizeof(float) * WIDTH };
+         layouts[2] = l2;
+      }
+
+      const PerceptualMap mapper( 0, 0, 0, 0.0f, PerceptualMap::CONTRAST, 0,
+         0.0f );
+
+      for( dword outType = 0;  outType < 2;  ++outType )
+      {
+         const dword outLength = LENGTH * (outType ? 2 : 1);
+
+         // map packed (a copy, since it is modified)
+         Array<ubyte> outPacked( outLength );
+         {
+            Array<float> in( floats );
+            isFail |= !mapper.map( WIDTH, HEIGHT, PerceptualMap::RGB_FLOAT,
+               in.getMemory(), outType, outPacked.getMemory(), 0, 0 );
+         }
+
+         for( dword l = 0;  l < 3;  ++l )
+         {
+            Array<ubyte> out( outLength );
+            isFail |= !mapper.map( WIDTH, HEIGHT, PerceptualMap::RGB_FLOAT,
+               layouts[l], outType, out.getMemory(), 0, 0 );
+
+            dword diffs = 0;
+            for( dword i = outLength;  i-- > 0; )
+            {
+               diffs += dword(out[i] != outPacked[i]);
+            }
+            isFail |= (0 != diffs);
+
+            if( pOut && isVerbose ) *pOut << "out " << outType <<
+               "  layout " << l << "  diffs " << diffs << "\n";
+         }
+      }
+      if( pOut && isVerbose ) *pOut << "\n";
+
+      if( pOut ) *pOut << "layouts out of range : " <<
+         (!isFail ? "--- succeeded" : "*** failed") << "\n\n";
+      isOk &= !isFail;
+   }
+
+
+   // output big-endian words, rows top first, same as packed
+   {
+      bool isFail = false;
+
+      static const dword WIDTH  = 67;
+      static const dword HEIGHT = 150;
+      static const dword LENGTH = WIDTH * HEIGHT * 3;
+
+      Array<float> image( LENGTH );
+      for( dword i = LENGTH;  i-- > 0; )
+      {
+         image[i] = ::powf( 10.0f, (getRand01() * 5.0f) - 2.0f );
+      }
+
+      static const dword FLAGS[] = { PerceptualMap::HUMAN,
+         PerceptualMap::CONTRAST };
+      for( dword f = sizeof(FLAGS) / sizeof(FLAGS[0]);  f-- > 0; )
+      {
+         const PerceptualMap mapper( 0, 0, 0, 0.0f, FLAGS[f], 0, 0.0f );
+
+         // map packed, native words
+         Array<uword> outPacked( LENGTH );
+         {
+            Array<float> in( image );
+            isFail |= !mapper.map( WIDTH, HEIGHT, PerceptualMap::RGB_FLOAT,
+               in.getMemory(), PerceptualMap::RGB_WORD,
+               outPacked.getMemory(), 0, 0 );
+         }
+
+         // map big-endian, last row first
+         static const dword ROW_BYTES = WIDTH * 3 * sizeof(uword);
+         Array<ubyte> outFlipped( ROW_BYTES * HEIGHT );
+         try
+         {
+            PerceptualMapStream stream( mapper, WIDTH, HEIGHT,
+               PerceptualMap::RGB_FLOAT, PerceptualMap::RGB_WORD_BE );
+            stream.setOutRowStride( -ROW_BYTES );
+
+            stream.analyseRows( HEIGHT, image.getMemory() );
+            isFail |= (HEIGHT != stream.mapRows( HEIGHT, image.getMemory(),
+               outFlipped.getMemory() + ((HEIGHT - 1) * ROW_BYTES) ));
+         }
+         catch( ... )
+         {
+            isFail = true;
+         }
+
+         dword diffs = 0;
+         for( dword y = HEIGHT;  y-- > 0; )
+         {
+            for( dword i = WIDTH * 3;  i-- > 0; )
+            {
+               const ubyte* pBytes = outFlipped.getMemory() +
+                  ((HEIGHT - 1 - y) * ROW_BYTES) + (i * 2);
+               const uword  word   = uword( (pBytes[0] << 8) | pBytes[1] );
+               diffs += dword(word != outPacked[(y * WIDTH * 3) + i]);
+            }
+         }
+         isFail |= (0 != diffs);
+
+         if( pOut && isVerbose ) *pOut << "flags " << FLAGS[f] <<
+            "  diffs " << diffs << "\n";
+      }
+      if( pOut && isVerbose ) *pOut << "\n";
+
+      if( pOut ) *pOut << "out layout : " <<
+         (!isFail ? "--- succeeded" : "*** failed") << "\n\n";
+      isOk &= !isFail;
+   }
+
+
+   // analysis from proxy close to analysis from image
+   {
+      bool isFail = false;
+
+      static const dword WIDTH  = 320;
+      static const dword HEIGHT = 240;
+
+      // make image of random blobs, and half-size proxy by box filtering
+      Array<float> image( WIDTH * HEIGHT * 3 );
+      Array<float> proxy( (WIDTH / 2) * (HEIGHT / 2) * 3 );
+      {
+         for( dword y = HEIGHT;  y-- > 0; )
+         {
+            for( dword x = WIDTH;  x-- > 0; )
+            {
+               const float blob = ::sinf( float(x) * 0.03f ) *
+                  ::cosf( float(y) * 0.04f );
+               for( dword c = 3;  c-- > 0; )
+               {
+                  image[((y * WIDTH) + x) * 3 + c] = ::powf( 10.0f,
+                     (blob * 3.0f) + (getRand01() * 0.5f) );
+               }
+            }
+         }
+
+         for( dword i = proxy.getLength();  i-- > 0; )
+         {
+            proxy[i] = 0.0f;
+         }
+         for( dword y = HEIGHT;  y-- > 0; )
+         {
+            for( dword x = WIDTH;  x-- > 0; )
+            {
+               for( dword c = 3;  c-- > 0; )
+               {
+                  proxy[((((y / 2) * (WIDTH / 2)) + (x / 2)) * 3) + c] +=
+                     image[((y * WIDTH) + x) * 3 + c] * 0.25f;
+               }
+            }
+         }
+      }
+
+      const PerceptualMap mapper( 0, 0, 0, 0.0f, PerceptualMap::HUMAN, 0,
+         0.0f );
+
+      // map from whole image analysis, and from proxy analysis
+      Array<ubyte> outs[2];
+      for( dword p = 0;  p < 2;  ++p )
+      {
+         outs[p].setLength( WIDTH * HEIGHT * 3 );
+         try
+         {
+            PerceptualMapStream stream( mapper, WIDTH, HEIGHT,
+               PerceptualMap::RGB_FLOAT, PerceptualMap::RGB_BYTE );
+
+            // check proxy is big enough for the test
+            dword fovealWidth  = 0;
+            dword fovealHeight = 0;
+            stream.getFovealSize( fovealWidth, fovealHeight );
+            isFail |= (fovealWidth > (WIDTH / 2)) |
+               (fovealHeight > (HEIGHT / 2));
+
+            if( 0 == p )
+            {
+               stream.analyseRows( HEIGHT, image.getMemory() );
+            }
+            else
+            {
+               stream.setProxy( WIDTH / 2, HEIGHT / 2 );
+               stream.analyseRows( HEIGHT / 2, proxy.getMemory() );
+            }
+            isFail |= !stream.isAnalysed();
+
+            isFail |= (HEIGHT != stream.mapRows( HEIGHT, image.getMemory(),
+               outs[p].getMemory() ));
+         }
+         catch( ... )
+         {
+            isFail = true;
+         }
+      }
+
+      // compare: mean difference within a level
+      float meanDiff = 0.0f;
+      for( dword i = outs[0].getLength();  i-- > 0; )
+      {
+         meanDiff += ::fabsf( float(outs[0][i]) - float(outs[1][i]) );
+      }
+      meanDiff /= float(outs[0].getLength());
+      isFail |= !(meanDiff < 2.0f);
+
+      if( pOut && isVerbose ) *pOut << "proxy mean diff " << meanDiff <<
+         "\n\n";
+
+      if( pOut ) *pOut << "proxy : " <<
+         (!isFail ? "--- succeeded" : "*** failed") << "\n\n";
+      isOk &= !isFail;
+   }
+
+
+   // whole image mapped after its rows are analysed, same as whole image map
+   // (with values out of range, clamped as the whole image is)
+   {
+      bool isFail = false;
+
+      static const dword WIDTH  = 67;
+      static const dword HEIGHT = 59;
+      static const dword LENGTH = WIDTH * HEIGHT * 3;
+
+      Array<float> image( LENGTH );
+      for( dword i = LENGTH;  i-- > 0; )
+      {
+         const dword r = getRand() % 64;
+         image[i] = (0 == r) ? -1.0f : ((1 == r) ? 1.0e+20f :
+            ::powf( 10.0f, (getRand01() * 6.0f) - 2.0f ));
+      }
+
+      static const dword FLAGS[] = { PerceptualMap::IDEAL,
+         PerceptualMap::HUMAN };
+
+      for( dword f = sizeof(FLAGS) / sizeof(FLAGS[0]);  f-- > 0; )
+      {
+         const PerceptualMap mapper( 0, 0, 0, 0.0f, FLAGS[f], 0, 0.0f );
+
+         // map whole image
+         Array<ubyte> outWhole( LENGTH );
+         {
+            Array<float> in( image );
+            isFail |= !mapper.map( WIDTH, HEIGHT, PerceptualMap::RGB_FLOAT,
+               in.getMemory(), PerceptualMap::RGB_BYTE, outWhole.getMemory(),
+               0, 0 );
+         }
+
+         // analyse a row at a time, then map the image: into the output,
+         // first or last row first, or into a sink
+         for( dword way = 0;  way < 3;  ++way )
+         {
+            const bool isLastRowFirst = 0 != way;
+
+            Array<ubyte> out( LENGTH );
+            try
+            {
+               PerceptualMapStream stream( mapper, WIDTH, HEIGHT,
+                  PerceptualMap::RGB_FLOAT, PerceptualMap::RGB_BYTE );
+               for( dword y = 0;  y < HEIGHT;  ++y )
+               {
+                  stream.analyseRows( 1, image.getMemory() +
+                     (y * WIDTH * 3) );
+               }
+
+               Array<float>  in( image );
+               RowsCollected collected = { out.getMemory(), WIDTH * 3 };
+               stream.mapImage( in.getMemory(), isLastRowFirst,
+                  (2 == way) ? collectRows : 0, &collected,
+                  out.getMemory() );
+
+               // map again
+               try
+               {
+                  stream.mapImage( in.getMemory(), false, 0, 0,
+                     out.getMemory() );
+                  isFail = true;
+               }
+               catch( ... )
+               {
+               }
+            }
+            catch( ... )
+            {
+               isFail = true;
+            }
+
+            // compare
+            dword diffs = 0;
+            for( dword y = HEIGHT;  y-- > 0; )
+            {
+               const dword yOut = isLastRowFirst ? (HEIGHT - 1) - y : y;
+               diffs += dword(0 != ::memcmp(
+                  outWhole.getMemory() + (y * WIDTH * 3),
+                  out.getMemory() + (yOut * WIDTH * 3), WIDTH * 3 ));
+            }
+            isFail |= (0 != diffs);
+
+            if( pOut && isVerbose ) *pOut << "flags " << FLAGS[f] <<
+               "  way " << way << "  diffs " << diffs << "\n";
+         }
+      }
+      if( pOut && isVerbose ) *pOut << "\n";
+
+      if( pOut ) *pOut << "image after analysis : " <<
+         (!isFail ? "--- succeeded" : "*** failed") << "\n\n";
+      isOk &= !isFail;
+   }
+
+
+   // invalid use
+   {
+      bool isFail = false;
+
+      const PerceptualMap mapper;
+      PerceptualMapStream stream( mapper, 10, 10, PerceptualMap::RGB_FLOAT,
+         PerceptualMap::RGB_BYTE );
+      float in[ 10 * 11 * 3 ];
+      ubyte out[ 10 * 11 * 3 ];
+      for( dword i = sizeof(in) / sizeof(in[0]);  i-- > 0; )
+      {
+         in[i] = 1.0f;
+      }
+
+      // map before analysis
+      try
+      {
+         stream.mapRows( 1, in, out );
+         isFail = true;
+      }
+      catch( ... )
+      {
+      }
+      try
+      {
+         stream.mapImage( in, false, 0, 0, out );
+         isFail = true;
+      }
+      catch( ... )
+      {
+      }
+
+      // too many rows
+      try
+      {
+         stream.analyseRows( 11, in );
+         isFail = true;
+      }
+      catch( ... )
+      {
+      }
+
+      isFail |= stream.isAnalysed();
+
+      // proxy larger than image
+      try
+      {
+         stream.setProxy( 11, 5 );
+         isFail = true;
+      }
+      catch( ... )
+      {
+      }
+
+      // proxy after analysis started
+      try
+      {
+         stream.analyseRows( 1, in );
+         stream.setProxy( 5, 5 );
+         isFail = true;
+      }
+      catch( ... )
+      {
+      }
+
+      if( pOut ) *pOut << "invalid : " <<
+         (!isFail ? "--- succeeded" : "*** failed") << "\n\n";
+      isOk &= !isFail;
+   }
+
+
+   if( pOut ) *pOut << (isOk ? "--- successfully" : "*** failurefully") <<
+      " completed " << "\n\n\n";
+
+   if( pOut ) pOut->flush();
+
+
+   return isOk;
+}
+
+
+}//namespace
+
+
+#endif//TESTING
@@ -0,0 +1,282 @@
+/*--------------------------------------------------------------------
+
+   Perceptuum3 rendering components
+   Copyright (c) 2005-2007, Harrison Ainsworth / HXA7241.
+
+   http://www.hxa7241.org/
+
+--------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later
+   version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+   MA  02110-1301  USA
+
+--------------------------------------------------------------------*/
+
+
+
+#ifndef PerceptualMapStream_h
+#define PerceptualMapStream_h
+
+
+#include "p3tmPerceptualMap.h"
+
+#include "ColorSpace.hpp"
+#include "ImageRgbFloat.hpp"
+
+#include "p3tonemapper_image.hpp"
+
+
+
+
+#include "p3tonemapper_tonemap.hpp"
+namespace p3tonemapper_tonemap
+{
+   using p3tonemapper_image::ImageRgbFloat;
+   using p3tonemapper_image::ColorSpace;
+
+
+/**
+ * A PerceptualMap mapping, done on an image given row by row, in two
+ * passes.<br/><br/>
+ *
+ * Pass one: all the rows are given, in order, any number at a time, for
+ * analysis (the foveal image is accumulated incrementally). The veil and tone
+ * curve are made when the last row is given.<br/><br/>
+ *
+ * Pass two: all the rows are given again, in the same order, and mapped rows
+ * are returned. With acuity on, output lags input by up to getLatency() rows
+ * (the filter needs rows below) -- the remainder come with the last input.
+ * <br/><br/>
+ *
+ * Only a window of rows is held (about getLatency() * 2 + 64), so memory is
+ * proportional to the width, not the whole image. The result is the same as
+ * PerceptualMap::map on the whole image.<br/><br/>
+ *
+ * Analysis only needs a foveal-resolution image, so pass one can instead be
+ * given a smaller proxy of the image (eg a mip level), set by setProxy. The
+ * result is then close to, but not the same as, the whole-image mapping.
+ *
+ * @exceptions constructor and commands can throw
+ *
+ * @see
+ * PerceptualMap
+ *
+ * @invariants
+ * windowTop_m <= rowsOut_m <= rowsIn_m <= height_m
+ * rowsIn_m - windowTop_m <= window_m height
+ */
+class PerceptualMapStream
+{
+/// standard object services ---------------------------------------------------
+public:
+   /**
+    * @mapper         options are copied from this
+    * @width          width of input and output images
+    * @height         height of input and output images
+    * @inPixelsType   a PerceptualMap::EInPixelOptions value
+    * @outPixelsType  a PerceptualMap::EOutPixelOptions value
+    */
+            PerceptualMapStream( const PerceptualMap& mapper,
+                                 dword                width,
+                                 dword                height,
+                                 dword                inPixelsType,
+                                 dword                outPixelsType );
+
+   virtual ~PerceptualMapStream();
+private:
+            PerceptualMapStream( const PerceptualMapStream& );
+   PerceptualMapStream& operator=( const PerceptualMapStream& );
+
+
+/// commands -------------------------------------------------------------------
+public:
+   /**
+    * Make pass one take a smaller proxy of the image, instead of the image.
+    * <br/><br/>
+    *
+    * Must be before any rows are given. Proxy should be at least the foveal
+    * size, for a good result.
+    *
+    * @proxyWidth   no more than the image width
+    * @proxyHeight  no more than the image height
+    */
+   virtual void  setProxy( dword proxyWidth,
+                           dword proxyHeight );
+
+   /**
+    * Set the step, in bytes, from one output row to the next (eg negative,
+    * to write rows top first into a bottom-first buffer). Default is packed.
+    * <br/><br/>
+    *
+    * pOutRows given to mapRows then points to its first output row, with
+    * the others at this step.
+    */
+   virtual void  setOutRowStride( dword rowStride );
+   /**
+    * Set the output pixels type, instead of the one the stream was made with
+    * (eg if only known after pass one). Resets the row stride to packed.
+    * Must be before pass two.
+    *
+    * @outPixelsType  a PerceptualMap::EOutPixelOptions value
+    */
+   virtual void  setOutPixelsType( dword outPixelsType );
+
+   /**
+    * Pass one: give the next input rows for analysis.
+    *
+    * @rowCount  number of rows in pInRows
+    * @pInRows   array of input RGB pixels, rowCount rows
+    */
+   virtual void  analyseRows( dword       rowCount,
+                              const void* pInRows );
+   /**
+    * Pass one, with input rows in any layout.
+    *
+    * @inRows  where the channels of the first of the rows are
+    */
+   virtual void  analyseRows( dword               rowCount,
+                              const p3tmInLayout& inRows );
+
+   /**
+    * Pass two: give the next input rows, and get the mapped rows ready.
+    *
+    * @rowCount   number of rows in pInRows
+    * @pInRows    array of input RGB pixels, rowCount rows
+    * @pOutRows   array of output RGB pixels, with room for
+    *             rowCount + getLatency() rows
+    *
+    * @return  number of rows written to pOutRows
+    */
+   virtual dword mapRows( dword       rowCount,
+                          const void* pInRows,
+                          void*       pOutRows );
+   /**
+    * Pass two, with input rows in any layout.
+    *
+    * @inRows  where the channels of the first of the rows are
+    */
+   virtual dword mapRows( dword               rowCount,
+                          const p3tmInLayout& inRows,
+                          void*               pOutRows );
+   /**
+    * Pass two all at once, for float input held whole in memory: map the
+    * image in place (so it is modified), with the analysis from pass one.
+    * <br/><br/>
+    *
+    * The result is the same as PerceptualMap::map, however the rows were
+    * given to pass one. Output rows go from first to last, or from last to
+    * first if isLastRowFirst: a band at a time to pRowSink, if given, else
+    * packed into pOutPixels.
+    *
+    * @pInPixels       the whole image given to pass one
+    * @isLastRowFirst  give output rows from the last to the first
+    * @pRowSink        receiver of each band of packed output rows (or 0)
+    * @pSinkContext    given to pRowSink
+    * @pOutPixels      array of output RGB pixels (when no sink)
+    */
+   virtual void  mapImage( void*       pInPixels,
+                           bool        isLastRowFirst,
+                           p3tmRowSink pRowSink,
+                           void*       pSinkContext,
+                           void*       pOutPixels );
+
+
+/// queries --------------------------------------------------------------------
+   /**
+    * Whether all rows have been given to analyseRows.
+    */
+   virtual bool  isAnalysed()                                             const;
+   /**
+    * Most rows mapRows output can lag behind its input.
+    */
+   virtual dword getLatency()                                             const;
+   /**
+    * Size of the foveal image that analysis makes (for choosing a proxy).
+    */
+   virtual void  getFovealSize( dword& width,
+                                dword& height )                           const;
+
+
+/// implementation -------------------------------------------------------------
+protected:
+           p3tmInLayout getPackedLayout( const void* pInRows,
+                                         dword       rowWidth )           const;
+           void  readRows( const p3tmInLayout& inRows,
+                           dword               rowBegin,
+                           dword               rowCount,
+                           dword               rowWidth,
+                           float*              pWindowRows )              const;
+           void  clampRows( dword  width,
+                            dword  height,
+                            dword  rowBegin,
+                            dword  rowCount,
+                            float* pRows )                                const;
+           void  scaleRows( ImageRgbFloat& rows )                         const;
+           void  finishAnalysis();
+           void  applyHumanRows( ImageRgbFloat& rows,
+                                 dword          rowBegin )                const;
+           void  mapBand( dword rowBegin,
+                          dword rowEnd,
+                          void* pOutRows );
+
+   static const dword BAND_ROWS;
+
+
+/// fields ---------------------------------------------------------------------
+private:
+   // image
+   dword      width_m;
+   dword      height_m;
+   dword      inPixelsType_m;
+   dword      outPixelsType_m;
+   dword      outRowStride_m;
+
+   // options
+   ColorSpace colorSpace_m;
+   float      viewAngleHorizontal_m;
+   float      inputLuminanceScaling_m;
+   float      inputLuminanceOffset_m;
+   dword      mappingFlags_m;
+   float      outputBlackLuminance_m;
+   float      outputWhiteLuminance_m;
+   float      outputGamma_m;
+
+   // analysis
+   dword           proxyWidth_m;
+   dword           proxyHeight_m;
+   Foveal*         pFoveal_m;
+   Veil*           pVeil_m;
+   ToneAdjustment* pToneAdjustment_m;
+
+   // row window
+   dword         acuityRadius_m;
+   ImageRgbFloat window_m;
+   ImageRgbFloat acuityBand_m;
+   dword         rowsAnalysed_m;
+   dword         windowTop_m;
+   dword         rowsIn_m;
+   dword         rowsOut_m;
+};
+
+
+}//namespace
+
+
+
+
+#endif//PerceptualMapStream_h
@@ -0,0 +1,505 @@
+/*--------------------------------------------------------------------
+
+   Perceptuum3 rendering components
+   Copyright (c) 2005-2007, Harrison Ainsworth / HXA7241.
+
+   http://www.hxa7241.org/
+
+--------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later
+   version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+   MA  02110-1301  USA
+
+--------------------------------------------------------------------*/
+
+
+
+
+
+#include "FpEnvironment.hpp"
+#include "HalfFloat.hpp"
+
+#include "Vector3f.hpp"
+
+#include "ColorSpace.hpp"
+#include "ImageRgbInt.hpp"
+
+#include "Foveal.hpp"
+#include "ToneAdjustment.hpp"
+
+#include "PerceptualMapSweep.hpp"   // own header is included last
+
+
+using namespace p3tonemapper_tonemap;
+
+
+
+
+/// statics
+static const char SIZE_INVALID_MESSAGE[] =
+   "invalid image size given to PerceptualMapSweep";
+static const char PIXELS_TYPE_INVALID_MESSAGE[] =
+   "invalid input pixels type given to PerceptualMapSweep";
+static const char FLAGS_UNKNOWN_MESSAGE[] =
+   "mapping features not among those PerceptualMapSweep was made with";
+
+
+
+
+/// standard object services ---------------------------------------------------
+PerceptualMapSweep::PerceptualMapSweep
+(
+   const PerceptualMap& mapper,
+   const dword          width,
+   const dword          height,
+   const dword          inPixelsType,
+   void*                pInPixels,
+   const dword          mappingFlagsCount,
+   const dword*         pMappingFlags
+)
+ : mapper_m        ( mapper )
+ , width_m         ( width )
+ , height_m        ( height )
+ , floats_m        ()
+ , pOriginal_m     ( 0 )
+ , pFoveal_m       ( 0 )
+ , humanSets_m     ()
+ , humanOriginals_m()
+ , humanFoveals_m  ()
+{
+   if( (width < 1) | (height < 1) )
+   {
+      throw SIZE_INVALID_MESSAGE;
+   }
+   if( (PerceptualMap::RGB_FLOAT != inPixelsType) &
+       (PerceptualMap::RGB_HALF  != inPixelsType) )
+   {
+      throw PIXELS_TYPE_INVALID_MESSAGE;
+   }
+
+   // set this thread's fp environment (restored when leaving)
+   const hxa7241_general::FpEnvironment fpEnvironment;
+
+   try
+   {
+      // copy options
+      float chromaticities[6];
+      float whitePoint[2];
+      float scalingAndOffset[2];
+      float viewAngleHorizontal = 0.0f;
+      mapper_m.getOptions( chromaticities, whitePoint, scalingAndOffset,
+         &viewAngleHorizontal, 0, 0, 0 );
+
+      // make calibrated image: half input converted, float input in place
+      float* pPixels = static_cast<float*>( pInPixels );
+      if( PerceptualMap::RGB_HALF == inPixelsType )
+      {
+         floats_m.setLength( width * height * 3 );
+         hxa7241_general::halfsToFloats( static_cast<const uword*>(
+            pInPixels ), floats_m.getLength(), floats_m.getMemory() );
+         pPixels = floats_m.getMemory();
+      }
+
+      pOriginal_m = new ImageRgbFloat( width, height, pPixels, false,
+         p3tonemapper_image::ColorSpace( chromaticities, whitePoint ) );
+      if( (1.0f != scalingAndOffset[0]) | (0.0f != scalingAndOffset[1]) )
+      {
+         using hxa7241_graphics::Vector3f;
+
+         // scale and offset image
+         const Vector3f offset( Vector3f::ONE() * scalingAndOffset[1] );
+         for( dword op = pOriginal_m->getLength();  op-- > 0; )
+         {
+            pOriginal_m->set( op,
+               (pOriginal_m->get( op ) *= scalingAndOffset[0]) += offset );
+         }
+      }
+
+      // make foveal image
+      pFoveal_m = new Foveal( *pOriginal_m, viewAngleHorizontal );
+
+      // make images limited by each distinct set of human stages (none
+      // shares the unlimited ones)
+      for( dword i = 0;  i < mappingFlagsCount;  ++i )
+      {
+         const PerceptualMap::HumanLimits applyHuman =
+            PerceptualMap::getHumanLimits( pMappingFlags[i] );
+
+         bool isFound = false;
+         for( dword s = humanSets_m.getLength();  s-- > 0; )
+         {
+            isFound |= (applyHuman == humanSets_m[s]);
+         }
+
+         if( !isFound )
+         {
+            Foveal*const pFoveal = applyHuman ?
+               new Foveal( *pFoveal_m ) : pFoveal_m;
+            humanFoveals_m.append( pFoveal );
+            ImageRgbFloat*const pOriginal = applyHuman ?
+               new ImageRgbFloat( *pOriginal_m ) : pOriginal_m;
+            humanOriginals_m.append( pOriginal );
+            humanSets_m.append( applyHuman );
+
+            if( applyHuman )
+            {
+               (*applyHuman)( *pFoveal, *pOriginal );
+            }
+         }
+      }
+   }
+   catch( ... )
+   {
+      freeImages();
+      throw;
+   }
+}
+
+
+PerceptualMapSweep::~PerceptualMapSweep()
+{
+   freeImages();
+}
+
+
+
+
+/// queries --------------------------------------------------------------------
+void PerceptualMapSweep::map
+(
+   const dword        mappingFlags,
+   const float* const pOutLuminanceRange2,
+   const float        outGamma,
+   const dword        outPixelsType,
+   void* const        pOutPixels
+) const
+{
+   // set this thread's fp environment (restored when leaving)
+   const hxa7241_general::FpEnvironment fpEnvironment;
+
+   const dword set = findHumanSet( mappingFlags );
+
+   // options: the mapper's, except those given
+   float outLuminanceRange[2];
+   float gamma = 0.0f;
+   {
+      PerceptualMap options( mapper_m );
+      if( 0 != pOutLuminanceRange2 )
+      {
+         options.setOutputLuminanceRange( pOutLuminanceRange2 );
+      }
+      if( 0.0f != outGamma )
+      {
+         options.setOutputGamma( outGamma );
+      }
+      options.getOptions( 0, 0, 0, 0, 0, outLuminanceRange, &gamma );
+   }
+
+   // make tone adjustment, from the foveal image of its human stages
+   const ToneAdjustment toneAdjustment( *humanFoveals_m[set],
+      outLuminanceRange[0], outLuminanceRange[1], 0 != humanSets_m[set] );
+
+   // make wrapper for output image, and map into it
+   ImageRgbInt outImage( width_m, height_m,
+      PerceptualMap::RGB_BYTE != outPixelsType, false, pOutPixels );
+   outImage.setGamma( gamma );
+   outImage.setWordsBigEndian( PerceptualMap::RGB_WORD_BE == outPixelsType );
+
+   toneAdjustment.map( *humanOriginals_m[set], outImage );
+}
+
+
+
+
+/// implementation -------------------------------------------------------------
+dword PerceptualMapSweep::findHumanSet
+(
+   const dword mappingFlags
+) const
+{
+   const PerceptualMap::HumanLimits applyHuman =
+      PerceptualMap::getHumanLimits( mappingFlags );
+
+   for( dword s = humanSets_m.getLength();  s-- > 0; )
+   {
+      if( applyHuman == humanSets_m[s] )
+      {
+         return s;
+      }
+   }
+
+   throw FLAGS_UNKNOWN_MESSAGE;
+}
+
+
+void PerceptualMapSweep::freeImages()
+{
+   // (the unlimited images may also be listed, for no human stages)
+   for( dword s = humanFoveals_m.getLength();  s-- > 0; )
+   {
+      if( pFoveal_m != humanFoveals_m[s] )
+      {
+         delete humanFoveals_m[s];
+      }
+   }
+   for( dword s = humanOriginals_m.getLength();  s-- > 0; )
+   {
+      if( pOriginal_m != humanOriginals_m[s] )
+      {
+         delete humanOriginals_m[s];
+      }
+   }
+   humanSets_m.setLength( 0 );
+   humanOriginals_m.setLength( 0 );
+   humanFoveals_m.setLength( 0 );
+
+   delete pFoveal_m;
+   pFoveal_m = 0;
+   delete pOriginal_m;
+   pOriginal_m = 0;
+}
+
+
+
+
+
+
+
+
+/// test -----------------------------------------------------------------------
+#ifdef TESTING
+
+
+#include <math.h>
+#include <ostream>
+
+
+namespace p3tonemapper_tonemap
+{
+   using namespace hxa7241;
+   using hxa7241_general::Array;
+
+
+bool test_PerceptualMapSweep
+(
+   std::ostream* pOut,
+   const bool    isVerbose,
+   const dword   //seed
+)
+{
+   bool isOk = true;
+
+   if( pOut ) *pOut << "[ test_PerceptualMapSweep ]\n\n";
+
+
+   static const dword WIDTH  = 113;
+   static const dword HEIGHT = 71;
+   static const dword LENGTH = WIDTH * HEIGHT * 3;
+
+   // make image of blobs, over a wide luminance range
+   Array<float> image( LENGTH );
+   for( dword i = LENGTH;  i-- > 0; )
+   {
+      const dword x = (i / 3) % WIDTH;
+      const dword y = (i / 3) / WIDTH;
+      image[i] = ::powf( 10.0f, (::sinf( float(x) * 0.06f ) *
+         ::cosf( float(y) * 0.09f ) * 3.5f) + float(i % 3) * 0.15f );
+   }
+
+   static const dword FLAGS[] = { PerceptualMap::IDEAL,
+      PerceptualMap::HUMAN, PerceptualMap::GLARE | PerceptualMap::CONTRAST };
+   static const float RANGES[][2] = { { 2.0f, 150.0f }, { 0.5f, 400.0f } };
+   static const float GAMMAS[]    = { 0.45f, 0.6f };
+   const float scalingAndOffset[] = { 3.0f, 0.0f };
+
+   // variants same as mapping alone
+   {
+      bool isFail = false;
+
+      const PerceptualMap mapper( 0, 0, scalingAndOffset, 0.0f, 0, 0, 0.0f );
+
+      Array<float> in( image );
+      const PerceptualMapSweep sweep( mapper, WIDTH, HEIGHT,
+         PerceptualMap::RGB_FLOAT, in.getMemory(), 3, FLAGS );
+
+      // (every flags, range, gamma, and out type, together)
+      for( dword v = 0;  v < 3 * 2 * 2 * 3;  ++v )
+      {
+         const dword  flags    = FLAGS[v % 3];
+         const float* pRange   = RANGES[(v / 3) % 2];
+         const float  gamma    = GAMMAS[(v / 6) % 2];
+         const dword  outType  = (v / 12) % 3;
+         const dword  outBytes = LENGTH * (outType ? 2 : 1);
+
+         Array<ubyte> outSwept( outBytes );
+         sweep.map( flags, pRange, gamma, outType, outSwept.getMemory() );
+
+         PerceptualMap alone( mapper );
+         alone.setMappingFeatures( flags );
+         alone.setOutputLuminanceRange( pRange );
+         alone.setOutputGamma( gamma );
+         Array<ubyte> outAlone( outBytes );
+         Array<float> inAlone( image );
+         isFail |= !alone.map( WIDTH, HEIGHT, PerceptualMap::RGB_FLOAT,
+            inAlone.getMemory(), outType, outAlone.getMemory(), 0, 0 );
+
+         bool isSame = true;
+         for( dword i = outBytes;  i-- > 0; )
+         {
+            isSame &= (outSwept[i] == outAlone[i]);
+         }
+
+         if( pOut && isVerbose ) *pOut << "flags " << flags << "  range " <<
+            pRange[0] << "_" << pRange[1] << "  gamma " << gamma << "  out " <<
+            outType << "  " << isSame << "\n";
+
+         isFail |= !isSame;
+      }
+      if( pOut && isVerbose ) *pOut << "\n";
+
+      // features not made with throw
+      try
+      {
+         Array<ubyte> out( LENGTH );
+         sweep.map( PerceptualMap::ACUITY, 0, 0.0f, PerceptualMap::RGB_BYTE,
+            out.getMemory() );
+         isFail = true;
+      }
+      catch( const char* )
+      {
+      }
+
+      if( pOut ) *pOut << "variants : " <<
+         (!isFail ? "--- succeeded" : "*** failed") << "\n\n";
+      isOk &= !isFail;
+   }
+
+
+   // values out of range same as mapping alone
+   // (clamped, scaled, and offset, as the whole image is)
+   {
+      bool isFail = false;
+
+      // make image with some negative, huge, and tiny values
+      Array<float> wild( LENGTH );
+      for( dword i = LENGTH;  i-- > 0; )
+      {
+         const udword hash = udword(i) * 2654435761u;
+         const dword  kind = dword((hash >> 24) % 16);
+         wild[i] = (0 == kind) ? -float((hash >> 8) & 0xFF) :
+            (1 == kind) ? 1e20f : (2 == kind) ? 1e-20f : image[i];
+      }
+
+      static const float SCALINGS[][2] = { { 1.0f, 0.0f }, { 2.0f, -0.25f } };
+
+      for( dword s = 0;  s < 2;  ++s )
+      {
+         const PerceptualMap mapper( 0, 0, SCALINGS[s], 0.0f, 0, 0, 0.0f );
+
+         Array<float> in( wild );
+         const PerceptualMapSweep sweep( mapper, WIDTH, HEIGHT,
+            PerceptualMap::RGB_FLOAT, in.getMemory(), 3, FLAGS );
+
+         for( dword v = 0;  v < 3 * 2;  ++v )
+         {
+            const dword flags    = FLAGS[v % 3];
+            const dword outType  = v / 3;
+            const dword outBytes = LENGTH * (outType ? 2 : 1);
+
+            Array<ubyte> outSwept( outBytes );
+            sweep.map( flags, 0, 0.0f, outType, outSwept.getMemory() );
+
+            PerceptualMap alone( mapper );
+            alone.setMappingFeatures( flags );
+            Array<ubyte> outAlone( outBytes );
+            Array<float> inAlone( wild );
+            isFail |= !alone.map( WIDTH, HEIGHT, PerceptualMap::RGB_FLOAT,
+               inAlone.getMemory(), outType, outAlone.getMemory(), 0, 0 );
+
+            dword diffs = 0;
+            for( dword i = outBytes;  i-- > 0; )
+            {
+               diffs += dword(outSwept[i] != outAlone[i]);
+            }
+            isFail |= (0 != diffs);
+
+            if( pOut && isVerbose ) *pOut << "scaling " << SCALINGS[s][0] <<
+               "_" << SCALINGS[s][1] << "  flags " << flags << "  out " <<
+               outType << "  diffs " << diffs << "\n";
+         }
+      }
+      if( pOut && isVerbose ) *pOut << "\n";
+
+      if( pOut ) *pOut << "out of range : " <<
+         (!isFail ? "--- succeeded" : "*** failed") << "\n\n";
+      isOk &= !isFail;
+   }
+
+
+   // half input same as its floats
+   {
+      bool isFail = false;
+
+      Array<uword> halfs( LENGTH );
+      for( dword i = LENGTH;  i-- > 0; )
+      {
+         halfs[i] = uword( (udword(i) * 2654435761u >> 8) % 0x7C00 );
+      }
+      Array<float> floats( LENGTH );
+      hxa7241_general::halfsToFloats( halfs.getMemory(), LENGTH,
+         floats.getMemory() );
+
+      const PerceptualMap mapper( 0, 0, 0, 0.0f, PerceptualMap::HUMAN, 0,
+         0.0f );
+      const dword flags = PerceptualMap::HUMAN;
+      const PerceptualMapSweep sweep( mapper, WIDTH, HEIGHT,
+         PerceptualMap::RGB_HALF, halfs.getMemory(), 1, &flags );
+
+      Array<ubyte> outSwept( LENGTH );
+      sweep.map( flags, 0, 0.0f, PerceptualMap::RGB_BYTE,
+         outSwept.getMemory() );
+      Array<ubyte> outAlone( LENGTH );
+      isFail |= !mapper.map( WIDTH, HEIGHT, PerceptualMap::RGB_FLOAT,
+         floats.getMemory(), PerceptualMap::RGB_BYTE, outAlone.getMemory(),
+         0, 0 );
+
+      for( dword i = LENGTH;  i-- > 0; )
+      {
+         isFail |= (outSwept[i] != outAlone[i]);
+      }
+
+      if( pOut ) *pOut << "half input : " <<
+         (!isFail ? "--- succeeded" : "*** failed") << "\n\n";
+      isOk &= !isFail;
+   }
+
+
+   if( pOut ) *pOut << (isOk ? "--- successfully" : "*** failurefully") <<
+      " completed " << "\n\n\n";
+
+   if( pOut ) pOut->flush();
+
+
+   return isOk;
+}
+
+
+}//namespace
+
+
+#endif//TESTING
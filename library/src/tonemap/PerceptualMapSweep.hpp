@@ -0,0 +1,159 @@
+/*--------------------------------------------------------------------
+
+   Perceptuum3 rendering components
+   Copyright (c) 2005-2007, Harrison Ainsworth / HXA7241.
+
+   http://www.hxa7241.org/
+
+--------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later
+   version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free
+   Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+   MA  02110-1301  USA
+
+--------------------------------------------------------------------*/
+
+
+
+
+
+#ifndef PerceptualMapSweep_h
+#define PerceptualMapSweep_h
+
+
+#include "Array.hpp"
+#include "ImageRgbFloat.hpp"
+#include "PerceptualMap.hpp"
+
+#include "p3tonemapper_image.hpp"
+
+
+
+
+#include "p3tonemapper_tonemap.hpp"
+namespace p3tonemapper_tonemap
+{
+   using p3tonemapper_image::ImageRgbFloat;
+
+
+/**
+ * Several PerceptualMap mappings of one image -- a parameter sweep -- that
+ * differ only in mapping features, output luminance range and output gamma.
+ * <br/><br/>
+ *
+ * All the variants have in common is made once, at construction: the
+ * calibrated image and foveal image, and then, for each distinct set of human
+ * stages among the mapping features given, the images those stages limit
+ * (veil mixed in, color adjusted, acuity filtered). Each map then makes only
+ * its tone adjustment, and maps.<br/><br/>
+ *
+ * map only reads the sweep, so concurrent calls (eg one thread per variant)
+ * are safe. The result of each is the same as PerceptualMap::map with its
+ * options.<br/><br/>
+ *
+ * Memory is a whole float image for each set of human stages (and for half
+ * input, another for the calibrated image).
+ *
+ * @exceptions constructor and map can throw
+ *
+ * @see
+ * PerceptualMap
+ */
+class PerceptualMapSweep
+{
+/// standard object services ---------------------------------------------------
+public:
+   /**
+    * @mapper              options are copied from this (as the defaults of
+    *                      those varied)
+    * @width               width of input and output images
+    * @height              height of input and output images
+    * @inPixelsType        a PerceptualMap::EInPixelOptions value
+    * @pInPixels           array of input RGB pixels (float are used in
+    *                      place, so are modified, and must outlive the
+    *                      sweep)
+    * @mappingFlagsCount   number of mapping features sets to be mapped
+    * @pMappingFlags       array of mappingFlagsCount sets of
+    *                      PerceptualMap::EMappingOptions
+    */
+            PerceptualMapSweep( const PerceptualMap& mapper,
+                                dword                width,
+                                dword                height,
+                                dword                inPixelsType,
+                                void*                pInPixels,
+                                dword                mappingFlagsCount,
+                                const dword*         pMappingFlags );
+
+   virtual ~PerceptualMapSweep();
+private:
+            PerceptualMapSweep( const PerceptualMapSweep& );
+   PerceptualMapSweep& operator=( const PerceptualMapSweep& );
+
+
+/// queries --------------------------------------------------------------------
+public:
+   /**
+    * Map one variant.<br/><br/>
+    *
+    * @mappingFlags         one of the sets the sweep was made with
+    * @pOutLuminanceRange2  min and max display luminance (cd/m^2), array of
+    *                       two floats (or 0 for the mapper's)
+    * @outGamma             power transform to apply to output pixels (or 0
+    *                       for the mapper's)
+    * @outPixelsType        a PerceptualMap::EOutPixelOptions value
+    * @pOutPixels           array of output RGB pixels
+    */
+   virtual void  map( dword        mappingFlags,
+                      const float* pOutLuminanceRange2,
+                      float        outGamma,
+                      dword        outPixelsType,
+                      void*        pOutPixels )                           const;
+
+
+/// implementation -------------------------------------------------------------
+protected:
+           dword findHumanSet( dword mappingFlags )                       const;
+           void  freeImages();
+
+
+/// fields ---------------------------------------------------------------------
+private:
+   // image and options
+   PerceptualMap   mapper_m;
+   dword           width_m;
+   dword           height_m;
+
+   // calibrated image (of converted halfs, or wrapping the input floats),
+   // and its foveal image
+   hxa7241_general::Array<float> floats_m;
+   ImageRgbFloat*                pOriginal_m;
+   Foveal*                       pFoveal_m;
+
+   // each distinct set of human stages, and the images it limits (the ones
+   // above, for none)
+   hxa7241_general::Array<PerceptualMap::HumanLimits> humanSets_m;
+   hxa7241_general::Array<ImageRgbFloat*>             humanOriginals_m;
+   hxa7241_general::Array<Foveal*>                    humanFoveals_m;
+};
+
+
+}//namespace
+
+
+
+
+#endif//PerceptualMapSweep_h
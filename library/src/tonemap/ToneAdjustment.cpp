@@ -45,6 +45,18 @@
 using namespace p3tonemapper_tonemap;
 
 
+namespace p3tonemapper_tonemap
+{
+/**
+ * 16-bit output channel, stored most significant byte first.
+ */
+struct WordBigEndian
+{
+	ubyte bytes[2];
+};
+}
+
+
 
 
 /// statics
@@ -168,53 +180,89 @@ void ToneAdjustment::map
 ) const
 {
 	// check images same size (length will do for this...)
-	if( inImage.getLength() == outImage.getLength() )
+	if( (inImage.getLength() == outImage.getLength()) &
+		(0 != outImage.getPixels()) )
 	{
-		using hxa7241_graphics::Vector3f;
-		using p3tonemapper_image::ColorSpace;
-
-		const ColorSpace& colorSpace = inImage.getColorSpace();
-
-		// loop through pixels
-		for( dword i = 0;  i < outImage.getLength();  ++i )
-		{
-			const Vector3f& inPixel = inImage.get( i );
+		mapRange( inImage, 0, outImage );
+	}
+}
 
-			// get luminance of pixel
-			float inLuminance = colorSpace.getRgbLuminance( inPixel );
-			hxa7241_general::clampMin( inLuminance,
-				hxa7241_graphics::ColorConstants::getLuminanceMin() );
 
-			// map luminance with curve
-			const float outLuminance =
-				mapLuminance( brightnessCurve_m, inLuminance );
+void ToneAdjustment::map
+(
+	const ImageRgbFloat& inImage,
+	const dword          rowBegin,
+	ImageRgbInt&         outRows
+) const
+{
+	// check rows are inside image
+	if( (inImage.getWidth() == outRows.getWidth()) &
+		((rowBegin + outRows.getHeight()) <= inImage.getHeight()) &
+		(0 != outRows.getPixels()) )
+	{
+		mapRange( inImage, rowBegin * inImage.getWidth(), outRows );
+	}
+}
 
-			// rescale pixel to 0-1
-			float rgb01[3];
-			{
-				const float out01 =
-					outputLuminanceRange_m.getInterpolantClamped( outLuminance );
 
-				// calc scaling to bring input pixel into 0-1 range
-				const float scaling = out01 / inLuminance;
 
-				// scale pixel
-				Vector3f outPixel( inPixel * scaling );
-				outPixel.getXYZ( rgb01 );
-			}
 
-			// write to output pixel
-			// (clamp and quantize into something like 16 bits)
-			// (clamp desaturates color at ends of range)
-			outImage.setElement( i, rgb01 );
+/// implementation -------------------------------------------------------------
+void ToneAdjustment::mapRange
+(
+	const ImageRgbFloat& inImage,
+	const dword          pixelBegin,
+	ImageRgbInt&         outImage
+) const
+{
+	// select pixel loop once, by output channel size and gamma curve
+	const float gamma = outImage.getGamma();
+	if( outImage.is48Bit() & outImage.isWordsBigEndian() )
+	{
+		WordBigEndian* pOut =
+			static_cast<WordBigEndian*>( outImage.getPixels() );
+		if( 0.0f == gamma )
+		{
+			mapPixels<WordBigEndian, true>( inImage, pixelBegin,
+				outImage.getLength(), gamma, pOut );
+		}
+		else
+		{
+			mapPixels<WordBigEndian, false>( inImage, pixelBegin,
+				outImage.getLength(), gamma, pOut );
+		}
+	}
+	else if( outImage.is48Bit() )
+	{
+		uword* pOut = static_cast<uword*>( outImage.getPixels() );
+		if( 0.0f == gamma )
+		{
+			mapPixels<uword, true>( inImage, pixelBegin,
+				outImage.getLength(), gamma, pOut );
+		}
+		else
+		{
+			mapPixels<uword, false>( inImage, pixelBegin,
+				outImage.getLength(), gamma, pOut );
+		}
+	}
+	else
+	{
+		ubyte* pOut = static_cast<ubyte*>( outImage.getPixels() );
+		if( 0.0f == gamma )
+		{
+			mapPixels<ubyte, true>( inImage, pixelBegin,
+				outImage.getLength(), gamma, pOut );
+		}
+		else
+		{
+			mapPixels<ubyte, false>( inImage, pixelBegin,
+				outImage.getLength(), gamma, pOut );
 		}
 	}
 }
 
 
-
-
-/// implementation -------------------------------------------------------------
 void ToneAdjustment::fill
 (
 	const Foveal& fovealImage,
@@ -395,6 +443,93 @@ float ToneAdjustment::mapLuminance
 }
 
 
+static inline void quantize01
+(
+	const float f01,
+	ubyte&      channel
+)
+{
+	channel = ubyte( hxa7241_general::fp01ToByte( f01 ) );
+}
+
+
+static inline void quantize01
+(
+	const float f01,
+	uword&      channel
+)
+{
+	channel = uword( hxa7241_general::fp01ToWord( f01 ) );
+}
+
+
+static inline void quantize01
+(
+	const float    f01,
+	WordBigEndian& channel
+)
+{
+	const dword w = hxa7241_general::fp01ToWord( f01 );
+	channel.bytes[0] = ubyte( w >> 8 );
+	channel.bytes[1] = ubyte( w );
+}
+
+
+template<class CHANNEL, bool IS_GAMMA_709>
+void ToneAdjustment::mapPixels
+(
+	const ImageRgbFloat& inImage,
+	const dword          pixelBegin,
+	const dword          pixelCount,
+	const float          gamma,
+	CHANNEL*const        pOutTriples
+) const
+{
+	using hxa7241_graphics::Vector3f;
+
+	// luminance weights, fetched once
+	const Vector3f& weights =
+		inImage.getColorSpace().getRgbLuminanceWeights();
+	const float weightR = weights.getX();
+	const float weightG = weights.getY();
+	const float weightB = weights.getZ();
+
+	// loop through pixels
+	const float* pIn  = inImage.getPixels() + (pixelBegin * 3);
+	const float* pEnd = pIn + (pixelCount * 3);
+	CHANNEL*     pOut = pOutTriples;
+	for( ;  pIn < pEnd;  pIn += 3, pOut += 3 )
+	{
+		// get luminance of pixel
+		// (clamped, so black, and denormals flushed to zero, scale to zero)
+		const float inLuminance = hxa7241_general::clampMin(
+			(pIn[0] * weightR) + (pIn[1] * weightG) + (pIn[2] * weightB),
+			hxa7241_graphics::ColorConstants::getLuminanceMin() );
+
+		// map luminance with curve
+		const float outLuminance =
+			mapLuminance( brightnessCurve_m, inLuminance );
+
+		// calc scaling to bring input pixel into 0-1 range
+		const float scaling =
+			outputLuminanceRange_m.getInterpolantClamped( outLuminance ) /
+			inLuminance;
+
+		// scale, clamp, gamma, and quantize each channel
+		// (clamp desaturates color at ends of range)
+		for( dword i = 0;  i < 3;  ++i )
+		{
+			float channel01 = hxa7241_general::clamp01o( pIn[i] * scaling );
+			channel01       = IS_GAMMA_709 ?
+				hxa7241_graphics::ColorConstants::gammaEncode709( channel01 ) :
+				::powf( channel01, gamma );
+
+			quantize01( channel01, pOut[i] );
+		}
+	}
+}
+
+
 
 
 float ToneAdjustment::getFrequencyCeilingIdeal
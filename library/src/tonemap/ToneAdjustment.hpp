@@ -100,6 +100,12 @@ public:
 /// queries --------------------------------------------------------------------
 	virtual void  map( const ImageRgbFloat&,
 	                   ImageRgbInt& )                                      const;
+	/**
+	 * Map some rows of the image, into an image of just those rows.
+	 */
+	virtual void  map( const ImageRgbFloat& inImage,
+	                   dword                rowBegin,
+	                   ImageRgbInt&         outRows )                      const;
 
 
 /// implementation -------------------------------------------------------------
@@ -113,6 +119,18 @@ protected:
 	static  float mapLuminance( const SamplesRegular1& brightnessCurve,
 	                            float                  inLuminance );
 
+	        void  mapRange( const ImageRgbFloat& inImage,
+	                        dword                pixelBegin,
+	                        ImageRgbInt&         outImage )                const;
+
+	// specialized per output channel type and gamma curve
+	template<class CHANNEL, bool IS_GAMMA_709>
+	        void  mapPixels( const ImageRgbFloat& inImage,
+	                         dword                pixelBegin,
+	                         dword                pixelCount,
+	                         float                gamma,
+	                         CHANNEL*             pOutTriples )            const;
+
 	// secondary
 	static  float getFrequencyCeilingIdeal( float           totalSamples,
 	                                        float           binWidth,
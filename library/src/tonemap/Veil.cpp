@@ -99,6 +99,17 @@ void Veil::mixInto
 (
    ImageRgbFloat& image
 ) const
+{
+   Veil::mixInto( image, image.getHeight(), 0 );
+}
+
+
+void Veil::mixInto
+(
+   ImageRgbFloat& rows,
+   const dword    imageHeight,
+   const dword    rowBegin
+) const
 {
    /**
     * visitor for Veil::mixInto.
@@ -125,23 +136,24 @@ void Veil::mixInto
 
 
    // images same size (easy optimization)
-   if( (getWidth()  == image.getWidth() ) &&
-       (getHeight() == image.getHeight()) )
+   if( (getWidth()  == rows.getWidth()) &&
+       (getHeight() == imageHeight    ) )
    {
       using hxa7241_graphics::Vector3f;
 
-      // loop through pixels
-      for( dword i = getLength();  i-- > 0; )
+      // loop through pixels (of the band)
+      const dword offset = rowBegin * getWidth();
+      for( dword i = rows.getLength();  i-- > 0; )
       {
-         image.set( i, (image.get(i) *= CENTRAL_WEIGHTING) += get(i) );
+         rows.set( i, (rows.get(i) *= CENTRAL_WEIGHTING) += get(i + offset) );
          //*pOut = (*pOut * CENTRAL_WEIGHTING) + *pIn;
       }
    }
    else
    {
-      MixInto visitor( image );
+      MixInto visitor( rows );
       ImageRgbFloat::visitBilinear( *this, visitor,
-         image.getWidth(), image.getHeight() );
+         rows.getWidth(), imageHeight, rowBegin, rowBegin + rows.getHeight() );
    }
 }
 
@@ -79,6 +79,16 @@ public:
 	// inherit
 
 	virtual void  mixInto( ImageRgbFloat& )                                const;
+	/**
+	 * Mix into a band of rows of an image.<br/><br/>
+	 *
+	 * @rows         image rows, from rowBegin, full image width
+	 * @imageHeight  height of the whole image
+	 * @rowBegin     row index, in the whole image, of the band's first row
+	 */
+	virtual void  mixInto( ImageRgbFloat& rows,
+	                       dword          imageHeight,
+	                       dword          rowBegin )                       const;
 
 
 /// implementation -------------------------------------------------------------
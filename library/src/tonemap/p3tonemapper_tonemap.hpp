@@ -45,6 +45,8 @@ namespace p3tonemapper_tonemap
 	class ColorAdjustment;
 	class Foveal;
 	class PerceptualMap;
+	class PerceptualMapStream;
+	class PerceptualMapSweep;
 	class ToneAdjustment;
 	class Veil;
 }
@@ -4,7 +4,7 @@
 # set constants ----------------------------------------------------------------
 COMPILER=g++
 LINKER=g++
-COMPILE_OPTIONS="-c -x c++ -ansi -std=c++98 -pedantic -fno-enforce-eh-specs -fno-rtti -O3 -ffast-math -fno-threadsafe-statics -ftree-vectorize -mfpmath=sse -msse -Wall -Wextra -Wabi -Wold-style-cast -Wsign-promo -Woverloaded-virtual -Wstrict-null-sentinel -Wcast-align -Wwrite-strings -Wpointer-arith -Wcast-qual -Wconversion -Wredundant-decls -Wdisabled-optimization -D _PLATFORM_LINUX -Iapplication/src -Iapplication/src/general -Iapplication/src/image -Iapplication/src/format"
+COMPILE_OPTIONS="-c -x c++ -ansi -std=c++98 -pedantic -fno-enforce-eh-specs -fno-rtti -O3 -ffast-math -fno-threadsafe-statics -ftree-vectorize -mfpmath=sse -msse -Wall -Wextra -Wabi -Wold-style-cast -Wsign-promo -Woverloaded-virtual -Wstrict-null-sentinel -Wcast-align -Wwrite-strings -Wpointer-arith -Wcast-qual -Wconversion -Wredundant-decls -Wdisabled-optimization -D _PLATFORM_LINUX -Iapplication/src -Iapplication/src/general -Iapplication/src/image -Iapplication/src/format -Iapplication/src/mapping"
 
 
 mkdir application/obj
@@ -18,14 +18,32 @@ echo "--- compile --"
 
 $COMPILER $COMPILE_OPTIONS application/src/general/DynamicLibraryInterface.cpp -o application/obj/DynamicLibraryInterface.o
 $COMPILER $COMPILE_OPTIONS application/src/general/StringConstants.cpp -o application/obj/StringConstants.o
+$COMPILER $COMPILE_OPTIONS application/src/general/HalfFloat.cpp -o application/obj/HalfFloat.o
+$COMPILER $COMPILE_OPTIONS application/src/general/Mutex.cpp -o application/obj/Mutex.o
+$COMPILER $COMPILE_OPTIONS application/src/general/Processors.cpp -o application/obj/Processors.o
+$COMPILER $COMPILE_OPTIONS application/src/general/MappedFile.cpp -o application/obj/MappedFile.o
+$COMPILER $COMPILE_OPTIONS application/src/general/Thread.cpp -o application/obj/Thread.o
+$COMPILER $COMPILE_OPTIONS application/src/general/FileList.cpp -o application/obj/FileList.o
+$COMPILER $COMPILE_OPTIONS application/src/general/Clock.cpp -o application/obj/Clock.o
+$COMPILER $COMPILE_OPTIONS application/src/general/LocalSocket.cpp -o application/obj/LocalSocket.o
 
 $COMPILER $COMPILE_OPTIONS application/src/format/exr.cpp -o application/obj/exr.o
 $COMPILER $COMPILE_OPTIONS application/src/format/png.cpp -o application/obj/png.o
 $COMPILER $COMPILE_OPTIONS application/src/format/ppm.cpp -o application/obj/ppm.o
+$COMPILER $COMPILE_OPTIONS application/src/format/pfm.cpp -o application/obj/pfm.o
+$COMPILER $COMPILE_OPTIONS application/src/format/qoi.cpp -o application/obj/qoi.o
 $COMPILER $COMPILE_OPTIONS application/src/format/rgbe.cpp -o application/obj/rgbe.o
 $COMPILER $COMPILE_OPTIONS application/src/format/ImageFormatter.cpp -o application/obj/ImageFormatter.o
 $COMPILER $COMPILE_OPTIONS application/src/format/ImageRef.cpp -o application/obj/ImageRef.o
 
+$COMPILER $COMPILE_OPTIONS application/src/mapping/Options.cpp -o application/obj/Options.o
+$COMPILER $COMPILE_OPTIONS application/src/mapping/OutputRows.cpp -o application/obj/OutputRows.o
+$COMPILER $COMPILE_OPTIONS application/src/mapping/ImageJob.cpp -o application/obj/ImageJob.o
+$COMPILER $COMPILE_OPTIONS application/src/mapping/Batch.cpp -o application/obj/Batch.o
+$COMPILER $COMPILE_OPTIONS application/src/mapping/Sweep.cpp -o application/obj/Sweep.o
+$COMPILER $COMPILE_OPTIONS application/src/mapping/Frames.cpp -o application/obj/Frames.o
+$COMPILER $COMPILE_OPTIONS application/src/mapping/CommandFileCache.cpp -o application/obj/CommandFileCache.o
+
 $COMPILER $COMPILE_OPTIONS application/src/p3tonemapper.cpp -o application/obj/p3tonemapper.o
 
 
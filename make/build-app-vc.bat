@@ -6,7 +6,7 @@ rem --- using: MS VC++ 2005 ---
 
 set COMPILER=cl
 set LINKER=link
-set COMPILE_OPTIONS=/c /O2 /GL /fp:fast /EHsc /GR- /GS- /MT /W4 /WL /nologo /D_PLATFORM_WIN /Iapplication/src /Iapplication/src/general /Iapplication/src/format
+set COMPILE_OPTIONS=/c /O2 /GL /fp:fast /EHsc /GR- /GS- /MT /W4 /WL /nologo /D_PLATFORM_WIN /Iapplication/src /Iapplication/src/general /Iapplication/src/format /Iapplication/src/mapping
 
 
 
@@ -20,14 +20,32 @@ del /Q application\obj\*
 
 %COMPILER% %COMPILE_OPTIONS% application/src/general/DynamicLibraryInterface.cpp /Foapplication/obj/DynamicLibraryInterface.obj
 %COMPILER% %COMPILE_OPTIONS% application/src/general/StringConstants.cpp /Foapplication/obj/StringConstants.obj
+%COMPILER% %COMPILE_OPTIONS% application/src/general/HalfFloat.cpp /Foapplication/obj/HalfFloat.obj
+%COMPILER% %COMPILE_OPTIONS% application/src/general/Mutex.cpp /Foapplication/obj/Mutex.obj
+%COMPILER% %COMPILE_OPTIONS% application/src/general/Processors.cpp /Foapplication/obj/Processors.obj
+%COMPILER% %COMPILE_OPTIONS% application/src/general/MappedFile.cpp /Foapplication/obj/MappedFile.obj
+%COMPILER% %COMPILE_OPTIONS% application/src/general/Thread.cpp /Foapplication/obj/Thread.obj
+%COMPILER% %COMPILE_OPTIONS% application/src/general/FileList.cpp /Foapplication/obj/FileList.obj
+%COMPILER% %COMPILE_OPTIONS% application/src/general/Clock.cpp /Foapplication/obj/Clock.obj
+%COMPILER% %COMPILE_OPTIONS% application/src/general/LocalSocket.cpp /Foapplication/obj/LocalSocket.obj
 
 %COMPILER% %COMPILE_OPTIONS% application/src/format/exr.cpp /Foapplication/obj/exr.obj
 %COMPILER% %COMPILE_OPTIONS% application/src/format/png.cpp /Foapplication/obj/png.obj
 %COMPILER% %COMPILE_OPTIONS% application/src/format/ppm.cpp /Foapplication/obj/ppm.obj
+%COMPILER% %COMPILE_OPTIONS% application/src/format/pfm.cpp /Foapplication/obj/pfm.obj
+%COMPILER% %COMPILE_OPTIONS% application/src/format/qoi.cpp /Foapplication/obj/qoi.obj
 %COMPILER% %COMPILE_OPTIONS% application/src/format/rgbe.cpp /Foapplication/obj/rgbe.obj
 %COMPILER% %COMPILE_OPTIONS% application/src/format/ImageFormatter.cpp /Foapplication/obj/ImageFormatter.obj
 %COMPILER% %COMPILE_OPTIONS% application/src/format/ImageRef.cpp /Foapplication/obj/ImageRef.obj
 
+%COMPILER% %COMPILE_OPTIONS% application/src/mapping/Options.cpp /Foapplication/obj/Options.obj
+%COMPILER% %COMPILE_OPTIONS% application/src/mapping/OutputRows.cpp /Foapplication/obj/OutputRows.obj
+%COMPILER% %COMPILE_OPTIONS% application/src/mapping/ImageJob.cpp /Foapplication/obj/ImageJob.obj
+%COMPILER% %COMPILE_OPTIONS% application/src/mapping/Batch.cpp /Foapplication/obj/Batch.obj
+%COMPILER% %COMPILE_OPTIONS% application/src/mapping/Sweep.cpp /Foapplication/obj/Sweep.obj
+%COMPILER% %COMPILE_OPTIONS% application/src/mapping/Frames.cpp /Foapplication/obj/Frames.obj
+%COMPILER% %COMPILE_OPTIONS% application/src/mapping/CommandFileCache.cpp /Foapplication/obj/CommandFileCache.obj
+
 %COMPILER% %COMPILE_OPTIONS% application/src/p3tonemapper.cpp /Foapplication/obj/p3tonemapper.obj
 
 
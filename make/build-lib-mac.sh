@@ -4,7 +4,7 @@
 # set constants ----------------------------------------------------------------
 COMPILER=g++
 LINKER=g++
-COMPILE_OPTIONS="-c -fPIC -x c++ -ansi -std=c++98 -pedantic -fno-enforce-eh-specs -fno-rtti -O3 -ffast-math -fno-threadsafe-statics -ftree-vectorize -mfpmath=sse -msse -Wall -Wextra -Wabi -Wold-style-cast -Wsign-promo -Woverloaded-virtual -Wstrict-null-sentinel -Wcast-align -Wwrite-strings -Wpointer-arith -Wcast-qual -Wconversion -Wredundant-decls -Wdisabled-optimization -D _PLATFORM_LINUX -Ilibrary/src -Ilibrary/src/general -Ilibrary/src/graphics -Ilibrary/src/image -Ilibrary/src/tonemap"
+COMPILE_OPTIONS="-c -fPIC -x c++ -ansi -std=c++98 -pedantic -fno-enforce-eh-specs -fno-rtti -O3 -ffast-math -ftree-vectorize -mfpmath=sse -msse -Wall -Wextra -Wabi -Wold-style-cast -Wsign-promo -Woverloaded-virtual -Wstrict-null-sentinel -Wcast-align -Wwrite-strings -Wpointer-arith -Wcast-qual -Wconversion -Wredundant-decls -Wdisabled-optimization -D _PLATFORM_LINUX -Ilibrary/src -Ilibrary/src/general -Ilibrary/src/graphics -Ilibrary/src/image -Ilibrary/src/tonemap"
 LINK_OPTIONS="-shared -Wl,-soname,libp3tonemapper.so.1 -o libp3tonemapper.so.1.2"
 
 
@@ -19,6 +19,8 @@ echo "--- compile --"
 
 $COMPILER $COMPILE_OPTIONS library/src/general/Array.cpp -o library/obj/Array.o
 $COMPILER $COMPILE_OPTIONS library/src/general/Clamps.cpp -o library/obj/Clamps.o
+$COMPILER $COMPILE_OPTIONS library/src/general/FpEnvironment.cpp -o library/obj/FpEnvironment.o
+$COMPILER $COMPILE_OPTIONS library/src/general/HalfFloat.cpp -o library/obj/HalfFloat.o
 $COMPILER $COMPILE_OPTIONS library/src/general/FpToInt.cpp -o library/obj/FpToInt.o
 $COMPILER $COMPILE_OPTIONS library/src/general/Histogram.cpp -o library/obj/Histogram.o
 $COMPILER $COMPILE_OPTIONS library/src/general/Interval.cpp -o library/obj/Interval.o
@@ -38,6 +40,8 @@ $COMPILER $COMPILE_OPTIONS library/src/tonemap/AcuityFilter.cpp -o library/obj/A
 $COMPILER $COMPILE_OPTIONS library/src/tonemap/ColorAdjustment.cpp -o library/obj/ColorAdjustment.o
 $COMPILER $COMPILE_OPTIONS library/src/tonemap/Foveal.cpp -o library/obj/Foveal.o
 $COMPILER $COMPILE_OPTIONS library/src/tonemap/PerceptualMap.cpp -o library/obj/PerceptualMap.o
+$COMPILER $COMPILE_OPTIONS library/src/tonemap/PerceptualMapStream.cpp -o library/obj/PerceptualMapStream.o
+$COMPILER $COMPILE_OPTIONS library/src/tonemap/PerceptualMapSweep.cpp -o library/obj/PerceptualMapSweep.o
 $COMPILER $COMPILE_OPTIONS library/src/tonemap/ToneAdjustment.cpp -o library/obj/ToneAdjustment.o
 $COMPILER $COMPILE_OPTIONS library/src/tonemap/Veil.cpp -o library/obj/Veil.o
 
@@ -20,6 +20,8 @@ del /Q library\obj\*
 
 %COMPILER% %COMPILE_OPTIONS% library/src/general/Array.cpp /Folibrary/obj/Array.obj
 %COMPILER% %COMPILE_OPTIONS% library/src/general/Clamps.cpp /Folibrary/obj/Clamps.obj
+%COMPILER% %COMPILE_OPTIONS% library/src/general/FpEnvironment.cpp /Folibrary/obj/FpEnvironment.obj
+%COMPILER% %COMPILE_OPTIONS% library/src/general/HalfFloat.cpp /Folibrary/obj/HalfFloat.obj
 %COMPILER% %COMPILE_OPTIONS% library/src/general/FpToInt.cpp /Folibrary/obj/FpToInt.obj
 %COMPILER% %COMPILE_OPTIONS% library/src/general/Histogram.cpp /Folibrary/obj/Histogram.obj
 %COMPILER% %COMPILE_OPTIONS% library/src/general/Interval.cpp /Folibrary/obj/Interval.obj
@@ -39,6 +41,8 @@ del /Q library\obj\*
 %COMPILER% %COMPILE_OPTIONS% library/src/tonemap/ColorAdjustment.cpp /Folibrary/obj/ColorAdjustment.obj
 %COMPILER% %COMPILE_OPTIONS% library/src/tonemap/Foveal.cpp /Folibrary/obj/Foveal.obj
 %COMPILER% %COMPILE_OPTIONS% library/src/tonemap/PerceptualMap.cpp /Folibrary/obj/PerceptualMap.obj
+%COMPILER% %COMPILE_OPTIONS% library/src/tonemap/PerceptualMapStream.cpp /Folibrary/obj/PerceptualMapStream.obj
+%COMPILER% %COMPILE_OPTIONS% library/src/tonemap/PerceptualMapSweep.cpp /Folibrary/obj/PerceptualMapSweep.obj
 %COMPILER% %COMPILE_OPTIONS% library/src/tonemap/ToneAdjustment.cpp /Folibrary/obj/ToneAdjustment.obj
 %COMPILER% %COMPILE_OPTIONS% library/src/tonemap/Veil.cpp /Folibrary/obj/Veil.obj
 